@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Atomic operations on long values for lock-free code.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMMON_ATOMIC_H_INCLUDED
+#define COMMON_ATOMIC_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// barriers below rely on x86 memory ordering (see below), so other processors would get races silently
+#if !defined(_M_IX86) && !defined(_M_X64) && !defined(__i386__) && !defined(__x86_64__)
+#error "Atomic operations aren't implemented for this processor"
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_InterlockedCompareExchange, _InterlockedIncrement, _ReadWriteBarrier)
+#elif !defined(__GNUC__)
+#error "Atomic operations aren't implemented for this compiler"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Only x86 and x64 are supported, whose stores aren't reordered with other stores and loads aren't reordered
+// with other loads; so acquire loads and release stores need to stop just compiler reordering.
+// Read-modify-write operations are full barriers.
+
+/// Stops compiler from moving memory accesses across it.
+inline void compiler_barrier()
+{
+#if defined(_MSC_VER)
+   _ReadWriteBarrier();
+#else
+   __asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+/// Loads value; memory accesses following it aren't moved before it.
+inline long atomic_load(const volatile long* where)
+{
+   const long value = *where;
+   compiler_barrier();
+   return value;
+}
+
+/// Stores value; memory accesses preceding it aren't moved after it.
+inline void atomic_store(volatile long* where, long value)
+{
+   compiler_barrier();
+   *where = value;
+}
+
+/// Stores value if current one equals to comparand.
+/// \return Value before operation; it equals to comparand on success.
+inline long atomic_compare_exchange(volatile long* where, long value, long comparand)
+{
+#if defined(_MSC_VER)
+   return _InterlockedCompareExchange(where, value, comparand);
+#else
+   return __sync_val_compare_and_swap(where, comparand, value);
+#endif
+}
+
+/// \return Incremented value.
+inline long atomic_increment(volatile long* where)
+{
+#if defined(_MSC_VER)
+   return _InterlockedIncrement(where);
+#else
+   return __sync_add_and_fetch(where, 1);
+#endif
+}
+
+/// Sets value to zero.
+/// \return Value before operation.
+inline long atomic_take(volatile long* where)
+{
+   long value = atomic_load(where);
+   for (;;)
+   {
+      const long previous = atomic_compare_exchange(where, 0, value);
+      if (previous == value)
+      {
+         return value;
+      }
+      value = previous;
+   }
+}
+
+/// \return Signed distance between counters that wrap around, e.g. positive if to is after from.
+inline long get_distance(long from, long to)
+{
+   return static_cast<long>(static_cast<unsigned long>(to) - static_cast<unsigned long>(from));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // COMMON_ATOMIC_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Decorated stream that formats line into fixed buffer and writes it into its output at once.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMMON_FIXED_DECORATED_STREAM_H_INCLUDED
+#define COMMON_FIXED_DECORATED_STREAM_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Fixed_format.h"
+#include "Common/Typedefs.h"
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Size of line Fixed_decorated_stream formats, including new-line.
+const size_t fixed_line_size = 1024;
+
+/// Line of text formatted without memory allocation; text that doesn't fit is truncated.
+/// Built-in types are formatted as std::ostream with default flags does (see to_chars()); other types are
+/// formatted by their operator<< into std::ostringstream, that is slowly.
+/// Has no constructor, so that it could be kept in thread-local storage.
+class Fixed_line
+{
+public:
+
+   void clear()                                                { m_length = 0; m_is_full = false; }
+
+   const char* get_text() const                                { return m_text; }
+   size_t get_length() const                                   { return m_length; }
+
+   /// Adds new-line, for which there is always room.
+   void end_line()                                             { m_text[m_length++] = '\n'; }
+
+   /// Adds as many characters as fit.
+   void append(const char* text, size_t length);
+
+   /// Null string is empty.
+   Fixed_line& operator<<(const char* text);
+   Fixed_line& operator<<(const std::string& text)             { append(text.data(), text.size()); return *this; }
+
+   Fixed_line& operator<<(char value)                          { append(&value, 1); return *this; }
+   Fixed_line& operator<<(signed char value)                   { return *this << static_cast<char>(value); }
+   Fixed_line& operator<<(uchar value)                         { return *this << static_cast<char>(value); }
+   Fixed_line& operator<<(bool value)                          { return *this << (value ? '1' : '0'); }
+   Fixed_line& operator<<(short value)                         { return append_number(value); }
+   Fixed_line& operator<<(int value)                           { return append_number(value); }
+   Fixed_line& operator<<(long value)                          { return append_number(value); }
+   Fixed_line& operator<<(ushort value)                        { return append_number(value); }
+   Fixed_line& operator<<(uint value)                          { return append_number(value); }
+   Fixed_line& operator<<(ulong value)                         { return append_number(value); }
+   Fixed_line& operator<<(float value)                         { return append_number(value); }
+   Fixed_line& operator<<(double value)                        { return append_number(value); }
+   Fixed_line& operator<<(long double value)                   { return append_number(static_cast<double>(value)); }
+
+   template <class T>
+   Fixed_line& operator<<(const T& value);
+
+private:
+
+   /// Number that doesn't fit is dropped, and nothing is added after it, as after truncated text.
+   template <class T>
+   Fixed_line& append_number(T value);
+
+private:
+
+   /// The last character is kept for new-line.
+   char   m_text[fixed_line_size];
+   size_t m_length;
+   bool   m_is_full;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Line of calling thread Fixed_decorated_stream formats into.
+Fixed_line& get_thread_line();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Decorated_stream that formats chain of output statement into line of calling thread instead of std::ostream,
+/// so that neither locale nor sentry of stream is involved in formatting and nothing is allocated (see
+/// Fixed_line); at the end of chain whole line with new-line is written into output by single write, then output
+/// is flushed. That is, following code
+///   decorated_stream << 1 << 2 << 3;
+///   decorated_stream << 4 << 5 << 6;
+/// produces output:
+/// "123"
+/// "456"
+/// Note that each thread has only one line, so values written shouldn't write into Fixed_decorated_stream while
+/// they are formatted. Stream manipulators aren't supported.
+class Fixed_decorated_stream
+{
+public:
+   class Guard;
+public:
+
+   Fixed_decorated_stream(std::ostream& out) : m_out(out) { }
+   // default copying is ok
+
+   template <class T>
+   Guard operator<<(const T& value) { return Guard(&m_out, value); }
+
+public:
+
+   /// Temporary object that starts line of calling thread and writes it at the end of full expression.
+   class Guard
+   {
+   public:
+
+      template <class T>
+      Guard(std::ostream* out, const T& first) : m_out(out), m_line(&get_thread_line())
+      {
+         m_line->clear();
+         (*m_line) << first;
+      }
+
+      /// Takes line over, so that it is written once.
+      Guard(const Guard& other) : m_out(other.m_out), m_line(other.m_line)      { other.m_out = 0; }
+
+      template <class T>
+      const Guard& operator <<(const T& next) const                             { (*m_line) << next; return *this; }
+
+      ~Guard();
+
+   private:
+
+      Guard& operator=(const Guard&);
+
+   private:
+
+      /// Null if line is taken over.
+      mutable std::ostream* m_out;
+      Fixed_line*           m_line;
+   };
+
+private:
+
+   std::ostream& m_out;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+Fixed_line& Fixed_line::operator<<(const T& value)
+{
+   std::ostringstream text;
+   text << value;
+   return *this << text.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+Fixed_line& Fixed_line::append_number(T value)
+{
+   if (!m_is_full)
+   {
+      char* const end = to_chars(m_text + m_length, m_text + fixed_line_size - 1, value);
+      if (end)
+      {
+         m_length = end - m_text;
+      }
+      else
+      {
+         m_is_full = true;
+      }
+   }
+   return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // COMMON_FIXED_DECORATED_STREAM_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Formatting of numbers into character buffer without locale, stream or memory allocation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMMON_FIXED_FORMAT_H_INCLUDED
+#define COMMON_FIXED_FORMAT_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Each to_chars() writes value into [first, last) the same way std::ostream with default flags and classic locale
+// does, that is integers in decimal without grouping and floating point values as printf("%g").
+// \return Pointer past the last character written; null if value doesn't fit, in which case contents of range
+//         is unspecified.
+
+char* to_chars(char* first, char* last, long value);
+char* to_chars(char* first, char* last, ulong value);
+char* to_chars(char* first, char* last, double value);
+
+inline char* to_chars(char* first, char* last, short value)     { return to_chars(first, last, long(value)); }
+inline char* to_chars(char* first, char* last, int value)       { return to_chars(first, last, long(value)); }
+inline char* to_chars(char* first, char* last, ushort value)    { return to_chars(first, last, ulong(value)); }
+inline char* to_chars(char* first, char* last, uint value)      { return to_chars(first, last, ulong(value)); }
+inline char* to_chars(char* first, char* last, float value)     { return to_chars(first, last, double(value)); }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // COMMON_FIXED_FORMAT_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Reading and writing of little-endian numbers of file formats, regardless of host byte order and alignment.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMMON_LITTLE_ENDIAN_H_INCLUDED
+#define COMMON_LITTLE_ENDIAN_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Unsigned number of given size (1 to 4 bytes) stored least significant byte first.
+inline uint read_le(const uchar* p, uint nbytes)
+{
+   uint value = 0;
+   for (uint i = 0; i < nbytes; ++i)
+   {
+      value |= uint(p[i]) << (8*i);
+   }
+   return value;
+}
+
+/// Stores given number of the lowest bytes of value (1 to 4) least significant byte first.
+inline void write_le(uchar* p, uint value, uint nbytes)
+{
+   for (uint i = 0; i < nbytes; ++i)
+   {
+      p[i] = static_cast<uchar>(value >> (8*i));
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // COMMON_LITTLE_ENDIAN_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
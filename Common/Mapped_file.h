@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Files mapped into memory.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMMON_MAPPED_FILE_H_INCLUDED
+#define COMMON_MAPPED_FILE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+#include <cstddef>              // for size_t
+#include <stdexcept>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// File can't be mapped.
+class Mapped_file_exception : public std::runtime_error
+{
+public:
+   explicit Mapped_file_exception(const std::string& msg) : std::runtime_error(msg) { }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Whole file mapped for reading; pages are read by OS on first access, without copying into buffers.
+/// Works on Win32 and POSIX systems.
+class Mapped_file : boost::noncopyable
+{
+public:
+
+   /// \throw Mapped_file_exception if file can't be opened or mapped.
+   explicit Mapped_file(const std::string& file_name);
+
+   // copying is disallowed
+
+   ~Mapped_file();
+
+   /// \return Contents of file; null for empty file.
+   const uchar* get_data() const                                  { return m_data; }
+
+   /// \return Size of file in bytes.
+   size_t get_size() const                                        { return m_size; }
+
+private:
+
+   const uchar* m_data;
+   size_t       m_size;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// File of fixed size mapped for reading and writing.
+/// Writes go to OS pages of file right away, so they reach file even if process crashes without any flushing.
+/// Works on Win32 and POSIX systems.
+class Writable_mapped_file : boost::noncopyable
+{
+public:
+
+   /// Creates file of given (positive) size filled with zeros, replacing existing one; disk space is allocated
+   /// up front.
+   /// \throw Mapped_file_exception if file can't be created or mapped.
+   Writable_mapped_file(const std::string& file_name, size_t size);
+
+   // copying is disallowed
+
+   ~Writable_mapped_file();
+
+   uchar* get_data() const                                        { return m_data; }
+
+   size_t get_size() const                                        { return m_size; }
+
+private:
+
+   uchar* m_data;
+   size_t m_size;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // COMMON_MAPPED_FILE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
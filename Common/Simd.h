@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Detection of SIMD instruction sets available at compile time.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMMON_SIMD_H_INCLUDED
+#define COMMON_SIMD_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// COMMON_SSE2 is defined if compiler is allowed to emit SSE2 instructions
+// (MSVC: x64 or /arch:SSE2; GCC: -msse2, default for x86-64).
+// Code guarded by it should always have plain C++ fallback.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COMMON_SSE2
+#include <emmintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // COMMON_SIMD_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Decorated stream that formats line into fixed buffer.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Fixed_decorated_stream.h"
+
+#include <cstring>              // for std::memcpy, std::strlen
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// line is zero-initialized, that is empty, in each thread
+#if defined(_MSC_VER)
+__declspec(thread) Fixed_line thread_line;
+#else
+__thread Fixed_line thread_line;
+#endif
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Fixed_line& get_thread_line()
+{
+   return thread_line;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Fixed_line::append(const char* text, size_t length)
+{
+   if (m_is_full)
+   {
+      return;
+   }
+
+   const size_t room = fixed_line_size - 1 - m_length;
+   if (room < length)
+   {
+      length = room;
+      m_is_full = true;
+   }
+   std::memcpy(m_text + m_length, text, length);
+   m_length += length;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Fixed_line& Fixed_line::operator<<(const char* text)
+{
+   if (text)
+   {
+      append(text, std::strlen(text));
+   }
+   return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Fixed_decorated_stream::Guard::~Guard()
+{
+   if (m_out)
+   {
+      m_line->end_line();
+      m_out->write(m_line->get_text(), m_line->get_length());
+      m_out->flush();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
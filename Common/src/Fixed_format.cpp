@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Formatting of numbers into character buffer.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Fixed_format.h"
+
+#include <cstdio>               // for std::sprintf
+#include <cstring>              // for std::memcpy
+#include <limits>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Decimal digits of numbers from 0 to 99, so that number is converted by two digits at a time.
+const char digit_pairs[] =
+   "00010203040506070809"
+   "10111213141516171819"
+   "20212223242526272829"
+   "30313233343536373839"
+   "40414243444546474849"
+   "50515253545556575859"
+   "60616263646566676869"
+   "70717273747576777879"
+   "80818283848586878889"
+   "90919293949596979899";
+
+char* copy_chars(char* first, char* last, const char* begin, const char* end)
+{
+   const size_t length = end - begin;
+   if (static_cast<size_t>(last - first) < length)
+   {
+      return 0;
+   }
+   std::memcpy(first, begin, length);
+   return first + length;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char* to_chars(char* first, char* last, long value)
+{
+   if (value >= 0)
+   {
+      return to_chars(first, last, static_cast<ulong>(value));
+   }
+   if (first == last)
+   {
+      return 0;
+   }
+
+   // negation is done in unsigned, as -LONG_MIN overflows long
+   *first = '-';
+   return to_chars(first + 1, last, 0 - static_cast<ulong>(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char* to_chars(char* first, char* last, ulong value)
+{
+   char digits[std::numeric_limits<ulong>::digits10 + 1];
+   char* const end = digits + sizeof(digits);
+   char* digit = end;
+   while (value >= 10)
+   {
+      const char* const pair = digit_pairs + 2 * (value % 100);
+      value /= 100;
+      *--digit = pair[1];
+      *--digit = pair[0];
+   }
+   if (digit == end || value != 0)
+   {
+      *--digit = static_cast<char>('0' + value);
+   }
+   return copy_chars(first, last, digit, end);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char* to_chars(char* first, char* last, double value)
+{
+   // the longest is like "-1.79769e+308"
+   char text[32];
+   const int length = std::sprintf(text, "%g", value);
+   return copy_chars(first, last, text, text + length);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
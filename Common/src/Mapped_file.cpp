@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Mapped_file implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Mapped_file.h"
+
+#ifdef _WIN32
+#include "Third_party/Platform/Win32.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+Mapped_file::Mapped_file(const std::string& file_name)
+   : m_data(0)
+   , m_size(0)
+{
+   const HANDLE file = ::CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                     FILE_FLAG_SEQUENTIAL_SCAN, 0);
+   if (file == INVALID_HANDLE_VALUE)
+   {
+      throw Mapped_file_exception("Can't open file " + file_name);
+   }
+
+   LARGE_INTEGER size;
+   if (!::GetFileSizeEx(file, &size))
+   {
+      ::CloseHandle(file);
+      throw Mapped_file_exception("Can't get size of file " + file_name);
+   }
+   m_size = static_cast<size_t>(size.QuadPart);
+   if (m_size == 0)
+   {
+      ::CloseHandle(file);
+      return;
+   }
+
+   // view keeps mapping and file open, so their handles aren't needed after it is created
+   const HANDLE mapping = ::CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+   ::CloseHandle(file);
+   if (mapping == 0)
+   {
+      throw Mapped_file_exception("Can't map file " + file_name);
+   }
+   m_data = static_cast<const uchar*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+   ::CloseHandle(mapping);
+   if (m_data == 0)
+   {
+      throw Mapped_file_exception("Can't map file " + file_name);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Mapped_file::~Mapped_file()
+{
+   if (m_data != 0)
+   {
+      ::UnmapViewOfFile(m_data);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Writable_mapped_file::Writable_mapped_file(const std::string& file_name, size_t size)
+   : m_data(0)
+   , m_size(size)
+{
+   const HANDLE file = ::CreateFileA(file_name.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0,
+                                     CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+   if (file == INVALID_HANDLE_VALUE)
+   {
+      throw Mapped_file_exception("Can't create file " + file_name);
+   }
+
+   // mapping of given size extends file to it
+   ULARGE_INTEGER mapping_size;
+   mapping_size.QuadPart = size;
+   const HANDLE mapping = ::CreateFileMappingA(file, 0, PAGE_READWRITE, mapping_size.HighPart, mapping_size.LowPart, 0);
+   ::CloseHandle(file);
+   if (mapping == 0)
+   {
+      throw Mapped_file_exception("Can't map file " + file_name);
+   }
+   m_data = static_cast<uchar*>(::MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+   ::CloseHandle(mapping);
+   if (m_data == 0)
+   {
+      throw Mapped_file_exception("Can't map file " + file_name);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Writable_mapped_file::~Writable_mapped_file()
+{
+   ::UnmapViewOfFile(m_data);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#else
+
+Mapped_file::Mapped_file(const std::string& file_name)
+   : m_data(0)
+   , m_size(0)
+{
+   const int file = ::open(file_name.c_str(), O_RDONLY);
+   if (file < 0)
+   {
+      throw Mapped_file_exception("Can't open file " + file_name);
+   }
+
+   struct stat status;
+   if (::fstat(file, &status) != 0)
+   {
+      ::close(file);
+      throw Mapped_file_exception("Can't get size of file " + file_name);
+   }
+   m_size = static_cast<size_t>(status.st_size);
+   if (m_size == 0)
+   {
+      ::close(file);
+      return;
+   }
+
+   // mapping stays valid after descriptor is closed
+   void* data = ::mmap(0, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+   ::close(file);
+   if (data == MAP_FAILED)
+   {
+      throw Mapped_file_exception("Can't map file " + file_name);
+   }
+   ::madvise(data, m_size, MADV_SEQUENTIAL);
+   m_data = static_cast<const uchar*>(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Mapped_file::~Mapped_file()
+{
+   if (m_data != 0)
+   {
+      ::munmap(const_cast<uchar*>(m_data), m_size);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Writable_mapped_file::Writable_mapped_file(const std::string& file_name, size_t size)
+   : m_data(0)
+   , m_size(size)
+{
+   const int file = ::open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (file < 0)
+   {
+      throw Mapped_file_exception("Can't create file " + file_name);
+   }
+
+   // blocks are allocated now, so that writes through mapping don't fail when disk is full
+   if (::ftruncate(file, static_cast<off_t>(size)) != 0 || ::posix_fallocate(file, 0, static_cast<off_t>(size)) != 0)
+   {
+      ::close(file);
+      throw Mapped_file_exception("Can't allocate file " + file_name);
+   }
+
+   void* data = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+   ::close(file);
+   if (data == MAP_FAILED)
+   {
+      throw Mapped_file_exception("Can't map file " + file_name);
+   }
+   m_data = static_cast<uchar*>(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Writable_mapped_file::~Writable_mapped_file()
+{
+   ::munmap(m_data, m_size);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compares time Decorated_stream and Fixed_decorated_stream take to format and write lines, both into output that
+// discards them and into file.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Decorated_stream.h"
+#include "Common/Fixed_decorated_stream.h"
+
+#include <cstdio>               // for std::remove
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+namespace Decorated_stream_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint lines_number = 1000000;
+const char* const file_name = "decorated_stream_benchmark.txt";
+
+/// Output that discards everything, so that only formatting is measured.
+class Null_buffer : public streambuf
+{
+protected:
+
+   virtual streamsize xsputn(const char*, streamsize size)     { return size; }
+   virtual int_type overflow(int_type c)                       { return traits_type::not_eof(c); }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes lines like ones logger writes.
+/// \return Seconds spent.
+template <class Stream>
+double write_lines(ostream& out)
+{
+   Stream stream(out);
+   const clock_t start = clock();
+   for (uint i = 0; i < lines_number; ++i)
+   {
+      stream << "(" << i << ") (sender:" << 3 << ") Trivial: frame time " << i * 0.001 << " ms, " << -int(i) << '.';
+   }
+   return double(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void print(const char* name, double seconds)
+{
+   cout << name << ": " << seconds * 1e9 / lines_number << " ns per line" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   cout << lines_number << " lines" << endl;
+
+   Null_buffer null_buffer;
+   ostream null_out(&null_buffer);
+   print("Decorated_stream, discarded", write_lines<Decorated_stream>(null_out));
+   print("Fixed_decorated_stream, discarded", write_lines<Fixed_decorated_stream>(null_out));
+
+   {
+      ofstream out(file_name);
+      print("Decorated_stream, into file", write_lines<Decorated_stream>(out));
+   }
+   {
+      ofstream out(file_name);
+      print("Fixed_decorated_stream, into file", write_lines<Fixed_decorated_stream>(out));
+   }
+   remove(file_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Decorated_stream_benchmark
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Common::Decorated_stream_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,221 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for Fixed_decorated_stream and to_chars().
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Fixed_decorated_stream.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <climits>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+namespace Fixed_decorated_stream_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Value formatted by its own operator<<.
+struct Point
+{
+   int x;
+   int y;
+};
+
+ostream& operator<<(ostream& out, const Point& point)
+{
+   return out << '[' << point.x << ", " << point.y << ']';
+}
+
+/// Keeps text written into it and counts writes.
+class Counting_buffer : public streambuf
+{
+public:
+
+   Counting_buffer() : writes_number(0) { }
+
+   string text;
+   int    writes_number;
+
+protected:
+
+   virtual streamsize xsputn(const char* data, streamsize size)
+   {
+      ++writes_number;
+      text.append(data, static_cast<size_t>(size));
+      return size;
+   }
+
+   virtual int_type overflow(int_type c)
+   {
+      ++writes_number;
+      text += traits_type::to_char_type(c);
+      return c;
+   }
+};
+
+/// \return Value as formatted by to_chars() into buffer of given size; "null" if it doesn't fit.
+template <class T>
+string format(T value, size_t size = 32)
+{
+   char buffer[32];
+   char* const end = to_chars(buffer, buffer + size, value);
+   return end ? string(buffer, end) : "null";
+}
+
+/// \return Value as formatted by std::ostream.
+template <class T>
+string format_by_stream(T value)
+{
+   ostringstream out;
+   out << value;
+   return out.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_simple0()
+{
+   ostringstream strout;
+   Fixed_decorated_stream out(strout);
+
+   out << 1 << 'a' << "alpha";
+
+   BOOST_CHECK(strout.str() == "1aalpha\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_simple1()
+{
+   ostringstream strout;
+   Fixed_decorated_stream out(strout);
+
+   out << 1 << 'a' << "alpha";
+   out << 2 << 'b' << "beta";
+   out << 3 << 'c' << "gamma";
+
+   BOOST_CHECK(strout.str() == "1aalpha\n2bbeta\n3cgamma\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_simple2()
+{
+   ostringstream strout;
+   Fixed_decorated_stream out(strout);
+
+   out << "funny\n" << "string\n";
+
+   BOOST_CHECK(strout.str() == "funny\nstring\n\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Line is the same as Decorated_stream writes, and it is written at once.
+void test_types()
+{
+   ostringstream etalon;
+   Counting_buffer buffer;
+   ostream strout(&buffer);
+   Fixed_decorated_stream out(strout);
+
+   const string name = "banana";
+   char text[16] = "stain";
+   const Point point = { 3, -4 };
+
+   etalon << "Loaded " << name << " (" << 64 << 'x' << 64u << ") " << text << ' ' << point << '\n';
+   etalon << short(-7) << ' ' << -100000L << ' ' << 4000000000UL << ' ' << ushort(7) << ' ' << uchar('u') << '\n';
+   etalon << true << ' ' << 0.5f << ' ' << 2.25 << ' ' << 1e-10 << ' ' << 123456789.0 << ' ' << 1.5L << '\n';
+
+   out << "Loaded " << name << " (" << 64 << 'x' << 64u << ") " << text << ' ' << point;
+   BOOST_CHECK_EQUAL(buffer.writes_number, 1);
+   out << short(-7) << ' ' << -100000L << ' ' << 4000000000UL << ' ' << ushort(7) << ' ' << uchar('u');
+   out << true << ' ' << 0.5f << ' ' << 2.25 << ' ' << 1e-10 << ' ' << 123456789.0 << ' ' << 1.5L;
+   BOOST_CHECK_EQUAL(buffer.writes_number, 3);
+
+   BOOST_CHECK_EQUAL(buffer.text, etalon.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Text that doesn't fit into line is truncated, number is dropped with everything after it.
+void test_truncation()
+{
+   ostringstream strout;
+   Fixed_decorated_stream out(strout);
+
+   out << "Long " << string(fixed_line_size, 'a') << 12345;
+   out << string(fixed_line_size - 4, 'b') << 12345 << "end";
+   out << "Short " << 1;
+
+   BOOST_CHECK_EQUAL(strout.str(), "Long " + string(fixed_line_size - 6, 'a') + '\n'
+                                   + string(fixed_line_size - 4, 'b') + "\nShort 1\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_to_chars()
+{
+   BOOST_CHECK_EQUAL(format(0), "0");
+   BOOST_CHECK_EQUAL(format(7), "7");
+   BOOST_CHECK_EQUAL(format(10), "10");
+   BOOST_CHECK_EQUAL(format(-105), "-105");
+   BOOST_CHECK_EQUAL(format(1000u), "1000");
+   BOOST_CHECK_EQUAL(format(LONG_MAX), format_by_stream(LONG_MAX));
+   BOOST_CHECK_EQUAL(format(LONG_MIN), format_by_stream(LONG_MIN));
+   BOOST_CHECK_EQUAL(format(ULONG_MAX), format_by_stream(ULONG_MAX));
+   BOOST_CHECK_EQUAL(format(short(SHRT_MIN)), format_by_stream(short(SHRT_MIN)));
+
+   BOOST_CHECK_EQUAL(format(0.0), "0");
+   BOOST_CHECK_EQUAL(format(-0.1f), "-0.1");
+   BOOST_CHECK_EQUAL(format(1234567.0), format_by_stream(1234567.0));
+   BOOST_CHECK_EQUAL(format(-1.7976931348623157e308), format_by_stream(-1.7976931348623157e308));
+
+   // value should fit completely
+   BOOST_CHECK_EQUAL(format(12345, 5), "12345");
+   BOOST_CHECK_EQUAL(format(12345, 4), "null");
+   BOOST_CHECK_EQUAL(format(-1, 1), "null");
+   BOOST_CHECK_EQUAL(format(0.25, 4), "0.25");
+   BOOST_CHECK_EQUAL(format(0.25, 3), "null");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Fixed_decorated_stream_test
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Common::Fixed_decorated_stream_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Fixed_decorated_stream tests");
+
+   test->add(BOOST_TEST_CASE(test_simple0));
+   test->add(BOOST_TEST_CASE(test_simple1));
+   test->add(BOOST_TEST_CASE(test_simple2));
+   test->add(BOOST_TEST_CASE(test_types));
+   test->add(BOOST_TEST_CASE(test_truncation));
+   test->add(BOOST_TEST_CASE(test_to_chars));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
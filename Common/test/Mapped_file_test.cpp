@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for Mapped_file.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Mapped_file.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>               // for std::remove
+#include <cstring>              // for std::memcpy
+#include <fstream>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Common
+{
+namespace Mapped_file_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const file_name = "Mapped_file_test.bin";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_contents()
+{
+   string contents("mapped\0file", 11);
+   contents += string(100000, 'x');
+   {
+      ofstream file(file_name, ios::binary);
+      file << contents;
+   }
+
+   {
+      const Mapped_file file(file_name);
+      BOOST_REQUIRE_EQUAL(file.get_size(), contents.size());
+      BOOST_CHECK(string(reinterpret_cast<const char*>(file.get_data()), file.get_size()) == contents);
+   }
+   remove(file_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_empty()
+{
+   {
+      ofstream file(file_name, ios::binary);
+   }
+
+   {
+      const Mapped_file file(file_name);
+      BOOST_CHECK_EQUAL(file.get_size(), 0u);
+      BOOST_CHECK(file.get_data() == 0);
+   }
+   remove(file_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_missing()
+{
+   BOOST_CHECK_THROW(Mapped_file("no_such_file.bin"), Mapped_file_exception);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_writable()
+{
+   {
+      ofstream file(file_name, ios::binary);
+      file << "old contents";
+   }
+
+   {
+      const Writable_mapped_file file(file_name, 10000);
+      BOOST_REQUIRE_EQUAL(file.get_size(), 10000u);
+      BOOST_CHECK(string(reinterpret_cast<const char*>(file.get_data()), 12) == string(12, '\0'));
+      memcpy(file.get_data() + 9990, "written", 7);
+   }
+
+   {
+      const Mapped_file file(file_name);
+      BOOST_REQUIRE_EQUAL(file.get_size(), 10000u);
+      BOOST_CHECK(string(reinterpret_cast<const char*>(file.get_data()) + 9990, 10) == string("written\0\0\0", 10));
+   }
+   remove(file_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Mapped_file_test
+} // namespace Common
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Common::Mapped_file_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Mapped_file tests");
+
+   test->add(BOOST_TEST_CASE(test_contents));
+   test->add(BOOST_TEST_CASE(test_empty));
+   test->add(BOOST_TEST_CASE(test_missing));
+   test->add(BOOST_TEST_CASE(test_writable));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
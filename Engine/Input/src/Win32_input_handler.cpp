@@ -28,7 +28,12 @@ namespace Logging
 
 const uchar sender_input_handler = 4;
 
-#define LOG_INPUT(message_level) LOG(Engine::Logging::sender_input_handler, message_level)
+#ifdef NDEBUG
+// input handler logs trivial messages every frame
+LOG_COMPILED_LEVEL(sender_input_handler, minor);
+#endif
+
+#define LOG_INPUT(message_level) LOG_SENDER(Engine::Logging::sender_input_handler, message_level)
 
 }
 }
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Binary log: messages are kept as raw values of LOG arguments and formatted into text offline.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_LOGGING_BINARY_LOG_H_INCLUDED
+#define ENGINE_LOGGING_BINARY_LOG_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Record_ring.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+#include <iosfwd>
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Binary log starts with binary_log_magic; then records follow, each as used part of Log_record.
+// Record of message keeps values of LOG arguments one after another; its site field tells descriptor of LOG
+// statement, which is written once before the first message of the statement as records with descriptor_level;
+// text of descriptor is concatenated text of its records, so it isn't limited by size of record.
+// Descriptor keeps type of each argument and text of string literals, so literals aren't copied by messages.
+// Records of site 0 keep plain text (e.g. messages of Logger itself).
+// Note that values are kept as they are in memory, so log should be decoded on platform it was written on.
+
+/// The first bytes of binary log.
+const char binary_log_magic[] = "ELOGBIN1";
+
+/// Level field of descriptor record.
+const uchar descriptor_level = 0xFF;
+
+/// Type of piece of descriptor; each is uchar type followed by ushort size.
+enum Log_piece_type
+{
+   /// Size characters of literal follow piece in descriptor.
+   piece_literal
+   /// Value is ushort length followed by characters.
+   , piece_string
+   , piece_char
+   , piece_bool
+   /// Value is signed integer of size bytes.
+   , piece_signed
+   , piece_unsigned
+   , piece_float
+   , piece_double
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// LOG statement as binary log knows it.
+struct Log_site
+{
+   /// Binary log site is registered in (see Logger::enable_binary()); 0 if none.
+   volatile long generation;
+   /// Site field of records of statement; valid within generation.
+   ushort        id;
+};
+
+namespace
+{
+
+/// Static site of each LOG statement; statements are told by their __COUNTER__ value.
+template <int counter>
+struct Log_site_of
+{
+   static Log_site site;
+};
+
+template <int counter>
+Log_site Log_site_of<counter>::site;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Encodes values logged by LOG statement into record, and into descriptor of statement if it isn't registered.
+/// Values that don't fit into record are dropped, as text that doesn't fit is.
+class Binary_encoder : boost::noncopyable
+{
+public:
+
+   Binary_encoder();
+   // copying is disallowed
+
+   /// Starts record of message of given site.
+   /// \param generation Current generation of binary log; if site isn't registered in it, descriptor is built.
+   void begin(Timing::Milliseconds time, uchar sender_id, uchar level, Log_site& site, long generation);
+
+   /// Adds literal to descriptor only.
+   void add_literal(const char* text);
+
+   /// Null string is empty.
+   void add(const char* text);
+   void add(const std::string& text);
+
+   void add(char value)                                        { add_value(piece_char, value); }
+   void add(signed char value)                                 { add_value(piece_char, value); }
+   void add(uchar value)                                       { add_value(piece_char, value); }
+   void add(bool value)                                        { add_value(piece_bool, value); }
+   void add(short value)                                       { add_value(piece_signed, value); }
+   void add(int value)                                         { add_value(piece_signed, value); }
+   void add(long value)                                        { add_value(piece_signed, value); }
+   void add(ushort value)                                      { add_value(piece_unsigned, value); }
+   void add(uint value)                                        { add_value(piece_unsigned, value); }
+   void add(ulong value)                                       { add_value(piece_unsigned, value); }
+   void add(float value)                                       { add_value(piece_float, value); }
+   void add(double value)                                      { add_value(piece_double, value); }
+   void add(long double value)                                 { add_value(piece_double, static_cast<double>(value)); }
+
+   /// Values of other types are formatted into string by their operator<<.
+   template <class T>
+   void add(const T& value);
+
+   Log_site& get_site() const                                  { return *m_site; }
+
+   /// \return true if descriptor is built, that is site isn't registered in current generation.
+   bool is_describing() const                                  { return m_is_describing; }
+
+   /// \return Record of message; its site is set when site is registered.
+   Log_record& get_record()                                    { return m_record; }
+
+   /// \return Records of descriptor, valid if it is built; their site is set when site is registered.
+   std::vector<Log_record>& get_descriptor()                   { return m_descriptor; }
+
+private:
+
+   template <class T>
+   void add_value(Log_piece_type type, const T& value);
+
+   void describe(Log_piece_type type, ushort size);
+
+   /// Copies bytes to the end of descriptor, starting its next record when the last one is full.
+   void add_description(const void* data, uint size);
+
+private:
+
+   Log_site*               m_site;
+   bool                    m_is_describing;
+   Log_record              m_record;
+   /// Allocated only when LOG statement is described for the first time.
+   std::vector<Log_record> m_descriptor;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Formats binary log into text the same way Logger writes text log.
+/// Stops at the end of input or at incomplete record, which crash could leave.
+/// \throw std::runtime_error if input isn't binary log, refers to site it doesn't describe or has message of
+///        unknown level.
+void decode_binary_log(std::istream& in, std::ostream& out);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Copies given bytes to the end of text of record.
+/// If they don't fit, record is made full, so that decoder doesn't read values past the one that is dropped.
+/// \return false if bytes don't fit.
+bool put_bytes(Log_record& record, const void* data, uint size);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+void Binary_encoder::add(const T& value)
+{
+   std::ostringstream text;
+   text << value;
+   add(text.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+void Binary_encoder::add_value(Log_piece_type type, const T& value)
+{
+   if (m_is_describing)
+   {
+      describe(type, sizeof(value));
+   }
+   put_bytes(m_record, &value, sizeof(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Logging
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_LOGGING_BINARY_LOG_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
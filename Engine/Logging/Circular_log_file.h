@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Log file of fixed size that keeps the last messages and survives crash of application.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_LOGGING_CIRCULAR_LOG_FILE_H_INCLUDED
+#define ENGINE_LOGGING_CIRCULAR_LOG_FILE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Mapped_file.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+#include <iosfwd>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// The first bytes of circular log file.
+const char circular_log_magic[] = "ELOGRING";
+
+/// Header circular log file starts with; text follows it at circular_log_header_size offset.
+struct Circular_log_header
+{
+   char          magic[sizeof(circular_log_magic) - 1];
+   /// Bytes of text file keeps.
+   uint          capacity;
+   /// Offset in text the next byte is written at.
+   volatile uint cursor;
+   /// Nonzero once text was written over, so that text after cursor is older than one before it.
+   volatile uint is_wrapped;
+};
+
+const uint circular_log_header_size = 64;
+
+/// Appended to name of circular log file to keep file of previous run under (see Circular_log_file).
+const char previous_circular_log_suffix[] = ".old";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Output of Logger (see Logger::init()) kept in file of fixed size as circle: once file is full, text is written
+/// over the oldest one, so file keeps the last capacity bytes of log.
+/// File is mapped into memory, so that text is written by plain memory writes and cursor in header is updated
+/// after each write; flushing does nothing. OS keeps pages of file, so everything written reaches file even if
+/// application crashes. unroll_circular_log() gives log in chronological order.
+/// Existing file of the same name, e.g. one left by crashed run, isn't overwritten but renamed by appending
+/// previous_circular_log_suffix, replacing file of the run before it.
+class Circular_log_file : boost::noncopyable
+{
+public:
+
+   /// Creates file that keeps given number of bytes of text; existing one is kept as previous.
+   /// \throw Common::Mapped_file_exception if file can't be created.
+   Circular_log_file(const std::string& file_name, uint capacity);
+   // copying is disallowed
+
+   /// Stream to log into.
+   std::ostream& get_stream()                                  { return m_stream; }
+
+private:
+
+   /// Writes characters into the circle.
+   class Buffer : public std::streambuf
+   {
+   public:
+
+      /// Starts empty circle of given capacity in mapped file.
+      Buffer(uchar* file, uint capacity);
+
+   protected:
+
+      virtual std::streamsize xsputn(const char* text, std::streamsize size);
+      virtual int_type overflow(int_type c);
+
+   private:
+
+      Circular_log_header& m_header;
+      char*                m_text;
+   };
+
+private:
+
+   Common::Writable_mapped_file m_file;
+   Buffer                       m_buffer;
+   std::ostream                 m_stream;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes text of circular log file in chronological order.
+/// Text that is partially written over is skipped up to the next line.
+/// \throw std::runtime_error if data isn't circular log file.
+void unroll_circular_log(const uchar* file, size_t size, std::ostream& out);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Logging
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_LOGGING_CIRCULAR_LOG_FILE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -14,11 +14,13 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include "Engine/Logging/Binary_log.h"
 #include "Engine/Timing/Timer.h"
-#include "Common/Decorated_stream.h"
 
 #include "Common/Typedefs.h"
 
+#include "boost/noncopyable.hpp"
+
 #include <string>
 #include <iostream>
 #include <algorithm>
@@ -46,6 +48,104 @@ enum Message_level
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// ENGINE_LOGGING_MIN_LEVEL could be defined by build as value of Message_level; messages of lower levels are stripped
+// out at compile time whatever levels are set at run time. Defaults to trivial, so nothing is stripped.
+
+#ifndef ENGINE_LOGGING_MIN_LEVEL
+#define ENGINE_LOGGING_MIN_LEVEL 0
+#endif
+
+/// Level below which messages aren't compiled (see ENGINE_LOGGING_MIN_LEVEL).
+const Message_level compiled_message_level = Message_level(ENGINE_LOGGING_MIN_LEVEL);
+
+/// Level below which messages of sender with given id aren't compiled, if they are logged by LOG_SENDER.
+/// The global one unless raised for sender by LOG_COMPILED_LEVEL.
+template <uchar sender_id>
+struct Compiled_message_level
+{
+   static const Message_level value = compiled_message_level;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// What LOG statement does with message when queue of asynchronous logging is full.
+enum Overflow_policy
+{
+   /// Waits until writer thread frees room; nothing is lost, but caller could stall.
+   overflow_block
+   /// Drops message silently.
+   , overflow_drop
+   /// Drops message; writer thread logs how many messages were dropped.
+   , overflow_count
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class Async_writer;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Stream LOG statement puts message into; message ends with the statement, as with Common::Decorated_stream.
+/// Values are formatted into text unless logging is binary; then they are encoded into record (see Binary_encoder).
+class Log_stream
+{
+public:
+
+   explicit Log_stream(std::ostream& out) : m_out(&out), m_binary(0), m_is_ending(true)          { }
+   explicit Log_stream(Binary_encoder& binary) : m_out(0), m_binary(&binary), m_is_ending(true)  { }
+
+   /// Takes message over, so that it is ended once.
+   Log_stream(const Log_stream& other);
+
+   /// Ends message.
+   ~Log_stream();
+
+   /// String literal, which binary log keeps in descriptor of LOG statement.
+   template <size_t length>
+   const Log_stream& operator<<(const char (&text)[length]) const
+   {
+      if (m_binary)
+      {
+         m_binary->add_literal(text);
+      }
+      else
+      {
+         *m_out << text;
+      }
+      return *this;
+   }
+
+   /// Character array is logged as string, as it could change between messages.
+   template <size_t length>
+   const Log_stream& operator<<(char (&text)[length]) const       { return *this << static_cast<const char*>(text); }
+
+   template <class T>
+   const Log_stream& operator<<(const T& value) const
+   {
+      if (m_binary)
+      {
+         m_binary->add(value);
+      }
+      else
+      {
+         *m_out << value;
+      }
+      return *this;
+   }
+
+private:
+
+   Log_stream& operator=(const Log_stream&);
+
+private:
+
+   std::ostream*   m_out;
+   Binary_encoder* m_binary;
+   mutable bool    m_is_ending;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 /// Provides logging services to application.
 /// Allows filter messages by level and by sender.
 /// Note that application responsible for any clashes between sender identifiers.
@@ -70,10 +170,48 @@ public:
    static Message_level get_message_level(uchar sender_id)                        { return m_msg_lvls[sender_id]; }
 
    /// Puts message info into output stream and returns stream that is automatically flushed.
-   static Common::Decorated_stream get_stream(uchar message_id, Message_level lvl);
+   /// If logging is asynchronous, returns stream of record of calling thread that is queued instead.
+   static Log_stream    get_stream(uchar message_id, Message_level lvl);
+
+   /// Returns stream for message of given LOG statement; if logging is binary, the stream encodes it.
+   static Log_stream    get_stream(uchar message_id, Message_level lvl, Log_site& site);
+
+   /// Makes LOG statements queue messages, so that they don't wait for output; background thread writes them.
+   /// Message is formatted into record of calling thread, truncated to log_record_text_size characters, and pushed
+   /// into lock-free ring (see Record_ring); writer thread formats message info, writes messages in batches
+   /// and flushes output once per batch.
+   /// Should be called after init() and not concurrently with logging, as should disable_async().
+   /// \param capacity Number of messages queue holds.
+   static void          enable_async(uint capacity, Overflow_policy policy);
+
+   /// Makes logging asynchronous and binary: records keep raw values of LOG arguments, and writer thread writes
+   /// them as they are into given stream, which should be opened in binary mode; see Binary_log.h for format.
+   /// Each LOG statement is described in the stream before its first message, so neither formatting nor copying
+   /// of literals is done per message; decode_binary_log() gives text log back.
+   /// Messages go to this stream instead of one set by init() until disable_async().
+   static void          enable_binary(std::ostream* out, uint capacity, Overflow_policy policy);
+
+   /// Writes queued messages out and returns to synchronous logging.
+   static void          disable_async();
+
+   /// Blocks until messages logged so far are written and output is flushed.
+   static void          flush();
+
+   /// Writes queued messages out by calling thread and flushes output without waiting for writer thread,
+   /// which could be stopped; intended for handlers of crashes, so that messages that lead to crash aren't lost.
+   static void          flush_on_crash();
+
+   /// \return Number of messages dropped since enable_async() as queue was full.
+   static uint          get_dropped_number();
+
+   /// Puts message info "(<timestamp>) (sender:<id>) <level>: " into stream.
+   static void          print_prefix(std::ostream& out, Timing::Milliseconds time, uchar sender_id, Message_level lvl);
 
 private:
 
+   friend class Async_writer;
+   friend class Log_stream;
+
    static const char*   to_tag(Message_level lvl);
 
 private:
@@ -90,6 +228,22 @@ private:
    static std::string    m_lvl_names[4];
    static std::ostream*  m_out;
    static Timing::Timer* m_timer;
+   /// Null unless logging is asynchronous.
+   static Async_writer*  m_async;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Makes logging asynchronous for its lifetime, so that queued messages are written before, say, main() returns.
+class Async_logging_scope : boost::noncopyable
+{
+public:
+
+   /// \see Logger::enable_async().
+   Async_logging_scope(uint capacity, Overflow_policy policy)   { Logger::enable_async(capacity, policy); }
+   // copying is disallowed
+
+   ~Async_logging_scope()                                       { Logger::disable_async(); }
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -99,10 +253,28 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#define LOG(sender_id, msg_lvl) \
-   if (msg_lvl < Engine::Logging::Logger::get_message_level(sender_id)) \
+/// Logs message unless its level is below given compile-time one or below run-time one of sender.
+/// If level of message is constant, check against compile-time level is constant too, so compiler drops statement
+/// as dead code along with its literals when message is stripped.
+#define LOG_ABOVE(compiled_lvl, sender_id, msg_lvl) \
+   if (msg_lvl < (compiled_lvl) || msg_lvl < Engine::Logging::Logger::get_message_level(sender_id)) \
    { } \
-   else Engine::Logging::Logger::get_stream(sender_id, msg_lvl)
+   else Engine::Logging::Logger::get_stream(sender_id, msg_lvl, Engine::Logging::Log_site_of<__COUNTER__>::site)
+
+#define LOG(sender_id, msg_lvl) LOG_ABOVE(Engine::Logging::compiled_message_level, sender_id, msg_lvl)
+
+/// LOG for sender whose id is compile-time constant; obeys Compiled_message_level of sender.
+#define LOG_SENDER(sender_id, msg_lvl) \
+   LOG_ABOVE(Engine::Logging::Compiled_message_level<sender_id>::value, sender_id, msg_lvl)
+
+/// Raises level below which messages of sender aren't compiled to given one, unless global level is higher.
+/// Should be used in namespace Engine::Logging before LOG_SENDER statements of sender.
+#define LOG_COMPILED_LEVEL(sender_id, msg_lvl) \
+   template <> \
+   struct Compiled_message_level<sender_id> \
+   { \
+      static const Message_level value = (msg_lvl) > compiled_message_level ? (msg_lvl) : compiled_message_level; \
+   }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
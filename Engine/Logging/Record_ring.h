@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Lock-free ring of log records written by many threads and read by one.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_LOGGING_RECORD_RING_H_INCLUDED
+#define ENGINE_LOGGING_RECORD_RING_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Timing/Timer.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+#include "boost/scoped_array.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Longest message text record keeps; longer ones are truncated. Makes slot of ring 256 bytes on 32-bit platform.
+const uint log_record_text_size = 238;
+
+/// Message logged asynchronously: prefix is kept as is and formatted by thread that writes record out.
+struct Log_record
+{
+   Timing::Milliseconds time;
+   uchar                sender_id;
+   /// Message_level.
+   uchar                level;
+   /// Number of bytes of text used; text isn't null-terminated.
+   ushort               length;
+   /// LOG statement whose arguments text keeps in binary form (see Binary_log.h); 0 if text is plain.
+   ushort               site;
+   char                 text[log_record_text_size];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Bounded queue of records: any number of threads push, single thread at a time pops.
+/// Each slot has sequence number that tells whether slot is free for push of given position or filled for pop
+/// of it; so producers only compete for position by compare-and-swap and never wait for each other or consumer.
+class Record_ring : boost::noncopyable
+{
+public:
+
+   /// \param capacity Number of records ring holds; rounded up to power of two.
+   explicit Record_ring(uint capacity);
+   // copying is disallowed
+
+   uint get_capacity() const                                                     { return m_mask + 1; }
+
+   /// Copies used part of record into ring; could be called by any thread.
+   /// \return false if ring is full.
+   bool push(const Log_record& record);
+
+   /// \return Oldest record, null if ring is empty or the oldest record isn't pushed completely yet.
+   const Log_record* get_front() const;
+
+   /// Frees slot of record returned by get_front(), so that it could be pushed again.
+   void pop();
+
+   /// \return Number of positions taken by push() so far; wraps around (see Common::get_distance()).
+   long get_pushed() const;
+
+   /// \return Number of records popped so far; wraps around.
+   long get_popped() const;
+
+private:
+
+   struct Slot
+   {
+      /// Equals to position when slot is free for push to it, to position + 1 when record is pushed.
+      volatile long sequence;
+      Log_record    record;
+   };
+
+   /// Keeps positions on separate cache lines, so producers don't slow down consumer and vice versa.
+   struct Padding
+   {
+      char bytes[64];
+   };
+
+private:
+
+   boost::scoped_array<Slot> m_slots;
+   const uint                m_mask;
+   Padding                   m_head_padding;
+   volatile long             m_head;
+   Padding                   m_tail_padding;
+   volatile long             m_tail;
+   Padding                   m_end_padding;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Logging
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_LOGGING_RECORD_RING_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,350 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Binary log encoding and decoding.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Binary_log.h"
+#include "Engine/Logging/Logging.h"
+
+#include "Common/Atomic.h"
+
+#include <algorithm>            // for std::min
+#include <cstddef>              // for offsetof
+#include <cstring>              // for std::memcpy, std::strlen
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Bytes of Log_record before text.
+const uint log_record_header_size = offsetof(Log_record, text);
+
+bool read_record(std::istream& in, Log_record& record);
+void decode_message(const std::string& descriptor, const Log_record& record, std::ostream& out);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Binary_encoder::Binary_encoder()
+   : m_site(0)
+   , m_is_describing(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Binary_encoder::begin(Timing::Milliseconds time, uchar sender_id, uchar level, Log_site& site, long generation)
+{
+   m_site = &site;
+   m_is_describing = Common::atomic_load(&site.generation) != generation;
+
+   m_record.time = time;
+   m_record.sender_id = sender_id;
+   m_record.level = level;
+   m_record.length = 0;
+   m_record.site = 0;
+
+   if (m_is_describing)
+   {
+      m_descriptor.resize(1);
+      Log_record& descriptor = m_descriptor.front();
+      descriptor.time = time;
+      descriptor.sender_id = sender_id;
+      descriptor.level = descriptor_level;
+      descriptor.length = 0;
+      descriptor.site = 0;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Binary_encoder::add_literal(const char* text)
+{
+   if (m_is_describing)
+   {
+      const size_t length = std::strlen(text);
+      describe(piece_literal, static_cast<ushort>(length));
+      add_description(text, static_cast<uint>(length));
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Binary_encoder::add(const char* text)
+{
+   if (m_is_describing)
+   {
+      describe(piece_string, 0);
+   }
+
+   const size_t length = text ? std::strlen(text) : 0;
+   const ushort room = static_cast<ushort>(log_record_text_size - m_record.length);
+   if (room >= sizeof(ushort))
+   {
+      // string that doesn't fit is truncated, as text is
+      const ushort kept = static_cast<ushort>(std::min<size_t>(length, room - sizeof(ushort)));
+      put_bytes(m_record, &kept, sizeof(kept));
+      put_bytes(m_record, text, kept);
+      if (kept < length)
+      {
+         m_record.length = log_record_text_size;
+      }
+   }
+   else
+   {
+      m_record.length = log_record_text_size;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Binary_encoder::add(const std::string& text)
+{
+   add(text.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Binary_encoder::describe(Log_piece_type type, ushort size)
+{
+   const uchar piece = static_cast<uchar>(type);
+   add_description(&piece, sizeof(piece));
+   add_description(&size, sizeof(size));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Binary_encoder::add_description(const void* data, uint size)
+{
+   const char* bytes = static_cast<const char*>(data);
+   while (size > 0)
+   {
+      if (m_descriptor.back().length == log_record_text_size)
+      {
+         m_descriptor.push_back(m_descriptor.back());
+         m_descriptor.back().length = 0;
+      }
+
+      Log_record& descriptor = m_descriptor.back();
+      const uint part = std::min(size, log_record_text_size - descriptor.length);
+      std::memcpy(descriptor.text + descriptor.length, bytes, part);
+      descriptor.length = static_cast<ushort>(descriptor.length + part);
+      bytes += part;
+      size -= part;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool put_bytes(Log_record& record, const void* data, uint size)
+{
+   if (log_record_text_size - record.length < size)
+   {
+      // nothing could be added after value that is dropped, or values that follow it are misread
+      record.length = log_record_text_size;
+      return false;
+   }
+
+   std::memcpy(record.text + record.length, data, size);
+   record.length = static_cast<ushort>(record.length + size);
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void decode_binary_log(std::istream& in, std::ostream& out)
+{
+   char magic[sizeof(binary_log_magic) - 1];
+   if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, binary_log_magic, sizeof(magic)) != 0)
+   {
+      throw std::runtime_error("Input is not binary log");
+   }
+
+   std::vector<std::string> descriptors;
+   Log_record record;
+   while (read_record(in, record))
+   {
+      if (record.level == descriptor_level)
+      {
+         if (record.site >= descriptors.size())
+         {
+            descriptors.resize(record.site + 1);
+         }
+         descriptors[record.site].append(record.text, record.length);
+         continue;
+      }
+      if (record.level > critical)
+      {
+         throw std::runtime_error("Binary log has message of unknown level");
+      }
+
+      Logger::print_prefix(out, record.time, record.sender_id, Message_level(record.level));
+      if (record.site == 0)
+      {
+         out.write(record.text, record.length);
+      }
+      else if (record.site < descriptors.size() && !descriptors[record.site].empty())
+      {
+         decode_message(descriptors[record.site], record, out);
+      }
+      else
+      {
+         throw std::runtime_error("Binary log refers to site it does not describe");
+      }
+      out << '\n';
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return false if there are no more complete records.
+bool read_record(std::istream& in, Log_record& record)
+{
+   if (!in.read(reinterpret_cast<char*>(&record), log_record_header_size) || record.length > log_record_text_size)
+   {
+      return false;
+   }
+   return in.read(record.text, record.length) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Reads values one after another; nothing is read once they run out.
+class Value_reader
+{
+public:
+
+   explicit Value_reader(const Log_record& record) : m_data(record.text), m_left(record.length) { }
+
+   /// \return false if there are less than given number of bytes left.
+   bool read(void* value, size_t size)
+   {
+      if (m_left < size)
+      {
+         m_left = 0;
+         return false;
+      }
+
+      std::memcpy(value, m_data, size);
+      m_data += size;
+      m_left -= size;
+      return true;
+   }
+
+   template <class T>
+   bool print(std::ostream& out)
+   {
+      T value;
+      if (!read(&value, sizeof(value)))
+      {
+         return false;
+      }
+      out << value;
+      return true;
+   }
+
+private:
+
+   const char* m_data;
+   size_t      m_left;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Prints pieces of descriptor, taking values of arguments from record; stops at the first one record lacks.
+void decode_message(const std::string& descriptor, const Log_record& record, std::ostream& out)
+{
+   Value_reader values(record);
+   for (size_t position = 0; position + sizeof(uchar) + sizeof(ushort) <= descriptor.size(); )
+   {
+      const uchar type = static_cast<uchar>(descriptor[position]);
+      ushort size = 0;
+      std::memcpy(&size, descriptor.data() + position + sizeof(uchar), sizeof(size));
+      position += sizeof(uchar) + sizeof(ushort);
+
+      bool is_printed = true;
+      switch (type)
+      {
+      case piece_literal:
+         // descriptor cut by crash could end with part of literal
+         is_printed = size <= descriptor.size() - position;
+         if (is_printed)
+         {
+            out.write(descriptor.data() + position, size);
+            position += size;
+         }
+         break;
+
+      case piece_string:
+         {
+            ushort length = 0;
+            char text[log_record_text_size];
+            is_printed = values.read(&length, sizeof(length)) && values.read(text, length);
+            if (is_printed)
+            {
+               out.write(text, length);
+            }
+         }
+         break;
+
+      case piece_char:
+         is_printed = values.print<char>(out);
+         break;
+
+      case piece_bool:
+         is_printed = values.print<bool>(out);
+         break;
+
+      case piece_signed:
+         is_printed = size == sizeof(short) ? values.print<short>(out)
+                    : size == sizeof(int)   ? values.print<int>(out)
+                    :                         values.print<long>(out);
+         break;
+
+      case piece_unsigned:
+         is_printed = size == sizeof(ushort) ? values.print<ushort>(out)
+                    : size == sizeof(uint)   ? values.print<uint>(out)
+                    :                          values.print<ulong>(out);
+         break;
+
+      case piece_float:
+         is_printed = values.print<float>(out);
+         break;
+
+      case piece_double:
+         is_printed = values.print<double>(out);
+         break;
+
+      default:
+         throw std::runtime_error("Binary log has unknown descriptor piece");
+      }
+
+      if (!is_printed)
+      {
+         // message or descriptor was truncated
+         return;
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Logging
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Circular_log_file implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Circular_log_file.h"
+
+#include "Common/Atomic.h"
+
+#include <algorithm>            // for std::min, std::find
+#include <cassert>
+#include <cstdio>               // for std::remove, std::rename
+#include <cstring>              // for std::memcpy, std::memcmp
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::string& keep_previous(const std::string& file_name);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Circular_log_file::Circular_log_file(const std::string& file_name, uint capacity)
+   : m_file(keep_previous(file_name), circular_log_header_size + capacity)
+   , m_buffer(m_file.get_data(), capacity)
+   , m_stream(&m_buffer)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Renames existing file to previous one, so that creating file of given name doesn't wipe it.
+/// \return file_name.
+const std::string& keep_previous(const std::string& file_name)
+{
+   const std::string previous = file_name + previous_circular_log_suffix;
+
+   // rename() doesn't replace existing file on Windows; nothing is renamed if there is no file
+   std::remove(previous.c_str());
+   std::rename(file_name.c_str(), previous.c_str());
+   return file_name;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Circular_log_file::Buffer::Buffer(uchar* file, uint capacity)
+   : m_header(*reinterpret_cast<Circular_log_header*>(file))
+   , m_text(reinterpret_cast<char*>(file) + circular_log_header_size)
+{
+   assert(sizeof(Circular_log_header) <= circular_log_header_size);
+   assert(capacity > 0);
+
+   // file is filled with zeros
+   std::memcpy(m_header.magic, circular_log_magic, sizeof(m_header.magic));
+   m_header.capacity = capacity;
+
+   // no put area, so that every write goes through xsputn() or overflow(), which move cursor
+   setp(0, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::streamsize Circular_log_file::Buffer::xsputn(const char* text, std::streamsize size)
+{
+   uint cursor = m_header.cursor;
+   for (std::streamsize left = size; left > 0; )
+   {
+      const uint part = static_cast<uint>(std::min<std::streamsize>(left, m_header.capacity - cursor));
+      std::memcpy(m_text + cursor, text, part);
+      text += part;
+      left -= part;
+
+      cursor += part;
+      if (cursor == m_header.capacity)
+      {
+         cursor = 0;
+         m_header.is_wrapped = 1;
+      }
+   }
+
+   // text up to cursor is complete; if application crashes before, reader skips partially written line
+   Common::compiler_barrier();
+   m_header.cursor = cursor;
+   return size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Circular_log_file::Buffer::int_type Circular_log_file::Buffer::overflow(int_type c)
+{
+   if (!traits_type::eq_int_type(c, traits_type::eof()))
+   {
+      const char character = traits_type::to_char_type(c);
+      xsputn(&character, 1);
+   }
+   return traits_type::not_eof(c);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void unroll_circular_log(const uchar* file, size_t size, std::ostream& out)
+{
+   const Circular_log_header& header = *reinterpret_cast<const Circular_log_header*>(file);
+   if (size < circular_log_header_size
+       || std::memcmp(header.magic, circular_log_magic, sizeof(header.magic)) != 0
+       || size - circular_log_header_size < header.capacity
+       || header.cursor >= header.capacity)
+   {
+      throw std::runtime_error("File is not circular log");
+   }
+
+   const char* const text = reinterpret_cast<const char*>(file) + circular_log_header_size;
+   const char* const cursor = text + header.cursor;
+   if (header.is_wrapped)
+   {
+      // the oldest line was partially written over
+      const char* const end = text + header.capacity;
+      const char* const oldest = std::find(cursor, end, '\n');
+      if (oldest != end)
+      {
+         out.write(oldest + 1, end - oldest - 1);
+      }
+   }
+   out.write(text, cursor - text);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Logging
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,10 +11,26 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "Engine/Logging/Logging.h"
+#include "Engine/Logging/Record_ring.h"
 
+#include "Common/Atomic.h"
+
+#include "boost/bind.hpp"
+#include "boost/scoped_ptr.hpp"
+#include "boost/thread/condition.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+#include "boost/thread/tss.hpp"
+#include "boost/thread/xtime.hpp"
+#include "boost/version.hpp"
+
+#include <cassert>
+#include <cstddef>              // for offsetof
 #include <iomanip>              // for std::setw and std::setfill
 #include <typeinfo>
 #include <algorithm>            // for std::fill
+#include <sstream>
+#include <streambuf>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -43,6 +59,127 @@ namespace Logging
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// How long writer thread sleeps when queue is empty; messages are written at least that often.
+const uint async_poll_milliseconds = 10;
+
+/// Generation of the last binary log (see Log_site); 0 is generation of no binary log.
+long binary_generation = 0;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes messages queued by LOG statements from background thread (see Logger::enable_async()).
+class Async_writer : boost::noncopyable
+{
+public:
+
+   /// \param generation Generation of binary log writer writes into given stream; 0 if log is text.
+   Async_writer(std::ostream& out, long generation, uint capacity, Overflow_policy policy);
+   // copying is disallowed
+
+   /// Stops thread and writes queued messages out.
+   ~Async_writer();
+
+   bool is_binary() const                                      { return m_generation != 0; }
+
+   /// \return Stream of record of calling thread with message info filled.
+   std::ostream& get_stream(uchar sender_id, Message_level lvl);
+
+   /// \return Encoder of calling thread with record of given site started.
+   Binary_encoder& get_encoder(uchar sender_id, Message_level lvl, Log_site& site);
+
+   /// Queues record according to overflow policy.
+   void push(const Log_record& record)                         { push(record, m_policy); }
+
+   /// Queues record of encoder, registering its site first if it isn't registered yet.
+   void push_binary(Binary_encoder& encoder);
+
+   /// \see Logger::flush().
+   void flush();
+
+   /// \see Logger::flush_on_crash().
+   void flush_on_crash();
+
+   uint get_dropped_number() const                             { return static_cast<uint>(m_dropped); }
+
+private:
+
+   void push(const Log_record& record, Overflow_policy policy);
+
+   /// Body of writer thread.
+   void run();
+
+   /// Writes out records pushed completely and flushes output if there were any.
+   void write_records();
+
+   /// Writes record as text, or as it is into binary log.
+   void write_record(const Log_record& record);
+
+private:
+
+   std::ostream&                  m_out;
+   const long                     m_generation;
+   Record_ring                    m_ring;
+   const Overflow_policy          m_policy;
+   volatile long                  m_dropped;
+   /// Dropped messages writer hasn't reported yet; used by overflow_count policy.
+   volatile long                  m_unreported;
+
+   /// Taken by thread that writes records out.
+   boost::try_mutex               m_write_mutex;
+   boost::mutex                   m_mutex;
+   boost::condition               m_wake;
+   boost::condition               m_written;
+   bool                           m_is_stopping;
+   /// Taken while site is registered.
+   boost::mutex                   m_sites_mutex;
+   /// Sites registered so far; site ids are numbered from 1.
+   ushort                         m_sites_number;
+   /// Started last, as it uses all other members.
+   boost::scoped_ptr<boost::thread> m_thread;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Put area of record message text is formatted into; flushing of stream queues record.
+/// Text that doesn't fit into record is dropped.
+class Record_buffer : public std::streambuf
+{
+public:
+
+   Record_buffer();
+
+   /// Starts new record that writer queues when stream is flushed.
+   void begin(Async_writer& writer, Timing::Milliseconds time, uchar sender_id, Message_level lvl);
+
+protected:
+
+   virtual int_type overflow(int_type c);
+   virtual int sync();
+
+private:
+
+   Async_writer* m_writer;
+   Log_record    m_record;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Stream of record and binary encoder; every thread that logs has its own.
+struct Thread_log
+{
+   Thread_log() : out(&buffer) { }
+
+   Record_buffer  buffer;
+   std::ostream   out;
+   Binary_encoder binary;
+};
+
+boost::thread_specific_ptr<Thread_log> thread_logs;
+
+Thread_log& get_thread_log();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void print_heading(std::ostream& out)
 {
    // print heading
@@ -58,12 +195,6 @@ void Logger::init(std::ostream* out, Timing::Timer* timer)
    // log all messages unless application won't change it
    set_global_message_level(trivial);
 
-   // names for message levels
-   m_lvl_names[trivial]    = "Trivial:";
-   m_lvl_names[minor]      = "Minor:  ";
-   m_lvl_names[major]      = "Major:  ";
-   m_lvl_names[critical]   = "Critical:";
-
    static Timing::No_timer dummy;
    m_timer = &dummy;
 
@@ -106,13 +237,96 @@ void Logger::set_global_message_level(Message_level lvl)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Common::Decorated_stream Logger::get_stream(uchar sender_id, Message_level lvl)
+Log_stream Logger::get_stream(uchar sender_id, Message_level lvl)
+{
+   if (m_async)
+   {
+      return Log_stream(m_async->get_stream(sender_id, lvl));
+   }
+
+   print_prefix(*m_out, m_timer->get_app_time(), sender_id, lvl);
+   return Log_stream(*m_out);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Log_stream Logger::get_stream(uchar sender_id, Message_level lvl, Log_site& site)
+{
+   if (m_async && m_async->is_binary())
+   {
+      return Log_stream(m_async->get_encoder(sender_id, lvl, site));
+   }
+
+   return get_stream(sender_id, lvl);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Logger::enable_async(uint capacity, Overflow_policy policy)
+{
+   disable_async();
+   m_async = new Async_writer(*m_out, 0, capacity, policy);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Logger::enable_binary(std::ostream* out, uint capacity, Overflow_policy policy)
+{
+   assert(out && "Binary log needs stream of its own");
+
+   disable_async();
+   m_async = new Async_writer(*out, ++binary_generation, capacity, policy);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Logger::disable_async()
+{
+   delete m_async;
+   m_async = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Logger::flush()
+{
+   if (m_async)
+   {
+      m_async->flush();
+   }
+   else
+   {
+      m_out->flush();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Logger::flush_on_crash()
 {
-   // prepend message with "(<timestamp>) (sender:<id>) <level>: " info
-   *m_out << '(' << std::setw(8) << std::setfill('0') << m_timer->get_app_time() << ')'
-          << " (sender:" << std::setw(3) << std::setfill('0') << static_cast<int>(sender_id) << ") " << to_tag(lvl) << " ";
+   if (m_async)
+   {
+      m_async->flush_on_crash();
+   }
+   else if (m_out)
+   {
+      m_out->flush();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint Logger::get_dropped_number()
+{
+   return m_async ? m_async->get_dropped_number() : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-   return *m_out;
+void Logger::print_prefix(std::ostream& out, Timing::Milliseconds time, uchar sender_id, Message_level lvl)
+{
+   out << '(' << std::setw(8) << std::setfill('0') << time << ')'
+       << " (sender:" << std::setw(3) << std::setfill('0') << static_cast<int>(sender_id) << ") " << to_tag(lvl) << " ";
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -124,11 +338,317 @@ const char* Logger::to_tag(Message_level lvl)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Async_writer::Async_writer(std::ostream& out, long generation, uint capacity, Overflow_policy policy)
+   : m_out(out)
+   , m_generation(generation)
+   , m_ring(capacity)
+   , m_policy(policy)
+   , m_dropped(0)
+   , m_unreported(0)
+   , m_is_stopping(false)
+   , m_sites_number(0)
+{
+   if (is_binary())
+   {
+      m_out.write(binary_log_magic, sizeof(binary_log_magic) - 1);
+   }
+   m_thread.reset(new boost::thread(boost::bind(&Async_writer::run, this)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Async_writer::~Async_writer()
+{
+   {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_is_stopping = true;
+      m_wake.notify_one();
+   }
+   m_thread->join();
+
+   // records pushed after the last batch of thread
+   write_records();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::ostream& Async_writer::get_stream(uchar sender_id, Message_level lvl)
+{
+   Thread_log& log = get_thread_log();
+   log.buffer.begin(*this, Logger::m_timer->get_app_time(), sender_id, lvl);
+   return log.out;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Binary_encoder& Async_writer::get_encoder(uchar sender_id, Message_level lvl, Log_site& site)
+{
+   Binary_encoder& encoder = get_thread_log().binary;
+   encoder.begin(Logger::m_timer->get_app_time(), sender_id, static_cast<uchar>(lvl), site, m_generation);
+   return encoder;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Async_writer::push_binary(Binary_encoder& encoder)
+{
+   Log_site& site = encoder.get_site();
+   if (encoder.is_describing())
+   {
+      boost::mutex::scoped_lock lock(m_sites_mutex);
+      // other thread could register site meanwhile
+      if (Common::atomic_load(&site.generation) != m_generation)
+      {
+         assert(m_sites_number < 0xFFFF && "Too many LOG statements for binary log");
+         site.id = ++m_sites_number;
+
+         // messages can't be decoded without descriptor, so it is never dropped
+         std::vector<Log_record>& descriptor = encoder.get_descriptor();
+         for (size_t i = 0; i < descriptor.size(); ++i)
+         {
+            descriptor[i].site = site.id;
+            push(descriptor[i], overflow_block);
+         }
+         Common::atomic_store(&site.generation, m_generation);
+      }
+   }
+
+   Log_record& record = encoder.get_record();
+   record.site = site.id;
+   push(record);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Async_writer::push(const Log_record& record, Overflow_policy policy)
+{
+   while (!m_ring.push(record))
+   {
+      if (policy != overflow_block)
+      {
+         Common::atomic_increment(&m_dropped);
+         if (policy == overflow_count)
+         {
+            Common::atomic_increment(&m_unreported);
+         }
+         return;
+      }
+
+      m_wake.notify_one();
+      boost::thread::yield();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Async_writer::flush()
+{
+   const long pushed = m_ring.get_pushed();
+
+   boost::mutex::scoped_lock lock(m_mutex);
+   m_wake.notify_one();
+   while (Common::get_distance(m_ring.get_popped(), pushed) > 0)
+   {
+      m_written.wait(lock);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Async_writer::flush_on_crash()
+{
+   // writer thread could crash while it holds the lock; records it didn't write are lost then
+   boost::try_mutex::scoped_try_lock lock(m_write_mutex);
+   if (lock)
+   {
+      lock.unlock();
+      write_records();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Async_writer::run()
+{
+   boost::mutex::scoped_lock lock(m_mutex);
+   while (!m_is_stopping)
+   {
+      lock.unlock();
+      write_records();
+      lock.lock();
+      m_written.notify_all();
+
+      // new records could be pushed while previous ones were written
+      if (!m_is_stopping && !m_ring.get_front())
+      {
+         boost::xtime wake_time;
+#if BOOST_VERSION >= 105000
+         // TIME_UTC was renamed, as it clashes with macro of C11 <time.h>
+         boost::xtime_get(&wake_time, boost::TIME_UTC_);
+#else
+         boost::xtime_get(&wake_time, boost::TIME_UTC);
+#endif
+         wake_time.nsec += async_poll_milliseconds * 1000000;
+         if (wake_time.nsec >= 1000000000)
+         {
+            ++wake_time.sec;
+            wake_time.nsec -= 1000000000;
+         }
+         m_wake.timed_wait(lock, wake_time);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Async_writer::write_records()
+{
+   boost::try_mutex::scoped_lock lock(m_write_mutex);
+
+   const long unreported = Common::atomic_take(&m_unreported);
+   if (unreported > 0)
+   {
+      std::ostringstream text;
+      text << "!!! " << unreported << " messages dropped as log queue is full !!!";
+
+      Log_record report;
+      report.time = Logger::m_timer->get_app_time();
+      report.sender_id = 0;
+      report.level = critical;
+      report.length = 0;
+      report.site = 0;
+      put_bytes(report, text.str().data(), static_cast<uint>(text.str().size()));
+      write_record(report);
+   }
+
+   bool is_written = unreported > 0;
+   while (const Log_record* record = m_ring.get_front())
+   {
+      write_record(*record);
+      m_ring.pop();
+      is_written = true;
+   }
+
+   if (is_written)
+   {
+      m_out.flush();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Async_writer::write_record(const Log_record& record)
+{
+   if (is_binary())
+   {
+      m_out.write(reinterpret_cast<const char*>(&record), offsetof(Log_record, text) + record.length);
+      return;
+   }
+
+   Logger::print_prefix(m_out, record.time, record.sender_id, Message_level(record.level));
+   m_out.write(record.text, record.length);
+   m_out << '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Log_stream::Log_stream(const Log_stream& other)
+   : m_out(other.m_out)
+   , m_binary(other.m_binary)
+   , m_is_ending(other.m_is_ending)
+{
+   other.m_is_ending = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Log_stream::~Log_stream()
+{
+   if (!m_is_ending)
+   {
+      return;
+   }
+
+   if (m_binary)
+   {
+      Logger::m_async->push_binary(*m_binary);
+   }
+   else
+   {
+      *m_out << std::endl;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Record_buffer::Record_buffer()
+   : m_writer(0)
+{
+   setp(m_record.text, m_record.text + log_record_text_size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Record_buffer::begin(Async_writer& writer, Timing::Milliseconds time, uchar sender_id, Message_level lvl)
+{
+   m_writer           = &writer;
+   m_record.time      = time;
+   m_record.sender_id = sender_id;
+   m_record.level     = static_cast<uchar>(lvl);
+   m_record.site      = 0;
+   setp(m_record.text, m_record.text + log_record_text_size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Record_buffer::int_type Record_buffer::overflow(int_type c)
+{
+   // text is truncated, but stream stays good
+   return traits_type::not_eof(c);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int Record_buffer::sync()
+{
+   // Log_stream ends message with std::endl, which writes new-line before flush; writer adds its own
+   ushort length = static_cast<ushort>(pptr() - pbase());
+   if (length > 0 && m_record.text[length - 1] == '\n')
+   {
+      --length;
+   }
+
+   if (m_writer)
+   {
+      m_record.length = length;
+      m_writer->push(m_record);
+   }
+   setp(m_record.text, m_record.text + log_record_text_size);
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Thread_log of calling thread, created on its first message.
+Thread_log& get_thread_log()
+{
+   Thread_log* log = thread_logs.get();
+   if (!log)
+   {
+      log = new Thread_log;
+      thread_logs.reset(log);
+   }
+   return *log;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // definition of static members
 Message_level Logger::m_msg_lvls[m_senders_num];
 std::ostream* Logger::m_out;
-std::string Logger::m_lvl_names[4];
+std::string Logger::m_lvl_names[4] = { "Trivial:", "Minor:  ", "Major:  ", "Critical:" };
 Timing::Timer* Logger::m_timer;
+Async_writer* Logger::m_async;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Record_ring implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Record_ring.h"
+
+#include "Common/Atomic.h"
+
+#include <cassert>
+#include <cstddef>              // for offsetof
+#include <cstring>              // for std::memcpy
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint get_ring_capacity(uint capacity);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Record_ring::Record_ring(uint capacity)
+   : m_slots(new Slot[get_ring_capacity(capacity)])
+   , m_mask(get_ring_capacity(capacity) - 1)
+   , m_head(0)
+   , m_tail(0)
+{
+   for (uint i = 0; i <= m_mask; ++i)
+   {
+      m_slots[i].sequence = i;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Record_ring::push(const Log_record& record)
+{
+   assert(record.length <= log_record_text_size);
+
+   long position = Common::atomic_load(&m_head);
+   for (;;)
+   {
+      Slot& slot = m_slots[position & m_mask];
+      const long distance = Common::get_distance(position, Common::atomic_load(&slot.sequence));
+      if (distance < 0)
+      {
+         // slot still keeps record pushed one lap ago
+         return false;
+      }
+
+      if (distance == 0)
+      {
+         const long head = Common::atomic_compare_exchange(&m_head, position + 1, position);
+         if (head == position)
+         {
+            std::memcpy(&slot.record, &record, offsetof(Log_record, text) + record.length);
+            Common::atomic_store(&slot.sequence, position + 1);
+            return true;
+         }
+         position = head;
+      }
+      else
+      {
+         // other producer took position
+         position = Common::atomic_load(&m_head);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Log_record* Record_ring::get_front() const
+{
+   const Slot& slot = m_slots[m_tail & m_mask];
+   return Common::atomic_load(&slot.sequence) == m_tail + 1 ? &slot.record : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Record_ring::pop()
+{
+   Slot& slot = m_slots[m_tail & m_mask];
+   assert(slot.sequence == m_tail + 1 && "Nothing to pop");
+   Common::atomic_store(&slot.sequence, m_tail + m_mask + 1);
+   Common::atomic_store(&m_tail, m_tail + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+long Record_ring::get_pushed() const
+{
+   return Common::atomic_load(&m_head);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+long Record_ring::get_popped() const
+{
+   return Common::atomic_load(&m_tail);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return The least power of two that isn't less than given capacity.
+uint get_ring_capacity(uint capacity)
+{
+   uint result = 1;
+   while (result < capacity)
+   {
+      result *= 2;
+   }
+   return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Logging
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for Circular_log_file.
+// Note that due to static (non-object) nature of Logger, each unit-test should be separate application.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Circular_log_file.h"
+#include "Engine/Logging/Logging.h"
+#include "Dummy_timer.h"
+
+#include "Common/Mapped_file.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>               // for std::remove
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace Engine::Logging;
+using namespace Engine::Timing;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const file_name = "Circular_log_file_test.log";
+
+const string previous_file_name = string(file_name) + previous_circular_log_suffix;
+
+/// \return Text of circular log file in chronological order.
+string unroll(const string& name = file_name)
+{
+   const Common::Mapped_file file(name);
+   ostringstream out;
+   unroll_circular_log(file.get_data(), file.get_size(), out);
+   return out.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// File keeps all text until it is full.
+void test_not_full()
+{
+   {
+      Circular_log_file log(file_name, 100);
+      log.get_stream() << "first line" << endl << "second " << 2 << '\n';
+   }
+   BOOST_CHECK_EQUAL(unroll(), "first line\nsecond 2\n");
+
+   {
+      Circular_log_file log(file_name, 100);
+   }
+   BOOST_CHECK_EQUAL(unroll(), "");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// File of previous run is kept, and file of the run before it is dropped.
+void test_previous_kept()
+{
+   {
+      Circular_log_file log(file_name, 100);
+      log.get_stream() << "first run" << endl;
+   }
+   {
+      Circular_log_file log(file_name, 100);
+      log.get_stream() << "second run" << endl;
+   }
+   BOOST_CHECK_EQUAL(unroll(), "second run\n");
+   BOOST_CHECK_EQUAL(unroll(previous_file_name), "first run\n");
+
+   {
+      Circular_log_file log(file_name, 100);
+   }
+   BOOST_CHECK_EQUAL(unroll(), "");
+   BOOST_CHECK_EQUAL(unroll(previous_file_name), "second run\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Full file keeps the last lines that fit.
+void test_wrapped()
+{
+   ostringstream all;
+   {
+      Circular_log_file log(file_name, 64);
+      for (int i = 0; i < 100; ++i)
+      {
+         log.get_stream() << "line " << i << '\n';
+         all << "line " << i << '\n';
+      }
+   }
+
+   // 64 bytes keep lines 92..99, the first of which is partially written over
+   string tail;
+   for (int i = 93; i < 100; ++i)
+   {
+      ostringstream line;
+      line << "line " << i << '\n';
+      tail += line.str();
+   }
+   BOOST_CHECK_EQUAL(unroll(), tail);
+
+   // text longer than file
+   {
+      Circular_log_file log(file_name, 16);
+      log.get_stream() << string(40, 'a') << '\n' << "0123456789" << '\n' << "tail";
+   }
+   BOOST_CHECK_EQUAL(unroll(), "0123456789\ntail");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Logger writes into file without buffering; file keeps the last messages in the same format.
+void test_logger()
+{
+   {
+      Circular_log_file log(file_name, 4096);
+      Dummy_timer timer;
+      Logger::init(&log.get_stream(), &timer);
+      for (int i = 0; i < 1000; ++i)
+      {
+         LOG(1, major) << "Message " << i;
+      }
+
+      // messages are in file as soon as writer thread writes them out
+      Logger::enable_async(16, overflow_block);
+      LOG(1, major) << "Queued";
+      Logger::flush();
+      BOOST_CHECK(unroll().find("Queued") != string::npos);
+      Logger::disable_async();
+
+      Logger::init(0, 0);
+   }
+
+   istringstream text(unroll());
+   BOOST_CHECK(text.str().size() > 4096 - 40);
+
+   // the last messages follow each other
+   vector<string> lines;
+   for (string line; getline(text, line); )
+   {
+      lines.push_back(line);
+   }
+   BOOST_REQUIRE(lines.size() > 1);
+   BOOST_CHECK_EQUAL(lines.back(), "(00001001) (sender:001) Major:   Queued");
+   for (size_t i = 0; i + 1 < lines.size(); ++i)
+   {
+      const int message = 1000 - int(lines.size() - 1) + int(i);
+      ostringstream etalon;
+      etalon << '(' << setw(8) << setfill('0') << message + 1 << ") (sender:001) Major:   Message " << message;
+      BOOST_CHECK_EQUAL(lines[i], etalon.str());
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Reader rejects other files.
+void test_bad_file()
+{
+   const string text = "(00000001) (sender:001) Major:   Text\n";
+   ostringstream out;
+   BOOST_CHECK_THROW(unroll_circular_log(reinterpret_cast<const uchar*>(text.data()), text.size(), out),
+                     runtime_error);
+   remove(file_name);
+   remove(previous_file_name.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Circular_log_file");
+   test->add(BOOST_TEST_CASE(test_not_full));
+   test->add(BOOST_TEST_CASE(test_previous_kept));
+   test->add(BOOST_TEST_CASE(test_wrapped));
+   test->add(BOOST_TEST_CASE(test_logger));
+   test->add(BOOST_TEST_CASE(test_bad_file));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-test for asynchronous logging of Engine.Logging.
+// Note that due to static (non-object) nature of Logger, each unit-test should be separate application.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Logging/Record_ring.h"
+#include "Dummy_timer.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include "boost/bind.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace Engine::Logging;
+using namespace Engine::Timing;
+using boost::lexical_cast;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ostringstream strout;
+Dummy_timer timer;
+
+/// \return Output written after given position.
+string get_output_since(size_t position)
+{
+   return strout.str().substr(position);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Queued messages are written the same way synchronous ones are, once flushed.
+void test_output()
+{
+   const size_t start = strout.str().size();
+   Logger::enable_async(16, overflow_block);
+
+   LOG(0, trivial) << "Message" << 0;
+   LOG(1, minor) << "Message" << 1;
+   LOG(2, major) << "Message" << 2.5;
+   LOG(3, critical) << "Message3";
+   Logger::flush();
+
+   // message info is taken when message is logged, and written by writer thread
+   const string etalon =
+      "(00000001) (sender:000) Trivial: Message0\n"
+      "(00000002) (sender:001) Minor:   Message1\n"
+      "(00000003) (sender:002) Major:   Message2.5\n"
+      "(00000004) (sender:003) Critical: Message3\n"
+      ;
+   BOOST_CHECK_EQUAL(get_output_since(start), etalon);
+
+   // long message is truncated
+   const size_t long_start = strout.str().size();
+   LOG(0, major) << string(log_record_text_size, 'a') << "bbb";
+   Logger::flush();
+   BOOST_CHECK_EQUAL(get_output_since(long_start),
+                     "(00000005) (sender:000) Major:   " + string(log_record_text_size, 'a') + "\n");
+
+   // the next messages are written right away
+   Logger::disable_async();
+   const size_t sync_start = strout.str().size();
+   LOG(0, major) << "Synchronous";
+   BOOST_CHECK_EQUAL(get_output_since(sync_start), "(00000006) (sender:000) Major:   Synchronous\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint threads_number = 4;
+const uint messages_per_thread = 2000;
+
+void log_messages(uchar thread)
+{
+   for (uint i = 0; i < messages_per_thread; ++i)
+   {
+      LOG(thread, minor) << "message " << i;
+   }
+}
+
+/// \return Lines written after given position.
+vector<string> get_lines_since(size_t position)
+{
+   vector<string> lines;
+   istringstream in(get_output_since(position));
+   for (string line; getline(in, line); )
+   {
+      lines.push_back(line);
+   }
+   return lines;
+}
+
+/// Messages of several threads are kept in order with block policy, so none is lost though queue is short.
+void test_block()
+{
+   const size_t start = strout.str().size();
+   Logger::enable_async(4, overflow_block);
+
+   boost::thread_group threads;
+   for (uint i = 0; i < threads_number; ++i)
+   {
+      threads.create_thread(boost::bind(log_messages, uchar(i)));
+   }
+   threads.join_all();
+   BOOST_CHECK_EQUAL(Logger::get_dropped_number(), 0u);
+   Logger::disable_async();
+
+   const vector<string> lines = get_lines_since(start);
+   BOOST_REQUIRE_EQUAL(lines.size(), threads_number*messages_per_thread);
+
+   vector<uint> next(threads_number, 0);
+   for (size_t i = 0; i < lines.size(); ++i)
+   {
+      const uint thread = lexical_cast<uint>(lines[i].substr(lines[i].find("sender:") + 7, 3));
+      BOOST_REQUIRE(thread < threads_number);
+      BOOST_REQUIRE_EQUAL(lines[i].substr(lines[i].find("message")), "message " + lexical_cast<string>(next[thread]));
+      ++next[thread];
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// With count policy every message is either written or counted as dropped, and all dropped ones are reported.
+void test_count()
+{
+   const size_t start = strout.str().size();
+   Logger::enable_async(4, overflow_count);
+
+   boost::thread_group threads;
+   for (uint i = 0; i < threads_number; ++i)
+   {
+      threads.create_thread(boost::bind(log_messages, uchar(i)));
+   }
+   threads.join_all();
+   const uint dropped = Logger::get_dropped_number();
+   Logger::disable_async();
+
+   const vector<string> lines = get_lines_since(start);
+   uint written = 0;
+   uint reported = 0;
+   for (size_t i = 0; i < lines.size(); ++i)
+   {
+      const size_t report = lines[i].find("!!! ");
+      if (report == string::npos)
+      {
+         ++written;
+         continue;
+      }
+
+      istringstream in(lines[i].substr(report + 4));
+      uint number = 0;
+      in >> number;
+      reported += number;
+   }
+   BOOST_CHECK_EQUAL(reported, dropped);
+   BOOST_CHECK_EQUAL(written + dropped, threads_number*messages_per_thread);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   Logger::init(&strout, &timer);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Logging_async");
+   test->add(BOOST_TEST_CASE(test_output));
+   test->add(BOOST_TEST_CASE(test_block));
+   test->add(BOOST_TEST_CASE(test_count));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
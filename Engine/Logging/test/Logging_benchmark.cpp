@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compares time LOG statement takes from caller with synchronous, asynchronous and binary logging into file,
+// synchronous logging into circular log file, and with message filtered at run time or stripped at compile time.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Logging/Circular_log_file.h"
+
+#include "Engine/Timing/Stopwatch.h"
+
+#include <cstdio>               // for std::remove
+#include <fstream>
+#include <iostream>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+const uchar sender_stripped = 1;
+LOG_COMPILED_LEVEL(sender_stripped, minor);
+
+namespace Logging_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint messages_number = 200000;
+const char* const log_file = "logging_benchmark.log";
+const char* const binary_log_file = "logging_benchmark.blog";
+const char* const circular_log_file = "logging_benchmark.ring";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Logs messages like ones window logs every frame.
+/// \return Seconds caller spent.
+double log_messages()
+{
+   Timing::Stopwatch stopwatch;
+   for (uint i = 0; i < messages_number; ++i)
+   {
+      LOG(0, trivial) << "(Handling window messages) " << i;
+   }
+   return stopwatch.get_elapsed();
+}
+
+/// Logs the same messages with sender whose trivial messages aren't compiled.
+double log_stripped_messages()
+{
+   Timing::Stopwatch stopwatch;
+   for (uint i = 0; i < messages_number; ++i)
+   {
+      LOG_SENDER(sender_stripped, trivial) << "(Handling window messages) " << i;
+   }
+   return stopwatch.get_elapsed();
+}
+
+void print(const char* name, double seconds)
+{
+   cout << name << ": " << seconds * 1e9 / messages_number << " ns per message" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   cout << messages_number << " messages into " << log_file << endl;
+
+   ofstream out(log_file);
+   Logger::init(&out, 0);
+
+   const streamoff start = out.tellp();
+   print("Synchronous", log_messages());
+   const streamoff text_size = out.tellp() - start;
+
+   Logger::enable_async(4096, overflow_block);
+   print("Asynchronous, blocking when queue is full", log_messages());
+   const Timing::Stopwatch flush;
+   Logger::flush();
+   cout << "  then writer needed " << flush.get_elapsed() * 1000 << " ms more" << endl;
+   Logger::disable_async();
+
+   Logger::enable_async(4096, overflow_drop);
+   print("Asynchronous, dropping when queue is full", log_messages());
+   cout << "  " << Logger::get_dropped_number() << " messages dropped" << endl;
+   Logger::disable_async();
+
+   ofstream binary_out(binary_log_file, ios::binary);
+   Logger::enable_binary(&binary_out, 4096, overflow_block);
+   print("Binary, blocking when queue is full", log_messages());
+   const Timing::Stopwatch binary_flush;
+   Logger::flush();
+   cout << "  then writer needed " << binary_flush.get_elapsed() * 1000 << " ms more" << endl;
+   Logger::disable_async();
+   cout << "  " << binary_out.tellp() / messages_number << " bytes per message vs "
+        << text_size / messages_number << " bytes of text" << endl;
+
+   {
+      // every message is in file as soon as it is logged, as with flushing of file stream
+      Circular_log_file circle(circular_log_file, 1 << 20);
+      Logger::init(&circle.get_stream(), 0);
+      print("Synchronous into circular log file", log_messages());
+      Logger::init(&out, 0);
+   }
+
+   Logger::set_message_level(0, minor);
+   print("Filtered at run time", log_messages());
+   print("Stripped at compile time", log_stripped_messages());
+
+   out.close();
+   binary_out.close();
+   remove(log_file);
+   remove(binary_log_file);
+   remove(circular_log_file);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Logging_benchmark
+} // namespace Logging
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Logging::Logging_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
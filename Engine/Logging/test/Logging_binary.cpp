@@ -0,0 +1,234 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-test for binary logging of Engine.Logging.
+// Note that due to static (non-object) nature of Logger, each unit-test should be separate application.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Logging/Binary_log.h"
+#include "Dummy_timer.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstddef>              // for offsetof
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace Engine::Logging;
+using namespace Engine::Timing;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ostringstream strout;
+Dummy_timer timer;
+
+/// Value formatted by its own operator<<.
+struct Point
+{
+   int x;
+   int y;
+};
+
+ostream& operator<<(ostream& out, const Point& point)
+{
+   return out << '[' << point.x << ", " << point.y << ']';
+}
+
+/// Logs values of all kinds binary log keeps.
+void log_messages()
+{
+   const string name = "banana";
+   char buffer[16] = "stain";
+   const char* text = "cstr";
+   const Point point = { 3, -4 };
+
+   LOG(1, trivial) << "Loaded " << name << " (" << 64 << 'x' << 64u << ")";
+   LOG(1, minor) << buffer << ' ' << text << '|';
+   LOG(1, major) << "short " << short(-7) << ", long " << -100000L << ", ulong " << 4000000000UL;
+   LOG(2, critical) << "bool " << true << ", float " << 0.5f << ", double " << 2.25 << ", char " << uchar('u');
+   LOG(1, major) << "Point " << point;
+   Logger::get_stream(1, minor) << "Plain text " << 42;
+}
+
+/// \return Binary log of messages, written into stream of its own.
+string write_binary_log(uint capacity)
+{
+   ostringstream out(ios::binary);
+   Logger::enable_binary(&out, capacity, overflow_block);
+   log_messages();
+   Logger::disable_async();
+   return out.str();
+}
+
+string decode(const string& log)
+{
+   istringstream in(log, ios::binary);
+   ostringstream out;
+   decode_binary_log(in, out);
+   return out.str();
+}
+
+/// \return Lines of log without timestamps.
+vector<string> get_messages(const string& log)
+{
+   vector<string> messages;
+   istringstream in(log);
+   for (string line; getline(in, line); )
+   {
+      messages.push_back(line.substr(line.find(')') + 2));
+   }
+   return messages;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Decoded log is the same as text one, but for timestamps.
+void test_decode()
+{
+   const size_t start = strout.str().size();
+   log_messages();
+   const vector<string> etalon = get_messages(strout.str().substr(start));
+
+   const size_t binary_start = strout.str().size();
+   const Milliseconds first_time = timer.get_app_time() + 1;
+   const string decoded = decode(write_binary_log(4));
+   BOOST_CHECK_EQUAL(strout.str().size(), binary_start);
+
+   const vector<string> messages = get_messages(decoded);
+   BOOST_CHECK_EQUAL_COLLECTIONS(messages.begin(), messages.end(), etalon.begin(), etalon.end());
+   BOOST_REQUIRE_EQUAL(messages.size(), 6u);
+   BOOST_CHECK_EQUAL(messages[0], "(sender:001) Trivial: Loaded banana (64x64)");
+   BOOST_CHECK_EQUAL(messages[3], "(sender:002) Critical: bool 1, float 0.5, double 2.25, char u");
+
+   // timestamps are ones of messages
+   istringstream in(decoded);
+   string line;
+   getline(in, line);
+   ostringstream timestamp;
+   timestamp << '(' << setw(8) << setfill('0') << first_time << ") ";
+   BOOST_CHECK_EQUAL(line.substr(0, 11), timestamp.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Each binary log describes statements it has messages of, and literals aren't copied by messages.
+void test_generations()
+{
+   const string first = write_binary_log(16);
+   const string second = write_binary_log(16);
+   BOOST_CHECK_EQUAL(get_messages(decode(second)).size(), 6u);
+   BOOST_CHECK_EQUAL(second.size(), first.size());
+   BOOST_CHECK(second.find("short ") != string::npos);
+
+   // messages of described statement keep only values
+   ostringstream out(ios::binary);
+   Logger::enable_binary(&out, 16, overflow_block);
+   size_t first_size = 0;
+   for (int i = 1; i < 10; ++i)
+   {
+      LOG(1, major) << "Frame " << i;
+      if (i == 1)
+      {
+         Logger::flush();
+         first_size = out.str().size();
+      }
+   }
+   Logger::disable_async();
+   BOOST_CHECK_EQUAL(out.str().find("Frame "), out.str().rfind("Frame "));
+   BOOST_CHECK_EQUAL(out.str().size() - first_size, 8*(offsetof(Log_record, text) + sizeof(int)));
+   BOOST_CHECK_EQUAL(get_messages(decode(out.str())).back(), "(sender:001) Major:   Frame 9");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Values that don't fit into record are dropped, the same way text is truncated.
+void test_truncation()
+{
+   ostringstream out(ios::binary);
+   Logger::enable_binary(&out, 16, overflow_block);
+   LOG(1, major) << "Long " << string(log_record_text_size, 'a') << 12345;
+   LOG(1, major) << string(log_record_text_size - 3, 'b') << 12345 << "end";
+   Logger::disable_async();
+
+   const vector<string> messages = get_messages(decode(out.str()));
+   BOOST_REQUIRE_EQUAL(messages.size(), 2u);
+   BOOST_CHECK_EQUAL(messages[0], "(sender:001) Major:   Long " + string(log_record_text_size - 2, 'a'));
+   BOOST_CHECK_EQUAL(messages[1], "(sender:001) Major:   " + string(log_record_text_size - 3, 'b'));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Descriptor of statement with many pieces spans several records.
+void test_long_descriptor()
+{
+   const size_t start = strout.str().size();
+   for (int binary = 0; binary < 2; ++binary)
+   {
+      ostringstream out(ios::binary);
+      if (binary)
+      {
+         Logger::enable_binary(&out, 16, overflow_block);
+      }
+      LOG(1, major) << "The first piece of long statement " << 1 << ", the second piece of long statement " << 2
+                    << ", the third piece of long statement " << 3 << ", the fourth piece of long statement " << 4
+                    << ", the fifth piece of long statement " << 5 << ", the sixth piece of long statement " << 6
+                    << ", the last one";
+      if (binary)
+      {
+         Logger::disable_async();
+         const vector<string> messages = get_messages(decode(out.str()));
+         BOOST_REQUIRE_EQUAL(messages.size(), 1u);
+         BOOST_CHECK_EQUAL(messages[0], get_messages(strout.str().substr(start)).at(0));
+         BOOST_CHECK(messages[0].find(", the last one") != string::npos);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Decoder rejects text log and stops at incomplete record.
+void test_bad_input()
+{
+   BOOST_CHECK_THROW(decode("(00000001) (sender:001) Major:   Text"), runtime_error);
+
+   const string log = write_binary_log(16);
+   BOOST_CHECK_EQUAL(get_messages(decode(log.substr(0, log.size() - 1))).size(), 5u);
+
+   // plain record of unknown level
+   Log_record record = Log_record();
+   record.level = critical + 1;
+   const string bad_level = string(binary_log_magic, sizeof(binary_log_magic) - 1)
+                          + string(reinterpret_cast<const char*>(&record), offsetof(Log_record, text));
+   BOOST_CHECK_THROW(decode(bad_level), runtime_error);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   Logger::init(&strout, &timer);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Logging_binary");
+   test->add(BOOST_TEST_CASE(test_decode));
+   test->add(BOOST_TEST_CASE(test_generations));
+   test->add(BOOST_TEST_CASE(test_truncation));
+   test->add(BOOST_TEST_CASE(test_long_descriptor));
+   test->add(BOOST_TEST_CASE(test_bad_input));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
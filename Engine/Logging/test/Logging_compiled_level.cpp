@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-test for compile-time message levels of Engine.Logging.
+// Built with ENGINE_LOGGING_MIN_LEVEL set to minor (see Jamfile).
+// Note that due to static (non-object) nature of Logger, each unit-test should be separate application.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Logging.h"
+#include "Dummy_timer.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <sstream>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Logging
+{
+
+const uchar sender_stripped = 5;
+LOG_COMPILED_LEVEL(sender_stripped, major);
+
+/// Global level is kept for sender with lower one.
+const uchar sender_lowered = 6;
+LOG_COMPILED_LEVEL(sender_lowered, trivial);
+
+}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace Engine::Logging;
+using namespace Engine::Timing;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ostringstream strout;
+Dummy_timer timer;
+
+int evaluated_number = 0;
+
+/// Counts evaluations of arguments of messages that shouldn't be logged.
+int evaluate()
+{
+   return ++evaluated_number;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Messages below compile-time levels aren't logged whatever run-time levels are; run-time levels filter others.
+void test_compiled_level()
+{
+   // levels are compared as values, as they are only declared
+   BOOST_CHECK(compiled_message_level == minor);
+   BOOST_CHECK(Compiled_message_level<0>::value == minor);
+   BOOST_CHECK(Compiled_message_level<sender_stripped>::value == major);
+   BOOST_CHECK(Compiled_message_level<sender_lowered>::value == minor);
+
+   const size_t start = strout.str().size();
+
+   LOG(0, trivial) << "Stripped " << evaluate();
+   LOG(0, minor) << "Message0";
+
+   LOG_SENDER(sender_stripped, minor) << "Stripped " << evaluate();
+   // LOG obeys global level only
+   LOG(sender_stripped, minor) << "Message1";
+   LOG_SENDER(sender_stripped, major) << "Message2";
+
+   LOG_SENDER(sender_lowered, trivial) << "Stripped " << evaluate();
+   LOG_SENDER(sender_lowered, minor) << "Message3";
+
+   Logger::set_message_level(sender_stripped, critical);
+   LOG_SENDER(sender_stripped, major) << "Filtered " << evaluate();
+   LOG_SENDER(sender_stripped, critical) << "Message4";
+
+   // level known at run time only is checked at run time
+   Message_level lvl = trivial;
+   LOG_SENDER(sender_lowered, lvl) << "Stripped " << evaluate();
+   lvl = major;
+   LOG_SENDER(sender_lowered, lvl) << "Message5";
+
+   BOOST_CHECK_EQUAL(evaluated_number, 0);
+
+   const string etalon =
+      "(00000001) (sender:000) Minor:   Message0\n"
+      "(00000002) (sender:005) Minor:   Message1\n"
+      "(00000003) (sender:005) Major:   Message2\n"
+      "(00000004) (sender:006) Minor:   Message3\n"
+      "(00000005) (sender:005) Critical: Message4\n"
+      "(00000006) (sender:006) Major:   Message5\n"
+      ;
+   BOOST_CHECK_EQUAL(strout.str().substr(start), etalon);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   Logger::init(&strout, &timer);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Logging_compiled_level");
+   test->add(BOOST_TEST_CASE(test_compiled_level));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for Record_ring.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Record_ring.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace Engine::Logging;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Log_record make_record(uchar sender_id, int time, const string& text)
+{
+   Log_record record;
+   record.time = time;
+   record.sender_id = sender_id;
+   record.level = 0;
+   record.length = static_cast<ushort>(text.size());
+   record.site = 0;
+   memcpy(record.text, text.data(), text.size());
+   return record;
+}
+
+string get_text(const Log_record& record)
+{
+   return string(record.text, record.length);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Records are popped in order they are pushed; push fails only when ring is full.
+void test_order()
+{
+   Record_ring ring(3);
+   BOOST_CHECK_EQUAL(ring.get_capacity(), 4u);
+   BOOST_CHECK(!ring.get_front());
+
+   for (int i = 0; i < 4; ++i)
+   {
+      BOOST_CHECK(ring.push(make_record(1, i, string(i, 'a'))));
+   }
+   BOOST_CHECK(!ring.push(make_record(1, 4, "")));
+   BOOST_CHECK_EQUAL(ring.get_pushed(), 4);
+
+   // slots are reused many times
+   for (int i = 0; i < 100; ++i)
+   {
+      const Log_record* record = ring.get_front();
+      BOOST_REQUIRE(record);
+      BOOST_CHECK_EQUAL(record->time, i);
+      BOOST_CHECK_EQUAL(get_text(*record), string(i, 'a'));
+      ring.pop();
+      BOOST_CHECK(ring.push(make_record(1, i + 4, string(i + 4, 'a'))));
+   }
+   BOOST_CHECK_EQUAL(ring.get_popped(), 100);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint producers_number = 4;
+const int records_per_producer = 20000;
+
+/// Pushes records numbered from 0, retrying while ring is full.
+void produce(Record_ring& ring, uchar producer)
+{
+   for (int i = 0; i < records_per_producer; ++i)
+   {
+      while (!ring.push(make_record(producer, i, "record")))
+      {
+         boost::thread::yield();
+      }
+   }
+}
+
+/// Records of several threads aren't lost or duplicated; each thread's records keep their order.
+void test_producers()
+{
+   Record_ring ring(64);
+   boost::thread_group producers;
+   for (uint i = 0; i < producers_number; ++i)
+   {
+      producers.create_thread(boost::bind(produce, boost::ref(ring), uchar(i)));
+   }
+
+   vector<int> next(producers_number, 0);
+   for (int popped = 0; popped < int(producers_number)*records_per_producer; )
+   {
+      const Log_record* record = ring.get_front();
+      if (!record)
+      {
+         boost::thread::yield();
+         continue;
+      }
+
+      BOOST_REQUIRE(record->sender_id < producers_number);
+      BOOST_REQUIRE_EQUAL(record->time, next[record->sender_id]);
+      BOOST_REQUIRE_EQUAL(get_text(*record), "record");
+      ++next[record->sender_id];
+      ring.pop();
+      ++popped;
+   }
+   producers.join_all();
+
+   BOOST_CHECK(!ring.get_front());
+   BOOST_CHECK(ring.push(make_record(0, 0, "")));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Record_ring");
+   test->add(BOOST_TEST_CASE(test_order));
+   test->add(BOOST_TEST_CASE(test_producers));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
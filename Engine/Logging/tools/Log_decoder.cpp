@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Formats binary log (see Logger::enable_binary()) into text log offline.
+// Usage: Log_decoder <binary log>
+// Text is written to standard output, so it could be piped into scripts that take text log; e.g.
+// "Log_decoder main.blog | perl Test/Test_cases/process_log.pl".
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Binary_log.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   if (argc != 2)
+   {
+      std::cerr << "Usage: Log_decoder <binary log>" << std::endl;
+      return 1;
+   }
+
+   std::ifstream in(argv[1], std::ios::binary);
+   if (!in)
+   {
+      std::cerr << "Unable to open " << argv[1] << std::endl;
+      return 1;
+   }
+
+   try
+   {
+      Engine::Logging::decode_binary_log(in, std::cout);
+      return 0;
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
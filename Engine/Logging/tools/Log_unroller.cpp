@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Writes text of circular log file (see Circular_log_file) in chronological order, e.g. after crash of application.
+// Usage: Log_unroller <circular log file>
+// Text is written to standard output, so it could be piped into scripts that take text log; e.g.
+// "Log_unroller main.ring | perl Test/Test_cases/process_log.pl".
+// Application started again after crash keeps log of crashed run as main.ring.old.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Logging/Circular_log_file.h"
+
+#include "Common/Mapped_file.h"
+
+#include <iostream>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   if (argc != 2)
+   {
+      std::cerr << "Usage: Log_unroller <circular log file>" << std::endl;
+      return 1;
+   }
+
+   try
+   {
+      const Common::Mapped_file file(argv[1]);
+      Engine::Logging::unroll_circular_log(file.get_data(), file.get_size(), std::cout);
+      return 0;
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Single file with pre-decoded textures, mapped into memory at startup.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_ASSET_PACK_H_INCLUDED
+#define ENGINE_RENDERING_ASSET_PACK_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Block_compression.h"
+#include "Engine/Rendering/Image.h"
+
+#include "Common/Mapped_file.h"
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+#include "boost/scoped_ptr.hpp"
+
+#include <cstddef>              // for size_t
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Formats of texture data in pack.
+enum Packed_format
+{
+   /// A8R8G8B8 pixels row by row, as Image keeps them.
+   packed_format_a8r8g8b8,
+   /// BC1 blocks, as Compressed_image keeps them.
+   packed_format_bc1,
+   /// BC3 blocks, as Compressed_image keeps them.
+   packed_format_bc3
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Texture found in pack; data points into mapped pack, so it is valid while pack lives.
+struct Packed_texture
+{
+   uint          width;
+   uint          height;
+   Packed_format format;
+   /// Page-aligned data of texture.
+   const uchar*  data;
+   size_t        size;
+};
+
+/// Copies pixels of packed texture into image; blocks are decompressed.
+Image unpack_image(const Packed_texture& texture);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Pack can't be read or written.
+class Asset_pack_exception : public std::runtime_error
+{
+public:
+   explicit Asset_pack_exception(const std::string& msg) : std::runtime_error(msg) { }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Pack file mapped into memory.
+/// Pack keeps textures already decoded, each starting at page boundary, so opening it is one file lookup
+/// and renderers copy texture data right from mapped pages; OS reads pages on first access.
+/// Textures are found by names they are loaded by otherwise (see Texture_ID), through table sorted
+/// by name hash. Packs are written by Asset_pack_writer, offline by Pack_builder.
+class Asset_pack : boost::noncopyable
+{
+public:
+
+   /// Maps pack and checks its table.
+   /// \throw Asset_pack_exception if pack can't be mapped or is broken.
+   explicit Asset_pack(const std::string& file_name);
+
+   // copying is disallowed
+
+   /// Finds texture by name.
+   /// \return false if texture isn't in pack.
+   bool find(const std::string& name, Packed_texture& texture) const;
+
+   /// \return Number of textures in pack.
+   uint get_size() const                                          { return static_cast<uint>(m_entries.size()); }
+
+private:
+
+   /// Entry of table, as pack keeps it.
+   struct Entry
+   {
+      uint hash;
+      uint name_offset;
+      uint name_size;
+      uint format;
+      uint width;
+      uint height;
+      uint data_offset;
+      uint data_size;
+   };
+
+private:
+
+   static bool is_hash_less(const Entry& entry, uint hash);
+
+private:
+
+   boost::scoped_ptr<Common::Mapped_file> m_file;
+   /// Table read from pack, sorted by hash.
+   std::vector<Entry>                     m_entries;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Collects textures and writes them as pack.
+class Asset_pack_writer : boost::noncopyable
+{
+public:
+
+   Asset_pack_writer() { }
+   // copying is disallowed
+
+   /// Adds texture to be kept as A8R8G8B8 pixels.
+   void add(const std::string& name, const Image& image);
+
+   /// Adds texture to be kept as blocks.
+   void add(const std::string& name, const Compressed_image& image);
+
+   /// Writes pack with textures added so far.
+   /// \throw Asset_pack_exception if names repeat or pack can't be written.
+   void save(const std::string& file_name) const;
+
+   /// \return Number of textures added.
+   uint get_size() const                                          { return static_cast<uint>(m_sources.size()); }
+
+private:
+
+   /// Texture waiting for save().
+   struct Source
+   {
+      std::string        name;
+      uint               hash;
+      Packed_format      format;
+      uint               width;
+      uint               height;
+      std::vector<uchar> data;
+   };
+
+private:
+
+   static bool is_less(const Source* lhs, const Source* rhs);
+
+private:
+
+   std::vector<Source> m_sources;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_ASSET_PACK_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Grouping of sprites into batches that share render state.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_BATCH_H_INCLUDED
+#define ENGINE_RENDERING_BATCH_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Maximal number of quads that could be drawn by single indexed draw.
+/// Limited by 16-bit indexes: 4 vertexes per quad, 65536 vertexes at most.
+const uint max_quads_per_draw = 16384;
+
+/// Number of texture stages batch state consists of.
+const uint batch_stages_number = 2;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Run of sprites of the same vertex format that are rendered with the same state.
+struct Render_batch
+{
+   Vertex_format  format;
+   /// Index of the first sprite of batch (among sprites of the same format).
+   uint           first;
+   /// Number of sprites in batch.
+   uint           count;
+   Texture_ID     textures[batch_stages_number];
+   Blending_mode  blendings[batch_stages_number];
+};
+
+typedef std::vector<Render_batch> Batch_list;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Device batches are drawn with.
+/// Implemented by rendering backends; could be mocked to check what is drawn.
+class Batch_device
+{
+public:
+
+   virtual ~Batch_device() { }
+
+   /// Selects vertexes of given format as source of the next draws.
+   virtual void set_vertex_format(Vertex_format)                = 0;
+
+   /// Assigns texture to stage. Empty Texture_ID resets stage texture.
+   virtual void set_texture(uint nstage, const Texture_ID&)     = 0;
+
+   /// Sets both color and alpha blending for stage.
+   virtual void set_blending(uint nstage, Blending_mode)        = 0;
+
+   /// Draws quads as indexed triangle list.
+   /// \param first_quad Index of the first quad among vertexes of current format.
+   /// \param nquads Number of quads to draw; never exceeds max_quads_per_draw.
+   virtual void draw_quads(uint first_quad, uint nquads)        = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Empty batch starting from given sprite, with state of untextured drawing.
+Render_batch make_batch(Vertex_format format, uint first);
+
+/// Appends batches for colored sprites to list.
+/// Colored sprites don't use textures, so all of them go into single batch.
+void compile_batches(const std::vector<Colored_sprite>& sprites, Batch_list& batches);
+
+/// Appends batches for textured sprites to list.
+/// Each run of adjacent sprites with the same texture and blending becomes one batch.
+void compile_batches(const std::vector<Textured_sprite>& sprites, Batch_list& batches);
+
+/// Appends batches for multitextured sprites to list.
+/// Each run of adjacent sprites with the same textures and blendings becomes one batch.
+void compile_batches(const std::vector<Multitextured_2_sprite>& sprites, Batch_list& batches);
+
+/// Appends batches for sprites [first, first + count), e.g. run of sorted sprites (see Render_queue).
+/// Each run of adjacent sprites with the same state becomes one batch.
+void compile_batches(const std::vector<Colored_sprite>& sprites, uint first, uint count, Batch_list& batches);
+void compile_batches(const std::vector<Textured_sprite>& sprites, uint first, uint count, Batch_list& batches);
+void compile_batches(const std::vector<Multitextured_2_sprite>& sprites, uint first, uint count,
+                     Batch_list& batches);
+
+/// Appends batches for some of sprites, e.g. ones left after culling.
+/// \param slots Indexes of sprites to draw, in order of drawing, e.g. increasing.
+/// Each run of sprites with adjacent indexes and the same state becomes one batch.
+void compile_batches(const std::vector<Colored_sprite>& sprites, const std::vector<uint>& slots,
+                     Batch_list& batches);
+void compile_batches(const std::vector<Textured_sprite>& sprites, const std::vector<uint>& slots,
+                     Batch_list& batches);
+void compile_batches(const std::vector<Multitextured_2_sprite>& sprites, const std::vector<uint>& slots,
+                     Batch_list& batches);
+
+/// Emits batches to device: state is set once per batch, then quads are drawn.
+/// Batches longer than max_quads_per_draw are split into several draws.
+void draw_batches(const Batch_list& batches, Batch_device& device);
+
+/// Fills index data for drawing quads as triangle list.
+/// Quad vertexes are expected to be ordered as for triangle strip (see Direct3D_renderer).
+/// \param indexes Buffer of at least 6*nquads elements.
+void fill_quad_indexes(ushort* indexes, uint nquads);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_BATCH_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Block compression of images: BC1 (DXT1) and BC3 (DXT5).
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_BLOCK_COMPRESSION_H_INCLUDED
+#define ENGINE_RENDERING_BLOCK_COMPRESSION_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Image.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/shared_ptr.hpp"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Formats of compressed blocks; each block keeps 4x4 texels.
+enum Block_format
+{
+   /// 8 bytes per block: two RGB565 colors and 2-bit index per texel into 4 colors between them; opaque.
+   block_format_bc1,
+   /// 16 bytes per block: alpha block (two 8-bit alphas and 3-bit index per texel into 8 alphas between them)
+   /// followed by BC1 color block.
+   block_format_bc3
+};
+
+/// \return Size of single block in bytes.
+inline uint get_block_bytes(Block_format format)                    { return format == block_format_bc1 ? 8 : 16; }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Image compressed by blocks, as Direct3D keeps DXT1 and DXT5 textures.
+/// Blocks go row by row from top-left corner; blocks on right and bottom edges are padded
+/// if size isn't multiple of 4.
+struct Compressed_image
+{
+   Compressed_image() : width(0), height(0), format(block_format_bc1) { }
+
+   uint               width;
+   uint               height;
+   Block_format       format;
+   std::vector<uchar> blocks;
+
+   /// \return Number of blocks in row.
+   uint get_blocks_wide() const                                   { return (width + 3) / 4; }
+
+   /// \return Number of rows of blocks.
+   uint get_blocks_high() const                                   { return (height + 3) / 4; }
+};
+
+typedef boost::shared_ptr<const Compressed_image> Compressed_image_ptr;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Compresses image: endpoints of each block are taken from bounding box of its colors (and range of its alphas),
+/// shrunk a bit, so that rounding error is spread evenly; each texel gets the nearest of interpolated values.
+/// Meant for asset pipeline rather than runtime: it isn't fast and quality is just good enough.
+/// BC1 drops alpha of image.
+Compressed_image compress_image(const Image& image, Block_format format);
+
+/// Decompresses image into A8R8G8B8 pixels; BC1 images are opaque.
+/// Colors of 4 texels are selected at once with SSE2 if it is available.
+Image decompress_image(const Compressed_image& image);
+
+/// Decompresses blocks kept elsewhere, e.g. in mapped file, as decompress_image() does.
+/// \param blocks Blocks laid out as in Compressed_image.
+Image decompress_blocks(uint width, uint height, Block_format format, const uchar* blocks);
+
+/// \return Whether image has any texel that isn't fully opaque, so it needs BC3 rather than BC1.
+bool has_alpha(const Image& image);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_BLOCK_COMPRESSION_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Reading and writing of BMP files.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_BMP_H_INCLUDED
+#define ENGINE_RENDERING_BMP_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Image.h"
+
+#include <cstddef>              // for size_t
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Loads 24- or 32-bit BMP file, or 8-bit one with palette (uncompressed or RLE8).
+/// 8- and 24-bit images get opaque alpha; alpha of 32-bit images is taken as is.
+/// File is mapped into memory rather than read; 24-bit rows are converted with SSE2 if it is available.
+/// \throw Image_exception if file can't be read or its format isn't supported.
+Image load_bmp(const std::string& file_name);
+
+/// Decodes BMP file that is already in memory, as load_bmp() does.
+/// \param name Name of image for error messages.
+/// \throw Image_exception if data is truncated or its format isn't supported.
+Image decode_bmp(const uchar* data, size_t size, const std::string& name);
+
+/// Saves image as uncompressed 32-bit BMP file.
+/// \throw Image_exception if file can't be written.
+void save_bmp(const Image& image, const std::string& file_name);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_BMP_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Rejection of sprites outside of viewport.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_CULLING_H_INCLUDED
+#define ENGINE_RENDERING_CULLING_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+#include <algorithm>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Axis-aligned rectangle in screen coordinates; edges are included.
+struct Bounds
+{
+   float left, top, right, bottom;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprites culled during the last frame.
+struct Culling_statistics
+{
+   /// Sprites added to scene.
+   uint sprites;
+   uint culled_sprites;
+   /// Retained sprites.
+   uint retained;
+   uint culled_retained;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Bounding rectangle of sprite corners.
+template <Vertex_format format>
+Bounds get_bounds(const Sprite<format>& s)
+{
+   Bounds b = { s.vertexes[0].position.x, s.vertexes[0].position.y,
+                s.vertexes[0].position.x, s.vertexes[0].position.y };
+   for (uint i = 1; i < 4; ++i)
+   {
+      b.left   = std::min(b.left,   s.vertexes[i].position.x);
+      b.top    = std::min(b.top,    s.vertexes[i].position.y);
+      b.right  = std::max(b.right,  s.vertexes[i].position.x);
+      b.bottom = std::max(b.bottom, s.vertexes[i].position.y);
+   }
+   return b;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline bool intersect(const Bounds& lhs, const Bounds& rhs)
+{
+   return lhs.left <= rhs.right && rhs.left <= lhs.right && lhs.top <= rhs.bottom && rhs.top <= lhs.bottom;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Removes sprites that lie entirely outside of viewport; order of the rest is kept.
+/// Uses SSE2 if it is available (see Common/Simd.h).
+/// Defined for formats of Colored_sprite, Textured_sprite and Multitextured_2_sprite.
+/// \return Number of sprites removed.
+template <Vertex_format format>
+uint cull_sprites(std::vector<Sprite<format> >& sprites, const Bounds& viewport);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Spatial index of rectangles identified by small integers, for finding ones that intersect given area.
+/// Quadtree over world rectangle is complete up to given depth. Item goes to the deepest cell that is not smaller
+/// than the item and contains its center, so each item is kept in exactly one cell and moving item never splits it.
+/// Cells are "loose": they accept items sticking out by up to half of cell, so query visits cells enlarged twice.
+/// Items with centers outside of world are kept in the root and tested by every query.
+class Loose_quadtree : boost::noncopyable
+{
+public:
+
+   /// \param depth Number of levels below root.
+   Loose_quadtree(const Bounds& world, uint depth);
+   // copying is disallowed
+
+   /// Adds item; id should not be used by another item.
+   /// Ids are used as indexes, so they should be dense (like handles of Sprite_store).
+   void insert(uint id, const Bounds& bounds);
+
+   /// Changes bounds of item.
+   void move(uint id, const Bounds& bounds);
+
+   void remove(uint id);
+
+   /// Appends ids of items intersecting area, in no particular order.
+   void query(const Bounds& area, std::vector<uint>& ids) const;
+
+   /// \return Number of items.
+   uint get_size() const                                          { return m_size; }
+
+private:
+
+   /// Cell of quadtree.
+   struct Cell
+   {
+      uint level;
+      uint x;
+      uint y;
+   };
+
+   struct Item
+   {
+      Bounds bounds;
+      Cell   cell;
+      /// Position of item in ids of its node.
+      uint   position;
+      bool   is_used;
+   };
+
+   struct Node
+   {
+      Node() : subtree_size(0) { }
+
+      std::vector<uint> ids;
+      /// Number of items in node and all its descendants, so that empty subtrees are skipped.
+      uint              subtree_size;
+   };
+
+private:
+
+   Cell locate(const Bounds& bounds) const;
+
+   Node& get_node(const Cell& cell);
+   const Node& get_node(const Cell& cell) const;
+
+   void add_to_node(uint id, const Cell& cell);
+   void remove_from_node(uint id);
+
+   void query_node(uint level, uint x, uint y, const Bounds& area, std::vector<uint>& ids) const;
+
+private:
+
+   Bounds             m_world;
+   uint               m_depth;
+   /// Nodes level by level, each level row by row; allocated on the first insertion.
+   std::vector<Node>  m_nodes;
+   std::vector<Item>  m_items;
+   uint               m_size;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_CULLING_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
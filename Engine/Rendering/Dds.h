@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Reading and writing of DDS files with block-compressed images.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_DDS_H_INCLUDED
+#define ENGINE_RENDERING_DDS_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Block_compression.h"
+
+#include <cstddef>              // for size_t
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Whether file name has ".dds" extension, so texture should be loaded by load_dds().
+bool is_dds_file(const std::string& file_name);
+
+/// Loads DXT1 or DXT5 DDS file; blocks stay compressed. Only the top mip level is taken.
+/// File is mapped into memory rather than read.
+/// \throw Image_exception if file can't be read or its format isn't supported.
+Compressed_image load_dds(const std::string& file_name);
+
+/// Decodes DDS file that is already in memory, as load_dds() does.
+/// \param name Name of image for error messages.
+/// \throw Image_exception if data is truncated or its format isn't supported.
+Compressed_image decode_dds(const uchar* data, size_t size, const std::string& name);
+
+/// Saves image as DXT1 or DXT5 DDS file without mip levels.
+/// \throw Image_exception if file can't be written.
+void save_dds(const Compressed_image& image, const std::string& file_name);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_DDS_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -16,9 +16,20 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "Engine/Rendering/Renderer.h"
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Batch.h"
+#include "Engine/Rendering/Culling.h"
+#include "Engine/Rendering/Render_queue.h"
+#include "Engine/Rendering/Sprite_pool.h"
+#include "Engine/Rendering/Sprite_store.h"
+#include "Engine/Rendering/Texture_cache.h"
+#include "Engine/Rendering/Texture_streamer.h"
+#include "Engine/Rendering/Vertex_ring.h"
 
 #include "Engine/Rendering/Direct3D/Direct3D_system.h"
 
+#include "boost/scoped_ptr.hpp"
+
 #include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -31,7 +42,10 @@ namespace Rendering
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /// Renderer that uses Direct3D 9.0.
-class Direct3D_renderer : public Renderer
+/// Sprites are drawn in batches of the same state (see Batch.h), one indexed draw per batch.
+/// Vertexes are streamed through dynamic vertex buffer allocated as ring (see Vertex_ring.h).
+/// Retained sprites are kept in static vertex buffers, where only changed sprites are written.
+class Direct3D_renderer : public Renderer, private Stream_device, private Dynamic_vertex_buffer
 {
 public:
 
@@ -52,37 +66,208 @@ public:
    // \see base class for details.
    virtual void add_to_scene(const Multitextured_2_sprite&);
 
+   /// \see base class for details.
+   virtual void add_to_scene(const Scene_buffer&);
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Sprite_instances&);
+
    /// \see base class for details.
    virtual void render_scene();
 
    /// \see base class for details.
    virtual void clear_scene();
 
+   /// \see base class for details.
+   virtual Colored_sprite_handle create_sprite(const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual Textured_sprite_handle create_sprite(const Textured_sprite&);
+
+   /// \see base class for details.
+   virtual Multitextured_2_sprite_handle create_sprite(const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Colored_sprite_handle, const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Textured_sprite_handle, const Textured_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Multitextured_2_sprite_handle, const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Colored_sprite_handle);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Textured_sprite_handle);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Multitextured_2_sprite_handle);
+
    /// \see base class for details.
    virtual bool is_focused() const;
 
    /// \see base class for details.
    virtual void try_restore();
 
+   /// \see base class for details.
+   virtual const Render_stats& get_render_stats() const;
+
+public:
+
+   /// Draws sprites of pool with scene until clear_scene(): after opaque sprites added to scene, before translucent
+   /// ones, without sorting or culling. Their vertexes are converted from pool right into vertex buffer
+   /// (see stream_pool()), so pool should stay alive until then. Pools are drawn by formats, then in order added.
+   void add_to_scene(const Colored_sprite_pool& pool)             { m_colored_pools.push_back(&pool); }
+   void add_to_scene(const Textured_sprite_pool& pool)            { m_textured_pools.push_back(&pool); }
+   void add_to_scene(const Multitextured_2_sprite_pool& pool)     { m_multitextured_pools.push_back(&pool); }
+
+   /// Sets maximal size of memory occupied by loaded textures.
+   void set_texture_budget(uint bytes)                                           { m_textures.set_budget(bytes); }
+
+   /// \return Texture cache hits, misses and evictions.
+   const Texture_cache_statistics& get_texture_statistics() const                { return m_textures.get_statistics(); }
+
+   /// Makes textures load in background by given number of threads rather than when they are first drawn.
+   /// Until texture is loaded its sprites get placeholder, single white texel, so they show diffuse color.
+   /// Loaded textures are created at the beginning of render_scene(); ones that fail to load are logged
+   /// and stay placeholders.
+   void enable_texture_streaming(uint threads);
+
+   /// Starts loading texture before it is drawn, e.g. while level loads:
+   /// in background if streaming is enabled, right away otherwise.
+   void prefetch_texture(const Texture_ID& id);
+
+   /// Blocks until streamed textures are loaded and creates them, so they are drawn by the next frame.
+   void wait_for_textures();
+
+   /// Makes textures found in pack be taken from it, before they are loaded or streamed otherwise.
+   /// Texture data is copied right from mapped pack into locked texture.
+   /// \param pack Pack that should outlive renderer; null stops using pack.
+   void set_asset_pack(const Asset_pack* pack)                                   { m_pack = pack; }
+
+   /// \return Vertex buffer locks, discards and growths.
+   const Vertex_ring_statistics& get_vertex_statistics() const                   { return m_ring.get_statistics(); }
+
+   /// \return Numbers of sprites culled during last render_scene().
+   const Culling_statistics& get_culling_statistics() const                      { return m_culling; }
+
+   /// \return Numbers of device state calls issued and filtered as redundant (see State_cache).
+   const State_cache_statistics& get_state_statistics() const { return m_device.get_state_statistics(); }
+
+   /// Makes render_scene() log stats averaged over given number of frames; 0 disables logging.
+   void set_stats_log_period(uint frames)                                        { m_stats_log.set_period(frames); }
+
+// Batch_device interface
 private:
 
-   void set_texture(uint nstage, const Texture_ID& id);
-   void set_blending(uint nstage, Blending_mode mode);
+   virtual void set_vertex_format(Vertex_format format);
+   virtual void set_texture(uint nstage, const Texture_ID& id);
+   virtual void set_blending(uint nstage, Blending_mode mode);
+   virtual void draw_quads(uint first_quad, uint nquads);
+
+// Stream_device interface
+private:
+
+   virtual uint get_quad_bytes(Vertex_format format) const;
+   virtual void write_quads(Vertex_format format, uint first, uint nquads, void* where);
+   virtual void set_vertex_offset(uint offset);
+
+// Dynamic_vertex_buffer interface
+private:
+
+   virtual void* lock(uint offset, uint bytes, bool discard);
+   virtual void unlock();
+   virtual void resize(uint bytes);
+
+private:
+
+   /// Static vertex buffer of retained sprites of one format.
+   struct Retained_buffer
+   {
+      Retained_buffer() : capacity(0) { }
+
+      D3D_vertex_buffer_ptr vbuf;
+      /// Number of sprites buffer could hold.
+      uint                  capacity;
+   };
+
+private:
 
-   void copy_scene_to_vbuf();
    void draw_to_back_buffer();
 
+   /// Creates textures of images loaded by streamer and puts them into cache.
+   void take_streamed_textures();
+
+   /// Creates texture from asset pack and puts it into cache.
+   /// \return false if texture isn't in pack.
+   bool take_packed_texture(const Texture_ID& id, D3D_texture_ptr& texture);
+
+   /// Draws sprites of pools added to scene.
+   template <Vertex_format format>
+   void stream_pools(const std::vector<const Sprite_pool<format>*>& pools);
+
+   /// Writes changed retained sprites into their buffer; grows buffer if needed.
+   template <Vertex_format format>
+   void upload_retained(Sprite_store<format>& store, Retained_buffer& buffer);
+
+   Retained_buffer& get_retained_buffer(Vertex_format format);
+
 private:
 
    std::vector<Colored_sprite>         m_sprites_colored;
    std::vector<Textured_sprite>        m_sprites_textured;
    std::vector<Multitextured_2_sprite> m_sprites_multitextured;
+   /// Batches of opaque sprites added to scene.
+   Batch_list                          m_batches;
+   /// Batches of translucent sprites added to scene; drawn after translucent retained ones.
+   Batch_list                          m_translucent_batches;
+   /// Sorts sprites added to scene in draw order.
+   Render_queue                        m_queue;
+   std::vector<const Colored_sprite_pool*>         m_colored_pools;
+   std::vector<const Textured_sprite_pool*>        m_textured_pools;
+   std::vector<const Multitextured_2_sprite_pool*> m_multitextured_pools;
+   /// Batches of pool being drawn.
+   Batch_list                          m_pool_batches;
+
+   Sprite_store<Vertex_format(position | diffuse_color)>                                   m_retained_colored;
+   Sprite_store<Vertex_format(position | diffuse_color | texture_coord0)>                  m_retained_textured;
+   Sprite_store<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> m_retained_multitextured;
+   /// Batches of opaque retained sprites; compiled again only when retained sprites change.
+   Batch_list                          m_retained_batches;
+   /// Batches of translucent retained sprites, back to front; drawn after opaque sprites added to scene.
+   Batch_list                          m_retained_translucent;
+   /// Entries of visible translucent retained sprites, kept to avoid allocations.
+   std::vector<Queue_entry>            m_translucent_entries;
+   /// Slots of visible retained sprites.
+   std::vector<uint>                   m_visible_slots;
+   Culling_statistics                  m_culling;
+
+   Render_stats                        m_stats;
+   Render_stats_log                    m_stats_log;
+   /// Textures created since last render_scene() finished.
+   uint                                m_texture_loads;
 
    HWND                     m_window_handle;
    D3D_system_ptr           m_D3D;
    D3DPRESENT_PARAMETERS    m_present_params;
    D3D_device_ptr           m_device;
    D3D_vertex_buffer_ptr    m_vbuf;
+   D3D_index_buffer_ptr     m_ibuf;
+   Vertex_ring              m_ring;
+   Retained_buffer          m_retained_colored_vbuf;
+   Retained_buffer          m_retained_textured_vbuf;
+   Retained_buffer          m_retained_multitextured_vbuf;
+   /// Size of vertex of current format.
+   uint                     m_vertex_bytes;
+   Texture_cache<D3D_texture_ptr> m_textures;
+   /// Null unless streaming is enabled.
+   boost::scoped_ptr<Texture_streamer> m_streamer;
+   D3D_texture_ptr          m_placeholder;
+   std::vector<Streamed_image> m_streamed;
+   /// Null unless pack is set.
+   const Asset_pack*        m_pack;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
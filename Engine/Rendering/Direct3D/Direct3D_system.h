@@ -17,13 +17,18 @@
 
 #include "Common/Typedefs.h"
 
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Block_compression.h"
+#include "Engine/Rendering/Image.h"
 #include "Engine/Rendering/Logging.h"
+#include "Engine/Rendering/State_cache.h"
 
 #include "Third_party/Platform/Win32.h"
 #include "Third_party/Platform/Direct3D.h"
 
 #include "boost/intrusive_ptr.hpp"
 #include "boost/noncopyable.hpp"
+#include "boost/shared_ptr.hpp"
 
 #include <string>
 
@@ -53,6 +58,7 @@ namespace Rendering
 class D3D_system_ptr;
 class D3D_device_ptr;
 class D3D_vertex_buffer_ptr;
+class D3D_index_buffer_ptr;
 class D3D_texture_ptr;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -81,6 +87,8 @@ public:
    friend class D3D_device_ptr;
 public:
 
+   /// Constructs empty pointer.
+   D3D_vertex_buffer_ptr() : m_raw_buffer(0) { }
    // default copying is ok
 
    // TODO: upgrade to boost 1.39 and use boost::intrusive_ptr<>::reset() instead
@@ -88,6 +96,16 @@ public:
    /// It is needed as resource should be manually released on device reset.
    void reset() { m_raw_buffer.swap(boost::intrusive_ptr<IDirect3DVertexBuffer9>()); }
 
+   /// Locks region of buffer; it should be unlocked by unlock() before drawing.
+   /// Wrapper for IDirect3DVertexBuffer9::Lock().
+   /// \param flags D3DLOCK_DISCARD or D3DLOCK_NOOVERWRITE for dynamic buffer, 0 for static one.
+   /// \return Memory of region.
+   void* lock(uint offset, uint bytes, DWORD flags);
+
+   /// Wrapper for IDirect3DVertexBuffer9::Unlock().
+   /// \note Failure is logged only, so it could be called during cleanup.
+   void unlock();
+
 public:
 
    /// RAII wrapper for IDirect3DVertexBuffer9::Lock()/Unlock() operations.
@@ -123,6 +141,55 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// IDirect3DIndexBuffer9 wrapper.
+class D3D_index_buffer_ptr
+{
+public:
+   friend class Lock;
+   friend class D3D_device_ptr;
+public:
+
+   // default copying is ok
+
+   // TODO: upgrade to boost 1.39 and use boost::intrusive_ptr<>::reset() instead
+   /// Resets underlying resource.
+   void reset() { m_raw_buffer.swap(boost::intrusive_ptr<IDirect3DIndexBuffer9>()); }
+
+public:
+
+   /// RAII wrapper for IDirect3DIndexBuffer9::Lock()/Unlock() operations.
+   class Lock : boost::noncopyable
+   {
+   public:
+
+      /// Locks index buffer.
+      Lock(D3D_index_buffer_ptr);
+
+      /// Unlocks index buffer.
+      ~Lock();
+
+      // copying is disallowed
+
+      /// Unlocks index buffer.
+      /// \note it is safe to call reset() multiple times.
+      void reset();
+
+      /// Obtaines pointer to buffer's raw memory.
+      void* get_raw_memory();
+
+   private:
+      IDirect3DIndexBuffer9* m_ibuf;
+      void* m_raw;
+   };
+
+private:
+   D3D_index_buffer_ptr(IDirect3DIndexBuffer9* raw_buffer) : m_raw_buffer(raw_buffer, false) { }
+private:
+   boost::intrusive_ptr<IDirect3DIndexBuffer9> m_raw_buffer;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 /// IDirect3DTexture9 wrapper.
 class D3D_texture_ptr
 {
@@ -138,6 +205,10 @@ public:
    /// It is needed as resource should be manually released on device reset.
    void reset() { m_raw_texture.swap(boost::intrusive_ptr<IDirect3DTexture9>()); }
 
+   /// Counts memory occupied by all texture levels.
+   /// \return Size in bytes; 0 for empty texture.
+   uint get_bytes() const;
+
 private:
    D3D_texture_ptr(IDirect3DTexture9* raw_texture) : m_raw_texture(raw_texture, false) { }
 private:
@@ -147,6 +218,8 @@ private:
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /// IDirect3DDevice9 wrapper.
+/// Textures, stage states, vertex format and stream source are set through shadow copy of device state
+/// (see State_cache), so calls that don't change state don't reach Direct3D. Copies of pointer share it.
 class D3D_device_ptr
 {
 public:
@@ -159,17 +232,42 @@ public:
 
    // default copying is ok
 
-   /// Constructs vertex buffer with given capacity.
+   /// Constructs dynamic write-only vertex buffer with given capacity.
+   /// Buffer is not managed by Direct3D, so it should be released before device reset.
    /// \param Buffer capacity in bytes.
    D3D_vertex_buffer_ptr create_vertex_buffer(uint bytes);
 
-   /// Loads texture by file_name.
-   D3D_texture_ptr       create_texture(const std::string& file_name);
+   /// Constructs write-only vertex buffer for data that rarely changes.
+   /// Buffer is managed by Direct3D, so it survives device reset.
+   /// \param Buffer capacity in bytes.
+   D3D_vertex_buffer_ptr create_static_vertex_buffer(uint bytes);
+
+   /// Constructs buffer of 16-bit indexes with given capacity.
+   /// Buffer is managed by Direct3D, so it survives device reset.
+   /// \param Buffer capacity in bytes.
+   D3D_index_buffer_ptr  create_index_buffer(uint bytes);
+
+   /// Constructs A8R8G8B8 texture of single level with pixels of image.
+   /// Texture is managed by Direct3D, so it survives device reset.
+   D3D_texture_ptr       create_texture(const Image& image);
+
+   /// Constructs DXT1 or DXT5 texture of single level with blocks of image, so it stays compressed
+   /// in video memory. Direct3D needs sides of DXT textures to be multiple of 4, so other images
+   /// are decompressed into A8R8G8B8 texture.
+   /// Texture is managed by Direct3D, so it survives device reset.
+   D3D_texture_ptr       create_texture(const Compressed_image& image);
+
+   /// Constructs texture of packed texture, as ones above do; data is copied right from mapped pack.
+   D3D_texture_ptr       create_texture(const Packed_texture& texture);
 
    /// Binds vertex buffer to device data stream.
    /// Wrapper for IDirect3DDevice9::SetStreamSource()
    void set_vertex_buffer(D3D_vertex_buffer_ptr, uint offset, uint vertex_bytes);
 
+   /// Sets index data used by indexed drawing.
+   /// Wrapper for IDirect3DDevice9::SetIndices()
+   void set_index_buffer(D3D_index_buffer_ptr);
+
    /// Sets current vertex stream declaration.
    /// Wrapper for IDirect3DDevice9::SetFVF()
    void set_vertex_format(DWORD);
@@ -187,6 +285,14 @@ public:
    /// Wrapper for IDirect3DDevice9::DrawPrimitive()
    void draw_primitive(D3DPRIMITIVETYPE, uint offset, uint nvertexes);
 
+   /// Renders sequence of indexed primitives from current vertex and index buffers.
+   /// Wrapper for IDirect3DDevice9::DrawIndexedPrimitive()
+   /// \param base_vertex Vertex that index 0 refers to.
+   /// \param nvertexes Number of vertexes referred by indexes.
+   /// \param start_index First index to draw with.
+   void draw_indexed_primitive(D3DPRIMITIVETYPE, uint base_vertex, uint nvertexes, uint start_index,
+                               uint nprimitives);
+
    /// Presents back buffer on screen.
    bool present();
 
@@ -197,6 +303,11 @@ public:
    /// \note All created resources (buffers, textures) should be reseted as well.
    void reset(D3DPRESENT_PARAMETERS& present_params);
 
+   /// \return Numbers of state calls issued to Direct3D and filtered as redundant.
+   const State_cache_statistics& get_state_statistics() const;
+
+   void reset_state_statistics();
+
 public:
 
    /// RAII wrapper for IDirect3DDevice9::BeginScene()/EndScene() operations.
@@ -219,10 +330,19 @@ public:
    private:
       IDirect3DDevice9* m_raw_device;
    };
+private:
+   /// Device state calls behind shadow state.
+   struct Shadow;
+
 private:
    D3D_device_ptr(IDirect3DDevice9*);
+
+   /// Constructs managed texture of single level and copies rows of texels (or blocks) into it.
+   D3D_texture_ptr create_texture(uint width, uint height, D3DFORMAT format, const uchar* rows, uint row_bytes,
+                                  uint rows_number);
 private:
    boost::intrusive_ptr<IDirect3DDevice9> m_raw_device;
+   boost::shared_ptr<Shadow>              m_shadow;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Image in system memory.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_IMAGE_H_INCLUDED
+#define ENGINE_RENDERING_IMAGE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+#include "boost/shared_ptr.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Packs color channels into A8R8G8B8 pixel.
+inline uint make_argb(uchar a, uchar r, uchar g, uchar b)
+{
+   return (uint(a) << 24) | (uint(r) << 16) | (uint(g) << 8) | uint(b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Uncompressed image.
+/// Pixels are A8R8G8B8; rows go from top to bottom without gaps.
+struct Image
+{
+   Image() : width(0), height(0) { }
+   Image(uint w, uint h) : width(w), height(h), pixels(w*h) { }
+
+   uint              width;
+   uint              height;
+   std::vector<uint> pixels;
+};
+
+typedef boost::shared_ptr<const Image> Image_ptr;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Image file can't be read or written.
+class Image_exception : public std::runtime_error
+{
+public:
+   explicit Image_exception(const std::string& msg) : std::runtime_error(msg) { }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_IMAGE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -28,7 +28,7 @@ namespace Logging
 
 const uchar sender_renderer = 3;
 
-#define LOG_RENDERER(message_level) LOG(Engine::Logging::sender_renderer, message_level)
+#define LOG_RENDERER(message_level) LOG_SENDER(Engine::Logging::sender_renderer, message_level)
 
 }
 }
@@ -29,8 +29,6 @@ namespace Rendering
 struct Position;
 struct Diffuse_color;
 struct Texture_coord;
-enum Blending_mode;
-enum Vertex_format;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
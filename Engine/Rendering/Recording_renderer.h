@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Renderer decorator that records scene into binary stream.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_RECORDING_RENDERER_H_INCLUDED
+#define ENGINE_RENDERING_RECORDING_RENDERER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Renderer.h"
+
+#include <iosfwd>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Passes all calls to another renderer and writes scene calls (add_to_scene(), render_scene(), clear_scene() and
+/// calls on retained sprites) into stream (see Scene_format.h), so they could be replayed later by Scene_player.
+class Recording_renderer : public Renderer
+{
+public:
+
+   /// \param target Renderer that draws scene; should outlive recording one.
+   /// \param out Stream that scene is written into; should be binary and outlive renderer.
+   Recording_renderer(Renderer& target, std::ostream& out);
+   // copying is disallowed via base class
+
+// Renderer interface
+public:
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Textured_sprite&);
+
+   // \see base class for details.
+   virtual void add_to_scene(const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Scene_buffer&);
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Sprite_instances&);
+
+   /// \see base class for details.
+   virtual void render_scene();
+
+   /// \see base class for details.
+   virtual void clear_scene();
+
+   /// \see base class for details.
+   virtual Colored_sprite_handle create_sprite(const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual Textured_sprite_handle create_sprite(const Textured_sprite&);
+
+   /// \see base class for details.
+   virtual Multitextured_2_sprite_handle create_sprite(const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Colored_sprite_handle, const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Textured_sprite_handle, const Textured_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Multitextured_2_sprite_handle, const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Colored_sprite_handle);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Textured_sprite_handle);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Multitextured_2_sprite_handle);
+
+   /// \see base class for details.
+   virtual bool is_focused() const;
+
+   /// \see base class for details.
+   virtual void try_restore();
+
+   /// \return Stats of target renderer.
+   virtual const Render_stats& get_render_stats() const;
+
+private:
+
+   /// Writes texture record if texture isn't defined in stream yet.
+   void define_texture(const Texture_ID& id);
+
+   /// Writes records of textures sprite uses that aren't defined in stream yet.
+   void define_textures(const Colored_sprite& s);
+   void define_textures(const Textured_sprite& s);
+   void define_textures(const Multitextured_2_sprite& s);
+
+   /// Writes create or update record.
+   template <Vertex_format format>
+   void write_retained(uchar type, Sprite_handle<format> handle, const Sprite<format>& s);
+
+   /// Writes records of sprites added to scene.
+   template <class Sprite_type>
+   void write_sprites(const std::vector<Sprite_type>& sprites);
+
+   /// Writes accumulated record.
+   void flush_record();
+
+private:
+
+   Renderer&                    m_target;
+   std::ostream&                m_out;
+   /// Record being written.
+   std::vector<char>            m_record;
+   /// Texture handle -> handle it is defined with in stream; 0 if it isn't defined yet.
+   std::vector<uint>            m_stream_textures;
+   /// Number of textures defined in stream, that is the last stream handle given.
+   uint                         m_stream_textures_number;
+   /// Sprites instances are expanded into; kept to avoid allocation per call.
+   std::vector<Textured_sprite> m_expanded;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_RECORDING_RENDERER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
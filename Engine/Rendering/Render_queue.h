@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Ordering of sprites by packed sort keys.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_RENDER_QUEUE_H_INCLUDED
+#define ENGINE_RENDERING_RENDER_QUEUE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Batch.h"
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/cstdint.hpp"
+#include "boost/noncopyable.hpp"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Packed key sprites are drawn in increasing order of. From the highest bits:
+/// - translucency (1 bit): opaque sprites go first;
+/// - for opaque sprites: state (31 bits), then depth (24 bits) front to back, so that sprites sharing textures
+///   are drawn together and depth test rejects as many pixels as possible;
+/// - for translucent sprites: depth (24 bits) back to front, then state (31 bits), so that they are blended
+///   over everything behind them.
+/// State is vertex format (2 bits), texture handles (12 and 11 bits) and blending modes (3 bits each).
+/// Handles that don't fit are truncated: such sprites are grouped worse, but batches are still correct.
+/// The lowest 8 bits are not used.
+typedef boost::uint64_t Sort_key;
+
+/// Sprite of scene waiting to be drawn.
+struct Queue_entry
+{
+   Sort_key       key;
+   Vertex_format  format;
+   /// Index of sprite among sprites of the same format.
+   uint           index;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return true if sprite with given key is translucent.
+inline bool is_translucent(Sort_key key)                       { return key >> 63 != 0; }
+
+/// \return Sort key of sprite; its depth is average z of vertexes, z is clamped to [0, 1].
+/// Sprite is translucent if alpha of any of its vertexes is less than 255.
+Sort_key make_sort_key(const Colored_sprite& s);
+Sort_key make_sort_key(const Textured_sprite& s);
+Sort_key make_sort_key(const Multitextured_2_sprite& s);
+
+/// Stable LSD radix sort of entries by keys, 8 bits per pass.
+/// Passes over bytes that are the same in all keys are skipped.
+/// \param buffer Scratch space; resized as needed.
+void radix_sort(std::vector<Queue_entry>& entries, std::vector<Queue_entry>& buffer);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sorts sprites of scene in draw order.
+/// Keeps buffers between frames, so sorting doesn't allocate once they grow large enough.
+class Render_queue : boost::noncopyable
+{
+public:
+
+   Render_queue() { }
+   // copying is disallowed
+
+   /// Reorders sprites of each format by their keys and appends batches that draw them in order of keys.
+   /// Sprites with equal keys keep their order; sprites of different formats with equal keys are drawn
+   /// colored first, then textured, then multitextured.
+   /// \return Number of batches appended for opaque sprites; batches of translucent ones follow them.
+   uint sort(std::vector<Colored_sprite>& colored, std::vector<Textured_sprite>& textured,
+             std::vector<Multitextured_2_sprite>& multitextured, Batch_list& batches);
+
+   /// Appends batches that draw some of sprites in order of their keys, without moving sprites,
+   /// e.g. translucent retained sprites (see compile_visible_batches()).
+   /// \param entries Entries of sprites; index of entry is index of sprite among sprites of its format.
+   ///        Sorted by keys.
+   void compile_sorted(std::vector<Queue_entry>& entries, const std::vector<Colored_sprite>& colored,
+                       const std::vector<Textured_sprite>& textured,
+                       const std::vector<Multitextured_2_sprite>& multitextured, Batch_list& batches);
+
+private:
+
+   std::vector<Queue_entry>            m_entries;
+   std::vector<Queue_entry>            m_buffer;
+   std::vector<uint>                   m_slots;
+   std::vector<Colored_sprite>         m_colored;
+   std::vector<Textured_sprite>        m_textured;
+   std::vector<Multitextured_2_sprite> m_multitextured;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_RENDER_QUEUE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
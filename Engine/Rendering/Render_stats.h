@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Per-frame renderer statistics.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_RENDER_STATS_H_INCLUDED
+#define ENGINE_RENDERING_RENDER_STATS_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// What the last render_scene() cost (see Renderer::get_render_stats()).
+/// Backends leave zero what they don't have, e.g. software renderer uploads no vertexes.
+struct Render_stats
+{
+   /// Indexed draws; batches longer than max_quads_per_draw take several.
+   uint   draw_calls;
+   /// State calls that reached device.
+   uint   state_changes;
+   /// Textures created: loaded, streamed in or taken from asset pack.
+   uint   texture_loads;
+   /// Vertexes written into vertex buffers, retained sprites included.
+   uint   vertex_bytes;
+   /// Sprites added to scene and retained ones.
+   uint   sprites_submitted;
+   uint   sprites_culled;
+   uint   sprites_drawn;
+
+   // CPU time of frame phases in seconds
+
+   /// Culling, sorting and conversion of sprites into vertexes of device.
+   double convert_seconds;
+   /// Locking and unlocking of vertex buffers.
+   double upload_seconds;
+   /// Clearing, setting state and issuing draws (rasterization for software renderer).
+   double draw_seconds;
+   double present_seconds;
+};
+
+/// Zeroes all counters and times.
+void clear_render_stats(Render_stats& stats);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Logs stats averaged over every given number of frames through LOG_RENDERER, so that regressions show up
+/// in logs of released application. Used by renderers; disabled by default.
+class Render_stats_log : boost::noncopyable
+{
+public:
+
+   Render_stats_log();
+   // copying is disallowed
+
+   /// \param frames Number of frames per message; 0 disables logging.
+   void set_period(uint frames);
+
+   /// Adds stats of frame; logs averages once period is over.
+   void add_frame(const Render_stats& stats);
+
+private:
+
+   uint         m_period;
+   /// Frames added since last message.
+   uint         m_frames;
+   Render_stats m_sum;
+   /// Sum of vertex bytes, which could overflow 32 bits.
+   double       m_vertex_bytes;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_RENDER_STATS_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
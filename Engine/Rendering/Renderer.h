@@ -15,7 +15,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include "Engine/Rendering/Render_stats.h"
+#include "Engine/Rendering/Scene_buffer.h"
 #include "Engine/Rendering/Sprite.h"
+#include "Engine/Rendering/Sprite_instance.h"
 
 #include "boost/noncopyable.hpp"
 
@@ -30,6 +33,8 @@ namespace Rendering
 
 /// Rendering device for sprites.
 /// Accumulates sprites into scene and render that scene afterwards.
+/// Sprites that persist across frames could be retained instead: they are created once, drawn by every
+/// render_scene() and updated only when changed, so renderer doesn't process unchanged ones again.
 class Renderer : private boost::noncopyable
 {
 public:
@@ -46,18 +51,60 @@ public:
    // Adds sprite with 2 textures associated to scene.
    virtual void add_to_scene(const Multitextured_2_sprite&)     = 0;
 
+   /// Adds all sprites of buffer to scene, sprites of each type in order they were added to buffer.
+   /// Buffers let several threads prepare scene (see Parallel_scene); renderer itself is used by single thread.
+   virtual void add_to_scene(const Scene_buffer&)               = 0;
+
+   /// Adds textured sprite per instance, in order of instances; each is drawn as the sprite expand_instances()
+   /// makes of it.
+   virtual void add_to_scene(const Sprite_instances&)           = 0;
+
    /// Render scene on screen.
+   /// Sprites added to scene are drawn in order of their sort keys (see Render_queue): opaque ones grouped
+   /// by textures, then translucent ones back to front. Sprites with equal keys are drawn in order they were added.
    virtual void render_scene() = 0;
 
-   /// Clear scene: remove all sprites.
+   /// Clear scene: remove all sprites added to it. Retained sprites stay.
    virtual void clear_scene() = 0;
 
+   /// Retains colored sprite. Opaque retained sprites are drawn before sprites added to scene, in unspecified order.
+   /// Translucent ones are drawn back to front after opaque sprites added to scene, before translucent ones.
+   /// \return Handle that stays valid until sprite is destroyed.
+   virtual Colored_sprite_handle create_sprite(const Colored_sprite&)                             = 0;
+
+   /// Retains textured sprite.
+   virtual Textured_sprite_handle create_sprite(const Textured_sprite&)                           = 0;
+
+   /// Retains sprite with 2 textures associated.
+   virtual Multitextured_2_sprite_handle create_sprite(const Multitextured_2_sprite&)             = 0;
+
+   /// Replaces retained sprite.
+   virtual void update_sprite(Colored_sprite_handle, const Colored_sprite&)                       = 0;
+
+   /// Replaces retained sprite.
+   virtual void update_sprite(Textured_sprite_handle, const Textured_sprite&)                     = 0;
+
+   /// Replaces retained sprite.
+   virtual void update_sprite(Multitextured_2_sprite_handle, const Multitextured_2_sprite&)       = 0;
+
+   /// Stops drawing retained sprite; its handle becomes invalid.
+   virtual void destroy_sprite(Colored_sprite_handle)                                             = 0;
+
+   /// Stops drawing retained sprite; its handle becomes invalid.
+   virtual void destroy_sprite(Textured_sprite_handle)                                            = 0;
+
+   /// Stops drawing retained sprite; its handle becomes invalid.
+   virtual void destroy_sprite(Multitextured_2_sprite_handle)                                     = 0;
+
    /// Is renderer in focus? (So user sees scene rendered etc.)
    virtual bool is_focused() const = 0;
 
    /// Try to restore device if it's not focused.
    /// It is not quaranteed that it would succeed.
    virtual void try_restore() = 0;
+
+   /// \return What the last render_scene() cost; see Render_stats.
+   virtual const Render_stats& get_render_stats() const = 0;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
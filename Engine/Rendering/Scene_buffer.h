@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Buffers for building scene from several threads.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SCENE_BUFFER_H_INCLUDED
+#define ENGINE_RENDERING_SCENE_BUFFER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+#include "boost/scoped_array.hpp"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+class Renderer;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprites collected for scene apart from renderer; renderer takes them at once
+/// (see Renderer::add_to_scene(const Scene_buffer&)).
+/// Buffer isn't synchronized, but different buffers could be filled by different threads at the same time.
+/// Note that constructing Texture_ID from file name isn't thread-safe (see Texture_registry), so threads other
+/// than rendering one should take Texture_IDs created before they start, rather than file names.
+class Scene_buffer : boost::noncopyable
+{
+public:
+
+   Scene_buffer() { }
+   // copying is disallowed
+
+   void add_to_scene(const Colored_sprite& s)                     { m_colored.push_back(s); }
+   void add_to_scene(const Textured_sprite& s)                    { m_textured.push_back(s); }
+   void add_to_scene(const Multitextured_2_sprite& s)             { m_multitextured.push_back(s); }
+
+   /// Removes all sprites; memory is kept for the next frame.
+   void clear();
+
+   bool is_empty() const;
+
+   /// Sprites in order they were added.
+   const std::vector<Colored_sprite>& get_colored_sprites() const                 { return m_colored; }
+   const std::vector<Textured_sprite>& get_textured_sprites() const               { return m_textured; }
+   const std::vector<Multitextured_2_sprite>& get_multitextured_sprites() const   { return m_multitextured; }
+
+private:
+
+   std::vector<Colored_sprite>         m_colored;
+   std::vector<Textured_sprite>        m_textured;
+   std::vector<Multitextured_2_sprite> m_multitextured;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Scene built by several threads at once: thread i adds its sprites to get_buffer(i), no locks are taken.
+/// Buffers are submitted to renderer in order of their indexes, so resulting scene doesn't depend on
+/// how threads were scheduled.
+/// Textures of sprites should be interned into Texture_IDs before threads start (see Scene_buffer).
+class Parallel_scene : boost::noncopyable
+{
+public:
+
+   explicit Parallel_scene(uint threads_number);
+   // copying is disallowed
+
+   uint get_threads_number() const                                { return m_threads_number; }
+
+   Scene_buffer& get_buffer(uint thread);
+
+   /// Adds sprites of all buffers to scene of renderer, then clears buffers.
+   /// Should be called after all threads are done with their buffers, from thread renderer is used by.
+   void submit(Renderer& renderer);
+
+private:
+
+   /// Buffer that doesn't share cache line with buffers of other threads.
+   struct Slot
+   {
+      char         padding_before[64];
+      Scene_buffer buffer;
+      char         padding_after[64];
+   };
+
+private:
+
+   uint                       m_threads_number;
+   boost::scoped_array<Slot>  m_slots;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SCENE_BUFFER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
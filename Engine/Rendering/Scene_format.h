@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Binary format of recorded Renderer calls.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SCENE_FORMAT_H_INCLUDED
+#define ENGINE_RENDERING_SCENE_FORMAT_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+#include <stdexcept>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Scene stream is written by Recording_renderer and read by Scene_player.
+//
+// Stream starts with signature "SCNR" and 32-bit version. Records follow; each starts with 1-byte type:
+// - texture: 32-bit texture handle, 16-bit length of file name, file name;
+//   defines handle that following sprites refer to; each handle is defined once, before its first use;
+//   handles are given densely from 1 in order of definition, so that player could bound its table by them;
+// - sprite: for each of 4 vertexes: x, y, z, color (a, r, g, b bytes), texture coordinates (if any);
+//   then for each texture: 32-bit handle (0 for none) and 1-byte blending mode;
+// - render, clear: no data;
+// - create, update: 32-bit handle of retained sprite, then sprite record (type and data as above);
+//   handles are the ones recorded renderer returned, independent for each sprite type;
+// - destroy: 32-bit handle of retained sprite, 1-byte sprite record type.
+// Numbers are in host byte order (little-endian on all platforms we support).
+
+const char scene_signature[4]   = { 'S', 'C', 'N', 'R' };
+const uint scene_version        = 3;
+/// Earlier versions have texture handles of registry that recorded, which aren't dense.
+const uint scene_oldest_version = 3;
+
+enum Scene_record_type
+{
+   scene_record_texture = 1
+   , scene_record_colored
+   , scene_record_textured
+   , scene_record_multitextured
+   , scene_record_render
+   , scene_record_clear
+   , scene_record_create
+   , scene_record_update
+   , scene_record_destroy
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Scene stream is malformed.
+class Scene_format_exception : public std::runtime_error
+{
+public:
+   explicit Scene_format_exception(const std::string& msg) : std::runtime_error(msg) { }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SCENE_FORMAT_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
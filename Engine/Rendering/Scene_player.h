@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Replaying of recorded scenes.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SCENE_PLAYER_H_INCLUDED
+#define ENGINE_RENDERING_SCENE_PLAYER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Renderer.h"
+#include "Engine/Rendering/Scene_format.h"
+
+#include "boost/noncopyable.hpp"
+
+#include <cstddef>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Feeds scene recorded by Recording_renderer to any renderer, frame by frame.
+/// Recorded texture handles are mapped to handles of current process, so stream could be played anywhere.
+class Scene_player : boost::noncopyable
+{
+public:
+
+   /// \param data Recorded stream; isn't copied, so should outlive player.
+   /// \throw Scene_format_exception if stream header is wrong.
+   Scene_player(const char* data, std::size_t size);
+   // copying is disallowed
+
+   /// Plays recorded calls up to and including the next render_scene().
+   /// \return false if stream ended before render_scene().
+   /// \throw Scene_format_exception if stream is malformed.
+   bool play_frame(Renderer& renderer);
+
+   /// Starts playing from the beginning of stream.
+   /// \param renderer Renderer stream was played to; retained sprites created by played records are destroyed there.
+   void rewind(Renderer& renderer);
+
+private:
+
+   template <class T>
+   void read(T& value);
+   void read_vertex(Vertex<Vertex_format(position | diffuse_color)>& v);
+   void read_vertex(Vertex<Vertex_format(position | diffuse_color | texture_coord0)>& v);
+   void read_vertex(Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>& v);
+   void read_stage(Texture_ID& texture, Blending_mode& blending);
+   void read_texture();
+   void read_sprite(Colored_sprite& s);
+   void read_sprite(Textured_sprite& s);
+   void read_sprite(Multitextured_2_sprite& s);
+
+   /// Plays create, update or destroy record of retained sprite.
+   void play_retained(Renderer& renderer, uchar type);
+   template <Vertex_format format>
+   void play_retained(Renderer& renderer, uchar type, uint id, std::vector<uint>& handles);
+   template <Vertex_format format>
+   void destroy_retained(Renderer& renderer, std::vector<uint>& handles);
+
+private:
+
+   const char*             m_end;
+   /// Position of the first record.
+   const char*             m_records;
+   const char*             m_cur;
+   /// Recorded handle -> identifier in current process; handle 0 is no texture.
+   std::vector<Texture_ID> m_textures;
+   /// Recorded handle of retained sprite -> handle given by renderer played to.
+   std::vector<uint>       m_colored_handles;
+   std::vector<uint>       m_textured_handles;
+   std::vector<uint>       m_multitextured_handles;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SCENE_PLAYER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Renderer that rasterizes sprites on CPU.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SOFTWARE_SOFTWARE_RENDERER_H_INCLUDED
+#define ENGINE_RENDERING_SOFTWARE_SOFTWARE_RENDERER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Renderer.h"
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Batch.h"
+#include "Engine/Rendering/Culling.h"
+#include "Engine/Rendering/Image.h"
+#include "Engine/Rendering/Render_queue.h"
+#include "Engine/Rendering/Sprite_store.h"
+#include "Engine/Rendering/Texture_cache.h"
+#include "Engine/Rendering/Texture_streamer.h"
+
+#include "boost/scoped_ptr.hpp"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Raster_vertex;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Renderer that rasterizes sprites into A8R8G8B8 frame in system memory; doesn't need any window or device.
+/// Follows Direct3D_renderer conventions, so both produce the same picture:
+/// - positions are pretransformed screen coordinates; pixel centers are at +0.5;
+/// - depth test is "less or equal" against depth buffer cleared to 1;
+/// - blending modes work as texture stage operations: arg1 is texture, arg2 is result of previous stage
+///   (diffuse color for the first stage); stage without texture passes its arg2 through;
+/// - textures are sampled with nearest filter and wrap addressing.
+class Software_renderer : public Renderer, private Batch_device
+{
+public:
+
+   typedef Texture_cache<Image_ptr>::Loader Texture_loader;
+
+public:
+
+   /// Constructs renderer with textures loaded from BMP or DDS files; DDS ones are decompressed.
+   Software_renderer(uint width, uint height);
+
+   /// Constructs renderer with custom texture loader.
+   Software_renderer(uint width, uint height, Texture_loader loader);
+
+   // copying is disallowed via base class
+
+// Renderer interface
+public:
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Textured_sprite&);
+
+   // \see base class for details.
+   virtual void add_to_scene(const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Scene_buffer&);
+
+   /// \see base class for details.
+   virtual void add_to_scene(const Sprite_instances&);
+
+   /// \see base class for details.
+   virtual void render_scene();
+
+   /// \see base class for details.
+   virtual void clear_scene();
+
+   /// \see base class for details.
+   virtual Colored_sprite_handle create_sprite(const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual Textured_sprite_handle create_sprite(const Textured_sprite&);
+
+   /// \see base class for details.
+   virtual Multitextured_2_sprite_handle create_sprite(const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Colored_sprite_handle, const Colored_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Textured_sprite_handle, const Textured_sprite&);
+
+   /// \see base class for details.
+   virtual void update_sprite(Multitextured_2_sprite_handle, const Multitextured_2_sprite&);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Colored_sprite_handle);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Textured_sprite_handle);
+
+   /// \see base class for details.
+   virtual void destroy_sprite(Multitextured_2_sprite_handle);
+
+   /// Frame is always available.
+   virtual bool is_focused() const;
+
+   /// Nothing to restore.
+   virtual void try_restore();
+
+   /// Upload and present times are zero, as is number of vertex bytes: sprites are rasterized right away.
+   virtual const Render_stats& get_render_stats() const;
+
+public:
+
+   /// \return Frame drawn by last render_scene().
+   const Image& get_frame() const                                                { return m_frame; }
+
+   /// Sets maximal size of memory occupied by loaded textures.
+   void set_texture_budget(uint bytes)                                           { m_textures.set_budget(bytes); }
+
+   /// \return Texture cache hits, misses and evictions.
+   const Texture_cache_statistics& get_texture_statistics() const                { return m_textures.get_statistics(); }
+
+   /// Makes textures load in background by given number of threads rather than when they are first drawn.
+   /// Until texture is loaded its sprites get placeholder, single white texel, so they show diffuse color.
+   /// Loaded textures are taken at the beginning of render_scene(); ones that fail to load are logged
+   /// and stay placeholders.
+   /// \note Textures are loaded from BMP or DDS files, custom loader isn't used.
+   void enable_texture_streaming(uint threads);
+
+   /// Starts loading texture before it is drawn, e.g. while level loads:
+   /// in background if streaming is enabled, right away otherwise.
+   void prefetch_texture(const Texture_ID& id);
+
+   /// Blocks until streamed textures are loaded and takes them, so they are drawn by the next frame.
+   void wait_for_textures();
+
+   /// Makes textures found in pack be taken from it, before they are loaded or streamed otherwise.
+   /// Rasterizer samples its own images, so pixels are copied from pack and blocks are decompressed.
+   /// \param pack Pack that should outlive renderer; null stops using pack.
+   void set_asset_pack(const Asset_pack* pack)                                   { m_pack = pack; }
+
+   /// \return Numbers of sprites culled during last render_scene().
+   const Culling_statistics& get_culling_statistics() const                      { return m_culling; }
+
+   /// Makes render_scene() log stats averaged over given number of frames; 0 disables logging.
+   void set_stats_log_period(uint frames)                                        { m_stats_log.set_period(frames); }
+
+// Batch_device interface
+private:
+
+   virtual void set_vertex_format(Vertex_format format);
+   virtual void set_texture(uint nstage, const Texture_ID& id);
+   virtual void set_blending(uint nstage, Blending_mode mode);
+   virtual void draw_quads(uint first_quad, uint nquads);
+
+private:
+
+   /// Puts textures loaded by streamer into cache.
+   void take_streamed_textures();
+
+   /// Puts texture from asset pack into cache.
+   /// \return false if texture isn't in pack.
+   bool take_packed_texture(const Texture_ID& id, Image_ptr& texture);
+
+   void draw_quad(const Raster_vertex* v);
+   void draw_triangle(const Raster_vertex& v0, const Raster_vertex& v1, const Raster_vertex& v2);
+
+private:
+
+   std::vector<Colored_sprite>         m_sprites_colored;
+   std::vector<Textured_sprite>        m_sprites_textured;
+   std::vector<Multitextured_2_sprite> m_sprites_multitextured;
+   /// Batches of opaque sprites added to scene.
+   Batch_list                          m_batches;
+   /// Batches of translucent sprites added to scene; drawn after translucent retained ones.
+   Batch_list                          m_translucent_batches;
+   /// Sorts sprites added to scene in draw order.
+   Render_queue                        m_queue;
+
+   Sprite_store<Vertex_format(position | diffuse_color)>                                   m_retained_colored;
+   Sprite_store<Vertex_format(position | diffuse_color | texture_coord0)>                  m_retained_textured;
+   Sprite_store<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> m_retained_multitextured;
+   /// Batches of opaque retained sprites; compiled again only when retained sprites change.
+   Batch_list                                                                              m_retained_batches;
+   /// Batches of translucent retained sprites, back to front; drawn after opaque sprites added to scene.
+   Batch_list                                                                              m_retained_translucent;
+   /// Entries of visible translucent retained sprites, kept to avoid allocations.
+   std::vector<Queue_entry>                                                                m_translucent_entries;
+   /// Slots of visible retained sprites.
+   std::vector<uint>                                                                       m_visible_slots;
+   Culling_statistics                                                                      m_culling;
+
+   Render_stats            m_stats;
+   Render_stats_log        m_stats_log;
+   /// Textures created since last render_scene() finished.
+   uint                    m_texture_loads;
+
+   Image                   m_frame;
+   std::vector<float>      m_depths;
+   Texture_cache<Image_ptr> m_textures;
+   /// Null unless streaming is enabled.
+   boost::scoped_ptr<Texture_streamer> m_streamer;
+   Image_ptr               m_placeholder;
+   std::vector<Streamed_image> m_streamed;
+   /// Null unless pack is set.
+   const Asset_pack*       m_pack;
+
+   // current state set by draw_batches()
+   Vertex_format           m_format;
+   /// Whether draw_quads() takes retained sprites or ones added to scene.
+   bool                    m_drawing_retained;
+   Image_ptr               m_stage_textures[batch_stages_number];
+   Blending_mode           m_stage_blendings[batch_stages_number];
+
+   // buffers for single span
+   std::vector<uint>       m_span;
+   std::vector<uint>       m_texels;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SOFTWARE_SOFTWARE_RENDERER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Operations on horizontal spans of A8R8G8B8 pixels used by software rasterizer.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SOFTWARE_SPAN_H_INCLUDED
+#define ENGINE_RENDERING_SOFTWARE_SPAN_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// All functions process 4 pixels per step with SSE2 if it is available (see Common/Simd.h);
+// results are the same as of plain C++ code.
+// Channels are processed independently, alpha the same way as colors.
+
+/// Fills n pixels with color.
+void fill_span(uint* pixels, uint color, uint n);
+
+/// Writes interpolated colors: channel k of pixel i is set to int(channels[k] + i*steps[k]) clamped to [0, 255].
+/// Channels go in memory order of A8R8G8B8 pixel: blue, green, red, alpha.
+void interpolate_span(uint* pixels, const float channels[4], const float steps[4], uint n);
+
+/// Multiplies pixels by arguments: pixel = pixel*arg/255 (rounded), per channel.
+void modulate_span(uint* pixels, const uint* args, uint n);
+
+/// Adds arguments to pixels with saturation, per channel.
+void add_span(uint* pixels, const uint* args, uint n);
+
+/// Writes pixels into frame buffer with depth test.
+/// Depth of pixel i is z + i*dz; pixel passes the test if its depth is less or equal than stored one.
+/// Depth buffer is updated for passed pixels.
+void write_span(uint* frame, float* depths, const uint* pixels, float z, float dz, uint n);
+
+/// Same as above for pixels of single color.
+void write_span(uint* frame, float* depths, uint color, float z, float dz, uint n);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SOFTWARE_SPAN_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -16,8 +16,7 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "Engine/Rendering/Vertex.h"
-
-#include <string>
+#include "Engine/Rendering/Texture_ID.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -28,17 +27,6 @@ namespace Rendering
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-/// Identifier of texture.
-struct Texture_ID
-{
-   std::string file_name;
-};
-
-inline bool operator==(const Texture_ID& lhs, const Texture_ID& rhs) { return lhs.file_name == rhs.file_name; }
-inline bool operator!=(const Texture_ID& lhs, const Texture_ID& rhs) { return !(lhs == rhs); }
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
 /// Sprite primary template.
 /// Specializations typically hold graphical data that depend on Vertex_format.
 template <Vertex_format>
@@ -88,6 +76,20 @@ typedef Sprite<Vertex_format(position | diffuse_color | texture_coord0 | texture
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Handle of sprite retained by renderer (see Renderer::create_sprite()).
+/// Handles of different formats are independent.
+template <Vertex_format>
+struct Sprite_handle
+{
+   uint id;
+};
+
+typedef Sprite_handle<Vertex_format(position | diffuse_color)>                                   Colored_sprite_handle;
+typedef Sprite_handle<Vertex_format(position | diffuse_color | texture_coord0)>                  Textured_sprite_handle;
+typedef Sprite_handle<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> Multitextured_2_sprite_handle;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace Rendering
 } // namespace Engine
 
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compact sprites given by placement rather than corners.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SPRITE_INSTANCE_H_INCLUDED
+#define ENGINE_RENDERING_SPRITE_INSTANCE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textured sprite given by placement: rectangle centered at (x, y), turned around its center and showing
+/// rectangle of texture; all corners have the same color. Takes 32 bytes, while Textured_sprite takes 104,
+/// and rotating it is changing single number.
+struct Sprite_instance
+{
+   /// Center in screen coordinates.
+   float         x, y;
+   /// Halves of width and height.
+   float         half_width, half_height;
+   /// Angle in radians; positive one turns sprite clockwise on screen, since y goes down.
+   float         rotation;
+   Diffuse_color color;
+   /// Rectangle of texture: left, top, right and bottom texture coordinates in 1/65535 units, so 65535 stands
+   /// for 1. Sprites that rely on wrapping need coordinates outside of [0, 1], so they stay Textured_sprite.
+   ushort        u0, v0, u1, v1;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Instances sharing texture, blending and depth, submitted to renderer at once (see Renderer::add_to_scene()).
+struct Sprite_instances
+{
+   const Sprite_instance* instances;
+   uint                   number;
+   Texture_ID             texture;
+   Blending_mode          blending;
+   float                  z;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes textured sprite per instance. Corners go in the same order main application uses:
+/// top-left, bottom-left, bottom-right, top-right of unturned rectangle.
+/// Computes 4 instances at once with SSE2 if it is available (see Common/Simd.h), sine and cosine included;
+/// results are the same as of plain C++ code.
+/// \param where instances.number sprites.
+void expand_instances(const Sprite_instances& instances, Textured_sprite* where);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SPRITE_INSTANCE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Structure-of-arrays storage of sprites for bulk transforms.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SPRITE_POOL_H_INCLUDED
+#define ENGINE_RENDERING_SPRITE_POOL_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Batch.h"
+#include "Engine/Rendering/Vertex_conversion.h"
+#include "Engine/Rendering/Vertex_ring.h"
+
+#include "Common/Typedefs.h"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Keeps sprites of one format as separate contiguous arrays of x, y, z, colors, texture coordinates, textures
+/// and blendings, so that moving or recoloring many sprites touches only the data it needs and is done with SIMD.
+/// Per-vertex arrays hold 4 elements per sprite, corners in the same order as in Sprite::vertexes;
+/// colors are packed as 0xAARRGGBB (D3DCOLOR).
+/// Defined for formats of Colored_sprite, Textured_sprite and Multitextured_2_sprite.
+template <Vertex_format format>
+class Sprite_pool
+{
+public:
+
+   typedef Sprite<format> Sprite_type;
+
+   enum { stages_number = (format & texture_coord1) ? 2 : (format & texture_coord0) ? 1 : 0 };
+
+public:
+
+   /// Appends sprite.
+   /// \return Index of sprite.
+   uint add(const Sprite_type& s);
+
+   /// Replaces sprite.
+   void set(uint index, const Sprite_type& s);
+
+   Sprite_type get(uint index) const;
+
+   /// Removes sprite; the last sprite takes its index.
+   void remove(uint index);
+
+   void clear();
+
+   void reserve(uint sprites_number);
+
+   uint get_size() const                                          { return static_cast<uint>(m_xs.size() / 4); }
+
+   /// Moves all sprites.
+   void translate(float dx, float dy);
+
+   /// Moves every sprite by its own offset.
+   /// \param dxs, dys get_size() offsets each.
+   void translate(const float* dxs, const float* dys);
+
+   /// Scales all sprites relative to given center.
+   void scale(float center_x, float center_y, float sx, float sy);
+
+   /// Multiplies colors of all vertexes by given one, channel by channel (255 stands for 1).
+   void tint(const Diffuse_color& color);
+
+   /// Per-vertex arrays; get_size()*4 elements each.
+   const float* get_xs() const                                    { return m_xs.empty() ? 0 : &m_xs[0]; }
+   const float* get_ys() const                                    { return m_ys.empty() ? 0 : &m_ys[0]; }
+   const float* get_zs() const                                    { return m_zs.empty() ? 0 : &m_zs[0]; }
+   const uint*  get_colors() const                                { return m_colors.empty() ? 0 : &m_colors[0]; }
+   const float* get_tus(uint stage) const;
+   const float* get_tvs(uint stage) const;
+
+   /// Per-sprite state of given texture stage.
+   const Texture_ID&    get_texture(uint index, uint stage) const;
+   Blending_mode        get_blending(uint index, uint stage) const;
+
+private:
+
+   void set_stages(uint index, const Sprite_type& s);
+   void get_stages(uint index, Sprite_type& s) const;
+
+private:
+
+   std::vector<float>         m_xs;
+   std::vector<float>         m_ys;
+   std::vector<float>         m_zs;
+   std::vector<uint>          m_colors;
+   std::vector<float>         m_tus[batch_stages_number];
+   std::vector<float>         m_tvs[batch_stages_number];
+   std::vector<Texture_ID>    m_textures[batch_stages_number];
+   std::vector<Blending_mode> m_blendings[batch_stages_number];
+};
+
+typedef Sprite_pool<Vertex_format(position | diffuse_color)> Colored_sprite_pool;
+typedef Sprite_pool<Vertex_format(position | diffuse_color | texture_coord0)> Textured_sprite_pool;
+typedef Sprite_pool<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>
+        Multitextured_2_sprite_pool;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes 4 vertexes per sprite for sprites [first, first + n) exactly as convert_sprites() does for sprites
+/// stored as array.
+template <Vertex_format format>
+void convert_sprites(const Sprite_pool<format>& pool, uint first, uint n, Device_vertex<format>* where);
+
+/// Appends batches for sprites of pool to list.
+/// Each run of adjacent sprites with the same textures and blendings becomes one batch.
+template <Vertex_format format>
+void compile_batches(const Sprite_pool<format>& pool, Batch_list& batches);
+
+/// Draws all sprites of pool in their order, writing their vertexes by convert_sprites() right into ring,
+/// so that they aren't copied into sprite arrays first. Device sets state and draws as for stream_batches();
+/// its write_quads() isn't called.
+/// \param batches Scratch memory, kept by caller to avoid allocations.
+template <Vertex_format format>
+void stream_pool(const Sprite_pool<format>& pool, Vertex_ring& ring, Stream_device& device, Batch_list& batches);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SPRITE_POOL_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,291 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Storage of retained sprites.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_SPRITE_STORE_H_INCLUDED
+#define ENGINE_RENDERING_SPRITE_STORE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Batch.h"
+#include "Engine/Rendering/Culling.h"
+#include "Engine/Rendering/Render_queue.h"
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Slot of destroyed sprite.
+const uint no_sprite_slot = ~0u;
+
+/// Area where retained sprites are indexed by quadtree; sprites outside of it are tested one by one.
+/// Covers several screens around the visible one.
+const Bounds retained_sprites_world = { -4096, -4096, 8192, 8192 };
+
+/// Depth of quadtree of retained sprites: the smallest cells are 192 pixels wide.
+const uint retained_sprites_depth = 6;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Keeps sprites of one format that renderer draws every frame, addressed by handles.
+/// Sprites are packed into contiguous array; destroyed sprite is replaced by the last one, so sprites order changes.
+/// Slots changed since last clear_dirty() form dirty range, so renderer could upload just them.
+/// Sprites are indexed by quadtree, so ones visible in viewport are found without testing each sprite.
+template <Vertex_format format>
+class Sprite_store : boost::noncopyable
+{
+public:
+
+   typedef Sprite<format>        Sprite_type;
+   typedef Sprite_handle<format> Handle;
+
+public:
+
+   Sprite_store()
+      : m_index(retained_sprites_world, retained_sprites_depth), m_dirty_first(0), m_dirty_end(0), m_changed(false) { }
+   // copying is disallowed
+
+   /// Appends sprite.
+   Handle create(const Sprite_type& s);
+
+   /// Replaces sprite.
+   void update(Handle handle, const Sprite_type& s);
+
+   /// Removes sprite; handle becomes invalid and could be reused by create().
+   void destroy(Handle handle);
+
+   /// \return Sprites in order renderer should draw them.
+   const std::vector<Sprite_type>& get_sprites() const            { return m_sprites; }
+
+   /// Replaces contents of slots with slots of sprites intersecting area, in increasing order.
+   void get_visible_slots(const Bounds& area, std::vector<uint>& slots) const;
+
+   /// \return The first slot changed since last clear_dirty().
+   uint get_dirty_first() const                                   { return m_dirty_first; }
+
+   /// \return Slot after the last one changed since last clear_dirty(); equal to get_dirty_first() if none changed.
+   /// \note Slots of destroyed sprites past the end of array aren't included.
+   uint get_dirty_end() const;
+
+   /// \return true if sprites were created, changed or destroyed since last clear_dirty().
+   bool is_changed() const                                        { return m_changed; }
+
+   /// Marks all sprites dirty, e.g. when their device copy is lost.
+   void mark_all_dirty();
+
+   /// Marks all sprites clean.
+   void clear_dirty();
+
+private:
+
+   uint get_size() const                                          { return static_cast<uint>(m_sprites.size()); }
+
+   void mark_dirty(uint slot);
+
+private:
+
+   std::vector<Sprite_type> m_sprites;
+   /// Slot -> handle of its sprite.
+   std::vector<uint>        m_slot_handles;
+   /// Handle -> slot of its sprite, no_sprite_slot for destroyed sprite.
+   std::vector<uint>        m_handle_slots;
+   /// Handles of destroyed sprites.
+   std::vector<uint>        m_free_handles;
+   /// Bounds of sprites by handles.
+   Loose_quadtree           m_index;
+   uint                     m_dirty_first;
+   uint                     m_dirty_end;
+   bool                     m_changed;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+Sprite_handle<format> Sprite_store<format>::create(const Sprite_type& s)
+{
+   Handle handle;
+   if (m_free_handles.empty())
+   {
+      handle.id = static_cast<uint>(m_handle_slots.size());
+      m_handle_slots.push_back(no_sprite_slot);
+   }
+   else
+   {
+      handle.id = m_free_handles.back();
+      m_free_handles.pop_back();
+   }
+
+   const uint slot = get_size();
+   m_sprites.push_back(s);
+   m_slot_handles.push_back(handle.id);
+   m_handle_slots[handle.id] = slot;
+   m_index.insert(handle.id, get_bounds(s));
+   mark_dirty(slot);
+
+   return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_store<format>::update(Handle handle, const Sprite_type& s)
+{
+   assert(handle.id < m_handle_slots.size() && m_handle_slots[handle.id] != no_sprite_slot && "Invalid sprite handle");
+
+   const uint slot = m_handle_slots[handle.id];
+   m_sprites[slot] = s;
+   m_index.move(handle.id, get_bounds(s));
+   mark_dirty(slot);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_store<format>::destroy(Handle handle)
+{
+   assert(handle.id < m_handle_slots.size() && m_handle_slots[handle.id] != no_sprite_slot && "Invalid sprite handle");
+
+   // move the last sprite into the hole
+   const uint slot = m_handle_slots[handle.id];
+   const uint last = get_size() - 1;
+   if (slot != last)
+   {
+      m_sprites[slot] = m_sprites[last];
+      m_slot_handles[slot] = m_slot_handles[last];
+      m_handle_slots[m_slot_handles[slot]] = slot;
+      mark_dirty(slot);
+   }
+   m_sprites.pop_back();
+   m_slot_handles.pop_back();
+
+   m_handle_slots[handle.id] = no_sprite_slot;
+   m_free_handles.push_back(handle.id);
+   m_index.remove(handle.id);
+   m_changed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_store<format>::get_visible_slots(const Bounds& area, std::vector<uint>& slots) const
+{
+   slots.clear();
+   m_index.query(area, slots);
+   for (size_t i = 0; i < slots.size(); ++i)
+   {
+      slots[i] = m_handle_slots[slots[i]];
+   }
+   std::sort(slots.begin(), slots.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+uint Sprite_store<format>::get_dirty_end() const
+{
+   return std::max(m_dirty_first, std::min(m_dirty_end, get_size()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_store<format>::mark_all_dirty()
+{
+   m_dirty_first = 0;
+   m_dirty_end   = get_size();
+   m_changed     = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_store<format>::clear_dirty()
+{
+   m_dirty_first = 0;
+   m_dirty_end   = 0;
+   m_changed     = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_store<format>::mark_dirty(uint slot)
+{
+   if (m_dirty_first == m_dirty_end)
+   {
+      m_dirty_first = slot;
+      m_dirty_end   = slot + 1;
+   }
+   else
+   {
+      m_dirty_first = std::min(m_dirty_first, slot);
+      m_dirty_end   = std::max(m_dirty_end, slot + 1);
+   }
+   m_changed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Appends batches of opaque retained sprites that intersect viewport. Translucent ones are to be drawn back to
+/// front after opaque sprites, so their entries are appended to translucent instead (see Render_queue).
+/// \param slots Scratch memory, kept by caller to avoid allocations.
+/// \return Number of sprites culled.
+template <Vertex_format format>
+uint compile_visible_batches(const Sprite_store<format>& store, const Bounds& viewport, std::vector<uint>& slots,
+                             Batch_list& batches, std::vector<Queue_entry>& translucent)
+{
+   store.get_visible_slots(viewport, slots);
+
+   const std::vector<Sprite<format> >& sprites = store.get_sprites();
+   size_t opaque = 0;
+   for (size_t i = 0; i < slots.size(); ++i)
+   {
+      const Queue_entry entry = { make_sort_key(sprites[slots[i]]), format, slots[i] };
+      if (is_translucent(entry.key))
+      {
+         translucent.push_back(entry);
+      }
+      else
+      {
+         slots[opaque++] = slots[i];
+      }
+   }
+   const size_t visible = slots.size();
+   slots.resize(opaque);
+
+   compile_batches(sprites, slots, batches);
+   return static_cast<uint>(sprites.size() - visible);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_SPRITE_STORE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
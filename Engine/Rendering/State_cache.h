@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Shadow copy of device state that drops redundant state calls.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_STATE_CACHE_H_INCLUDED
+#define ENGINE_RENDERING_STATE_CACHE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Number of texture stages whose state is cached; Direct3D 9 devices have at most 8.
+const uint state_cache_stages = 8;
+
+/// Stage state types below this one are cached; covers all D3DTEXTURESTAGESTATETYPE values.
+const uint state_cache_stage_states = 33;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// State calls of device, made only when they change state.
+/// Implemented by rendering backends; objects are identified by addresses, so device should keep object
+/// it is given alive until another one replaces it, as Direct3D does by reference counting.
+class State_device
+{
+public:
+
+   virtual ~State_device() { }
+
+   /// Assigns texture to stage; null resets stage texture.
+   virtual void set_texture(uint nstage, const void* texture)                         = 0;
+
+   /// Sets state of stage, e.g. color operation.
+   virtual void set_texture_stage_state(uint nstage, uint type, uint value)           = 0;
+
+   /// Sets vertex format, e.g. FVF code.
+   virtual void set_vertex_format(uint format)                                        = 0;
+
+   /// Binds vertex buffer as source of vertexes.
+   virtual void set_stream_source(const void* buffer, uint offset, uint vertex_bytes) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Counters of state calls.
+struct State_cache_statistics
+{
+   /// Calls passed to device.
+   uint issued;
+   /// Calls dropped since they don't change state.
+   uint filtered;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Remembers state set through it and passes to device only calls that change that state.
+/// State is unknown at first and after invalidate(), so the first call of each kind is always passed.
+/// Stages and stage states beyond cached ones are always passed.
+class State_cache : boost::noncopyable
+{
+public:
+
+   /// \param device Device that should outlive cache.
+   explicit State_cache(State_device& device);
+   // copying is disallowed
+
+   void set_texture(uint nstage, const void* texture);
+
+   void set_texture_stage_state(uint nstage, uint type, uint value);
+
+   void set_vertex_format(uint format);
+
+   void set_stream_source(const void* buffer, uint offset, uint vertex_bytes);
+
+   /// Forgets state, so that every next call is passed once; needed when device state is changed
+   /// bypassing cache, e.g. by device reset.
+   void invalidate();
+
+   /// \return Numbers of calls issued and filtered since construction or last reset_statistics().
+   const State_cache_statistics& get_statistics() const           { return m_statistics; }
+
+   void reset_statistics();
+
+private:
+
+   State_device&          m_device;
+
+   bool                   m_is_texture_known[state_cache_stages];
+   const void*            m_textures[state_cache_stages];
+   bool                   m_is_stage_state_known[state_cache_stages][state_cache_stage_states];
+   uint                   m_stage_states[state_cache_stages][state_cache_stage_states];
+   bool                   m_is_format_known;
+   uint                   m_format;
+   bool                   m_is_stream_known;
+   const void*            m_stream_buffer;
+   uint                   m_stream_offset;
+   uint                   m_stream_vertex_bytes;
+
+   State_cache_statistics m_statistics;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_STATE_CACHE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Texture identifier.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_TEXTURE_ID_H_INCLUDED
+#define ENGINE_RENDERING_TEXTURE_ID_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Common/Typedefs.h"
+
+#include <string>
+#include <cstddef>              // for size_t
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Identifier of texture.
+/// File names are interned (see Texture_registry), so identifier is just 32-bit handle:
+/// it is copied, compared and hashed without touching the string.
+class Texture_ID
+{
+public:
+
+   /// Constructs empty identifier: no texture.
+   Texture_ID() : m_handle(0) { }
+
+   /// Constructs identifier of texture loaded from given file.
+   /// The same file names give equal identifiers.
+   explicit Texture_ID(const std::string& file_name);
+
+   // default copying is ok
+
+   /// \return Name of file texture is loaded from; empty for empty identifier.
+   const std::string& get_file_name() const;
+
+   /// \return Dense handle: 0 for empty identifier, small consecutive numbers for others.
+   uint get_handle() const                                       { return m_handle; }
+
+private:
+
+   uint m_handle;
+};
+
+inline bool operator==(const Texture_ID& lhs, const Texture_ID& rhs) { return lhs.get_handle() == rhs.get_handle(); }
+inline bool operator!=(const Texture_ID& lhs, const Texture_ID& rhs) { return !(lhs == rhs); }
+inline bool operator< (const Texture_ID& lhs, const Texture_ID& rhs) { return lhs.get_handle() < rhs.get_handle(); }
+
+/// Hash function (boost::hash compatible).
+inline std::size_t hash_value(const Texture_ID& id)                 { return id.get_handle(); }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Global table of interned texture file names.
+/// \note Not thread-safe: textures should be identified from rendering thread; other threads, e.g. ones filling
+///       Scene_buffer, could only copy Texture_IDs created there.
+class Texture_registry
+{
+public:
+
+   /// Gets handle of file name; registers name if it is met first time.
+   static uint               intern(const std::string& file_name);
+
+   /// Gets file name by handle.
+   static const std::string& get_file_name(uint handle);
+
+   /// \return Number of handles given out, including handle of empty name.
+   static uint               get_size();
+
+private:
+
+   // no need to create, copy or destroy objects
+   Texture_registry();
+   Texture_registry(const Texture_registry&);
+   Texture_registry& operator=(const Texture_registry&);
+   ~Texture_registry();
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline Texture_ID::Texture_ID(const std::string& file_name)
+   : m_handle(Texture_registry::intern(file_name))
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline const std::string& Texture_ID::get_file_name() const
+{
+   return Texture_registry::get_file_name(m_handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_TEXTURE_ID_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Packing of many textures into few atlas pages.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_TEXTURE_ATLAS_H_INCLUDED
+#define ENGINE_RENDERING_TEXTURE_ATLAS_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Image.h"
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Places rectangles into page with skyline bottom-left heuristic.
+/// Skyline is the upper edge of occupied space; rectangle goes where its top would be the lowest,
+/// space under skyline is never reused.
+class Skyline_packer
+{
+public:
+
+   Skyline_packer(uint width, uint height);
+
+   // default copying is ok
+
+   /// Finds place for rectangle and marks it as occupied.
+   /// \return false if rectangle doesn't fit.
+   bool insert(uint width, uint height, uint& x, uint& y);
+
+   uint get_width() const                                         { return m_width; }
+   uint get_height() const                                        { return m_height; }
+
+private:
+
+   /// Horizontal piece of skyline.
+   struct Segment
+   {
+      uint x;
+      uint y;
+      uint width;
+   };
+
+private:
+
+   /// \return Whether rectangle fits if its left edge is at segment; y is the lowest top it could have there.
+   bool fit(size_t nsegment, uint width, uint height, uint& y) const;
+
+private:
+
+   uint                  m_width;
+   uint                  m_height;
+   /// Segments from left to right, covering the whole width.
+   std::vector<Segment>  m_skyline;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Place of texture in atlas.
+struct Atlas_region
+{
+   /// Texture of atlas page.
+   Texture_ID page;
+   /// Texture coordinates of region corners within page.
+   float      u0, v0, u1, v1;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Atlas description can't be read or written.
+class Atlas_exception : public std::runtime_error
+{
+public:
+   explicit Atlas_exception(const std::string& msg) : std::runtime_error(msg) { }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textures packed into pages, so that sprites of different textures could share batch.
+/// Pages are ordinary BMP files, so renderers load them as any other texture.
+/// Atlas is either packed at runtime (add() and pack(), then save() to write pages) or prepared offline
+/// by Atlas_builder and loaded from its description.
+/// Sprites are moved to atlas by remap() when they are submitted.
+class Texture_atlas : boost::noncopyable
+{
+public:
+
+   Texture_atlas() { }
+   // copying is disallowed
+
+   /// Adds texture to be packed by the next pack().
+   void add(const Texture_ID& id, const Image& image);
+
+   /// Packs textures added since the last pack() into pages of given size, named "<name>_<n>.bmp".
+   /// Each texture is surrounded by 1 texel border copied from its edges, so filtering doesn't pick
+   /// neighbours; textures that don't fit into page with their border are left out of atlas.
+   void pack(uint page_size, const std::string& name);
+
+   /// Writes pages as BMP files and description into given file.
+   /// \throw Image_exception, Atlas_exception if files can't be written.
+   void save(const std::string& description_file) const;
+
+   /// Reads description of atlas written by save(); pages are not loaded.
+   /// \throw Atlas_exception if description can't be read.
+   void load(const std::string& description_file);
+
+   /// Finds region of texture.
+   /// \return false if texture isn't in atlas.
+   bool find(const Texture_ID& id, Atlas_region& region) const;
+
+   /// Replaces texture of sprite with atlas page and maps its texture coordinates into region.
+   /// Sprites with coordinates outside of [0, 1] rely on wrapping, so they are left as is.
+   /// \return false if sprite is left as is.
+   bool remap(Textured_sprite& s) const;
+
+   /// Remaps both stages independently (see above).
+   /// \return false if neither stage is remapped.
+   bool remap(Multitextured_2_sprite& s) const;
+
+   /// \return Images of pages; empty for loaded atlas.
+   const std::vector<Image>& get_pages() const                    { return m_pages; }
+
+   /// \return Number of textures in atlas.
+   uint get_size() const;
+
+private:
+
+   /// Texture waiting for pack().
+   struct Source
+   {
+      Texture_ID id;
+      Image      image;
+   };
+
+   /// Placement of texture as description keeps it.
+   struct Placement
+   {
+      Texture_ID id;
+      uint       page;
+      uint       x, y, width, height;
+   };
+
+private:
+
+   /// Computes region of placement.
+   void place(const Placement& placement, uint page_width, uint page_height);
+
+   static bool is_taller(const Source* lhs, const Source* rhs);
+
+private:
+
+   std::vector<Source>       m_sources;
+   std::vector<Image>        m_pages;
+   std::vector<Texture_ID>   m_page_ids;
+   std::vector<Placement>    m_placements;
+   /// Regions indexed by Texture_ID handles; empty page means texture isn't in atlas.
+   std::vector<Atlas_region> m_regions;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_TEXTURE_ATLAS_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
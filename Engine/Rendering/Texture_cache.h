@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Cache of loaded textures.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_TEXTURE_CACHE_H_INCLUDED
+#define ENGINE_RENDERING_TEXTURE_CACHE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/function.hpp"
+#include "boost/noncopyable.hpp"
+
+#include <list>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Counters of texture cache activity.
+struct Texture_cache_statistics
+{
+   uint hits;
+   uint misses;
+   uint evictions;
+   /// Total size of textures that are currently in cache.
+   uint bytes_used;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Budget (in bytes) of texture cache that renderers create.
+const uint texture_cache_budget = 64 << 20;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Keeps loaded textures, so each texture is loaded once.
+/// When total size of textures exceeds budget, least recently used ones are evicted.
+/// Entries are indexed by Texture_ID handles, so lookup is constant time.
+/// \param Texture Type of texture handle; should be copyable.
+template <class Texture>
+class Texture_cache : boost::noncopyable
+{
+public:
+
+   /// Loads texture by identifier; stores size of loaded texture (in bytes) into second argument.
+   typedef boost::function<Texture (const Texture_ID&, uint&)> Loader;
+
+public:
+
+   /// \param loader Function that is called on cache miss.
+   /// \param budget Maximal total size of textures (in bytes) cache keeps.
+   Texture_cache(Loader loader, uint budget);
+   // copying is disallowed
+
+   /// Gets texture with given id, loads it if it isn't cached yet.
+   Texture get(const Texture_ID& id);
+
+   /// Gets texture with given id if it is cached; doesn't load it.
+   /// \return false if texture isn't cached; it isn't counted as miss.
+   bool find(const Texture_ID& id, Texture& texture);
+
+   /// \return Whether texture with given id is cached; doesn't count hits or mark texture as used.
+   bool contains(const Texture_ID& id) const;
+
+   /// Puts texture loaded elsewhere (e.g. from images of Texture_streamer) into cache; counted as miss.
+   /// Replaces texture with the same id if it is cached.
+   void insert(const Texture_ID& id, const Texture& texture, uint bytes);
+
+   /// Changes budget; evicts textures if needed.
+   void set_budget(uint budget);
+
+   /// \return Budget in bytes.
+   uint get_budget() const                                        { return m_budget; }
+
+   /// Releases all textures, so they would be loaded again on demand.
+   /// \note Should be called before device reset if textures depend on device.
+   void clear();
+
+   /// \return Number of hits, misses etc. since construction or last reset_statistics().
+   const Texture_cache_statistics& get_statistics() const         { return m_statistics; }
+
+   /// Resets hits, misses and evictions counters.
+   void reset_statistics();
+
+private:
+
+   typedef std::list<Texture_ID> Lru_list;
+
+   struct Entry
+   {
+      Entry() : loaded(false), bytes(0) { }
+
+      bool                loaded;
+      Texture             texture;
+      uint                bytes;
+      /// Position in the list of recently used textures.
+      Lru_list::iterator  lru_pos;
+   };
+
+   typedef std::vector<Entry> Entries;
+
+private:
+
+   /// Evicts least recently used textures (except the most recently used one) while budget exceeded.
+   void fit_budget();
+
+private:
+
+   Loader                   m_loader;
+   uint                     m_budget;
+   Entries                  m_entries;
+   /// Front is the most recently used texture, back is the least recently used one.
+   Lru_list                 m_lru;
+   Texture_cache_statistics m_statistics;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+Texture_cache<Texture>::Texture_cache(Loader loader, uint budget)
+   : m_loader(loader)
+   , m_budget(budget)
+{
+   m_statistics.bytes_used = 0;
+   reset_statistics();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+Texture Texture_cache<Texture>::get(const Texture_ID& id)
+{
+   if (id.get_handle() >= m_entries.size())
+   {
+      m_entries.resize(Texture_registry::get_size());
+   }
+
+   Entry& entry = m_entries[id.get_handle()];
+   if (entry.loaded)
+   {
+      ++m_statistics.hits;
+
+      // mark as most recently used
+      m_lru.splice(m_lru.begin(), m_lru, entry.lru_pos);
+      return entry.texture;
+   }
+
+   uint bytes = 0;
+   const Texture texture = m_loader(id, bytes);
+   insert(id, texture, bytes);
+   return texture;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+bool Texture_cache<Texture>::find(const Texture_ID& id, Texture& texture)
+{
+   if (!contains(id))
+   {
+      return false;
+   }
+
+   ++m_statistics.hits;
+
+   Entry& entry = m_entries[id.get_handle()];
+   m_lru.splice(m_lru.begin(), m_lru, entry.lru_pos);
+   texture = entry.texture;
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+bool Texture_cache<Texture>::contains(const Texture_ID& id) const
+{
+   return id.get_handle() < m_entries.size() && m_entries[id.get_handle()].loaded;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+void Texture_cache<Texture>::insert(const Texture_ID& id, const Texture& texture, uint bytes)
+{
+   if (id.get_handle() >= m_entries.size())
+   {
+      m_entries.resize(Texture_registry::get_size());
+   }
+
+   ++m_statistics.misses;
+
+   Entry& entry = m_entries[id.get_handle()];
+   if (entry.loaded)
+   {
+      m_statistics.bytes_used -= entry.bytes;
+      m_lru.erase(entry.lru_pos);
+   }
+
+   entry.texture = texture;
+   entry.bytes   = bytes;
+   entry.loaded  = true;
+   entry.lru_pos = m_lru.insert(m_lru.begin(), id);
+   m_statistics.bytes_used += bytes;
+
+   fit_budget();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+void Texture_cache<Texture>::set_budget(uint budget)
+{
+   m_budget = budget;
+   fit_budget();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+void Texture_cache<Texture>::clear()
+{
+   m_entries.clear();
+   m_lru.clear();
+   m_statistics.bytes_used = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+void Texture_cache<Texture>::reset_statistics()
+{
+   m_statistics.hits      = 0;
+   m_statistics.misses    = 0;
+   m_statistics.evictions = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Texture>
+void Texture_cache<Texture>::fit_budget()
+{
+   // the most recently used texture is kept even if it doesn't fit alone: it's going to be used right now
+   // (note: list contains distinct ids, so front and back are equal only for single element; size() is linear)
+   while (m_statistics.bytes_used > m_budget && !m_lru.empty() && m_lru.front() != m_lru.back())
+   {
+      Entry& entry = m_entries[m_lru.back().get_handle()];
+      m_statistics.bytes_used -= entry.bytes;
+      ++m_statistics.evictions;
+
+      entry = Entry();
+      m_lru.pop_back();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_TEXTURE_CACHE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Background loading of texture images.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_TEXTURE_STREAMER_H_INCLUDED
+#define ENGINE_RENDERING_TEXTURE_STREAMER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Block_compression.h"
+#include "Engine/Rendering/Image.h"
+#include "Engine/Rendering/Texture_ID.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/function.hpp"
+#include "boost/noncopyable.hpp"
+#include "boost/thread/condition.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Image loaded by Texture_streamer.
+struct Streamed_image
+{
+   Texture_ID           id;
+   /// Null if image can't be loaded or it is kept compressed.
+   Image_ptr            image;
+   /// Image of DDS file if streamer keeps them compressed; null otherwise.
+   Compressed_image_ptr compressed;
+   /// Reason of failure; empty if image is loaded.
+   std::string          error;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Pool of threads that read and decode images in background, so rendering thread doesn't wait for files.
+/// Images are only decoded here; renderer turns them into textures when it takes them by collect(),
+/// which it does between frames.
+/// Requested images are loaded before prefetched ones.
+/// \note Except for decoding, all work is done by thread that owns streamer (normally rendering one):
+///       methods aren't thread-safe, as Texture_registry isn't.
+class Texture_streamer : boost::noncopyable
+{
+public:
+
+   /// Reads and decodes image file; throws std::exception if it can't.
+   /// Called by loading threads, so it shouldn't touch anything shared without locking.
+   typedef boost::function<Image (const std::string&)> Decoder;
+
+   /// What is done with block-compressed images of DDS files.
+   enum Dds_mode
+   {
+      /// Decompressed by loading thread (for Software_renderer).
+      dds_decompressed,
+      /// Kept compressed, so device could take blocks as they are.
+      dds_compressed
+   };
+
+public:
+
+   /// Starts given number of loading threads; images are loaded by load_dds() and load_bmp() by file extension.
+   explicit Texture_streamer(uint threads, Dds_mode dds_mode = dds_decompressed);
+
+   /// Starts given number of loading threads that load images by given decoder.
+   Texture_streamer(uint threads, Decoder decoder);
+
+   // copying is disallowed
+
+   /// Stops loading threads; images that aren't loaded yet are dropped.
+   ~Texture_streamer();
+
+   /// Queues image for loading ahead of prefetched ones, as it's needed for current frame.
+   /// Image that is already prefetched is moved ahead; otherwise nothing is done for pending image.
+   void request(const Texture_ID& id);
+
+   /// Queues image for loading after requested ones, e.g. while level loads.
+   /// Does nothing if image is already queued or loaded but not collected.
+   void prefetch(const Texture_ID& id);
+
+   /// Takes images loaded since last call: appends them to given ones.
+   void collect(std::vector<Streamed_image>& images);
+
+   /// Blocks until all queued images are loaded.
+   void wait();
+
+   /// \return Whether image is queued or loaded but not collected.
+   bool is_pending(const Texture_ID& id) const;
+
+   /// \return Number of images queued or loaded but not collected.
+   uint get_pending_number() const                                { return m_pending_number; }
+
+private:
+
+   struct Job
+   {
+      Texture_ID  id;
+      /// Name is taken by owner thread, as Texture_registry isn't thread-safe.
+      std::string file_name;
+   };
+
+   typedef std::deque<Job> Jobs;
+
+   /// Where image is pending.
+   enum Pending_state
+   {
+      not_pending
+      /// Queued among prefetched images, unless loading thread took it already.
+      , pending_prefetched
+      /// Queued among requested images or promoted there; request() has nothing to do with it.
+      , pending_requested
+   };
+
+private:
+
+   void start(uint threads);
+
+   /// Marks image as pending in given state and queues it.
+   void queue(const Texture_ID& id, Pending_state state, Jobs& jobs);
+
+   /// Body of loading thread: takes jobs until streamer stops.
+   void work();
+
+   /// Loads image of job by loading thread.
+   void load(const Job& job, Streamed_image& loaded) const;
+
+private:
+
+   /// Empty if images are loaded by file extension.
+   Decoder                     m_decoder;
+   Dds_mode                    m_dds_mode;
+
+   // owner thread only
+   /// Pending_state indexed by Texture_ID handles.
+   std::vector<uchar>          m_pending;
+   uint                        m_pending_number;
+
+   // guarded by mutex
+   boost::mutex                m_mutex;
+   boost::condition            m_job_queued;
+   boost::condition            m_job_done;
+   Jobs                        m_requests;
+   Jobs                        m_prefetches;
+   std::vector<Streamed_image> m_loaded;
+   /// Number of jobs being done right now.
+   uint                        m_busy;
+   bool                        m_stopping;
+
+   boost::thread_group         m_threads;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_TEXTURE_STREAMER_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Bulk conversion of sprites into vertexes hardware renderers feed to device.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_VERTEX_CONVERSION_H_INCLUDED
+#define ENGINE_RENDERING_VERTEX_CONVERSION_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Device vertexes have pre-transformed positions with 'w' being rhw (D3DFVF_XYZRHW, see DirectX documentation)
+// and colors packed as 0xAARRGGBB (D3DCOLOR).
+
+template <Vertex_format>
+struct Device_vertex;
+
+template <>
+struct Device_vertex<Vertex_format(position | diffuse_color)>
+{
+   float x, y, z, w;
+   uint  color;
+};
+
+template <>
+struct Device_vertex<Vertex_format(position | diffuse_color | texture_coord0)>
+{
+   float x, y, z, w;
+   uint  color;
+   float tu, tv;
+};
+
+template <>
+struct Device_vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>
+{
+   float x, y, z, w;
+   uint  color;
+   float tu0, tv0;
+   float tu1, tv1;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes 4 vertexes per sprite: rhw is set to 1, colors are packed, corners go in 0, 1, 3, 2 order
+/// to be drawn as triangle strip.
+/// Uses SSE2 if it is available (see Common/Simd.h); results are the same as of plain C++ code.
+/// Defined for formats of Colored_sprite, Textured_sprite and Multitextured_2_sprite.
+template <Vertex_format format>
+void convert_sprites(const Sprite<format>* sprites, uint n, Device_vertex<format>* where);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_VERTEX_CONVERSION_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
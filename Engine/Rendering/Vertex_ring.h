@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Ring allocation of dynamic vertex buffer and streaming of batches through it.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_RENDERING_VERTEX_RING_H_INCLUDED
+#define ENGINE_RENDERING_VERTEX_RING_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Batch.h"
+
+#include "Common/Typedefs.h"
+
+#include "boost/noncopyable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Number of frames in a row that should use more vertex memory than ring has before ring grows.
+const uint vertex_ring_overflow_frames = 3;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Dynamic vertex buffer Vertex_ring allocates from.
+/// Implemented by rendering backends; could be mocked to check how buffer is used.
+class Dynamic_vertex_buffer
+{
+public:
+
+   virtual ~Dynamic_vertex_buffer() { }
+
+   /// Locks region of buffer for writing.
+   /// \param discard If true, the whole buffer contents could be dropped, so that device doesn't wait for draws
+   ///                that still use it (D3DLOCK_DISCARD). Otherwise caller promises not to touch memory used
+   ///                by pending draws (D3DLOCK_NOOVERWRITE).
+   /// \return Memory of region.
+   virtual void* lock(uint offset, uint bytes, bool discard)    = 0;
+
+   /// Unlocks region locked last; should not throw as it is called during cleanup.
+   virtual void unlock()                                        = 0;
+
+   /// Recreates buffer with given capacity; contents are lost.
+   virtual void resize(uint bytes)                              = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Vertex_ring_statistics
+{
+   uint locks;
+   /// Number of locks that wrapped to the beginning of buffer.
+   uint discards;
+   uint growths;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Allocates regions of dynamic vertex buffer one after another, across frames.
+/// Regions are locked without overwrite until buffer end is reached; then allocation wraps to the buffer beginning
+/// and buffer is discarded. So device never waits for vertexes written before.
+/// If frames need more memory than buffer has for vertex_ring_overflow_frames frames in a row, buffer grows.
+class Vertex_ring : boost::noncopyable
+{
+public:
+
+   /// RAII wrapper for allocation of region and its locking.
+   class Lock : boost::noncopyable
+   {
+   public:
+
+      /// Allocates and locks region.
+      /// \param bytes Size of region; should not exceed ring capacity.
+      Lock(Vertex_ring& ring, uint bytes);
+
+      /// Unlocks region.
+      ~Lock();
+
+      // copying is disallowed
+
+      /// Unlocks region.
+      /// \note it is safe to call reset() multiple times.
+      void reset();
+
+      /// Obtains pointer to region memory.
+      void* get_raw_memory()                                      { return m_raw; }
+
+      /// \return Offset of region in buffer.
+      uint get_offset() const                                     { return m_offset; }
+
+   private:
+      Vertex_ring* m_ring;
+      void*        m_raw;
+      uint         m_offset;
+   };
+
+   friend class Lock;
+
+public:
+
+   /// \param buffer Buffer to allocate from; it should already have given capacity.
+   Vertex_ring(Dynamic_vertex_buffer& buffer, uint capacity);
+   // copying is disallowed
+
+   /// \return Bytes that could be allocated without wrapping.
+   uint get_free_bytes() const                                    { return m_capacity - m_head; }
+
+   uint get_capacity() const                                      { return m_capacity; }
+
+   /// Marks end of frame; grows buffer if frames overflow it.
+   void end_frame();
+
+   /// Makes the next allocation discard buffer; should be called if buffer was recreated outside of ring.
+   void reset()                                                   { m_head = m_capacity; }
+
+   const Vertex_ring_statistics& get_statistics() const           { return m_statistics; }
+
+private:
+
+   Dynamic_vertex_buffer& m_buffer;
+   uint                   m_capacity;
+   /// Offset the next region starts from.
+   uint                   m_head;
+   /// Bytes allocated during current frame.
+   uint                   m_frame_bytes;
+   /// Number of the last frames in a row that overflowed buffer.
+   uint                   m_overflow_frames;
+   /// The largest frame among them.
+   uint                   m_overflow_peak;
+   Vertex_ring_statistics m_statistics;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Batch device that takes vertexes from dynamic vertex buffer.
+class Stream_device : public Batch_device
+{
+public:
+
+   /// \return Size of vertexes of single quad of given format.
+   virtual uint get_quad_bytes(Vertex_format) const                           = 0;
+
+   /// Writes vertexes of sprites of given format.
+   /// \param first Index of the first sprite among sprites of given format.
+   virtual void write_quads(Vertex_format, uint first, uint nquads, void* where) = 0;
+
+   /// Makes quads starting from given buffer offset source of the next draws:
+   /// draw_quads() counts quads from there. Current vertex format is used.
+   virtual void set_vertex_offset(uint offset)                                = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Emits batches to device writing their vertexes into ring.
+/// As many batches as fit are written under one lock and then drawn; scene that doesn't fit into ring is drawn
+/// in several such flushes. State is set once per batch, as by draw_batches().
+void stream_batches(const Batch_list& batches, Vertex_ring& ring, Stream_device& device);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_RENDERING_VERTEX_RING_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
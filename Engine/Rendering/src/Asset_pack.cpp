@@ -0,0 +1,300 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Asset_pack implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Asset_pack.h"
+
+#include "Engine/Rendering/Logging.h"
+
+#include "Common/Little_endian.h"
+
+#include <algorithm>
+#include <cstring>              // for std::memcmp, std::memcpy
+#include <fstream>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Pack layout; all numbers are 32-bit little-endian:
+// - header: magic "APAK", version, number of textures, page size;
+// - table of textures sorted by hash of name: hash, name offset, name size, format, width, height,
+//   data offset, data size;
+// - names, not terminated;
+// - data of textures, each starting at page boundary.
+// Offsets are from the beginning of pack, so pack can't exceed 4 GB.
+
+const uint pack_header_size = 16;
+const uint pack_entry_size  = 32;
+const uint pack_version     = 1;
+/// Data is aligned to pages, so that it starts at page of its own and is aligned for any access.
+const uint pack_page_size   = 4096;
+/// Larger sides are rejected, so that broken tables don't pass size checks by overflow.
+const uint pack_max_side    = 1 << 15;
+
+uint get_name_hash(const char* name, size_t size);
+size_t get_packed_size(Packed_format format, uint width, uint height);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Image unpack_image(const Packed_texture& texture)
+{
+   if (texture.format != packed_format_a8r8g8b8)
+   {
+      return decompress_blocks(texture.width, texture.height,
+                               texture.format == packed_format_bc1 ? block_format_bc1 : block_format_bc3, texture.data);
+   }
+
+   Image image(texture.width, texture.height);
+   std::memcpy(&image.pixels[0], texture.data, texture.size);
+   return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Asset_pack::Asset_pack(const std::string& file_name)
+{
+   try
+   {
+      m_file.reset(new Common::Mapped_file(file_name));
+   }
+   catch (const Common::Mapped_file_exception&)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't open \"" << file_name << "\"; throw !!!";
+      throw Asset_pack_exception("Can't open asset pack " + file_name);
+   }
+
+   const uchar* const data = m_file->get_data();
+   const size_t size = m_file->get_size();
+   if (size < pack_header_size || std::memcmp(data, "APAK", 4) != 0 || Common::read_le(data + 4, 4) != pack_version
+       || Common::read_le(data + 12, 4) != pack_page_size)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! \"" << file_name << "\" isn't asset pack of version " << pack_version
+                                      << "; throw !!!";
+      throw Asset_pack_exception("Not an asset pack " + file_name);
+   }
+
+   const size_t entries_number = Common::read_le(data + 8, 4);
+   bool is_valid = entries_number <= (size - pack_header_size) / pack_entry_size;
+   m_entries.resize(is_valid ? entries_number : 0);
+   for (size_t i = 0; i < m_entries.size() && is_valid; ++i)
+   {
+      const uchar* const p = data + pack_header_size + i*pack_entry_size;
+      Entry& e = m_entries[i];
+      e.hash        = Common::read_le(p, 4);
+      e.name_offset = Common::read_le(p + 4, 4);
+      e.name_size   = Common::read_le(p + 8, 4);
+      e.format      = Common::read_le(p + 12, 4);
+      e.width       = Common::read_le(p + 16, 4);
+      e.height      = Common::read_le(p + 20, 4);
+      e.data_offset = Common::read_le(p + 24, 4);
+      e.data_size   = Common::read_le(p + 28, 4);
+
+      // everything find() relies on is checked here, so lookups don't check anything
+      is_valid = e.name_offset <= size && e.name_size <= size - e.name_offset
+              && e.hash == get_name_hash(reinterpret_cast<const char*>(data + e.name_offset), e.name_size)
+              && (i == 0 || m_entries[i - 1].hash <= e.hash)
+              && e.format <= packed_format_bc3
+              && e.width > 0 && e.height > 0 && e.width <= pack_max_side && e.height <= pack_max_side
+              && e.data_size == get_packed_size(Packed_format(e.format), e.width, e.height)
+              && e.data_offset % pack_page_size == 0 && e.data_offset <= size && e.data_size <= size - e.data_offset;
+   }
+
+   if (!is_valid)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Asset pack \"" << file_name << "\" is broken; throw !!!";
+      throw Asset_pack_exception("Broken asset pack " + file_name);
+   }
+
+   LOG_RENDERER(Logging::major) << "Asset pack \"" << file_name << "\" of " << m_entries.size()
+                                << " textures mapped";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Asset_pack::find(const std::string& name, Packed_texture& texture) const
+{
+   const uint hash = get_name_hash(name.data(), name.size());
+   for (std::vector<Entry>::const_iterator i = std::lower_bound(m_entries.begin(), m_entries.end(), hash,
+                                                                is_hash_less);
+        i != m_entries.end() && i->hash == hash; ++i)
+   {
+      if (i->name_size == name.size()
+          && std::memcmp(m_file->get_data() + i->name_offset, name.data(), name.size()) == 0)
+      {
+         texture.width  = i->width;
+         texture.height = i->height;
+         texture.format = Packed_format(i->format);
+         texture.data   = m_file->get_data() + i->data_offset;
+         texture.size   = i->data_size;
+         return true;
+      }
+   }
+   return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Asset_pack::is_hash_less(const Entry& entry, uint hash)
+{
+   return entry.hash < hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Asset_pack_writer::add(const std::string& name, const Image& image)
+{
+   m_sources.push_back(Source());
+   Source& source = m_sources.back();
+   source.name   = name;
+   source.hash   = get_name_hash(name.data(), name.size());
+   source.format = packed_format_a8r8g8b8;
+   source.width  = image.width;
+   source.height = image.height;
+   source.data.resize(image.pixels.size()*sizeof(uint));
+   if (!image.pixels.empty())
+   {
+      std::memcpy(&source.data[0], &image.pixels[0], source.data.size());
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Asset_pack_writer::add(const std::string& name, const Compressed_image& image)
+{
+   m_sources.push_back(Source());
+   Source& source = m_sources.back();
+   source.name   = name;
+   source.hash   = get_name_hash(name.data(), name.size());
+   source.format = image.format == block_format_bc1 ? packed_format_bc1 : packed_format_bc3;
+   source.width  = image.width;
+   source.height = image.height;
+   source.data   = image.blocks;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Asset_pack_writer::save(const std::string& file_name) const
+{
+   std::vector<const Source*> sorted;
+   for (size_t i = 0; i < m_sources.size(); ++i)
+   {
+      sorted.push_back(&m_sources[i]);
+   }
+   std::sort(sorted.begin(), sorted.end(), is_less);
+   for (size_t i = 0; i < sorted.size(); ++i)
+   {
+      const Source& source = *sorted[i];
+      if (i > 0 && sorted[i - 1]->name == source.name)
+      {
+         LOG_RENDERER(Logging::critical) << "!!! Texture \"" << source.name << "\" is added to pack twice; throw !!!";
+         throw Asset_pack_exception("Texture added to pack twice " + source.name);
+      }
+      if (source.width == 0 || source.height == 0 || source.width > pack_max_side || source.height > pack_max_side)
+      {
+         LOG_RENDERER(Logging::critical) << "!!! Texture \"" << source.name << "\" of size " << source.width << "x"
+                                         << source.height << " can't be packed; throw !!!";
+         throw Asset_pack_exception("Texture can't be packed " + source.name);
+      }
+   }
+
+   // header, table and names; data offsets are known once names are placed
+   std::vector<uchar> head(pack_header_size + sorted.size()*pack_entry_size);
+   std::memcpy(&head[0], "APAK", 4);
+   Common::write_le(&head[4],  pack_version, 4);
+   Common::write_le(&head[8],  static_cast<uint>(sorted.size()), 4);
+   Common::write_le(&head[12], pack_page_size, 4);
+   for (size_t i = 0; i < sorted.size(); ++i)
+   {
+      const Source& source = *sorted[i];
+      uchar* const p = &head[pack_header_size + i*pack_entry_size];
+      Common::write_le(p,      source.hash, 4);
+      Common::write_le(p + 4,  static_cast<uint>(head.size()), 4);
+      Common::write_le(p + 8,  static_cast<uint>(source.name.size()), 4);
+      Common::write_le(p + 12, source.format, 4);
+      Common::write_le(p + 16, source.width, 4);
+      Common::write_le(p + 20, source.height, 4);
+      Common::write_le(p + 28, static_cast<uint>(source.data.size()), 4);
+      head.insert(head.end(), source.name.begin(), source.name.end());
+   }
+
+   size_t offset = (head.size() + pack_page_size - 1) / pack_page_size * pack_page_size;
+   for (size_t i = 0; i < sorted.size(); ++i)
+   {
+      Common::write_le(&head[pack_header_size + i*pack_entry_size + 24], static_cast<uint>(offset), 4);
+      offset += (sorted[i]->data.size() + pack_page_size - 1) / pack_page_size * pack_page_size;
+   }
+
+   std::ofstream file(file_name.c_str(), std::ios::binary);
+   file.write(reinterpret_cast<const char*>(&head[0]), head.size());
+   const std::vector<char> padding(pack_page_size, 0);
+   size_t written = head.size();
+   for (size_t i = 0; i < sorted.size(); ++i)
+   {
+      file.write(&padding[0], (pack_page_size - written % pack_page_size) % pack_page_size);
+      written += (pack_page_size - written % pack_page_size) % pack_page_size;
+      if (!sorted[i]->data.empty())
+      {
+         file.write(reinterpret_cast<const char*>(&sorted[i]->data[0]), sorted[i]->data.size());
+         written += sorted[i]->data.size();
+      }
+   }
+
+   if (!file || written > 0xFFFFFFFFu)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't write asset pack \"" << file_name << "\"; throw !!!";
+      throw Asset_pack_exception("Can't write asset pack " + file_name);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Asset_pack_writer::is_less(const Source* lhs, const Source* rhs)
+{
+   return lhs->hash < rhs->hash || (lhs->hash == rhs->hash && lhs->name < rhs->name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// 32-bit FNV-1a hash.
+uint get_name_hash(const char* name, size_t size)
+{
+   uint hash = 2166136261u;
+   for (size_t i = 0; i < size; ++i)
+   {
+      hash = (hash ^ static_cast<uchar>(name[i])) * 16777619u;
+   }
+   return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t get_packed_size(Packed_format format, uint width, uint height)
+{
+   if (format == packed_format_a8r8g8b8)
+   {
+      return size_t(width)*height*sizeof(uint);
+   }
+   return size_t((width + 3) / 4)*((height + 3) / 4)*get_block_bytes(format == packed_format_bc1 ? block_format_bc1
+                                                                                                  : block_format_bc3);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Batches compilation and drawing.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Batch.h"
+
+#include <algorithm>            // for std::min
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool same_state(const Colored_sprite& lhs, const Colored_sprite& rhs);
+bool same_state(const Textured_sprite& lhs, const Textured_sprite& rhs);
+bool same_state(const Multitextured_2_sprite& lhs, const Multitextured_2_sprite& rhs);
+void set_state(Render_batch& batch, const Colored_sprite& s);
+void set_state(Render_batch& batch, const Textured_sprite& s);
+void set_state(Render_batch& batch, const Multitextured_2_sprite& s);
+template <class Sprite_type>
+void compile_range_batches(Vertex_format format, const std::vector<Sprite_type>& sprites, uint first, uint count,
+                           Batch_list& batches);
+template <class Sprite_type>
+void compile_slot_batches(Vertex_format format, const std::vector<Sprite_type>& sprites,
+                          const std::vector<uint>& slots, Batch_list& batches);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Colored_sprite>& sprites, Batch_list& batches)
+{
+   compile_batches(sprites, 0, static_cast<uint>(sprites.size()), batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Textured_sprite>& sprites, Batch_list& batches)
+{
+   compile_batches(sprites, 0, static_cast<uint>(sprites.size()), batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Multitextured_2_sprite>& sprites, Batch_list& batches)
+{
+   compile_batches(sprites, 0, static_cast<uint>(sprites.size()), batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Colored_sprite>& sprites, uint first, uint count, Batch_list& batches)
+{
+   compile_range_batches(Vertex_format(position | diffuse_color), sprites, first, count, batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Textured_sprite>& sprites, uint first, uint count, Batch_list& batches)
+{
+   compile_range_batches(Vertex_format(position | diffuse_color | texture_coord0), sprites, first, count, batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Multitextured_2_sprite>& sprites, uint first, uint count,
+                     Batch_list& batches)
+{
+   compile_range_batches(Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1), sprites, first,
+                         count, batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Colored_sprite>& sprites, const std::vector<uint>& slots,
+                     Batch_list& batches)
+{
+   compile_slot_batches(Vertex_format(position | diffuse_color), sprites, slots, batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Textured_sprite>& sprites, const std::vector<uint>& slots,
+                     Batch_list& batches)
+{
+   compile_slot_batches(Vertex_format(position | diffuse_color | texture_coord0), sprites, slots, batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compile_batches(const std::vector<Multitextured_2_sprite>& sprites, const std::vector<uint>& slots,
+                     Batch_list& batches)
+{
+   compile_slot_batches(Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1), sprites, slots,
+                        batches);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void draw_batches(const Batch_list& batches, Batch_device& device)
+{
+   for (size_t i = 0; i < batches.size(); ++i)
+   {
+      const Render_batch& batch = batches[i];
+
+      if (i == 0 || batches[i - 1].format != batch.format)
+      {
+         device.set_vertex_format(batch.format);
+      }
+
+      for (uint nstage = 0; nstage < batch_stages_number; ++nstage)
+      {
+         device.set_texture(nstage, batch.textures[nstage]);
+         device.set_blending(nstage, batch.blendings[nstage]);
+      }
+
+      // split batch if it doesn't fit into 16-bit indexes
+      for (uint first = batch.first; first < batch.first + batch.count; first += max_quads_per_draw)
+      {
+         device.draw_quads(first, std::min(max_quads_per_draw, batch.first + batch.count - first));
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void fill_quad_indexes(ushort* indexes, uint nquads)
+{
+   // vertexes of each quad are ordered for triangle strip: (0, 1, 2) and (2, 1, 3) are its triangles
+   for (uint i = 0; i < nquads; ++i)
+   {
+      const ushort base = static_cast<ushort>(4*i);
+      indexes[6*i + 0] = base + 0;
+      indexes[6*i + 1] = base + 1;
+      indexes[6*i + 2] = base + 2;
+      indexes[6*i + 3] = base + 2;
+      indexes[6*i + 4] = base + 1;
+      indexes[6*i + 5] = base + 3;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Creates batch with state used for untextured drawing: stage 0 passes diffuse color, stage 1 is disabled.
+Render_batch make_batch(Vertex_format format, uint first)
+{
+   Render_batch batch;
+   batch.format       = format;
+   batch.first        = first;
+   batch.count        = 0;
+   batch.textures[0]  = Texture_ID();
+   batch.blendings[0] = blending_mode_select_arg1;
+   batch.textures[1]  = Texture_ID();
+   batch.blendings[1] = blending_mode_disable;
+   return batch;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool same_state(const Colored_sprite&, const Colored_sprite&)
+{
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool same_state(const Textured_sprite& lhs, const Textured_sprite& rhs)
+{
+   return lhs.texture == rhs.texture && lhs.blending == rhs.blending;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool same_state(const Multitextured_2_sprite& lhs, const Multitextured_2_sprite& rhs)
+{
+   return lhs.texture0 == rhs.texture0 && lhs.blending0 == rhs.blending0
+       && lhs.texture1 == rhs.texture1 && lhs.blending1 == rhs.blending1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void set_state(Render_batch&, const Colored_sprite&)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void set_state(Render_batch& batch, const Textured_sprite& s)
+{
+   batch.textures[0]  = s.texture;
+   batch.blendings[0] = s.blending;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void set_state(Render_batch& batch, const Multitextured_2_sprite& s)
+{
+   batch.textures[0]  = s.texture0;
+   batch.blendings[0] = s.blending0;
+   batch.textures[1]  = s.texture1;
+   batch.blendings[1] = s.blending1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Sprite_type>
+void compile_range_batches(Vertex_format format, const std::vector<Sprite_type>& sprites, uint first, uint count,
+                           Batch_list& batches)
+{
+   assert(first + count <= sprites.size() && "Range is out of sprites");
+
+   const uint end = first + count;
+   for (uint i = first; i < end; )
+   {
+      // extend run while state remains the same
+      uint run_end = i + 1;
+      while (run_end < end && same_state(sprites[i], sprites[run_end]))
+      {
+         ++run_end;
+      }
+
+      Render_batch batch = make_batch(format, i);
+      batch.count = run_end - i;
+      set_state(batch, sprites[i]);
+      batches.push_back(batch);
+
+      i = run_end;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Sprite_type>
+void compile_slot_batches(Vertex_format format, const std::vector<Sprite_type>& sprites,
+                          const std::vector<uint>& slots, Batch_list& batches)
+{
+   for (size_t i = 0; i < slots.size(); )
+   {
+      // extend run while slots are adjacent and state remains the same
+      size_t end = i + 1;
+      while (end < slots.size() && slots[end] == slots[end - 1] + 1
+             && same_state(sprites[slots[i]], sprites[slots[end]]))
+      {
+         ++end;
+      }
+
+      Render_batch batch = make_batch(format, slots[i]);
+      batch.count = static_cast<uint>(end - i);
+      set_state(batch, sprites[slots[i]]);
+      batches.push_back(batch);
+
+      i = end;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,419 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Block compression implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Block_compression.h"
+
+#include "Common/Little_endian.h"
+#include "Common/Simd.h"
+
+#include "boost/cstdint.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void get_block_texels(const Image& image, uint block_x, uint block_y, uint* texels);
+void compress_color_block(const uint* texels, uchar* block);
+void compress_alpha_block(const uint* texels, uchar* block);
+void decompress_block(Block_format format, const uchar* block, uint* dst, uint pitch);
+void select_colors(const uint* palette, uint indices, uint* dst, uint pitch);
+void make_color_palette(uint color0, uint color1, bool four_colors, uint* palette);
+void make_alpha_palette(uint alpha0, uint alpha1, uint* palette);
+uint pack_565(const uint* channels);
+uint get_color_distance(uint lhs, uint rhs);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Compressed_image compress_image(const Image& image, Block_format format)
+{
+   Compressed_image compressed;
+   compressed.width  = image.width;
+   compressed.height = image.height;
+   compressed.format = format;
+
+   const uint block_bytes = get_block_bytes(format);
+   compressed.blocks.resize(compressed.get_blocks_wide()*compressed.get_blocks_high()*block_bytes);
+
+   uint texels[16];
+   uchar* block = compressed.blocks.empty() ? 0 : &compressed.blocks[0];
+   for (uint y = 0; y < compressed.get_blocks_high(); ++y)
+   {
+      for (uint x = 0; x < compressed.get_blocks_wide(); ++x, block += block_bytes)
+      {
+         get_block_texels(image, x, y, texels);
+         if (format == block_format_bc3)
+         {
+            compress_alpha_block(texels, block);
+            compress_color_block(texels, block + 8);
+         }
+         else
+         {
+            compress_color_block(texels, block);
+         }
+      }
+   }
+
+   return compressed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Image decompress_image(const Compressed_image& image)
+{
+   assert(image.blocks.size() == image.get_blocks_wide()*image.get_blocks_high()*get_block_bytes(image.format));
+
+   return decompress_blocks(image.width, image.height, image.format, image.blocks.empty() ? 0 : &image.blocks[0]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Image decompress_blocks(uint width, uint height, Block_format format, const uchar* blocks)
+{
+   const uint block_bytes = get_block_bytes(format);
+   const uint blocks_wide = (width + 3) / 4;
+   const uint blocks_high = (height + 3) / 4;
+
+   Image result(width, height);
+
+   uint texels[16];
+   const uchar* block = blocks;
+   for (uint y = 0; y < blocks_high; ++y)
+   {
+      for (uint x = 0; x < blocks_wide; ++x, block += block_bytes)
+      {
+         // inner blocks are written right into image; edge ones are clipped
+         if (4*x + 4 <= width && 4*y + 4 <= height)
+         {
+            decompress_block(format, block, &result.pixels[4*(y*width + x)], width);
+            continue;
+         }
+
+         decompress_block(format, block, texels, 4);
+         const uint block_width  = std::min(4u, width - 4*x);
+         const uint block_height = std::min(4u, height - 4*y);
+         for (uint row = 0; row < block_height; ++row)
+         {
+            std::copy(texels + 4*row, texels + 4*row + block_width, &result.pixels[(4*y + row)*width + 4*x]);
+         }
+      }
+   }
+
+   return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool has_alpha(const Image& image)
+{
+   for (size_t i = 0; i < image.pixels.size(); ++i)
+   {
+      if ((image.pixels[i] >> 24) != 0xFF)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Takes 4x4 texels of block; texels outside of image repeat the nearest edge ones.
+void get_block_texels(const Image& image, uint block_x, uint block_y, uint* texels)
+{
+   for (uint y = 0; y < 4; ++y)
+   {
+      const uint row = std::min(4*block_y + y, image.height - 1);
+      for (uint x = 0; x < 4; ++x)
+      {
+         const uint column = std::min(4*block_x + x, image.width - 1);
+         texels[4*y + x] = image.pixels[row*image.width + column];
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes BC1 block of texels; it always uses 4 colors, as BC3 requires.
+void compress_color_block(const uint* texels, uchar* block)
+{
+   // channels are red, green, blue
+   uint lows[3]  = { 255, 255, 255 };
+   uint highs[3] = { 0, 0, 0 };
+   for (uint i = 0; i < 16; ++i)
+   {
+      for (uint c = 0; c < 3; ++c)
+      {
+         const uint channel = (texels[i] >> (16 - 8*c)) & 0xFF;
+         lows[c]  = std::min(lows[c], channel);
+         highs[c] = std::max(highs[c], channel);
+      }
+   }
+
+   // endpoints on the box corners waste half of the step on the outside
+   for (uint c = 0; c < 3; ++c)
+   {
+      const uint inset = (highs[c] - lows[c]) >> 4;
+      lows[c]  += inset;
+      highs[c] -= inset;
+   }
+
+   uint color0 = pack_565(highs);
+   uint color1 = pack_565(lows);
+   uint indices = 0;
+   if (color0 != color1)
+   {
+      // the first color is greater in 4-color mode
+      if (color0 < color1)
+      {
+         std::swap(color0, color1);
+      }
+
+      uint palette[4];
+      make_color_palette(color0, color1, true, palette);
+      for (uint i = 0; i < 16; ++i)
+      {
+         uint best = 0;
+         uint best_distance = get_color_distance(texels[i], palette[0]);
+         for (uint j = 1; j < 4; ++j)
+         {
+            const uint distance = get_color_distance(texels[i], palette[j]);
+            if (distance < best_distance)
+            {
+               best = j;
+               best_distance = distance;
+            }
+         }
+         indices |= best << (2*i);
+      }
+   }
+
+   Common::write_le(block, color0, 2);
+   Common::write_le(block + 2, color1, 2);
+   Common::write_le(block + 4, indices, 4);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes alpha part of BC3 block; it uses 8 alphas unless all of them are equal.
+void compress_alpha_block(const uint* texels, uchar* block)
+{
+   uint low  = 255;
+   uint high = 0;
+   for (uint i = 0; i < 16; ++i)
+   {
+      low  = std::min(low, texels[i] >> 24);
+      high = std::max(high, texels[i] >> 24);
+   }
+
+   uint palette[8];
+   make_alpha_palette(high, low, palette);
+
+   boost::uint64_t indices = 0;
+   for (uint i = 0; i < 16; ++i)
+   {
+      const uint alpha = texels[i] >> 24;
+      uint best = 0;
+      for (uint j = 1; j < 8; ++j)
+      {
+         const int distance      = int(alpha) - int(palette[j]);
+         const int best_distance = int(alpha) - int(palette[best]);
+         if (distance*distance < best_distance*best_distance)
+         {
+            best = j;
+         }
+      }
+      indices |= boost::uint64_t(best) << (3*i);
+   }
+
+   block[0] = static_cast<uchar>(high);
+   block[1] = static_cast<uchar>(low);
+   for (uint i = 0; i < 6; ++i)
+   {
+      block[2 + i] = static_cast<uchar>(indices >> (8*i));
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Decompresses block into 4 rows of 4 texels.
+/// \param pitch Distance between rows in texels.
+void decompress_block(Block_format format, const uchar* block, uint* dst, uint pitch)
+{
+   // color block of BC3 is always in 4-color mode
+   const uchar* color_block = format == block_format_bc3 ? block + 8 : block;
+   const uint color0 = Common::read_le(color_block, 2);
+   const uint color1 = Common::read_le(color_block + 2, 2);
+
+   uint palette[4];
+   make_color_palette(color0, color1, format == block_format_bc3 || color0 > color1, palette);
+   select_colors(palette, Common::read_le(color_block + 4, 4), dst, pitch);
+
+   if (format != block_format_bc3)
+   {
+      return;
+   }
+
+   uint alphas[8];
+   make_alpha_palette(block[0], block[1], alphas);
+   boost::uint64_t indices = 0;
+   for (uint i = 0; i < 6; ++i)
+   {
+      indices |= boost::uint64_t(block[2 + i]) << (8*i);
+   }
+   for (uint y = 0; y < 4; ++y)
+   {
+      uint* row = dst + y*pitch;
+      for (uint x = 0; x < 4; ++x, indices >>= 3)
+      {
+         row[x] = (row[x] & 0x00FFFFFF) | (alphas[indices & 7] << 24);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes colors of palette selected by 2-bit indices of 16 texels.
+void select_colors(const uint* palette, uint indices, uint* dst, uint pitch)
+{
+#ifdef COMMON_SSE2
+   // lane x of row y tests bits 2x and 2x + 1 of byte y; low bit picks odd color of pair,
+   // high bit picks the second pair
+   const __m128i all     = _mm_set1_epi32(static_cast<int>(indices));
+   const __m128i color0  = _mm_set1_epi32(static_cast<int>(palette[0]));
+   const __m128i color2  = _mm_set1_epi32(static_cast<int>(palette[2]));
+   const __m128i diff01  = _mm_xor_si128(color0, _mm_set1_epi32(static_cast<int>(palette[1])));
+   const __m128i diff23  = _mm_xor_si128(color2, _mm_set1_epi32(static_cast<int>(palette[3])));
+   __m128i low_bits      = _mm_setr_epi32(1, 1 << 2, 1 << 4, 1 << 6);
+   __m128i high_bits     = _mm_slli_epi32(low_bits, 1);
+   for (uint y = 0; y < 4; ++y)
+   {
+      const __m128i is_odd    = _mm_cmpeq_epi32(_mm_and_si128(all, low_bits), low_bits);
+      const __m128i is_second = _mm_cmpeq_epi32(_mm_and_si128(all, high_bits), high_bits);
+      const __m128i first     = _mm_xor_si128(color0, _mm_and_si128(is_odd, diff01));
+      const __m128i second    = _mm_xor_si128(color2, _mm_and_si128(is_odd, diff23));
+      const __m128i colors    = _mm_xor_si128(first, _mm_and_si128(is_second, _mm_xor_si128(first, second)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y*pitch), colors);
+
+      low_bits  = _mm_slli_epi32(low_bits, 8);
+      high_bits = _mm_slli_epi32(high_bits, 8);
+   }
+#else
+   for (uint y = 0; y < 4; ++y)
+   {
+      for (uint x = 0; x < 4; ++x, indices >>= 2)
+      {
+         dst[y*pitch + x] = palette[indices & 3];
+      }
+   }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Expands RGB565 endpoints and interpolates colors between them.
+/// In 3-color mode the last color is transparent black.
+void make_color_palette(uint color0, uint color1, bool four_colors, uint* palette)
+{
+   uint channels0[3];
+   uint channels1[3];
+   for (uint c = 0; c < 3; ++c)
+   {
+      // red and blue have 5 bits, green has 6 bits; high bits are repeated in low ones
+      const uint bits  = c == 1 ? 6 : 5;
+      const uint shift = c == 0 ? 11 : c == 1 ? 5 : 0;
+      const uint value0 = (color0 >> shift) & ((1 << bits) - 1);
+      const uint value1 = (color1 >> shift) & ((1 << bits) - 1);
+      channels0[c] = (value0 << (8 - bits)) | (value0 >> (2*bits - 8));
+      channels1[c] = (value1 << (8 - bits)) | (value1 >> (2*bits - 8));
+   }
+
+   palette[0] = make_argb(0xFF, uchar(channels0[0]), uchar(channels0[1]), uchar(channels0[2]));
+   palette[1] = make_argb(0xFF, uchar(channels1[0]), uchar(channels1[1]), uchar(channels1[2]));
+   if (four_colors)
+   {
+      palette[2] = make_argb(0xFF, uchar((2*channels0[0] + channels1[0]) / 3), uchar((2*channels0[1] + channels1[1]) / 3),
+                             uchar((2*channels0[2] + channels1[2]) / 3));
+      palette[3] = make_argb(0xFF, uchar((channels0[0] + 2*channels1[0]) / 3), uchar((channels0[1] + 2*channels1[1]) / 3),
+                             uchar((channels0[2] + 2*channels1[2]) / 3));
+   }
+   else
+   {
+      palette[2] = make_argb(0xFF, uchar((channels0[0] + channels1[0]) / 2), uchar((channels0[1] + channels1[1]) / 2),
+                             uchar((channels0[2] + channels1[2]) / 2));
+      palette[3] = 0;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Interpolates 8 alphas if the first one is greater; 6 and then 0 and 255 otherwise.
+void make_alpha_palette(uint alpha0, uint alpha1, uint* palette)
+{
+   palette[0] = alpha0;
+   palette[1] = alpha1;
+   if (alpha0 > alpha1)
+   {
+      for (uint i = 1; i < 7; ++i)
+      {
+         palette[i + 1] = ((7 - i)*alpha0 + i*alpha1) / 7;
+      }
+   }
+   else
+   {
+      for (uint i = 1; i < 5; ++i)
+      {
+         palette[i + 1] = ((5 - i)*alpha0 + i*alpha1) / 5;
+      }
+      palette[6] = 0;
+      palette[7] = 255;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Rounds red, green and blue to RGB565.
+uint pack_565(const uint* channels)
+{
+   const uint red   = (channels[0]*31 + 127) / 255;
+   const uint green = (channels[1]*63 + 127) / 255;
+   const uint blue  = (channels[2]*31 + 127) / 255;
+   return (red << 11) | (green << 5) | blue;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Squared distance between colors; alpha is ignored.
+uint get_color_distance(uint lhs, uint rhs)
+{
+   uint distance = 0;
+   for (uint shift = 0; shift < 24; shift += 8)
+   {
+      const int delta = int((lhs >> shift) & 0xFF) - int((rhs >> shift) & 0xFF);
+      distance += delta*delta;
+   }
+   return distance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// BMP reading and writing implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Bmp.h"
+
+#include "Engine/Rendering/Logging.h"
+
+#include "Common/Little_endian.h"
+#include "Common/Mapped_file.h"
+#include "Common/Simd.h"
+
+#include <algorithm>
+#include <cstring>              // for std::memcpy
+#include <fstream>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// BMP layout: BITMAPFILEHEADER (14 bytes), BITMAPINFOHEADER (at least 40 bytes), palette, pixels.
+// All numbers are little-endian; each row is padded to 4 bytes.
+
+const uint bmp_file_header_size = 14;
+const uint bmp_info_header_size = 40;
+const uint bmp_bi_rgb           = 0;
+const uint bmp_bi_rle8          = 1;
+const uint bmp_bi_bitfields     = 3;
+/// Larger sides are rejected, so that broken headers don't make huge allocations.
+const uint bmp_max_side         = 1 << 15;
+
+void convert_bgr_row(const uchar* src, const uchar* end, uint* dst, uint width);
+void convert_indexed_row(const uchar* src, const uint* palette, uint* dst, uint width);
+bool decode_rle8(const uchar* src, const uchar* end, const uint* palette, bool bottom_up, Image& image);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Image load_bmp(const std::string& file_name)
+{
+   try
+   {
+      const Common::Mapped_file file(file_name);
+      return decode_bmp(file.get_data(), file.get_size(), file_name);
+   }
+   catch (const Common::Mapped_file_exception&)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't open \"" << file_name << "\"; throw !!!";
+      throw Image_exception("Can't open BMP file " + file_name);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Image decode_bmp(const uchar* data, size_t size, const std::string& name)
+{
+   if (size < bmp_file_header_size + bmp_info_header_size || data[0] != 'B' || data[1] != 'M')
+   {
+      LOG_RENDERER(Logging::critical) << "!!! \"" << name << "\" isn't BMP file; throw !!!";
+      throw Image_exception("Not a BMP file " + name);
+   }
+
+   const uchar* info = data + bmp_file_header_size;
+   const uint offset      = Common::read_le(data + 10, 4);
+   const uint info_size   = Common::read_le(info, 4);
+   const int  width       = static_cast<int>(Common::read_le(info + 4, 4));
+   const int  height      = static_cast<int>(Common::read_le(info + 8, 4));
+   const uint bpp         = Common::read_le(info + 14, 2);
+   uint       compression = Common::read_le(info + 16, 4);
+   const uint colors_used = Common::read_le(info + 32, 4);
+
+   // 32-bit pixels with the usual masks are the same as without them
+   if (compression == bmp_bi_bitfields && bpp == 32 && size >= bmp_file_header_size + bmp_info_header_size + 12
+       && Common::read_le(info + 40, 4) == 0x00FF0000 && Common::read_le(info + 44, 4) == 0x0000FF00
+       && Common::read_le(info + 48, 4) == 0x000000FF)
+   {
+      compression = bmp_bi_rgb;
+   }
+
+   // negative height means rows are stored top to bottom
+   const bool bottom_up = height > 0;
+   const uint rows      = bottom_up ? height : -height;
+
+   const bool is_supported = (bpp == 8 && (compression == bmp_bi_rgb || (compression == bmp_bi_rle8 && bottom_up)))
+                          || ((bpp == 24 || bpp == 32) && compression == bmp_bi_rgb);
+   if (width <= 0 || rows == 0 || uint(width) > bmp_max_side || rows > bmp_max_side || !is_supported
+       || info_size < bmp_info_header_size || (bpp == 8 && colors_used > 256))
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Unsupported BMP format of \"" << name << "\"; throw !!!";
+      throw Image_exception("Unsupported BMP format " + name);
+   }
+
+   // palette follows info header; colors that aren't listed are black
+   uint palette[256];
+   if (bpp == 8)
+   {
+      const uint colors = colors_used == 0 ? 256 : colors_used;
+      const size_t palette_offset = bmp_file_header_size + size_t(info_size);
+      if (palette_offset + 4*colors > size)
+      {
+         LOG_RENDERER(Logging::critical) << "!!! BMP file \"" << name << "\" is truncated; throw !!!";
+         throw Image_exception("Truncated BMP file " + name);
+      }
+      std::fill(palette, palette + 256, make_argb(0xFF, 0, 0, 0));
+      for (uint i = 0; i < colors; ++i)
+      {
+         palette[i] = 0xFF000000 | Common::read_le(data + palette_offset + 4*i, 3);
+      }
+   }
+
+   Image image(width, rows);
+
+   if (compression == bmp_bi_rle8)
+   {
+      if (offset >= size || !decode_rle8(data + offset, data + size, palette, bottom_up, image))
+      {
+         LOG_RENDERER(Logging::critical) << "!!! BMP file \"" << name << "\" is truncated; throw !!!";
+         throw Image_exception("Truncated BMP file " + name);
+      }
+      return image;
+   }
+
+   // the last row could lack padding
+   const size_t pixel_bytes = width*(bpp / 8);
+   const size_t row_bytes   = (pixel_bytes + 3) & ~size_t(3);
+   if (offset > size || size - offset < row_bytes*(rows - 1) + pixel_bytes)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! BMP file \"" << name << "\" is truncated; throw !!!";
+      throw Image_exception("Truncated BMP file " + name);
+   }
+
+   for (uint y = 0; y < rows; ++y)
+   {
+      const uchar* src = data + offset + y*row_bytes;
+      uint* dst = &image.pixels[(bottom_up ? rows - 1 - y : y)*width];
+      switch (bpp)
+      {
+      case 8:
+         convert_indexed_row(src, palette, dst, width);
+         break;
+      case 24:
+         convert_bgr_row(src, data + size, dst, width);
+         break;
+      case 32:
+         // blue, green, red, alpha is exactly A8R8G8B8 in little-endian order
+         std::memcpy(dst, src, pixel_bytes);
+         break;
+      }
+   }
+
+   return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void save_bmp(const Image& image, const std::string& file_name)
+{
+   const uint pixels_bytes = 4*image.width*image.height;
+
+   uchar header[bmp_file_header_size + bmp_info_header_size] = { 'B', 'M' };
+   uchar* info = header + bmp_file_header_size;
+   Common::write_le(header + 2,  sizeof(header) + pixels_bytes, 4);
+   Common::write_le(header + 10, sizeof(header), 4);
+   Common::write_le(info,        bmp_info_header_size, 4);
+   Common::write_le(info + 4,    image.width, 4);
+   Common::write_le(info + 8,    static_cast<uint>(-static_cast<int>(image.height)), 4);     // top-down
+   Common::write_le(info + 12,   1, 2);
+   Common::write_le(info + 14,   32, 2);
+   Common::write_le(info + 16,   bmp_bi_rgb, 4);
+   Common::write_le(info + 20,   pixels_bytes, 4);
+
+   std::ofstream file(file_name.c_str(), std::ios::binary);
+   file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+   // A8R8G8B8 in little-endian order is exactly BMP's blue, green, red, alpha
+   std::vector<uchar> row(4*image.width);
+   for (uint y = 0; y < image.height; ++y)
+   {
+      for (uint x = 0; x < image.width; ++x)
+      {
+         Common::write_le(&row[4*x], image.pixels[y*image.width + x], 4);
+      }
+      if (!row.empty())
+      {
+         file.write(reinterpret_cast<const char*>(&row[0]), row.size());
+      }
+   }
+
+   if (!file)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't write \"" << file_name << "\"; throw !!!";
+      throw Image_exception("Can't write BMP file " + file_name);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Converts row of blue, green, red triples to opaque A8R8G8B8.
+/// \param end End of readable memory: SSE2 path reads 16 bytes to convert 4 pixels.
+void convert_bgr_row(const uchar* src, const uchar* end, uint* dst, uint width)
+{
+   uint x = 0;
+
+#ifdef COMMON_SSE2
+   // triple of pixel i is shifted by i bytes to its lane, then bytes of other pixels are masked out
+   const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+   const __m128i mask0 = _mm_setr_epi32(0x00FFFFFF, 0, 0, 0);
+   const __m128i mask1 = _mm_setr_epi32(0, 0x00FFFFFF, 0, 0);
+   const __m128i mask2 = _mm_setr_epi32(0, 0, 0x00FFFFFF, 0);
+   const __m128i mask3 = _mm_setr_epi32(0, 0, 0, 0x00FFFFFF);
+   for (; x + 4 <= width && end - (src + 3*x) >= 16; x += 4)
+   {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*x));
+      const __m128i p01 = _mm_or_si128(_mm_and_si128(v, mask0), _mm_and_si128(_mm_slli_si128(v, 1), mask1));
+      const __m128i p23 = _mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 2), mask2),
+                                       _mm_and_si128(_mm_slli_si128(v, 3), mask3));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_or_si128(_mm_or_si128(p01, p23), alpha));
+   }
+#else
+   (void)end;
+#endif
+
+   for (; x < width; ++x)
+   {
+      dst[x] = make_argb(0xFF, src[3*x + 2], src[3*x + 1], src[3*x]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void convert_indexed_row(const uchar* src, const uint* palette, uint* dst, uint width)
+{
+   for (uint x = 0; x < width; ++x)
+   {
+      dst[x] = palette[src[x]];
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Decodes run-length encoded 8-bit pixels; pixels that are skipped get the first color of palette.
+/// Runs are pairs of count and index; zero count starts escape: end of row (0), end of image (1),
+/// move by next two bytes (2) or run of given number of literal indexes, padded to 2 bytes.
+/// \return false if data ends before end of image.
+bool decode_rle8(const uchar* src, const uchar* end, const uint* palette, bool bottom_up, Image& image)
+{
+   std::fill(image.pixels.begin(), image.pixels.end(), palette[0]);
+
+   uint x = 0;
+   uint y = 0;
+   while (end - src >= 2)
+   {
+      const uint count = src[0];
+      const uint value = src[1];
+      src += 2;
+
+      if (count > 0)
+      {
+         // pixels beyond row are clipped
+         if (y < image.height)
+         {
+            uint* row = &image.pixels[(bottom_up ? image.height - 1 - y : y)*image.width];
+            std::fill(row + std::min(x, image.width), row + std::min(x + count, image.width), palette[value]);
+         }
+         x += count;
+         continue;
+      }
+
+      switch (value)
+      {
+      case 0:
+         x = 0;
+         ++y;
+         break;
+      case 1:
+         return true;
+      case 2:
+         if (end - src < 2)
+         {
+            return false;
+         }
+         x += src[0];
+         y += src[1];
+         src += 2;
+         break;
+      default:
+         if (end - src < static_cast<ptrdiff_t>(value))
+         {
+            return false;
+         }
+         if (y < image.height)
+         {
+            uint* row = &image.pixels[(bottom_up ? image.height - 1 - y : y)*image.width];
+            for (uint i = 0; i < value && x + i < image.width; ++i)
+            {
+               row[x + i] = palette[src[i]];
+            }
+         }
+         x += value;
+         src += value + (value & 1);
+      }
+   }
+
+   return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Culling implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Culling.h"
+
+#include "Common/Simd.h"
+
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline uint get_level_offset(uint level);
+
+#ifdef COMMON_SSE2
+template <Vertex_format format>
+inline bool is_visible(const Sprite<format>& s, const __m128& low, const __m128& high);
+#else
+template <Vertex_format format>
+inline bool is_visible(const Sprite<format>& s, const Bounds& viewport);
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+uint cull_sprites(std::vector<Sprite<format> >& sprites, const Bounds& viewport)
+{
+#ifdef COMMON_SSE2
+   // only x and y lanes are compared
+   const __m128 low  = _mm_setr_ps(viewport.left, viewport.top, 0, 0);
+   const __m128 high = _mm_setr_ps(viewport.right, viewport.bottom, 0, 0);
+#endif
+
+   // visible sprites are moved towards the beginning
+   size_t kept = 0;
+   for (size_t i = 0; i < sprites.size(); ++i)
+   {
+#ifdef COMMON_SSE2
+      if (is_visible(sprites[i], low, high))
+#else
+      if (is_visible(sprites[i], viewport))
+#endif
+      {
+         if (kept != i)
+         {
+            sprites[kept] = sprites[i];
+         }
+         ++kept;
+      }
+   }
+
+   const uint culled = static_cast<uint>(sprites.size() - kept);
+   sprites.erase(sprites.begin() + kept, sprites.end());
+   return culled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Loose_quadtree::Loose_quadtree(const Bounds& world, uint depth)
+   : m_world(world),
+     m_depth(depth),
+     m_size(0)
+{
+   assert(world.left < world.right && world.top < world.bottom && "Invalid world");
+   assert(depth < 16 && "Too deep quadtree");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Loose_quadtree::insert(uint id, const Bounds& bounds)
+{
+   if (id >= m_items.size())
+   {
+      Item unused = Item();
+      m_items.resize(id + 1, unused);
+   }
+   assert(!m_items[id].is_used && "Item is already in quadtree");
+
+   if (m_nodes.empty())
+   {
+      m_nodes.resize(get_level_offset(m_depth + 1));
+   }
+
+   m_items[id].bounds  = bounds;
+   m_items[id].is_used = true;
+   add_to_node(id, locate(bounds));
+   ++m_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Loose_quadtree::move(uint id, const Bounds& bounds)
+{
+   assert(id < m_items.size() && m_items[id].is_used && "No such item");
+
+   Item& item = m_items[id];
+   item.bounds = bounds;
+
+   const Cell cell = locate(bounds);
+   if (cell.level != item.cell.level || cell.x != item.cell.x || cell.y != item.cell.y)
+   {
+      remove_from_node(id);
+      add_to_node(id, cell);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Loose_quadtree::remove(uint id)
+{
+   assert(id < m_items.size() && m_items[id].is_used && "No such item");
+
+   remove_from_node(id);
+   m_items[id].is_used = false;
+   --m_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Loose_quadtree::query(const Bounds& area, std::vector<uint>& ids) const
+{
+   if (m_size != 0)
+   {
+      query_node(0, 0, 0, area, ids);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Loose_quadtree::Cell Loose_quadtree::locate(const Bounds& bounds) const
+{
+   Cell cell = { 0, 0, 0 };
+
+   const float center_x = (bounds.left + bounds.right) / 2;
+   const float center_y = (bounds.top + bounds.bottom) / 2;
+   // negated, so that NaN goes to root too
+   if (!(center_x >= m_world.left && center_x < m_world.right && center_y >= m_world.top && center_y < m_world.bottom))
+   {
+      return cell;
+   }
+
+   // the deepest level with cells not smaller than item
+   const float width  = bounds.right - bounds.left;
+   const float height = bounds.bottom - bounds.top;
+   uint level = m_depth;
+   while (level > 0 && (width  > (m_world.right - m_world.left) / (1 << level)
+                    ||  height > (m_world.bottom - m_world.top) / (1 << level)))
+   {
+      --level;
+   }
+
+   const uint cells = 1u << level;
+   cell.level = level;
+   cell.x = std::min(cells - 1, uint((center_x - m_world.left) / (m_world.right - m_world.left) * cells));
+   cell.y = std::min(cells - 1, uint((center_y - m_world.top) / (m_world.bottom - m_world.top) * cells));
+   return cell;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Loose_quadtree::Node& Loose_quadtree::get_node(const Cell& cell)
+{
+   return m_nodes[get_level_offset(cell.level) + (cell.y << cell.level) + cell.x];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Loose_quadtree::Node& Loose_quadtree::get_node(const Cell& cell) const
+{
+   return m_nodes[get_level_offset(cell.level) + (cell.y << cell.level) + cell.x];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Loose_quadtree::add_to_node(uint id, const Cell& cell)
+{
+   Node& node = get_node(cell);
+   m_items[id].cell     = cell;
+   m_items[id].position = static_cast<uint>(node.ids.size());
+   node.ids.push_back(id);
+
+   // node and all its ancestors
+   Cell ancestor = cell;
+   for (uint i = 0; i <= cell.level; ++i)
+   {
+      ++get_node(ancestor).subtree_size;
+      ancestor.level -= 1;
+      ancestor.x >>= 1;
+      ancestor.y >>= 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Loose_quadtree::remove_from_node(uint id)
+{
+   const Item& item = m_items[id];
+   Node& node = get_node(item.cell);
+
+   // move the last id into the hole
+   const uint last = node.ids.back();
+   node.ids[item.position] = last;
+   m_items[last].position = item.position;
+   node.ids.pop_back();
+
+   Cell ancestor = item.cell;
+   for (uint i = 0; i <= item.cell.level; ++i)
+   {
+      --get_node(ancestor).subtree_size;
+      ancestor.level -= 1;
+      ancestor.x >>= 1;
+      ancestor.y >>= 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Loose_quadtree::query_node(uint level, uint x, uint y, const Bounds& area, std::vector<uint>& ids) const
+{
+   const Cell cell = { level, x, y };
+   const Node& node = get_node(cell);
+   if (node.subtree_size == 0)
+   {
+      return;
+   }
+
+   // root holds items from outside of world, so it is always visited
+   if (level > 0)
+   {
+      const float width  = (m_world.right - m_world.left) / (1 << level);
+      const float height = (m_world.bottom - m_world.top) / (1 << level);
+      const Bounds loose = { m_world.left + (x - 0.5f)*width,  m_world.top + (y - 0.5f)*height,
+                             m_world.left + (x + 1.5f)*width,  m_world.top + (y + 1.5f)*height };
+      if (!intersect(loose, area))
+      {
+         return;
+      }
+   }
+
+   for (size_t i = 0; i < node.ids.size(); ++i)
+   {
+      if (intersect(m_items[node.ids[i]].bounds, area))
+      {
+         ids.push_back(node.ids[i]);
+      }
+   }
+
+   if (level < m_depth)
+   {
+      query_node(level + 1, 2*x,     2*y,     area, ids);
+      query_node(level + 1, 2*x + 1, 2*y,     area, ids);
+      query_node(level + 1, 2*x,     2*y + 1, area, ids);
+      query_node(level + 1, 2*x + 1, 2*y + 1, area, ids);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Number of nodes on levels above given one: 1 + 4 + ... + 4^(level - 1).
+inline uint get_level_offset(uint level)
+{
+   return ((1u << 2*level) - 1) / 3;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef COMMON_SSE2
+
+/// Vertex starts with x, y, z and color, so bounds of sprite are minimum and maximum of 4 rows;
+/// lanes of z and color are ignored.
+/// \param low  Left and top of viewport in the lowest lanes.
+/// \param high Right and bottom of viewport in the lowest lanes.
+template <Vertex_format format>
+inline bool is_visible(const Sprite<format>& s, const __m128& low, const __m128& high)
+{
+   const __m128 v0 = _mm_loadu_ps(&s.vertexes[0].position.x);
+   const __m128 v1 = _mm_loadu_ps(&s.vertexes[1].position.x);
+   const __m128 v2 = _mm_loadu_ps(&s.vertexes[2].position.x);
+   const __m128 v3 = _mm_loadu_ps(&s.vertexes[3].position.x);
+   const __m128 min_corner = _mm_min_ps(_mm_min_ps(v0, v1), _mm_min_ps(v2, v3));
+   const __m128 max_corner = _mm_max_ps(_mm_max_ps(v0, v1), _mm_max_ps(v2, v3));
+
+   const __m128 inside = _mm_and_ps(_mm_cmpge_ps(max_corner, low), _mm_cmple_ps(min_corner, high));
+   return (_mm_movemask_ps(inside) & 3) == 3;
+}
+
+#else
+
+template <Vertex_format format>
+inline bool is_visible(const Sprite<format>& s, const Bounds& viewport)
+{
+   return intersect(get_bounds(s), viewport);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template uint cull_sprites(std::vector<Colored_sprite>&, const Bounds&);
+template uint cull_sprites(std::vector<Textured_sprite>&, const Bounds&);
+template uint cull_sprites(std::vector<Multitextured_2_sprite>&, const Bounds&);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// DDS reading and writing implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Dds.h"
+
+#include "Engine/Rendering/Logging.h"
+
+#include "Common/Little_endian.h"
+#include "Common/Mapped_file.h"
+
+#include <cstring>              // for std::memcmp
+#include <fstream>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// DDS layout: magic "DDS ", DDS_HEADER (124 bytes, with DDS_PIXELFORMAT at offset 72 of it), top level blocks,
+// then smaller mip levels. All numbers are little-endian.
+
+const uint dds_header_size         = 128;
+const uint dds_flags               = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000;   // caps, height, width, format, size
+const uint dds_pixel_format_fourcc = 0x4;
+const uint dds_caps_texture        = 0x1000;
+/// Larger sides are rejected, so that broken headers don't make huge allocations.
+const uint dds_max_side            = 1 << 15;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool is_dds_file(const std::string& file_name)
+{
+   const size_t size = file_name.size();
+   if (size < 4 || file_name[size - 4] != '.')
+   {
+      return false;
+   }
+
+   const char* const extension = "dds";
+   for (uint i = 0; i < 3; ++i)
+   {
+      const char c = file_name[size - 3 + i];
+      if (c != extension[i] && c != extension[i] - 'a' + 'A')
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Compressed_image load_dds(const std::string& file_name)
+{
+   try
+   {
+      const Common::Mapped_file file(file_name);
+      return decode_dds(file.get_data(), file.get_size(), file_name);
+   }
+   catch (const Common::Mapped_file_exception&)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't open \"" << file_name << "\"; throw !!!";
+      throw Image_exception("Can't open DDS file " + file_name);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Compressed_image decode_dds(const uchar* data, size_t size, const std::string& name)
+{
+   if (size < dds_header_size || std::memcmp(data, "DDS ", 4) != 0 || Common::read_le(data + 4, 4) != 124)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! \"" << name << "\" isn't DDS file; throw !!!";
+      throw Image_exception("Not a DDS file " + name);
+   }
+
+   Compressed_image image;
+   image.height = Common::read_le(data + 12, 4);
+   image.width  = Common::read_le(data + 16, 4);
+
+   const uchar* pixel_format = data + 76;
+   const bool is_dxt1 = std::memcmp(pixel_format + 8, "DXT1", 4) == 0;
+   const bool is_dxt5 = std::memcmp(pixel_format + 8, "DXT5", 4) == 0;
+   if ((Common::read_le(pixel_format + 4, 4) & dds_pixel_format_fourcc) == 0 || !(is_dxt1 || is_dxt5)
+       || image.width == 0 || image.height == 0 || image.width > dds_max_side || image.height > dds_max_side)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Unsupported DDS format of \"" << name << "\"; throw !!!";
+      throw Image_exception("Unsupported DDS format " + name);
+   }
+   image.format = is_dxt1 ? block_format_bc1 : block_format_bc3;
+
+   const size_t bytes = size_t(image.get_blocks_wide())*image.get_blocks_high()*get_block_bytes(image.format);
+   if (size - dds_header_size < bytes)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! DDS file \"" << name << "\" is truncated; throw !!!";
+      throw Image_exception("Truncated DDS file " + name);
+   }
+   image.blocks.assign(data + dds_header_size, data + dds_header_size + bytes);
+
+   return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void save_dds(const Compressed_image& image, const std::string& file_name)
+{
+   uchar header[dds_header_size] = { 'D', 'D', 'S', ' ' };
+   Common::write_le(header + 4,   124, 4);
+   Common::write_le(header + 8,   dds_flags, 4);
+   Common::write_le(header + 12,  image.height, 4);
+   Common::write_le(header + 16,  image.width, 4);
+   Common::write_le(header + 20,  static_cast<uint>(image.blocks.size()), 4);
+   Common::write_le(header + 76,  32, 4);
+   Common::write_le(header + 80,  dds_pixel_format_fourcc, 4);
+   std::memcpy(header + 84, image.format == block_format_bc1 ? "DXT1" : "DXT5", 4);
+   Common::write_le(header + 108, dds_caps_texture, 4);
+
+   std::ofstream file(file_name.c_str(), std::ios::binary);
+   file.write(reinterpret_cast<const char*>(header), sizeof(header));
+   if (!image.blocks.empty())
+   {
+      file.write(reinterpret_cast<const char*>(&image.blocks[0]), image.blocks.size());
+   }
+
+   if (!file)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't write \"" << file_name << "\"; throw !!!";
+      throw Image_exception("Can't write DDS file " + file_name);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,11 +11,20 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "Engine/Rendering/Direct3D/Direct3D_renderer.h"
+#include "Engine/Rendering/Bmp.h"
+#include "Engine/Rendering/Dds.h"
+#include "Engine/Rendering/Vertex_conversion.h"
 
 #include "Engine/Logging/Logging.h"
+#include "Engine/Timing/Stopwatch.h"
 
 #include "Common/Typedefs.h"
 
+#include "boost/bind.hpp"
+
+#include <algorithm>
+#include <cassert>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace Engine
@@ -25,46 +34,42 @@ namespace Rendering
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void add_to_vbuf(const Colored_sprite& s, struct D3D_colored_vertex* where);
-void add_to_vbuf(const Textured_sprite& s, struct D3D_textured_vertex* where);
-void add_to_vbuf(const Multitextured_2_sprite& s, struct D3D_multitextured_2_vertex* where);
+/// Initial size of dynamic vertex buffer; it grows if scenes don't fit (see Vertex_ring).
+const uint initial_vertex_buffer_bytes = 1 << 20;
+
+/// Minimal number of sprites buffer of retained sprites is created for.
+const uint min_retained_capacity = 256;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 D3DPRESENT_PARAMETERS default_present_params(HWND, bool fullscreen);
+D3D_index_buffer_ptr create_quad_index_buffer(D3D_device_ptr device);
+D3D_texture_ptr load_texture(D3D_device_ptr device, const Texture_ID& id, uint& bytes);
 D3DTEXTUREOP get_direct3d_texture_op(Blending_mode mode);
 void init_direct3d_texture_stages();
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Direct3D friendly rendering structures.
-// 'w' is rhw param for D3DFVF_XYZRHW (see DirectX documentation for details).
+// Direct3D friendly rendering structures (see Vertex_conversion.h).
 
-struct D3D_colored_vertex
-{
-   float x, y, z, w;
-   D3DCOLOR color;
-};
-
-struct D3D_textured_vertex
-{
-   float x, y, z, w;
-   D3DCOLOR color;
-   float tu, tv;
-};
-
-struct D3D_multitextured_2_vertex
-{
-   float x, y, z, w;
-   D3DCOLOR color;
-   float tu0, tv0;
-   float tu1, tv1;
-};
+typedef Device_vertex<Vertex_format(position | diffuse_color)>                                   D3D_colored_vertex;
+typedef Device_vertex<Vertex_format(position | diffuse_color | texture_coord0)>                  D3D_textured_vertex;
+typedef Device_vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> D3D_multitextured_2_vertex;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Direct3D_renderer::Direct3D_renderer(HWND window_handle, bool fullscreen)
-   : m_window_handle(window_handle)
+   : m_culling()
+   , m_texture_loads(0)
+   , m_window_handle(window_handle)
    , m_present_params(default_present_params(window_handle, fullscreen))
    , m_device(m_D3D.create_device(window_handle, m_present_params))
-   , m_vbuf(m_device.create_vertex_buffer(1 << 20)) // TODO: expose parameter to config
+   , m_vbuf(m_device.create_vertex_buffer(initial_vertex_buffer_bytes))
+   , m_ibuf(create_quad_index_buffer(m_device))
+   , m_ring(*this, initial_vertex_buffer_bytes)
+   , m_vertex_bytes(0)
+   , m_textures(boost::bind(load_texture, m_device, _1, _2), texture_cache_budget)
+   , m_pack(0)
 {
    init_direct3d_texture_stages();
 }
@@ -92,13 +97,56 @@ void Direct3D_renderer::add_to_scene(const Multitextured_2_sprite& s)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Direct3D_renderer::add_to_scene(const Scene_buffer& buffer)
+{
+   m_sprites_colored.insert(m_sprites_colored.end(), buffer.get_colored_sprites().begin(),
+                            buffer.get_colored_sprites().end());
+   m_sprites_textured.insert(m_sprites_textured.end(), buffer.get_textured_sprites().begin(),
+                             buffer.get_textured_sprites().end());
+   m_sprites_multitextured.insert(m_sprites_multitextured.end(), buffer.get_multitextured_sprites().begin(),
+                                  buffer.get_multitextured_sprites().end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// fixed-function pipeline takes pre-transformed vertexes only, so instances are expanded on CPU
+void Direct3D_renderer::add_to_scene(const Sprite_instances& instances)
+{
+   const size_t size = m_sprites_textured.size();
+   m_sprites_textured.resize(size + instances.number);
+   if (instances.number > 0)
+   {
+      expand_instances(instances, &m_sprites_textured[size]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Direct3D_renderer::render_scene()
 {
+   clear_render_stats(m_stats);
+   const uint issued = m_device.get_state_statistics().issued;
+   Timing::Stopwatch stopwatch;
+
+   // textures loaded since previous frame are drawn from this one on
+   take_streamed_textures();
+
    m_device.clear();
 
-   copy_scene_to_vbuf();
+   // conversion and uploads are measured where they happen, the rest is drawing
    draw_to_back_buffer();
+   m_ring.end_frame();
+   m_stats.draw_seconds = stopwatch.lap() - m_stats.convert_seconds - m_stats.upload_seconds;
+
    m_device.present();
+   m_stats.present_seconds = stopwatch.lap();
+
+   m_stats.state_changes     = m_device.get_state_statistics().issued - issued;
+   m_stats.texture_loads     = m_texture_loads;
+   m_stats.sprites_submitted = m_culling.sprites + m_culling.retained;
+   m_stats.sprites_culled    = m_culling.culled_sprites + m_culling.culled_retained;
+   m_texture_loads = 0;
+   m_stats_log.add_frame(m_stats);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -109,6 +157,72 @@ void Direct3D_renderer::clear_scene()
    m_sprites_colored.clear();
    m_sprites_textured.clear();
    m_sprites_multitextured.clear();
+   m_colored_pools.clear();
+   m_textured_pools.clear();
+   m_multitextured_pools.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Colored_sprite_handle Direct3D_renderer::create_sprite(const Colored_sprite& s)
+{
+   return m_retained_colored.create(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Textured_sprite_handle Direct3D_renderer::create_sprite(const Textured_sprite& s)
+{
+   return m_retained_textured.create(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Multitextured_2_sprite_handle Direct3D_renderer::create_sprite(const Multitextured_2_sprite& s)
+{
+   return m_retained_multitextured.create(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::update_sprite(Colored_sprite_handle handle, const Colored_sprite& s)
+{
+   m_retained_colored.update(handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::update_sprite(Textured_sprite_handle handle, const Textured_sprite& s)
+{
+   m_retained_textured.update(handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::update_sprite(Multitextured_2_sprite_handle handle, const Multitextured_2_sprite& s)
+{
+   m_retained_multitextured.update(handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::destroy_sprite(Colored_sprite_handle handle)
+{
+   m_retained_colored.destroy(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::destroy_sprite(Textured_sprite_handle handle)
+{
+   m_retained_textured.destroy(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::destroy_sprite(Multitextured_2_sprite_handle handle)
+{
+   m_retained_multitextured.destroy(handle);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -139,10 +253,97 @@ void Direct3D_renderer::try_restore()
    {
       LOG_RENDERER(Logging::minor) << "Restore renderer";
 
-      // reset device and associated resources
+      // reset device and associated resources; textures are reloaded on demand
+      for (uint nstage = 0; nstage < batch_stages_number; ++nstage)
+      {
+         m_device.set_texture(nstage, D3D_texture_ptr());
+      }
+      m_textures.clear();
       m_vbuf.reset();
       m_device.reset(m_present_params);
-      m_vbuf = m_device.create_vertex_buffer(1 << 20);
+      m_vbuf = m_device.create_vertex_buffer(m_ring.get_capacity());
+      m_ring.reset();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Render_stats& Direct3D_renderer::get_render_stats() const
+{
+   return m_stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::enable_texture_streaming(uint threads)
+{
+   Image placeholder(1, 1);
+   placeholder.pixels[0] = 0xFFFFFFFF;
+   m_placeholder = m_device.create_texture(placeholder);
+
+   m_streamer.reset(new Texture_streamer(threads, Texture_streamer::dds_compressed));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::prefetch_texture(const Texture_ID& id)
+{
+   D3D_texture_ptr texture;
+   if (m_textures.contains(id) || take_packed_texture(id, texture))
+   {
+      return;
+   }
+
+   if (!m_streamer)
+   {
+      m_textures.get(id);
+      ++m_texture_loads;
+   }
+   else
+   {
+      m_streamer->prefetch(id);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::wait_for_textures()
+{
+   if (m_streamer)
+   {
+      m_streamer->wait();
+      take_streamed_textures();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::take_streamed_textures()
+{
+   if (!m_streamer || m_streamer->get_pending_number() == 0)
+   {
+      return;
+   }
+
+   m_streamed.clear();
+   m_streamer->collect(m_streamed);
+   for (size_t i = 0; i < m_streamed.size(); ++i)
+   {
+      const Streamed_image& loaded = m_streamed[i];
+      if (!loaded.image && !loaded.compressed)
+      {
+         // placeholder stays, so texture isn't requested again
+         LOG_RENDERER(Logging::critical) << "!!! Can't load texture \"" << loaded.id.get_file_name() << "\": "
+                                         << loaded.error << " !!!";
+         m_textures.insert(loaded.id, m_placeholder, 0);
+         continue;
+      }
+
+      LOG_RENDERER(Logging::trivial) << "Texture \"" << loaded.id.get_file_name() << "\" streamed";
+      const D3D_texture_ptr texture = loaded.compressed ? m_device.create_texture(*loaded.compressed)
+                                                        : m_device.create_texture(*loaded.image);
+      m_textures.insert(loaded.id, texture, texture.get_bytes());
+      ++m_texture_loads;
    }
 }
 
@@ -151,16 +352,38 @@ void Direct3D_renderer::try_restore()
 void Direct3D_renderer::set_texture(uint nstage, const Texture_ID& id)
 {
    // reset texture if empty Texture_ID is given; set valid texture otherwise
-   if (id == Texture_ID())
+   D3D_texture_ptr texture;
+   if (id != Texture_ID() && !m_textures.find(id, texture) && !take_packed_texture(id, texture))
    {
-      D3D_texture_ptr texture;
-      m_device.set_texture(nstage, texture);
+      if (!m_streamer)
+      {
+         texture = m_textures.get(id);
+         ++m_texture_loads;
+      }
+      else
+      {
+         m_streamer->request(id);
+         texture = m_placeholder;
+      }
    }
-   else
+   m_device.set_texture(nstage, texture);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Direct3D_renderer::take_packed_texture(const Texture_ID& id, D3D_texture_ptr& texture)
+{
+   Packed_texture packed;
+   if (!m_pack || !m_pack->find(id.get_file_name(), packed))
    {
-      D3D_texture_ptr texture = m_device.create_texture(id.file_name.c_str());
-      m_device.set_texture(nstage, texture);
+      return false;
    }
+
+   LOG_RENDERER(Logging::trivial) << "Texture \"" << id.get_file_name() << "\" taken from asset pack";
+   texture = m_device.create_texture(packed);
+   m_textures.insert(id, texture, texture.get_bytes());
+   ++m_texture_loads;
+   return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -174,78 +397,230 @@ void Direct3D_renderer::set_blending(uint nstage, Blending_mode mode)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Direct3D_renderer::copy_scene_to_vbuf()
+void Direct3D_renderer::draw_to_back_buffer()
 {
-   D3D_vertex_buffer_ptr::Lock lock(m_vbuf);
+   D3D_device_ptr::Scene_guard guard(m_device);
 
-   // add colored sprites
-   void* raw = lock.get_raw_memory();
-   D3D_colored_vertex* coords = reinterpret_cast<D3D_colored_vertex*>(raw);
-   for (size_t i = 0; i < m_sprites_colored.size(); ++i)
+   m_device.set_index_buffer(m_ibuf);
+
+   const Bounds viewport = { 0, 0, float(m_present_params.BackBufferWidth), float(m_present_params.BackBufferHeight) };
+
+   // retained sprites are drawn right from their buffers, see set_vertex_format();
+   // viewport doesn't change, so does visibility of retained sprites
+   Timing::Stopwatch stopwatch;
+   if (m_retained_colored.is_changed() || m_retained_textured.is_changed() || m_retained_multitextured.is_changed())
    {
-      add_to_vbuf(m_sprites_colored[i], coords + 4*i);
+      m_retained_batches.clear();
+      m_retained_translucent.clear();
+      m_translucent_entries.clear();
+      m_culling.retained = static_cast<uint>(m_retained_colored.get_sprites().size()
+                                             + m_retained_textured.get_sprites().size()
+                                             + m_retained_multitextured.get_sprites().size());
+      m_culling.culled_retained =
+         compile_visible_batches(m_retained_colored, viewport, m_visible_slots, m_retained_batches,
+                                 m_translucent_entries)
+         + compile_visible_batches(m_retained_textured, viewport, m_visible_slots, m_retained_batches,
+                                   m_translucent_entries)
+         + compile_visible_batches(m_retained_multitextured, viewport, m_visible_slots, m_retained_batches,
+                                   m_translucent_entries);
+      m_queue.compile_sorted(m_translucent_entries, m_retained_colored.get_sprites(),
+                             m_retained_textured.get_sprites(), m_retained_multitextured.get_sprites(),
+                             m_retained_translucent);
+      m_stats.convert_seconds += stopwatch.get_elapsed();
+
+      upload_retained(m_retained_colored, m_retained_colored_vbuf);
+      upload_retained(m_retained_textured, m_retained_textured_vbuf);
+      upload_retained(m_retained_multitextured, m_retained_multitextured_vbuf);
    }
+   draw_batches(m_retained_batches, *this);
+
+   // off-screen sprites are dropped before their vertexes are written
+   stopwatch.restart();
+   m_culling.sprites = static_cast<uint>(m_sprites_colored.size() + m_sprites_textured.size()
+                                         + m_sprites_multitextured.size());
+   m_culling.culled_sprites = cull_sprites(m_sprites_colored, viewport) + cull_sprites(m_sprites_textured, viewport)
+                              + cull_sprites(m_sprites_multitextured, viewport);
+
+   m_batches.clear();
+   const uint opaque_batches = m_queue.sort(m_sprites_colored, m_sprites_textured, m_sprites_multitextured, m_batches);
+   m_translucent_batches.assign(m_batches.begin() + opaque_batches, m_batches.end());
+   m_batches.resize(opaque_batches);
+   m_stats.convert_seconds += stopwatch.get_elapsed();
+
+   // translucent sprites are blended over all opaque ones; retained ones go first
+   stream_batches(m_batches, m_ring, *this);
+   stream_pools(m_colored_pools);
+   stream_pools(m_textured_pools);
+   stream_pools(m_multitextured_pools);
+   draw_batches(m_retained_translucent, *this);
+   stream_batches(m_translucent_batches, m_ring, *this);
+}
 
-   // add textured sprites
-   raw = coords + 4*m_sprites_colored.size();
-   D3D_textured_vertex* coords2 = reinterpret_cast<D3D_textured_vertex*>(raw);
-   for (size_t i = 0; i < m_sprites_textured.size(); ++i)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Direct3D_renderer::stream_pools(const std::vector<const Sprite_pool<format>*>& pools)
+{
+   for (size_t i = 0; i < pools.size(); ++i)
    {
-      add_to_vbuf(m_sprites_textured[i], coords2 + 4*i);
+      stream_pool(*pools[i], m_ring, *this, m_pool_batches);
    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-   // add multitextured sprites
-   raw = coords2 + 4*m_sprites_textured.size();
-   D3D_multitextured_2_vertex* coords3 = reinterpret_cast<D3D_multitextured_2_vertex*>(raw);
-   for (size_t i = 0; i < m_sprites_multitextured.size(); ++i)
+template <Vertex_format format>
+void Direct3D_renderer::upload_retained(Sprite_store<format>& store, Retained_buffer& buffer)
+{
+   const uint count = static_cast<uint>(store.get_sprites().size());
+   if (count > buffer.capacity)
    {
-      add_to_vbuf(m_sprites_multitextured[i], coords3 + 4*i);
+      buffer.capacity = std::max(std::max(count, 2*buffer.capacity), min_retained_capacity);
+      buffer.vbuf.reset();
+      buffer.vbuf = m_device.create_static_vertex_buffer(buffer.capacity*get_quad_bytes(format));
+      store.mark_all_dirty();
    }
+
+   const uint first = store.get_dirty_first();
+   const uint end = store.get_dirty_end();
+   if (first < end)
+   {
+      const uint quad_bytes = get_quad_bytes(format);
+      Timing::Stopwatch stopwatch;
+      void* raw = buffer.vbuf.lock(first*quad_bytes, (end - first)*quad_bytes, 0);
+      m_stats.upload_seconds += stopwatch.lap();
+      convert_sprites(&store.get_sprites()[first], end - first, static_cast<Device_vertex<format>*>(raw));
+      m_stats.convert_seconds += stopwatch.lap();
+      buffer.vbuf.unlock();
+      m_stats.upload_seconds += stopwatch.lap();
+      m_stats.vertex_bytes += (end - first)*quad_bytes;
+   }
+   store.clear_dirty();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Direct3D_renderer::draw_to_back_buffer()
+Direct3D_renderer::Retained_buffer& Direct3D_renderer::get_retained_buffer(Vertex_format format)
 {
-   D3D_device_ptr::Scene_guard guard(m_device);
+   switch (uint(format))
+   {
+   case position | diffuse_color:
+      return m_retained_colored_vbuf;
+   case position | diffuse_color | texture_coord0:
+      return m_retained_textured_vbuf;
+   default:
+      assert(format == (position | diffuse_color | texture_coord0 | texture_coord1) && "Unsupported vertex format");
+      return m_retained_multitextured_vbuf;
+   }
+}
 
-   // reset state
-   set_texture(0, Texture_ID());
-   set_blending(0, blending_mode_select_arg1);
-   set_texture(1, Texture_ID());
-   set_blending(1, blending_mode_disable);
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-   // draw colored sprites
-   m_device.set_vertex_buffer(m_vbuf, 0, sizeof(D3D_colored_vertex));
-   m_device.set_vertex_format(D3DFVF_XYZRHW | D3DFVF_DIFFUSE);
-   for (size_t i = 0; i < m_sprites_colored.size(); ++i)
+void Direct3D_renderer::set_vertex_format(Vertex_format format)
+{
+   switch (uint(format))
    {
-      m_device.draw_primitive(D3DPT_TRIANGLESTRIP, 4*i, 2);
+   case position | diffuse_color:
+      m_device.set_vertex_format(D3DFVF_XYZRHW | D3DFVF_DIFFUSE);
+      break;
+   case position | diffuse_color | texture_coord0:
+      m_device.set_vertex_format(D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX1);
+      break;
+   case position | diffuse_color | texture_coord0 | texture_coord1:
+      m_device.set_vertex_format(D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX2);
+      break;
+   default:
+      assert(false && "Unsupported vertex format");
    }
+   m_vertex_bytes = get_quad_bytes(format) / 4;
+
+   // source of retained sprites; streamed ones are taken from ring by set_vertex_offset()
+   m_device.set_vertex_buffer(get_retained_buffer(format).vbuf, 0, m_vertex_bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::draw_quads(uint first_quad, uint nquads)
+{
+   ++m_stats.draw_calls;
+   m_stats.sprites_drawn += nquads;
+   m_device.draw_indexed_primitive(D3DPT_TRIANGLELIST, 4*first_quad, 4*nquads, 0, 2*nquads);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-   // draw textured sprites
-   // TODO: clean me!!!
-   m_device.set_vertex_buffer(m_vbuf, 4*sizeof(D3D_colored_vertex)*m_sprites_colored.size(), sizeof(D3D_textured_vertex));
-   m_device.set_vertex_format(D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX1);
-   for (size_t i = 0; i < m_sprites_textured.size(); ++i)
+uint Direct3D_renderer::get_quad_bytes(Vertex_format format) const
+{
+   switch (uint(format))
    {
-      set_texture(0, m_sprites_textured[i].texture);
-      set_blending(0, m_sprites_textured[i].blending);
-      m_device.draw_primitive(D3DPT_TRIANGLESTRIP, 4*i, 2);
+   case position | diffuse_color:
+      return 4*sizeof(D3D_colored_vertex);
+   case position | diffuse_color | texture_coord0:
+      return 4*sizeof(D3D_textured_vertex);
+   case position | diffuse_color | texture_coord0 | texture_coord1:
+      return 4*sizeof(D3D_multitextured_2_vertex);
+   default:
+      assert(false && "Unsupported vertex format");
+      return 0;
    }
-   // draw multi-textured sprites
-   // TODO: clean me!!!
-   m_device.set_vertex_buffer(m_vbuf, 4*sizeof(D3D_colored_vertex)*m_sprites_colored.size()
-                                    + 4*sizeof(D3D_textured_vertex)*m_sprites_textured.size(), sizeof(D3D_multitextured_2_vertex));
-   m_device.set_vertex_format(D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX2);
-   for (size_t i = 0; i < m_sprites_multitextured.size(); ++i)
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::write_quads(Vertex_format format, uint first, uint nquads, void* where)
+{
+   const Timing::Stopwatch stopwatch;
+   switch (uint(format))
    {
-      set_texture(0, m_sprites_multitextured[i].texture0);
-      set_blending(0, m_sprites_multitextured[i].blending0);
-      set_texture(1, m_sprites_multitextured[i].texture1);
-      set_blending(1, m_sprites_multitextured[i].blending1);
-      m_device.draw_primitive(D3DPT_TRIANGLESTRIP, 4*i, 2);
+   case position | diffuse_color:
+      convert_sprites(&m_sprites_colored[first], nquads, static_cast<D3D_colored_vertex*>(where));
+      break;
+   case position | diffuse_color | texture_coord0:
+      convert_sprites(&m_sprites_textured[first], nquads, static_cast<D3D_textured_vertex*>(where));
+      break;
+   case position | diffuse_color | texture_coord0 | texture_coord1:
+      convert_sprites(&m_sprites_multitextured[first], nquads, static_cast<D3D_multitextured_2_vertex*>(where));
+      break;
+   default:
+      assert(false && "Unsupported vertex format");
    }
+   m_stats.convert_seconds += stopwatch.get_elapsed();
+   m_stats.vertex_bytes += nquads*get_quad_bytes(format);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::set_vertex_offset(uint offset)
+{
+   // regions of different formats follow each other, so offset is passed as is rather than by base vertex index
+   m_device.set_vertex_buffer(m_vbuf, offset, m_vertex_bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* Direct3D_renderer::lock(uint offset, uint bytes, bool discard)
+{
+   const Timing::Stopwatch stopwatch;
+   void* where = m_vbuf.lock(offset, bytes, discard ? D3DLOCK_DISCARD : D3DLOCK_NOOVERWRITE);
+   m_stats.upload_seconds += stopwatch.get_elapsed();
+   return where;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::unlock()
+{
+   const Timing::Stopwatch stopwatch;
+   m_vbuf.unlock();
+   m_stats.upload_seconds += stopwatch.get_elapsed();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Direct3D_renderer::resize(uint bytes)
+{
+   m_vbuf.reset();
+   m_vbuf = m_device.create_vertex_buffer(bytes);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -273,122 +648,29 @@ D3DPRESENT_PARAMETERS default_present_params(HWND window_handle, bool fullscreen
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void add_to_vbuf(const Colored_sprite& s, D3D_colored_vertex* where)
+/// Creates index buffer shared by all quads drawn.
+D3D_index_buffer_ptr create_quad_index_buffer(D3D_device_ptr device)
 {
-   const Vertex<Vertex_format(position | diffuse_color)>* const v = s.vertexes;
-
-   where[0].x = v[0].position.x;
-   where[0].y = v[0].position.y;
-   where[0].z = v[0].position.z;
-   where[0].w = 1;
-   where[0].color = D3DCOLOR_ARGB(v[0].color.a, v[0].color.r, v[0].color.g, v[0].color.b);
-
-   where[1].x = v[1].position.x;
-   where[1].y = v[1].position.y;
-   where[1].z = v[1].position.z;
-   where[1].w = 1;
-   where[1].color = D3DCOLOR_ARGB(v[1].color.a, v[1].color.r, v[1].color.g, v[1].color.b);
-
-   // note: index mismatch because of drawing triangle strip
-   where[2].x = v[3].position.x;
-   where[2].y = v[3].position.y;
-   where[2].z = v[3].position.z;
-   where[2].w = 1;
-   where[2].color = D3DCOLOR_ARGB(v[3].color.a, v[3].color.r, v[3].color.g, v[3].color.b);
-
-   where[3].x = v[2].position.x;
-   where[3].y = v[2].position.y;
-   where[3].z = v[2].position.z;
-   where[3].w = 1;
-   where[3].color = D3DCOLOR_ARGB(v[2].color.a, v[2].color.r, v[2].color.g, v[2].color.b);
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void add_to_vbuf(const Textured_sprite& s, D3D_textured_vertex* where)
-{
-   const Vertex<Vertex_format(position | diffuse_color | texture_coord0)>* const v = s.vertexes;
-
-   where[0].x = v[0].position.x;
-   where[0].y = v[0].position.y;
-   where[0].z = v[0].position.z;
-   where[0].w = 1;
-   where[0].color = D3DCOLOR_ARGB(v[0].color.a, v[0].color.r, v[0].color.g, v[0].color.b);
-   where[0].tu = v[0].texture_coord.tu;
-   where[0].tv = v[0].texture_coord.tv;
-
-   where[1].x = v[1].position.x;
-   where[1].y = v[1].position.y;
-   where[1].z = v[1].position.z;
-   where[1].w = 1;
-   where[1].color = D3DCOLOR_ARGB(v[1].color.a, v[1].color.r, v[1].color.g, v[1].color.b);
-   where[1].tu = v[1].texture_coord.tu;
-   where[1].tv = v[1].texture_coord.tv;
-
-   // note: index mismatch because of drawing triangle strip
-   where[2].x = v[3].position.x;
-   where[2].y = v[3].position.y;
-   where[2].z = v[3].position.z;
-   where[2].w = 1;
-   where[2].color = D3DCOLOR_ARGB(v[3].color.a, v[3].color.r, v[3].color.g, v[3].color.b);
-   where[2].tu = v[3].texture_coord.tu;
-   where[2].tv = v[3].texture_coord.tv;
-
-   where[3].x = v[2].position.x;
-   where[3].y = v[2].position.y;
-   where[3].z = v[2].position.z;
-   where[3].w = 1;
-   where[3].color = D3DCOLOR_ARGB(v[2].color.a, v[2].color.r, v[2].color.g, v[2].color.b);
-   where[3].tu = v[2].texture_coord.tu;
-   where[3].tv = v[2].texture_coord.tv;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void add_to_vbuf(const Multitextured_2_sprite& s, struct D3D_multitextured_2_vertex* where)
-{
-   const Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>* const v = s.vertexes;
-
-   where[0].x = v[0].position.x;
-   where[0].y = v[0].position.y;
-   where[0].z = v[0].position.z;
-   where[0].w = 1;
-   where[0].color = D3DCOLOR_ARGB(v[0].color.a, v[0].color.r, v[0].color.g, v[0].color.b);
-   where[0].tu0 = v[0].texture_coord0.tu;
-   where[0].tv0 = v[0].texture_coord0.tv;
-   where[0].tu1 = v[0].texture_coord1.tu;
-   where[0].tv1 = v[0].texture_coord1.tv;
-
-   where[1].x = v[1].position.x;
-   where[1].y = v[1].position.y;
-   where[1].z = v[1].position.z;
-   where[1].w = 1;
-   where[1].color = D3DCOLOR_ARGB(v[1].color.a, v[1].color.r, v[1].color.g, v[1].color.b);
-   where[1].tu0 = v[1].texture_coord0.tu;
-   where[1].tv0 = v[1].texture_coord0.tv;
-   where[1].tu1 = v[1].texture_coord1.tu;
-   where[1].tv1 = v[1].texture_coord1.tv;
-
-   // note: index mismatch because of drawing triangle strip
-   where[2].x = v[3].position.x;
-   where[2].y = v[3].position.y;
-   where[2].z = v[3].position.z;
-   where[2].w = 1;
-   where[2].color = D3DCOLOR_ARGB(v[3].color.a, v[3].color.r, v[3].color.g, v[3].color.b);
-   where[2].tu0 = v[3].texture_coord0.tu;
-   where[2].tv0 = v[3].texture_coord0.tv;
-   where[2].tu1 = v[3].texture_coord1.tu;
-   where[2].tv1 = v[3].texture_coord1.tv;
-
-   where[3].x = v[2].position.x;
-   where[3].y = v[2].position.y;
-   where[3].z = v[2].position.z;
-   where[3].w = 1;
-   where[3].color = D3DCOLOR_ARGB(v[2].color.a, v[2].color.r, v[2].color.g, v[2].color.b);
-   where[3].tu0 = v[2].texture_coord0.tu;
-   where[3].tv0 = v[2].texture_coord0.tv;
-   where[3].tu1 = v[2].texture_coord1.tu;
-   where[3].tv1 = v[2].texture_coord1.tv;
+   D3D_index_buffer_ptr ibuf = device.create_index_buffer(6*sizeof(ushort)*max_quads_per_draw);
+
+   D3D_index_buffer_ptr::Lock lock(ibuf);
+   fill_quad_indexes(static_cast<ushort*>(lock.get_raw_memory()), max_quads_per_draw);
+
+   return ibuf;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Texture_cache loader.
+D3D_texture_ptr load_texture(D3D_device_ptr device, const Texture_ID& id, uint& bytes)
+{
+   LOG_RENDERER(Logging::trivial) << "Load texture \"" << id.get_file_name() << "\"";
+
+   const std::string& file_name = id.get_file_name();
+   D3D_texture_ptr texture = is_dds_file(file_name) ? device.create_texture(load_dds(file_name))
+                                                    : device.create_texture(load_bmp(file_name));
+   bytes = texture.get_bytes();
+   return texture;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -19,6 +19,7 @@
 #include "boost/format.hpp"
 
 #include <cassert>
+#include <cstring>              // for std::memcpy
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -79,9 +80,39 @@ D3D_device_ptr D3D_system_ptr::create_device(HWND window_handle, const D3DPRESEN
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void set_render_state(IDirect3DDevice9* device, D3DRENDERSTATETYPE state, DWORD value);
+uint get_level_bytes(const D3DSURFACE_DESC& desc);
+
+/// Makes state calls to Direct3D device.
+class D3D_state_device : public State_device
+{
+public:
+
+   explicit D3D_state_device(IDirect3DDevice9* raw_device) : m_raw_device(raw_device) { }
+
+   virtual void set_texture(uint nstage, const void* texture);
+   virtual void set_texture_stage_state(uint nstage, uint type, uint value);
+   virtual void set_vertex_format(uint format);
+   virtual void set_stream_source(const void* buffer, uint offset, uint vertex_bytes);
+
+private:
+
+   /// Device is owned by D3D_device_ptr that owns this one.
+   IDirect3DDevice9* m_raw_device;
+};
+
+struct D3D_device_ptr::Shadow
+{
+   explicit Shadow(IDirect3DDevice9* raw_device) : device(raw_device), cache(device) { }
+
+   D3D_state_device device;
+   State_cache      cache;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 D3D_device_ptr::D3D_device_ptr(IDirect3DDevice9* raw_device)
    : m_raw_device(raw_device, false)
+   , m_shadow(new Shadow(raw_device))
 {
    // TODO: more advanced precondition/postcondition system
    assert(m_raw_device);
@@ -96,7 +127,8 @@ D3D_device_ptr::D3D_device_ptr(IDirect3DDevice9* raw_device)
 D3D_vertex_buffer_ptr D3D_device_ptr::create_vertex_buffer(UINT size)
 {
    IDirect3DVertexBuffer9* raw_vbuf;
-   HRESULT hr = m_raw_device->CreateVertexBuffer(size, 0, 0, D3DPOOL_DEFAULT, &raw_vbuf, 0); // TODO: comment me!!!
+   HRESULT hr = m_raw_device->CreateVertexBuffer(size, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT,
+                                                 &raw_vbuf, 0);
    if (hr != D3D_OK)
    {
       LOG_RENDERER(Logging::critical) << "!!! Can't create vertex buffer; throw !!!";
@@ -113,72 +145,167 @@ D3D_vertex_buffer_ptr D3D_device_ptr::create_vertex_buffer(UINT size)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-D3D_texture_ptr D3D_device_ptr::create_texture(const std::string& file_name)
+D3D_vertex_buffer_ptr D3D_device_ptr::create_static_vertex_buffer(uint size)
 {
-   IDirect3DTexture9* raw_texture;
-   HRESULT hr = D3DXCreateTextureFromFileEx(m_raw_device.get(), file_name.c_str(),
-                                            D3DX_DEFAULT, D3DX_DEFAULT, D3DX_DEFAULT, 0, D3DFMT_UNKNOWN, D3DPOOL_DEFAULT,
-                                            D3DX_DEFAULT, D3DX_DEFAULT, 0, NULL, NULL, &raw_texture);
+   IDirect3DVertexBuffer9* raw_vbuf;
+   HRESULT hr = m_raw_device->CreateVertexBuffer(size, D3DUSAGE_WRITEONLY, 0, D3DPOOL_MANAGED, &raw_vbuf, 0);
    if (hr != D3D_OK)
    {
-      LOG_RENDERER(Logging::critical) << "!!! Can't create vertex buffer texture from file \""
-                                      << file_name << "\"; throw !!!";
-      throw D3D_exception("D3DXCreateTextureFromFile() failed", hr);
+      LOG_RENDERER(Logging::critical) << "!!! Can't create vertex buffer; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::CreateVertexBuffer() failed", hr);
+   }
+   if (!raw_vbuf)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't create vertex buffer; throw !!!";
+      throw D3D_exception("Can't create vertex buffer: null pointer returned", E_FAIL);
    }
 
-   return raw_texture;
+   return raw_vbuf;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void D3D_device_ptr::set_vertex_buffer(D3D_vertex_buffer_ptr buf, uint offset, uint vertex_bytes)
+D3D_index_buffer_ptr D3D_device_ptr::create_index_buffer(uint size)
 {
-   HRESULT hr = m_raw_device->SetStreamSource(0, buf.m_raw_buffer.get(), offset, vertex_bytes);
+   IDirect3DIndexBuffer9* raw_ibuf;
+   HRESULT hr = m_raw_device->CreateIndexBuffer(size, D3DUSAGE_WRITEONLY, D3DFMT_INDEX16, D3DPOOL_MANAGED,
+                                                &raw_ibuf, 0);
    if (hr != D3D_OK)
    {
-      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetStreamSource() failed; throw !!!";
-      throw D3D_exception("IDirect3DDevice9::SetStreamSource() failed", hr);
+      LOG_RENDERER(Logging::critical) << "!!! Can't create index buffer; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::CreateIndexBuffer() failed", hr);
+   }
+   if (!raw_ibuf)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't create index buffer; throw !!!";
+      throw D3D_exception("Can't create index buffer: null pointer returned", E_FAIL);
+   }
+
+   return raw_ibuf;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+D3D_texture_ptr D3D_device_ptr::create_texture(const Image& image)
+{
+   return create_texture(image.width, image.height, D3DFMT_A8R8G8B8,
+                         reinterpret_cast<const uchar*>(&image.pixels[0]), 4*image.width, image.height);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+D3D_texture_ptr D3D_device_ptr::create_texture(const Compressed_image& image)
+{
+   if (image.width % 4 != 0 || image.height % 4 != 0)
+   {
+      LOG_RENDERER(Logging::major) << "Compressed texture " << image.width << "x" << image.height
+                                   << " isn't multiple of 4; decompress it";
+      return create_texture(decompress_image(image));
    }
+
+   return create_texture(image.width, image.height, image.format == block_format_bc1 ? D3DFMT_DXT1 : D3DFMT_DXT5,
+                         &image.blocks[0], image.get_blocks_wide()*get_block_bytes(image.format),
+                         image.get_blocks_high());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void D3D_device_ptr::set_vertex_format(DWORD fvf)
+D3D_texture_ptr D3D_device_ptr::create_texture(const Packed_texture& texture)
 {
-   HRESULT hr = m_raw_device->SetFVF(fvf);
-   if (hr != D3D_OK)
+   if (texture.format == packed_format_a8r8g8b8)
    {
-      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetFVF() failed; throw !!!";
-      throw D3D_exception("IDirect3DDevice9::SetFVF() failed", hr);
+      return create_texture(texture.width, texture.height, D3DFMT_A8R8G8B8, texture.data, 4*texture.width,
+                            texture.height);
    }
+
+   if (texture.width % 4 != 0 || texture.height % 4 != 0)
+   {
+      LOG_RENDERER(Logging::major) << "Compressed texture " << texture.width << "x" << texture.height
+                                   << " isn't multiple of 4; decompress it";
+      return create_texture(unpack_image(texture));
+   }
+
+   const bool is_bc1 = texture.format == packed_format_bc1;
+   return create_texture(texture.width, texture.height, is_bc1 ? D3DFMT_DXT1 : D3DFMT_DXT5, texture.data,
+                         texture.width / 4*get_block_bytes(is_bc1 ? block_format_bc1 : block_format_bc3),
+                         texture.height / 4);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void D3D_device_ptr::set_texture(uint nstage, D3D_texture_ptr texture)
+D3D_texture_ptr D3D_device_ptr::create_texture(uint width, uint height, D3DFORMAT format, const uchar* rows,
+                                               uint row_bytes, uint rows_number)
 {
-   HRESULT hr = m_raw_device->SetTexture(nstage, texture.m_raw_texture.get());
+   IDirect3DTexture9* raw_texture;
+   HRESULT hr = m_raw_device->CreateTexture(width, height, 1, 0, format, D3DPOOL_MANAGED, &raw_texture, 0);
    if (hr != D3D_OK)
    {
-      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetTexture() failed; throw !!!";
-      throw D3D_exception("IDirect3DDevice9::SetTexture() failed", hr);
+      LOG_RENDERER(Logging::critical) << "!!! Can't create texture " << width << "x" << height << " of format "
+                                      << format << "; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::CreateTexture() failed", hr);
+   }
+   D3D_texture_ptr texture(raw_texture);
+
+   D3DLOCKED_RECT rect;
+   hr = raw_texture->LockRect(0, &rect, 0, 0);
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! IDirect3DTexture9::LockRect() failed; throw !!!";
+      throw D3D_exception("IDirect3DTexture9::LockRect() failed", hr);
    }
+
+   // rows of texture could be padded; pitch of compressed texture is distance between rows of blocks
+   for (uint y = 0; y < rows_number; ++y)
+   {
+      std::memcpy(static_cast<uchar*>(rect.pBits) + y*rect.Pitch, rows + y*row_bytes, row_bytes);
+   }
+   raw_texture->UnlockRect(0);
+
+   return texture;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void D3D_device_ptr::set_texture_stage_state(uint nstage, D3DTEXTURESTAGESTATETYPE type, uint value)
+void D3D_device_ptr::set_vertex_buffer(D3D_vertex_buffer_ptr buf, uint offset, uint vertex_bytes)
 {
-   HRESULT hr = m_raw_device->SetTextureStageState(nstage, type, value);
+   m_shadow->cache.set_stream_source(buf.m_raw_buffer.get(), offset, vertex_bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_device_ptr::set_index_buffer(D3D_index_buffer_ptr buf)
+{
+   HRESULT hr = m_raw_device->SetIndices(buf.m_raw_buffer.get());
    if (hr != D3D_OK)
    {
-      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetTextureStageState() failed; throw !!!";
-      throw D3D_exception("IDirect3DDevice9::SetTextureStageState() failed", hr);
+      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetIndices() failed; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::SetIndices() failed", hr);
    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void D3D_device_ptr::set_vertex_format(DWORD fvf)
+{
+   m_shadow->cache.set_vertex_format(fvf);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_device_ptr::set_texture(uint nstage, D3D_texture_ptr texture)
+{
+   m_shadow->cache.set_texture(nstage, texture.m_raw_texture.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_device_ptr::set_texture_stage_state(uint nstage, D3DTEXTURESTAGESTATETYPE type, uint value)
+{
+   m_shadow->cache.set_texture_stage_state(nstage, type, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void D3D_device_ptr::clear()
 {
    HRESULT hr = m_raw_device->Clear(0, 0, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, D3DCOLOR_XRGB(0, 0, 255), 1.0f, 0);
@@ -203,6 +330,19 @@ void D3D_device_ptr::draw_primitive(D3DPRIMITIVETYPE type, uint offset, uint nve
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void D3D_device_ptr::draw_indexed_primitive(D3DPRIMITIVETYPE type, uint base_vertex, uint nvertexes, uint start_index,
+                                            uint nprimitives)
+{
+   HRESULT hr = m_raw_device->DrawIndexedPrimitive(type, base_vertex, 0, nvertexes, start_index, nprimitives);
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::DrawIndexedPrimitive() failed; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::DrawIndexedPrimitive() failed", hr);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool D3D_device_ptr::present()
 {
    HRESULT hr = m_raw_device->Present(0, 0, 0, 0);
@@ -253,6 +393,8 @@ void D3D_device_ptr::reset(D3DPRESENT_PARAMETERS& present_params)
    {
       LOG_RENDERER(Logging::minor) << "Reset failed";
    }
+   // reset returns state to defaults
+   m_shadow->cache.invalidate();
 
    set_render_state(m_raw_device.get(), D3DRS_CULLMODE, D3DCULL_NONE);
    set_render_state(m_raw_device.get(), D3DRS_LIGHTING, FALSE);
@@ -261,6 +403,20 @@ void D3D_device_ptr::reset(D3DPRESENT_PARAMETERS& present_params)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+const State_cache_statistics& D3D_device_ptr::get_state_statistics() const
+{
+   return m_shadow->cache.get_statistics();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_device_ptr::reset_state_statistics()
+{
+   m_shadow->cache.reset_statistics();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 D3D_device_ptr::Scene_guard::Scene_guard(D3D_device_ptr device)
    : m_raw_device(device.m_raw_device.get())
 {
@@ -301,6 +457,32 @@ void D3D_device_ptr::Scene_guard::reset()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void* D3D_vertex_buffer_ptr::lock(uint offset, uint bytes, DWORD flags)
+{
+   void* raw = 0;
+   HRESULT hr = m_raw_buffer->Lock(offset, bytes, &raw, flags);
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't lock vertex buffer; throw !!!";
+      throw D3D_exception("IDirect3DVertexBuffer9::Lock() failed", hr);
+   }
+
+   return raw;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_vertex_buffer_ptr::unlock()
+{
+   HRESULT hr = m_raw_buffer->Unlock();
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't unlock vertex buffer; CANNOT THROW IN CLEANUP FUNCTION - ignore !!!";
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 D3D_vertex_buffer_ptr::Lock::Lock(D3D_vertex_buffer_ptr buf)
    : m_vbuf(buf.m_raw_buffer.get())
    , m_raw(0)
@@ -348,6 +530,151 @@ void* D3D_vertex_buffer_ptr::Lock::get_raw_memory()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+D3D_index_buffer_ptr::Lock::Lock(D3D_index_buffer_ptr buf)
+   : m_ibuf(buf.m_raw_buffer.get())
+   , m_raw(0)
+{
+   if (m_ibuf)
+   {
+      HRESULT hr = m_ibuf->Lock(0, 0, &m_raw, 0);
+      if (hr != D3D_OK)
+      {
+         LOG_RENDERER(Logging::critical) << "!!! Can't lock index buffer; throw !!!";
+         throw D3D_exception("IDirect3DIndexBuffer9::Lock() failed", hr);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+D3D_index_buffer_ptr::Lock::~Lock()
+{
+   reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_index_buffer_ptr::Lock::reset()
+{
+   if (m_ibuf)
+   {
+      HRESULT hr = m_ibuf->Unlock();
+      m_ibuf = 0;
+
+      if (hr != D3D_OK)
+      {
+         LOG_RENDERER(Logging::critical) << "!!! Can't unlock index buffer; CANNOT THROW IN CLEANUP FUNCTION - ignore !!!";
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* D3D_index_buffer_ptr::Lock::get_raw_memory()
+{
+   return m_raw;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint D3D_texture_ptr::get_bytes() const
+{
+   if (!m_raw_texture)
+   {
+      return 0;
+   }
+
+   uint bytes = 0;
+   for (DWORD level = 0; level < m_raw_texture->GetLevelCount(); ++level)
+   {
+      D3DSURFACE_DESC desc;
+      if (m_raw_texture->GetLevelDesc(level, &desc) != D3D_OK)
+      {
+         // it's just estimation, so don't throw
+         LOG_RENDERER(Logging::minor) << "IDirect3DTexture9::GetLevelDesc() failed; texture size is underestimated";
+         break;
+      }
+      bytes += get_level_bytes(desc);
+   }
+   return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_state_device::set_texture(uint nstage, const void* texture)
+{
+   HRESULT hr = m_raw_device->SetTexture(nstage, static_cast<IDirect3DTexture9*>(const_cast<void*>(texture)));
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetTexture() failed; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::SetTexture() failed", hr);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_state_device::set_texture_stage_state(uint nstage, uint type, uint value)
+{
+   HRESULT hr = m_raw_device->SetTextureStageState(nstage, D3DTEXTURESTAGESTATETYPE(type), value);
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetTextureStageState() failed; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::SetTextureStageState() failed", hr);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_state_device::set_vertex_format(uint format)
+{
+   HRESULT hr = m_raw_device->SetFVF(format);
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetFVF() failed; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::SetFVF() failed", hr);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void D3D_state_device::set_stream_source(const void* buffer, uint offset, uint vertex_bytes)
+{
+   IDirect3DVertexBuffer9* const raw_buffer = static_cast<IDirect3DVertexBuffer9*>(const_cast<void*>(buffer));
+   HRESULT hr = m_raw_device->SetStreamSource(0, raw_buffer, offset, vertex_bytes);
+   if (hr != D3D_OK)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! IDirect3DDevice9::SetStreamSource() failed; throw !!!";
+      throw D3D_exception("IDirect3DDevice9::SetStreamSource() failed", hr);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Size of texture level in bytes for formats textures are loaded in; 4 bytes per texel for others.
+uint get_level_bytes(const D3DSURFACE_DESC& desc)
+{
+   // compressed formats keep 4x4 blocks
+   const uint blocks = ((desc.Width + 3) / 4)*((desc.Height + 3) / 4);
+   switch (desc.Format)
+   {
+   case D3DFMT_DXT1:
+      return 8*blocks;
+   case D3DFMT_DXT3:
+   case D3DFMT_DXT5:
+      return 16*blocks;
+   case D3DFMT_R5G6B5:
+   case D3DFMT_A1R5G5B5:
+   case D3DFMT_A4R4G4B4:
+      return 2*desc.Width*desc.Height;
+   case D3DFMT_R8G8B8:
+      return 3*desc.Width*desc.Height;
+   default:
+      return 4*desc.Width*desc.Height;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void set_render_state(IDirect3DDevice9* device, D3DRENDERSTATETYPE state, DWORD value)
 {
    HRESULT hr = device->SetRenderState(state, value);
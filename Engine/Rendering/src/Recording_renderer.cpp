@@ -0,0 +1,435 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Recording_renderer implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Recording_renderer.h"
+#include "Engine/Rendering/Scene_format.h"
+
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+void append(std::vector<char>& record, const T& value);
+void append_vertex(std::vector<char>& record, const Vertex<Vertex_format(position | diffuse_color)>& v);
+void append_vertex(std::vector<char>& record, const Vertex<Vertex_format(position | diffuse_color | texture_coord0)>& v);
+void append_vertex(std::vector<char>& record,
+                   const Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>& v);
+void append_stage(std::vector<char>& record, const std::vector<uint>& textures, const Texture_ID& texture,
+                  Blending_mode blending);
+void append_sprite(std::vector<char>& record, const std::vector<uint>& textures, const Colored_sprite& s);
+void append_sprite(std::vector<char>& record, const std::vector<uint>& textures, const Textured_sprite& s);
+void append_sprite(std::vector<char>& record, const std::vector<uint>& textures, const Multitextured_2_sprite& s);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Recording_renderer::Recording_renderer(Renderer& target, std::ostream& out)
+   : m_target(target)
+   , m_out(out)
+   , m_stream_textures_number(0)
+{
+   m_out.write(scene_signature, sizeof(scene_signature));
+   append(m_record, scene_version);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::add_to_scene(const Colored_sprite& s)
+{
+   m_target.add_to_scene(s);
+
+   define_textures(s);
+   append_sprite(m_record, m_stream_textures, s);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::add_to_scene(const Textured_sprite& s)
+{
+   m_target.add_to_scene(s);
+
+   define_textures(s);
+   append_sprite(m_record, m_stream_textures, s);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::add_to_scene(const Multitextured_2_sprite& s)
+{
+   m_target.add_to_scene(s);
+
+   define_textures(s);
+   append_sprite(m_record, m_stream_textures, s);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// sprites are recorded as if they were added one by one, so that stream format stays the same
+void Recording_renderer::add_to_scene(const Scene_buffer& buffer)
+{
+   m_target.add_to_scene(buffer);
+
+   write_sprites(buffer.get_colored_sprites());
+   write_sprites(buffer.get_textured_sprites());
+   write_sprites(buffer.get_multitextured_sprites());
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// instances are recorded as sprites they are expanded into
+void Recording_renderer::add_to_scene(const Sprite_instances& instances)
+{
+   m_target.add_to_scene(instances);
+
+   m_expanded.resize(instances.number);
+   if (instances.number > 0)
+   {
+      expand_instances(instances, &m_expanded[0]);
+   }
+   write_sprites(m_expanded);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::render_scene()
+{
+   m_target.render_scene();
+
+   m_record.push_back(scene_record_render);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::clear_scene()
+{
+   m_target.clear_scene();
+
+   m_record.push_back(scene_record_clear);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Colored_sprite_handle Recording_renderer::create_sprite(const Colored_sprite& s)
+{
+   const Colored_sprite_handle handle = m_target.create_sprite(s);
+   write_retained(scene_record_create, handle, s);
+   return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Textured_sprite_handle Recording_renderer::create_sprite(const Textured_sprite& s)
+{
+   const Textured_sprite_handle handle = m_target.create_sprite(s);
+   write_retained(scene_record_create, handle, s);
+   return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Multitextured_2_sprite_handle Recording_renderer::create_sprite(const Multitextured_2_sprite& s)
+{
+   const Multitextured_2_sprite_handle handle = m_target.create_sprite(s);
+   write_retained(scene_record_create, handle, s);
+   return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::update_sprite(Colored_sprite_handle handle, const Colored_sprite& s)
+{
+   m_target.update_sprite(handle, s);
+   write_retained(scene_record_update, handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::update_sprite(Textured_sprite_handle handle, const Textured_sprite& s)
+{
+   m_target.update_sprite(handle, s);
+   write_retained(scene_record_update, handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::update_sprite(Multitextured_2_sprite_handle handle, const Multitextured_2_sprite& s)
+{
+   m_target.update_sprite(handle, s);
+   write_retained(scene_record_update, handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::destroy_sprite(Colored_sprite_handle handle)
+{
+   m_target.destroy_sprite(handle);
+
+   m_record.push_back(scene_record_destroy);
+   append(m_record, handle.id);
+   m_record.push_back(scene_record_colored);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::destroy_sprite(Textured_sprite_handle handle)
+{
+   m_target.destroy_sprite(handle);
+
+   m_record.push_back(scene_record_destroy);
+   append(m_record, handle.id);
+   m_record.push_back(scene_record_textured);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::destroy_sprite(Multitextured_2_sprite_handle handle)
+{
+   m_target.destroy_sprite(handle);
+
+   m_record.push_back(scene_record_destroy);
+   append(m_record, handle.id);
+   m_record.push_back(scene_record_multitextured);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Recording_renderer::is_focused() const
+{
+   return m_target.is_focused();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::try_restore()
+{
+   m_target.try_restore();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Render_stats& Recording_renderer::get_render_stats() const
+{
+   return m_target.get_render_stats();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::define_texture(const Texture_ID& id)
+{
+   const uint handle = id.get_handle();
+   if (handle == 0 || (handle < m_stream_textures.size() && m_stream_textures[handle] != 0))
+   {
+      return;
+   }
+
+   if (handle >= m_stream_textures.size())
+   {
+      m_stream_textures.resize(Texture_registry::get_size());
+   }
+   // stream handles are given densely from 1 in order of definition
+   m_stream_textures[handle] = ++m_stream_textures_number;
+
+   const std::string& name = id.get_file_name();
+   m_record.push_back(scene_record_texture);
+   append(m_record, m_stream_textures[handle]);
+   append(m_record, static_cast<ushort>(name.size()));
+   m_record.insert(m_record.end(), name.begin(), name.end());
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::define_textures(const Colored_sprite&)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::define_textures(const Textured_sprite& s)
+{
+   define_texture(s.texture);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::define_textures(const Multitextured_2_sprite& s)
+{
+   define_texture(s.texture0);
+   define_texture(s.texture1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Recording_renderer::write_retained(uchar type, Sprite_handle<format> handle, const Sprite<format>& s)
+{
+   // textures are defined by their own records, so they go first
+   define_textures(s);
+
+   m_record.push_back(type);
+   append(m_record, handle.id);
+   append_sprite(m_record, m_stream_textures, s);
+   flush_record();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Sprite_type>
+void Recording_renderer::write_sprites(const std::vector<Sprite_type>& sprites)
+{
+   for (size_t i = 0; i < sprites.size(); ++i)
+   {
+      define_textures(sprites[i]);
+      append_sprite(m_record, m_stream_textures, sprites[i]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Recording_renderer::flush_record()
+{
+   // empty scene buffer gives empty record
+   if (m_record.empty())
+   {
+      return;
+   }
+
+   m_out.write(&m_record[0], m_record.size());
+   m_record.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Appends raw bytes of value.
+template <class T>
+void append(std::vector<char>& record, const T& value)
+{
+   const char* bytes = reinterpret_cast<const char*>(&value);
+   record.insert(record.end(), bytes, bytes + sizeof(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_vertex(std::vector<char>& record, const Vertex<Vertex_format(position | diffuse_color)>& v)
+{
+   append(record, v.position.x);
+   append(record, v.position.y);
+   append(record, v.position.z);
+   append(record, v.color.a);
+   append(record, v.color.r);
+   append(record, v.color.g);
+   append(record, v.color.b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_vertex(std::vector<char>& record, const Vertex<Vertex_format(position | diffuse_color | texture_coord0)>& v)
+{
+   append(record, v.position.x);
+   append(record, v.position.y);
+   append(record, v.position.z);
+   append(record, v.color.a);
+   append(record, v.color.r);
+   append(record, v.color.g);
+   append(record, v.color.b);
+   append(record, v.texture_coord.tu);
+   append(record, v.texture_coord.tv);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_vertex(std::vector<char>& record,
+                   const Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>& v)
+{
+   append(record, v.position.x);
+   append(record, v.position.y);
+   append(record, v.position.z);
+   append(record, v.color.a);
+   append(record, v.color.r);
+   append(record, v.color.g);
+   append(record, v.color.b);
+   append(record, v.texture_coord0.tu);
+   append(record, v.texture_coord0.tv);
+   append(record, v.texture_coord1.tu);
+   append(record, v.texture_coord1.tv);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_stage(std::vector<char>& record, const std::vector<uint>& textures, const Texture_ID& texture,
+                  Blending_mode blending)
+{
+   // texture is defined before sprite, so it has stream handle unless it is none
+   const uint handle = texture.get_handle();
+   append(record, handle == 0 ? 0u : textures[handle]);
+   record.push_back(static_cast<char>(blending));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_sprite(std::vector<char>& record, const std::vector<uint>&, const Colored_sprite& s)
+{
+   record.push_back(scene_record_colored);
+   for (uint i = 0; i < 4; ++i)
+   {
+      append_vertex(record, s.vertexes[i]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_sprite(std::vector<char>& record, const std::vector<uint>& textures, const Textured_sprite& s)
+{
+   record.push_back(scene_record_textured);
+   for (uint i = 0; i < 4; ++i)
+   {
+      append_vertex(record, s.vertexes[i]);
+   }
+   append_stage(record, textures, s.texture, s.blending);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_sprite(std::vector<char>& record, const std::vector<uint>& textures, const Multitextured_2_sprite& s)
+{
+   record.push_back(scene_record_multitextured);
+   for (uint i = 0; i < 4; ++i)
+   {
+      append_vertex(record, s.vertexes[i]);
+   }
+   append_stage(record, textures, s.texture0, s.blending0);
+   append_stage(record, textures, s.texture1, s.blending1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
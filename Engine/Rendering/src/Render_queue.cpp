@@ -0,0 +1,296 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Render_queue implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Render_queue.h"
+
+#include <algorithm>            // for std::fill
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fields of sort key (see Sort_key).
+const uint     key_unused_bits     = 8;
+const uint     key_state_bits      = 31;
+const uint     key_depth_bits      = 24;
+const uint     key_max_depth       = (1u << key_depth_bits) - 1;
+const uint     key_texture0_bits   = 12;
+const uint     key_texture1_bits   = 11;
+const uint     key_blending_bits   = 3;
+const Sort_key key_translucent     = Sort_key(1) << 63;
+const uint     key_radix_passes    = 8;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+Sort_key make_key(const Sprite<format>& s, uint format_index, uint texture0, Blending_mode blending0,
+                  uint texture1, Blending_mode blending1);
+template <class Sprite_type>
+void add_entries(const std::vector<Sprite_type>& sprites, Vertex_format format, std::vector<Queue_entry>& entries);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Sort_key make_sort_key(const Colored_sprite& s)
+{
+   // the same state make_batch() gives
+   return make_key(s, 0, 0, blending_mode_select_arg1, 0, blending_mode_disable);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Sort_key make_sort_key(const Textured_sprite& s)
+{
+   return make_key(s, 1, s.texture.get_handle(), s.blending, 0, blending_mode_disable);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Sort_key make_sort_key(const Multitextured_2_sprite& s)
+{
+   return make_key(s, 2, s.texture0.get_handle(), s.blending0, s.texture1.get_handle(), s.blending1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void radix_sort(std::vector<Queue_entry>& entries, std::vector<Queue_entry>& buffer)
+{
+   const size_t n = entries.size();
+   if (n < 2)
+   {
+      return;
+   }
+   buffer.resize(n);
+
+   // histograms of all passes are counted at once
+   uint counts[key_radix_passes][256];
+   std::fill(&counts[0][0], &counts[0][0] + key_radix_passes*256, 0u);
+   for (size_t i = 0; i < n; ++i)
+   {
+      const Sort_key key = entries[i].key;
+      for (uint pass = 0; pass < key_radix_passes; ++pass)
+      {
+         ++counts[pass][uint(key >> 8*pass) & 0xFF];
+      }
+   }
+
+   Queue_entry* source = &entries[0];
+   Queue_entry* target = &buffer[0];
+   for (uint pass = 0; pass < key_radix_passes; ++pass)
+   {
+      uint* count = counts[pass];
+      const uint shift = 8*pass;
+
+      // byte is the same in all keys: pass wouldn't change order
+      if (count[uint(source[0].key >> shift) & 0xFF] == n)
+      {
+         continue;
+      }
+
+      // counts become offsets of buckets
+      uint offset = 0;
+      for (uint digit = 0; digit < 256; ++digit)
+      {
+         const uint size = count[digit];
+         count[digit] = offset;
+         offset += size;
+      }
+
+      for (size_t i = 0; i < n; ++i)
+      {
+         target[count[uint(source[i].key >> shift) & 0xFF]++] = source[i];
+      }
+      std::swap(source, target);
+   }
+
+   if (source != &entries[0])
+   {
+      entries.swap(buffer);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint Render_queue::sort(std::vector<Colored_sprite>& colored, std::vector<Textured_sprite>& textured,
+                        std::vector<Multitextured_2_sprite>& multitextured, Batch_list& batches)
+{
+   m_entries.clear();
+   add_entries(colored, Vertex_format(position | diffuse_color), m_entries);
+   add_entries(textured, Vertex_format(position | diffuse_color | texture_coord0), m_entries);
+   add_entries(multitextured, Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1), m_entries);
+
+   radix_sort(m_entries, m_buffer);
+
+   // sprites of each format are put in order of entries, so that runs of entries become ranges of sprites
+   m_colored.clear();
+   m_textured.clear();
+   m_multitextured.clear();
+   for (size_t i = 0; i < m_entries.size(); ++i)
+   {
+      const Queue_entry& entry = m_entries[i];
+      switch (uint(entry.format))
+      {
+      case position | diffuse_color:
+         m_colored.push_back(colored[entry.index]);
+         break;
+      case position | diffuse_color | texture_coord0:
+         m_textured.push_back(textured[entry.index]);
+         break;
+      case position | diffuse_color | texture_coord0 | texture_coord1:
+         m_multitextured.push_back(multitextured[entry.index]);
+         break;
+      default:
+         assert(false && "Unsupported vertex format");
+      }
+   }
+   colored.swap(m_colored);
+   textured.swap(m_textured);
+   multitextured.swap(m_multitextured);
+
+   // batches don't span opaque and translucent sprites, so that renderer could draw something between them
+   const size_t batches_number = batches.size();
+   uint opaque_batches = 0;
+   uint colored_first       = 0;
+   uint textured_first      = 0;
+   uint multitextured_first = 0;
+   for (size_t i = 0; i < m_entries.size(); )
+   {
+      const Vertex_format format = m_entries[i].format;
+      const bool translucent = is_translucent(m_entries[i].key);
+      size_t end = i + 1;
+      while (end < m_entries.size() && m_entries[end].format == format
+             && is_translucent(m_entries[end].key) == translucent)
+      {
+         ++end;
+      }
+
+      const uint count = static_cast<uint>(end - i);
+      switch (uint(format))
+      {
+      case position | diffuse_color:
+         compile_batches(colored, colored_first, count, batches);
+         colored_first += count;
+         break;
+      case position | diffuse_color | texture_coord0:
+         compile_batches(textured, textured_first, count, batches);
+         textured_first += count;
+         break;
+      case position | diffuse_color | texture_coord0 | texture_coord1:
+         compile_batches(multitextured, multitextured_first, count, batches);
+         multitextured_first += count;
+         break;
+      default:
+         assert(false && "Unsupported vertex format");
+      }
+      if (!translucent)
+      {
+         opaque_batches = static_cast<uint>(batches.size() - batches_number);
+      }
+
+      i = end;
+   }
+
+   return opaque_batches;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Render_queue::compile_sorted(std::vector<Queue_entry>& entries, const std::vector<Colored_sprite>& colored,
+                                  const std::vector<Textured_sprite>& textured,
+                                  const std::vector<Multitextured_2_sprite>& multitextured, Batch_list& batches)
+{
+   radix_sort(entries, m_buffer);
+
+   // each run of entries of the same format gives batches of its slots
+   for (size_t i = 0; i < entries.size(); )
+   {
+      const Vertex_format format = entries[i].format;
+      m_slots.clear();
+      for (; i < entries.size() && entries[i].format == format; ++i)
+      {
+         m_slots.push_back(entries[i].index);
+      }
+
+      switch (uint(format))
+      {
+      case position | diffuse_color:
+         compile_batches(colored, m_slots, batches);
+         break;
+      case position | diffuse_color | texture_coord0:
+         compile_batches(textured, m_slots, batches);
+         break;
+      case position | diffuse_color | texture_coord0 | texture_coord1:
+         compile_batches(multitextured, m_slots, batches);
+         break;
+      default:
+         assert(false && "Unsupported vertex format");
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Packs key fields; see Sort_key for layout.
+template <Vertex_format format>
+Sort_key make_key(const Sprite<format>& s, uint format_index, uint texture0, Blending_mode blending0,
+                  uint texture1, Blending_mode blending1)
+{
+   const Sort_key state =
+      Sort_key(format_index) << (key_texture0_bits + key_texture1_bits + 2*key_blending_bits)
+      | Sort_key(texture0 & ((1u << key_texture0_bits) - 1)) << (key_texture1_bits + 2*key_blending_bits)
+      | Sort_key(blending0) << (key_texture1_bits + key_blending_bits)
+      | Sort_key(texture1 & ((1u << key_texture1_bits) - 1)) << key_blending_bits
+      | Sort_key(blending1);
+
+   bool is_translucent = false;
+   float z = 0;
+   for (uint i = 0; i < 4; ++i)
+   {
+      z += s.vertexes[i].position.z;
+      is_translucent = is_translucent || s.vertexes[i].color.a != 0xFF;
+   }
+   z /= 4;
+
+   // negated, so that NaN goes to the front
+   const Sort_key depth = !(z > 0) ? 0 : z >= 1 ? key_max_depth : Sort_key(z*key_max_depth);
+
+   if (is_translucent)
+   {
+      return key_translucent | (key_max_depth - depth) << (key_state_bits + key_unused_bits)
+             | state << key_unused_bits;
+   }
+   return state << (key_depth_bits + key_unused_bits) | depth << key_unused_bits;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Sprite_type>
+void add_entries(const std::vector<Sprite_type>& sprites, Vertex_format format, std::vector<Queue_entry>& entries)
+{
+   for (size_t i = 0; i < sprites.size(); ++i)
+   {
+      const Queue_entry entry = { make_sort_key(sprites[i]), format, static_cast<uint>(i) };
+      entries.push_back(entry);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
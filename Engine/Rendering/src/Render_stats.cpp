@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Render_stats implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Render_stats.h"
+
+#include "Engine/Rendering/Logging.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void clear_render_stats(Render_stats& stats)
+{
+   stats.draw_calls        = 0;
+   stats.state_changes     = 0;
+   stats.texture_loads     = 0;
+   stats.vertex_bytes      = 0;
+   stats.sprites_submitted = 0;
+   stats.sprites_culled    = 0;
+   stats.sprites_drawn     = 0;
+   stats.convert_seconds   = 0;
+   stats.upload_seconds    = 0;
+   stats.draw_seconds      = 0;
+   stats.present_seconds   = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Render_stats_log::Render_stats_log()
+   : m_period(0)
+   , m_frames(0)
+   , m_vertex_bytes(0)
+{
+   clear_render_stats(m_sum);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Render_stats_log::set_period(uint frames)
+{
+   m_period = frames;
+   m_frames = 0;
+   clear_render_stats(m_sum);
+   m_vertex_bytes = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Render_stats_log::add_frame(const Render_stats& stats)
+{
+   if (m_period == 0)
+   {
+      return;
+   }
+
+   m_sum.draw_calls        += stats.draw_calls;
+   m_sum.state_changes     += stats.state_changes;
+   m_sum.texture_loads     += stats.texture_loads;
+   m_vertex_bytes          += stats.vertex_bytes;
+   m_sum.sprites_submitted += stats.sprites_submitted;
+   m_sum.sprites_culled    += stats.sprites_culled;
+   m_sum.sprites_drawn     += stats.sprites_drawn;
+   m_sum.convert_seconds   += stats.convert_seconds;
+   m_sum.upload_seconds    += stats.upload_seconds;
+   m_sum.draw_seconds      += stats.draw_seconds;
+   m_sum.present_seconds   += stats.present_seconds;
+   if (++m_frames < m_period)
+   {
+      return;
+   }
+
+   // texture loads are rare, so they are summed rather than averaged; times are in milliseconds
+   const double n = m_frames;
+   LOG_RENDERER(Logging::major) << "Frame stats over " << m_frames << " frames: "
+                                << m_sum.draw_calls / n << " draws, "
+                                << m_sum.state_changes / n << " state changes, "
+                                << m_sum.texture_loads << " texture loads in total, "
+                                << m_vertex_bytes / n << " vertex bytes, "
+                                << m_sum.sprites_submitted / n << " sprites submitted, "
+                                << m_sum.sprites_culled / n << " culled, "
+                                << m_sum.sprites_drawn / n << " drawn; ms: "
+                                << m_sum.convert_seconds * 1000 / n << " convert, "
+                                << m_sum.upload_seconds * 1000 / n << " upload, "
+                                << m_sum.draw_seconds * 1000 / n << " draw, "
+                                << m_sum.present_seconds * 1000 / n << " present";
+   m_frames = 0;
+   clear_render_stats(m_sum);
+   m_vertex_bytes = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Scene buffers implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Scene_buffer.h"
+
+#include "Engine/Rendering/Renderer.h"
+
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_buffer::clear()
+{
+   m_colored.clear();
+   m_textured.clear();
+   m_multitextured.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Scene_buffer::is_empty() const
+{
+   return m_colored.empty() && m_textured.empty() && m_multitextured.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Parallel_scene::Parallel_scene(uint threads_number)
+   : m_threads_number(threads_number),
+     m_slots(new Slot[threads_number])
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Scene_buffer& Parallel_scene::get_buffer(uint thread)
+{
+   assert(thread < m_threads_number && "Invalid thread index");
+   return m_slots[thread].buffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Parallel_scene::submit(Renderer& renderer)
+{
+   for (uint i = 0; i < m_threads_number; ++i)
+   {
+      Scene_buffer& buffer = m_slots[i].buffer;
+      if (!buffer.is_empty())
+      {
+         renderer.add_to_scene(buffer);
+         buffer.clear();
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Scene_player implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Scene_player.h"
+
+#include "Engine/Rendering/Logging.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>              // for std::memcpy
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Recorded retained sprite that isn't created or is destroyed already.
+const uint no_played_sprite = ~0u;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Scene_player::Scene_player(const char* data, std::size_t size)
+   : m_end(data + size)
+   , m_records(data)
+   , m_cur(data)
+   , m_textures(1)
+{
+   uint version = 0;
+   if (size < sizeof(scene_signature) || !std::equal(scene_signature, scene_signature + sizeof(scene_signature), data))
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Scene stream signature mismatch; throw !!!";
+      throw Scene_format_exception("Not a scene stream");
+   }
+   m_cur += sizeof(scene_signature);
+
+   read(version);
+   if (version < scene_oldest_version || version > scene_version)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Scene stream version " << version << " isn't supported; throw !!!";
+      throw Scene_format_exception("Unsupported scene stream version");
+   }
+
+   m_records = m_cur;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Scene_player::play_frame(Renderer& renderer)
+{
+   while (m_cur != m_end)
+   {
+      const uchar type = *m_cur++;
+      switch (type)
+      {
+      case scene_record_texture:
+         read_texture();
+         break;
+      case scene_record_colored:
+         {
+            Colored_sprite s;
+            read_sprite(s);
+            renderer.add_to_scene(s);
+         }
+         break;
+      case scene_record_textured:
+         {
+            Textured_sprite s;
+            read_sprite(s);
+            renderer.add_to_scene(s);
+         }
+         break;
+      case scene_record_multitextured:
+         {
+            Multitextured_2_sprite s;
+            read_sprite(s);
+            renderer.add_to_scene(s);
+         }
+         break;
+      case scene_record_render:
+         renderer.render_scene();
+         return true;
+      case scene_record_clear:
+         renderer.clear_scene();
+         break;
+      case scene_record_create:
+      case scene_record_update:
+      case scene_record_destroy:
+         play_retained(renderer, type);
+         break;
+      default:
+         LOG_RENDERER(Logging::critical) << "!!! Unknown scene record type " << uint(type) << "; throw !!!";
+         throw Scene_format_exception("Unknown scene record type");
+      }
+   }
+
+   return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::rewind(Renderer& renderer)
+{
+   destroy_retained<Vertex_format(position | diffuse_color)>(renderer, m_colored_handles);
+   destroy_retained<Vertex_format(position | diffuse_color | texture_coord0)>(renderer, m_textured_handles);
+   destroy_retained<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>(renderer,
+                                                                                            m_multitextured_handles);
+   m_cur = m_records;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+void Scene_player::read(T& value)
+{
+   if (static_cast<std::size_t>(m_end - m_cur) < sizeof(value))
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Scene stream is truncated; throw !!!";
+      throw Scene_format_exception("Truncated scene stream");
+   }
+
+   std::memcpy(&value, m_cur, sizeof(value));
+   m_cur += sizeof(value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_vertex(Vertex<Vertex_format(position | diffuse_color)>& v)
+{
+   read(v.position.x);
+   read(v.position.y);
+   read(v.position.z);
+   read(v.color.a);
+   read(v.color.r);
+   read(v.color.g);
+   read(v.color.b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_vertex(Vertex<Vertex_format(position | diffuse_color | texture_coord0)>& v)
+{
+   read(v.position.x);
+   read(v.position.y);
+   read(v.position.z);
+   read(v.color.a);
+   read(v.color.r);
+   read(v.color.g);
+   read(v.color.b);
+   read(v.texture_coord.tu);
+   read(v.texture_coord.tv);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_vertex(Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>& v)
+{
+   read(v.position.x);
+   read(v.position.y);
+   read(v.position.z);
+   read(v.color.a);
+   read(v.color.r);
+   read(v.color.g);
+   read(v.color.b);
+   read(v.texture_coord0.tu);
+   read(v.texture_coord0.tv);
+   read(v.texture_coord1.tu);
+   read(v.texture_coord1.tv);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_stage(Texture_ID& texture, Blending_mode& blending)
+{
+   uint handle;
+   uchar mode;
+   read(handle);
+   read(mode);
+
+   if ((handle != 0 && (handle >= m_textures.size() || m_textures[handle] == Texture_ID()))
+       || mode >= blending_mode_number_of_elements)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Scene stream refers undefined texture or blending mode; throw !!!";
+      throw Scene_format_exception("Undefined texture or blending mode in scene stream");
+   }
+
+   texture  = handle == 0 ? Texture_ID() : m_textures[handle];
+   blending = static_cast<Blending_mode>(mode);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_texture()
+{
+   uint handle;
+   ushort length;
+   read(handle);
+   read(length);
+
+   if (static_cast<std::size_t>(m_end - m_cur) < length)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Scene stream is truncated; throw !!!";
+      throw Scene_format_exception("Truncated scene stream");
+   }
+
+   // handles are dense, so each new one is next to ones defined; defined again when frames are replayed
+   if (handle == 0 || handle > m_textures.size())
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Scene stream defines texture handle " << handle << " out of order; throw !!!";
+      throw Scene_format_exception("Texture handle out of order in scene stream");
+   }
+
+   const Texture_ID id(std::string(m_cur, m_cur + length));
+   if (handle == m_textures.size())
+   {
+      m_textures.push_back(id);
+   }
+   else
+   {
+      m_textures[handle] = id;
+   }
+   m_cur += length;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_sprite(Colored_sprite& s)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      read_vertex(s.vertexes[i]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_sprite(Textured_sprite& s)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      read_vertex(s.vertexes[i]);
+   }
+   read_stage(s.texture, s.blending);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::read_sprite(Multitextured_2_sprite& s)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      read_vertex(s.vertexes[i]);
+   }
+   read_stage(s.texture0, s.blending0);
+   read_stage(s.texture1, s.blending1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene_player::play_retained(Renderer& renderer, uchar type)
+{
+   uint id;
+   uchar sprite_type;
+   read(id);
+   read(sprite_type);
+
+   switch (sprite_type)
+   {
+   case scene_record_colored:
+      play_retained<Vertex_format(position | diffuse_color)>(renderer, type, id, m_colored_handles);
+      break;
+   case scene_record_textured:
+      play_retained<Vertex_format(position | diffuse_color | texture_coord0)>(renderer, type, id, m_textured_handles);
+      break;
+   case scene_record_multitextured:
+      play_retained<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>(renderer, type, id,
+                                                                                            m_multitextured_handles);
+      break;
+   default:
+      LOG_RENDERER(Logging::critical) << "!!! Unknown scene record type " << uint(sprite_type) << "; throw !!!";
+      throw Scene_format_exception("Unknown scene record type");
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Scene_player::play_retained(Renderer& renderer, uchar type, uint id, std::vector<uint>& handles)
+{
+   const bool defined = id < handles.size() && handles[id] != no_played_sprite;
+   if (defined == (type == scene_record_create))
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Scene stream refers undefined sprite or defines it twice; throw !!!";
+      throw Scene_format_exception("Undefined or duplicate retained sprite in scene stream");
+   }
+
+   Sprite<format> s;
+   Sprite_handle<format> handle;
+   switch (type)
+   {
+   case scene_record_create:
+      read_sprite(s);
+      if (id >= handles.size())
+      {
+         handles.resize(id + 1, no_played_sprite);
+      }
+      handles[id] = renderer.create_sprite(s).id;
+      break;
+   case scene_record_update:
+      read_sprite(s);
+      handle.id = handles[id];
+      renderer.update_sprite(handle, s);
+      break;
+   case scene_record_destroy:
+      handle.id = handles[id];
+      renderer.destroy_sprite(handle);
+      handles[id] = no_played_sprite;
+      break;
+   default:
+      assert(false && "Not a retained sprite record");
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Scene_player::destroy_retained(Renderer& renderer, std::vector<uint>& handles)
+{
+   for (size_t i = 0; i < handles.size(); ++i)
+   {
+      if (handles[i] != no_played_sprite)
+      {
+         Sprite_handle<format> handle;
+         handle.id = handles[i];
+         renderer.destroy_sprite(handle);
+      }
+   }
+   handles.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
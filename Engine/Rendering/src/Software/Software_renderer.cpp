@@ -0,0 +1,754 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Software_renderer implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Software/Software_renderer.h"
+#include "Engine/Rendering/Software/Span.h"
+#include "Engine/Rendering/Bmp.h"
+#include "Engine/Rendering/Dds.h"
+
+#include "Engine/Rendering/Logging.h"
+#include "Engine/Timing/Stopwatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Attributes interpolated over triangle.
+const uint raster_attribute_z        = 0;
+const uint raster_attribute_color    = 1;      // blue, green, red, alpha (memory order of A8R8G8B8)
+const uint raster_attribute_texture0 = 5;      // u, v
+const uint raster_attribute_texture1 = 7;      // u, v
+const uint raster_attributes_number  = 9;
+
+/// Vertex as rasterizer sees it.
+struct Raster_vertex
+{
+   float x;
+   float y;
+   float attributes[raster_attributes_number];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Image_ptr load_file_texture(const Texture_ID& id, uint& bytes);
+void make_raster_quad(const Colored_sprite& s, Raster_vertex* where);
+void make_raster_quad(const Textured_sprite& s, Raster_vertex* where);
+void make_raster_quad(const Multitextured_2_sprite& s, Raster_vertex* where);
+template <Vertex_format format>
+void make_raster_vertex(const Vertex<format>& v, Raster_vertex& where);
+uint pack_color(const float* channels);
+void sample_span(uint* texels, const Image& texture, float u, float v, float du, float dv, uint n);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Same as Direct3D_renderer uses.
+const uint clear_color = 0xFF0000FF;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Software_renderer::Software_renderer(uint width, uint height)
+   : m_culling()
+   , m_texture_loads(0)
+   , m_frame(width, height)
+   , m_depths(width*height, 1.0f)
+   , m_textures(load_file_texture, texture_cache_budget)
+   , m_pack(0)
+   , m_format(Vertex_format(position | diffuse_color))
+   , m_drawing_retained(false)
+   , m_span(width)
+   , m_texels(width)
+{
+   std::fill(m_stage_blendings, m_stage_blendings + batch_stages_number, blending_mode_disable);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Software_renderer::Software_renderer(uint width, uint height, Texture_loader loader)
+   : m_culling()
+   , m_texture_loads(0)
+   , m_frame(width, height)
+   , m_depths(width*height, 1.0f)
+   , m_textures(loader, texture_cache_budget)
+   , m_pack(0)
+   , m_format(Vertex_format(position | diffuse_color))
+   , m_drawing_retained(false)
+   , m_span(width)
+   , m_texels(width)
+{
+   std::fill(m_stage_blendings, m_stage_blendings + batch_stages_number, blending_mode_disable);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::add_to_scene(const Colored_sprite& s)
+{
+   m_sprites_colored.push_back(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::add_to_scene(const Textured_sprite& s)
+{
+   m_sprites_textured.push_back(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::add_to_scene(const Multitextured_2_sprite& s)
+{
+   m_sprites_multitextured.push_back(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::add_to_scene(const Scene_buffer& buffer)
+{
+   m_sprites_colored.insert(m_sprites_colored.end(), buffer.get_colored_sprites().begin(),
+                            buffer.get_colored_sprites().end());
+   m_sprites_textured.insert(m_sprites_textured.end(), buffer.get_textured_sprites().begin(),
+                             buffer.get_textured_sprites().end());
+   m_sprites_multitextured.insert(m_sprites_multitextured.end(), buffer.get_multitextured_sprites().begin(),
+                                  buffer.get_multitextured_sprites().end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::add_to_scene(const Sprite_instances& instances)
+{
+   const size_t size = m_sprites_textured.size();
+   m_sprites_textured.resize(size + instances.number);
+   if (instances.number > 0)
+   {
+      expand_instances(instances, &m_sprites_textured[size]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::render_scene()
+{
+   if (m_frame.pixels.empty())
+   {
+      return;
+   }
+
+   clear_render_stats(m_stats);
+   Timing::Stopwatch stopwatch;
+
+   // textures loaded since previous frame are drawn from this one on
+   take_streamed_textures();
+
+   fill_span(&m_frame.pixels[0], clear_color, m_frame.pixels.size());
+   std::fill(m_depths.begin(), m_depths.end(), 1.0f);
+   m_stats.draw_seconds += stopwatch.lap();
+
+   const Bounds viewport = { 0, 0, float(m_frame.width), float(m_frame.height) };
+
+   // same order as Direct3D_renderer draws sprites; viewport doesn't change, so does visibility of retained sprites
+   if (m_retained_colored.is_changed() || m_retained_textured.is_changed() || m_retained_multitextured.is_changed())
+   {
+      m_retained_batches.clear();
+      m_retained_translucent.clear();
+      m_translucent_entries.clear();
+      m_culling.retained = static_cast<uint>(m_retained_colored.get_sprites().size()
+                                             + m_retained_textured.get_sprites().size()
+                                             + m_retained_multitextured.get_sprites().size());
+      m_culling.culled_retained =
+         compile_visible_batches(m_retained_colored, viewport, m_visible_slots, m_retained_batches,
+                                 m_translucent_entries)
+         + compile_visible_batches(m_retained_textured, viewport, m_visible_slots, m_retained_batches,
+                                   m_translucent_entries)
+         + compile_visible_batches(m_retained_multitextured, viewport, m_visible_slots, m_retained_batches,
+                                   m_translucent_entries);
+      m_queue.compile_sorted(m_translucent_entries, m_retained_colored.get_sprites(),
+                             m_retained_textured.get_sprites(), m_retained_multitextured.get_sprites(),
+                             m_retained_translucent);
+
+      // sprites are drawn right from stores, so there is nothing to upload
+      m_retained_colored.clear_dirty();
+      m_retained_textured.clear_dirty();
+      m_retained_multitextured.clear_dirty();
+   }
+   m_stats.convert_seconds += stopwatch.lap();
+   m_drawing_retained = true;
+   draw_batches(m_retained_batches, *this);
+   m_stats.draw_seconds += stopwatch.lap();
+
+   m_culling.sprites = static_cast<uint>(m_sprites_colored.size() + m_sprites_textured.size()
+                                         + m_sprites_multitextured.size());
+   m_culling.culled_sprites = cull_sprites(m_sprites_colored, viewport) + cull_sprites(m_sprites_textured, viewport)
+                              + cull_sprites(m_sprites_multitextured, viewport);
+
+   m_batches.clear();
+   const uint opaque_batches = m_queue.sort(m_sprites_colored, m_sprites_textured, m_sprites_multitextured, m_batches);
+   m_translucent_batches.assign(m_batches.begin() + opaque_batches, m_batches.end());
+   m_batches.resize(opaque_batches);
+   m_stats.convert_seconds += stopwatch.lap();
+
+   // translucent sprites are blended over all opaque ones; retained ones go first
+   m_drawing_retained = false;
+   draw_batches(m_batches, *this);
+   m_drawing_retained = true;
+   draw_batches(m_retained_translucent, *this);
+   m_drawing_retained = false;
+   draw_batches(m_translucent_batches, *this);
+   m_stats.draw_seconds += stopwatch.lap();
+
+   m_stats.texture_loads     = m_texture_loads;
+   m_stats.sprites_submitted = m_culling.sprites + m_culling.retained;
+   m_stats.sprites_culled    = m_culling.culled_sprites + m_culling.culled_retained;
+   m_texture_loads = 0;
+   m_stats_log.add_frame(m_stats);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::clear_scene()
+{
+   m_sprites_colored.clear();
+   m_sprites_textured.clear();
+   m_sprites_multitextured.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Colored_sprite_handle Software_renderer::create_sprite(const Colored_sprite& s)
+{
+   return m_retained_colored.create(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Textured_sprite_handle Software_renderer::create_sprite(const Textured_sprite& s)
+{
+   return m_retained_textured.create(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Multitextured_2_sprite_handle Software_renderer::create_sprite(const Multitextured_2_sprite& s)
+{
+   return m_retained_multitextured.create(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::update_sprite(Colored_sprite_handle handle, const Colored_sprite& s)
+{
+   m_retained_colored.update(handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::update_sprite(Textured_sprite_handle handle, const Textured_sprite& s)
+{
+   m_retained_textured.update(handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::update_sprite(Multitextured_2_sprite_handle handle, const Multitextured_2_sprite& s)
+{
+   m_retained_multitextured.update(handle, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::destroy_sprite(Colored_sprite_handle handle)
+{
+   m_retained_colored.destroy(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::destroy_sprite(Textured_sprite_handle handle)
+{
+   m_retained_textured.destroy(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::destroy_sprite(Multitextured_2_sprite_handle handle)
+{
+   m_retained_multitextured.destroy(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Software_renderer::is_focused() const
+{
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::try_restore()
+{
+   LOG_RENDERER(Logging::minor) << "Renderer restoring requested, but it is nothing to restore";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Render_stats& Software_renderer::get_render_stats() const
+{
+   return m_stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::set_vertex_format(Vertex_format format)
+{
+   ++m_stats.state_changes;
+   m_format = format;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::enable_texture_streaming(uint threads)
+{
+   Image* placeholder = new Image(1, 1);
+   placeholder->pixels[0] = 0xFFFFFFFF;
+   m_placeholder.reset(placeholder);
+
+   m_streamer.reset(new Texture_streamer(threads));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::prefetch_texture(const Texture_ID& id)
+{
+   Image_ptr texture;
+   if (m_textures.contains(id) || take_packed_texture(id, texture))
+   {
+      return;
+   }
+
+   if (!m_streamer)
+   {
+      m_textures.get(id);
+      ++m_texture_loads;
+   }
+   else
+   {
+      m_streamer->prefetch(id);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::wait_for_textures()
+{
+   if (m_streamer)
+   {
+      m_streamer->wait();
+      take_streamed_textures();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::take_streamed_textures()
+{
+   if (!m_streamer || m_streamer->get_pending_number() == 0)
+   {
+      return;
+   }
+
+   m_streamed.clear();
+   m_streamer->collect(m_streamed);
+   for (size_t i = 0; i < m_streamed.size(); ++i)
+   {
+      const Streamed_image& loaded = m_streamed[i];
+      if (!loaded.image)
+      {
+         // placeholder stays, so texture isn't requested again
+         LOG_RENDERER(Logging::critical) << "!!! Can't load texture \"" << loaded.id.get_file_name() << "\": "
+                                         << loaded.error << " !!!";
+         m_textures.insert(loaded.id, m_placeholder, 0);
+         continue;
+      }
+
+      LOG_RENDERER(Logging::trivial) << "Texture \"" << loaded.id.get_file_name() << "\" streamed";
+      m_textures.insert(loaded.id, loaded.image, static_cast<uint>(loaded.image->pixels.size()*sizeof(uint)));
+      ++m_texture_loads;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::set_texture(uint nstage, const Texture_ID& id)
+{
+   ++m_stats.state_changes;
+   Image_ptr& texture = m_stage_textures[nstage];
+   if (id == Texture_ID())
+   {
+      texture.reset();
+   }
+   else if (!m_textures.find(id, texture) && !take_packed_texture(id, texture))
+   {
+      if (!m_streamer)
+      {
+         texture = m_textures.get(id);
+         ++m_texture_loads;
+      }
+      else
+      {
+         m_streamer->request(id);
+         texture = m_placeholder;
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Software_renderer::take_packed_texture(const Texture_ID& id, Image_ptr& texture)
+{
+   Packed_texture packed;
+   if (!m_pack || !m_pack->find(id.get_file_name(), packed))
+   {
+      return false;
+   }
+
+   LOG_RENDERER(Logging::trivial) << "Texture \"" << id.get_file_name() << "\" taken from asset pack";
+   texture.reset(new Image(unpack_image(packed)));
+   m_textures.insert(id, texture, static_cast<uint>(texture->pixels.size()*sizeof(uint)));
+   ++m_texture_loads;
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::set_blending(uint nstage, Blending_mode mode)
+{
+   ++m_stats.state_changes;
+   m_stage_blendings[nstage] = mode;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::draw_quads(uint first_quad, uint nquads)
+{
+   ++m_stats.draw_calls;
+   m_stats.sprites_drawn += nquads;
+   Raster_vertex quad[4];
+
+   switch (uint(m_format))
+   {
+   case position | diffuse_color:
+      {
+         const std::vector<Colored_sprite>& sprites =
+            m_drawing_retained ? m_retained_colored.get_sprites() : m_sprites_colored;
+         for (uint i = first_quad; i < first_quad + nquads; ++i)
+         {
+            make_raster_quad(sprites[i], quad);
+            draw_quad(quad);
+         }
+      }
+      break;
+   case position | diffuse_color | texture_coord0:
+      {
+         const std::vector<Textured_sprite>& sprites =
+            m_drawing_retained ? m_retained_textured.get_sprites() : m_sprites_textured;
+         for (uint i = first_quad; i < first_quad + nquads; ++i)
+         {
+            make_raster_quad(sprites[i], quad);
+            draw_quad(quad);
+         }
+      }
+      break;
+   case position | diffuse_color | texture_coord0 | texture_coord1:
+      {
+         const std::vector<Multitextured_2_sprite>& sprites =
+            m_drawing_retained ? m_retained_multitextured.get_sprites() : m_sprites_multitextured;
+         for (uint i = first_quad; i < first_quad + nquads; ++i)
+         {
+            make_raster_quad(sprites[i], quad);
+            draw_quad(quad);
+         }
+      }
+      break;
+   default:
+      assert(false && "Unsupported vertex format");
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::draw_quad(const Raster_vertex* v)
+{
+   // same triangles as Direct3D_renderer draws (it keeps vertexes in strip order 0, 1, 3, 2)
+   draw_triangle(v[0], v[1], v[3]);
+   draw_triangle(v[3], v[1], v[2]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Software_renderer::draw_triangle(const Raster_vertex& a, const Raster_vertex& b, const Raster_vertex& c)
+{
+   const float area = (b.x - a.x)*(c.y - a.y) - (c.x - a.x)*(b.y - a.y);
+   if (area == 0)
+   {
+      return;
+   }
+
+   // attribute(x, y) = a.attribute + ddx*(x - a.x) + ddy*(y - a.y)
+   float ddx[raster_attributes_number];
+   float ddy[raster_attributes_number];
+   for (uint k = 0; k < raster_attributes_number; ++k)
+   {
+      const float d1 = b.attributes[k] - a.attributes[k];
+      const float d2 = c.attributes[k] - a.attributes[k];
+      ddx[k] = (d1*(c.y - a.y) - d2*(b.y - a.y)) / area;
+      ddy[k] = (d2*(b.x - a.x) - d1*(c.x - a.x)) / area;
+   }
+
+   // stages that change diffuse color
+   uint stages[batch_stages_number];
+   uint nstages = 0;
+   for (uint nstage = 0; nstage < batch_stages_number && m_stage_blendings[nstage] != blending_mode_disable; ++nstage)
+   {
+      if (m_stage_textures[nstage] && m_stage_blendings[nstage] != blending_mode_select_arg2)
+      {
+         stages[nstages++] = nstage;
+      }
+   }
+
+   const bool flat_color = std::equal(a.attributes + raster_attribute_color, a.attributes + raster_attribute_color + 4,
+                                      b.attributes + raster_attribute_color)
+                        && std::equal(a.attributes + raster_attribute_color, a.attributes + raster_attribute_color + 4,
+                                      c.attributes + raster_attribute_color);
+   const uint color = pack_color(a.attributes + raster_attribute_color);
+
+   // sort vertexes by y
+   const Raster_vertex* top = &a;
+   const Raster_vertex* mid = &b;
+   const Raster_vertex* bot = &c;
+   if (mid->y < top->y) std::swap(mid, top);
+   if (bot->y < mid->y) std::swap(bot, mid);
+   if (mid->y < top->y) std::swap(mid, top);
+
+   // pixel is covered if its center is inside triangle; centers on the left and top edges are covered
+   const int width  = static_cast<int>(m_frame.width);
+   const int height = static_cast<int>(m_frame.height);
+   const int y_begin = std::max(0, static_cast<int>(std::ceil(top->y - 0.5f)));
+   const int y_end   = std::min(height, static_cast<int>(std::ceil(bot->y - 0.5f)));
+
+   for (int y = y_begin; y < y_end; ++y)
+   {
+      const float yc = y + 0.5f;
+
+      const float x_long = top->x + (yc - top->y)*(bot->x - top->x)/(bot->y - top->y);
+      const float x_short = yc < mid->y ? top->x + (yc - top->y)*(mid->x - top->x)/(mid->y - top->y)
+                                        : mid->x + (yc - mid->y)*(bot->x - mid->x)/(bot->y - mid->y);
+
+      const int x_begin = std::max(0, static_cast<int>(std::ceil(std::min(x_long, x_short) - 0.5f)));
+      const int x_end   = std::min(width, static_cast<int>(std::ceil(std::max(x_long, x_short) - 0.5f)));
+      if (x_begin >= x_end)
+      {
+         continue;
+      }
+
+      // attributes at the center of the first pixel of span
+      const float xc = x_begin + 0.5f;
+      float start[raster_attributes_number];
+      for (uint k = 0; k < raster_attributes_number; ++k)
+      {
+         start[k] = a.attributes[k] + ddx[k]*(xc - a.x) + ddy[k]*(yc - a.y);
+      }
+
+      const uint n = x_end - x_begin;
+      uint*  frame  = &m_frame.pixels[y*width + x_begin];
+      float* depths = &m_depths[y*width + x_begin];
+      const float z  = start[raster_attribute_z];
+      const float dz = ddx[raster_attribute_z];
+
+      if (flat_color && nstages == 0)
+      {
+         write_span(frame, depths, color, z, dz, n);
+         continue;
+      }
+
+      uint* span = &m_span[0];
+      if (flat_color)
+      {
+         fill_span(span, color, n);
+      }
+      else
+      {
+         interpolate_span(span, start + raster_attribute_color, ddx + raster_attribute_color, n);
+      }
+
+      for (uint i = 0; i < nstages; ++i)
+      {
+         const uint nstage = stages[i];
+         const uint uv = nstage == 0 ? raster_attribute_texture0 : raster_attribute_texture1;
+
+         uint* texels = &m_texels[0];
+         sample_span(texels, *m_stage_textures[nstage], start[uv], start[uv + 1], ddx[uv], ddx[uv + 1], n);
+
+         switch (m_stage_blendings[nstage])
+         {
+         case blending_mode_select_arg1:
+            std::copy(texels, texels + n, span);
+            break;
+         case blending_mode_modulate:
+            modulate_span(span, texels, n);
+            break;
+         case blending_mode_add:
+            add_span(span, texels, n);
+            break;
+         default:
+            assert(false && "Unsupported blending mode");
+         }
+      }
+
+      write_span(frame, depths, span, z, dz, n);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Texture_cache loader.
+Image_ptr load_file_texture(const Texture_ID& id, uint& bytes)
+{
+   LOG_RENDERER(Logging::trivial) << "Load texture \"" << id.get_file_name() << "\"";
+
+   // rasterizer samples plain texels, so compressed textures are decompressed right away
+   const std::string& file_name = id.get_file_name();
+   Image_ptr image(new Image(is_dds_file(file_name) ? decompress_image(load_dds(file_name)) : load_bmp(file_name)));
+   bytes = image->pixels.size()*sizeof(uint);
+   return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void make_raster_quad(const Colored_sprite& s, Raster_vertex* where)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      make_raster_vertex(s.vertexes[i], where[i]);
+      std::fill(where[i].attributes + raster_attribute_texture0, where[i].attributes + raster_attributes_number, 0.0f);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void make_raster_quad(const Textured_sprite& s, Raster_vertex* where)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      make_raster_vertex(s.vertexes[i], where[i]);
+      where[i].attributes[raster_attribute_texture0]     = s.vertexes[i].texture_coord.tu;
+      where[i].attributes[raster_attribute_texture0 + 1] = s.vertexes[i].texture_coord.tv;
+      where[i].attributes[raster_attribute_texture1]     = 0;
+      where[i].attributes[raster_attribute_texture1 + 1] = 0;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void make_raster_quad(const Multitextured_2_sprite& s, Raster_vertex* where)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      make_raster_vertex(s.vertexes[i], where[i]);
+      where[i].attributes[raster_attribute_texture0]     = s.vertexes[i].texture_coord0.tu;
+      where[i].attributes[raster_attribute_texture0 + 1] = s.vertexes[i].texture_coord0.tv;
+      where[i].attributes[raster_attribute_texture1]     = s.vertexes[i].texture_coord1.tu;
+      where[i].attributes[raster_attribute_texture1 + 1] = s.vertexes[i].texture_coord1.tv;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Fills position, depth and color.
+template <Vertex_format format>
+void make_raster_vertex(const Vertex<format>& v, Raster_vertex& where)
+{
+   where.x = v.position.x;
+   where.y = v.position.y;
+   where.attributes[raster_attribute_z] = v.position.z;
+
+   // channels are biased by 0.5, so truncation in span functions rounds them
+   where.attributes[raster_attribute_color]     = v.color.b + 0.5f;
+   where.attributes[raster_attribute_color + 1] = v.color.g + 0.5f;
+   where.attributes[raster_attribute_color + 2] = v.color.r + 0.5f;
+   where.attributes[raster_attribute_color + 3] = v.color.a + 0.5f;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Converts biased channels (see make_raster_vertex) to A8R8G8B8 the same way interpolate_span() does.
+uint pack_color(const float* channels)
+{
+   uint color = 0;
+   for (uint k = 0; k < 4; ++k)
+   {
+      const float v = std::min(std::max(channels[k], 0.0f), 255.0f);
+      color |= uint(static_cast<int>(v)) << (8*k);
+   }
+   return color;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Samples n texels along span: nearest filtering, wrap addressing.
+void sample_span(uint* texels, const Image& texture, float u, float v, float du, float dv, uint n)
+{
+   const float width  = static_cast<float>(texture.width);
+   const float height = static_cast<float>(texture.height);
+   const int w = static_cast<int>(texture.width);
+   const int h = static_cast<int>(texture.height);
+   const bool pow2 = (w & (w - 1)) == 0 && (h & (h - 1)) == 0;
+
+   const uint* pixels = &texture.pixels[0];
+   for (uint i = 0; i < n; ++i)
+   {
+      const float tu = (u + float(i)*du)*width;
+      const float tv = (v + float(i)*dv)*height;
+
+      // floor without calling floor()
+      int x = static_cast<int>(tu);
+      int y = static_cast<int>(tv);
+      x -= tu < x;
+      y -= tv < y;
+
+      if (pow2)
+      {
+         x &= w - 1;
+         y &= h - 1;
+      }
+      else
+      {
+         x = (x % w + w) % w;
+         y = (y % h + h) % h;
+      }
+
+      texels[i] = pixels[y*w + x];
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
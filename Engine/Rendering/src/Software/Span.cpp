@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Span operations implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Software/Span.h"
+
+#include "Common/Simd.h"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Each function handles groups of 4 pixels with SSE2 and then the rest of span one by one.
+// Without SSE2 the whole span is handled by the scalar code.
+
+uint modulate_pixel(uint pixel, uint arg);
+uint add_pixel(uint pixel, uint arg);
+float clamp_channel(float value);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void fill_span(uint* pixels, uint color, uint n)
+{
+   uint i = 0;
+
+#ifdef COMMON_SSE2
+   const __m128i colors = _mm_set1_epi32(color);
+   for (; i + 4 <= n; i += 4)
+   {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), colors);
+   }
+#endif
+
+   std::fill(pixels + i, pixels + n, color);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void interpolate_span(uint* pixels, const float channels[4], const float steps[4], uint n)
+{
+   uint i = 0;
+
+#ifdef COMMON_SSE2
+   const __m128 start = _mm_loadu_ps(channels);
+   const __m128 step  = _mm_loadu_ps(steps);
+   const __m128 zero  = _mm_setzero_ps();
+   const __m128 limit = _mm_set1_ps(255.0f);
+
+   // one pixel (4 channels) per register
+   __m128i c[4];
+   for (; i + 4 <= n; i += 4)
+   {
+      for (uint k = 0; k < 4; ++k)
+      {
+         __m128 v = _mm_add_ps(start, _mm_mul_ps(_mm_set1_ps(float(i + k)), step));
+         v = _mm_min_ps(_mm_max_ps(v, zero), limit);
+         c[k] = _mm_cvttps_epi32(v);
+      }
+      const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), packed);
+   }
+#endif
+
+   for (; i < n; ++i)
+   {
+      uint pixel = 0;
+      for (uint k = 0; k < 4; ++k)
+      {
+         const float v = clamp_channel(channels[k] + float(i)*steps[k]);
+         pixel |= uint(static_cast<int>(v)) << (8*k);
+      }
+      pixels[i] = pixel;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void modulate_span(uint* pixels, const uint* args, uint n)
+{
+   uint i = 0;
+
+#ifdef COMMON_SSE2
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i half = _mm_set1_epi16(128);
+   for (; i + 4 <= n; i += 4)
+   {
+      const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(args + i));
+
+      // 16 bits per channel; x/255 is computed as (x + 128 + ((x + 128) >> 8)) >> 8, exact for x <= 255*255
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(a, zero)), half);
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(a, zero)), half);
+      lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+      hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), _mm_packus_epi16(lo, hi));
+   }
+#endif
+
+   for (; i < n; ++i)
+   {
+      pixels[i] = modulate_pixel(pixels[i], args[i]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void add_span(uint* pixels, const uint* args, uint n)
+{
+   uint i = 0;
+
+#ifdef COMMON_SSE2
+   for (; i + 4 <= n; i += 4)
+   {
+      const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(args + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), _mm_adds_epu8(p, a));
+   }
+#endif
+
+   for (; i < n; ++i)
+   {
+      pixels[i] = add_pixel(pixels[i], args[i]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void write_span(uint* frame, float* depths, const uint* pixels, float z, float dz, uint n)
+{
+   uint i = 0;
+
+#ifdef COMMON_SSE2
+   const __m128 zs    = _mm_set1_ps(z);
+   const __m128 dzs   = _mm_set1_ps(dz);
+   const __m128 index = _mm_set_ps(3, 2, 1, 0);
+   for (; i + 4 <= n; i += 4)
+   {
+      const __m128 pz = _mm_add_ps(zs, _mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(i)), index), dzs));
+      const __m128 d  = _mm_loadu_ps(depths + i);
+      const __m128 passed = _mm_cmple_ps(pz, d);
+
+      // pixels are selected by float bitwise operations: they keep bit patterns intact
+      const __m128 f = _mm_loadu_ps(reinterpret_cast<const float*>(frame + i));
+      const __m128 p = _mm_loadu_ps(reinterpret_cast<const float*>(pixels + i));
+      _mm_storeu_ps(reinterpret_cast<float*>(frame + i), _mm_or_ps(_mm_and_ps(passed, p), _mm_andnot_ps(passed, f)));
+      _mm_storeu_ps(depths + i, _mm_or_ps(_mm_and_ps(passed, pz), _mm_andnot_ps(passed, d)));
+   }
+#endif
+
+   for (; i < n; ++i)
+   {
+      const float pz = z + float(i)*dz;
+      if (pz <= depths[i])
+      {
+         frame[i]  = pixels[i];
+         depths[i] = pz;
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void write_span(uint* frame, float* depths, uint color, float z, float dz, uint n)
+{
+   uint i = 0;
+
+#ifdef COMMON_SSE2
+   const __m128  zs     = _mm_set1_ps(z);
+   const __m128  dzs    = _mm_set1_ps(dz);
+   const __m128  index  = _mm_set_ps(3, 2, 1, 0);
+   const __m128  colors = _mm_load1_ps(reinterpret_cast<const float*>(&color));
+   for (; i + 4 <= n; i += 4)
+   {
+      const __m128 pz = _mm_add_ps(zs, _mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(i)), index), dzs));
+      const __m128 d  = _mm_loadu_ps(depths + i);
+      const __m128 passed = _mm_cmple_ps(pz, d);
+
+      const __m128 f = _mm_loadu_ps(reinterpret_cast<const float*>(frame + i));
+      _mm_storeu_ps(reinterpret_cast<float*>(frame + i), _mm_or_ps(_mm_and_ps(passed, colors), _mm_andnot_ps(passed, f)));
+      _mm_storeu_ps(depths + i, _mm_or_ps(_mm_and_ps(passed, pz), _mm_andnot_ps(passed, d)));
+   }
+#endif
+
+   for (; i < n; ++i)
+   {
+      const float pz = z + float(i)*dz;
+      if (pz <= depths[i])
+      {
+         frame[i]  = color;
+         depths[i] = pz;
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint modulate_pixel(uint pixel, uint arg)
+{
+   uint result = 0;
+   for (uint shift = 0; shift < 32; shift += 8)
+   {
+      const uint x = ((pixel >> shift) & 0xFF)*((arg >> shift) & 0xFF) + 128;
+      result |= ((x + (x >> 8)) >> 8) << shift;
+   }
+   return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint add_pixel(uint pixel, uint arg)
+{
+   uint result = 0;
+   for (uint shift = 0; shift < 32; shift += 8)
+   {
+      const uint x = ((pixel >> shift) & 0xFF) + ((arg >> shift) & 0xFF);
+      result |= std::min(x, 255u) << shift;
+   }
+   return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float clamp_channel(float value)
+{
+   return std::min(std::max(value, 0.0f), 255.0f);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
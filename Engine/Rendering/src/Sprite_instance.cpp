@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Sprite_instance implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite_instance.h"
+
+#include "Common/Simd.h"
+
+#include "boost/static_assert.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SSE2 code reads instance as 8 dwords and writes vertex as x, y, z, color followed by texture coordinates
+BOOST_STATIC_ASSERT(sizeof(Sprite_instance) == 32);
+BOOST_STATIC_ASSERT(sizeof(Vertex<Vertex_format(position | diffuse_color | texture_coord0)>) == 24);
+
+// Sine and cosine: angle is reduced to [-pi/4, pi/4] by subtracting multiple of pi/2 split into 3 parts
+// (so that subtraction is exact for angles sprites have), then polynomials of Cephes library are taken.
+// SSE2 and plain code do the same operations in the same order, so they give the same results.
+
+const float two_over_pi = 0.636619772f;
+const float pi_over_2_a = 1.5703125f;
+const float pi_over_2_b = 4.837512969970703125e-4f;
+const float pi_over_2_c = 7.54978995489188216e-8f;
+const float sine_0      = -1.9515295891e-4f;
+const float sine_1      = 8.3321608736e-3f;
+const float sine_2      = -1.6666654611e-1f;
+const float cosine_0    = 2.443315711809948e-5f;
+const float cosine_1    = -1.388731625493765e-3f;
+const float cosine_2    = 4.166664568298827e-2f;
+
+/// Texture coordinate 1 in units of Sprite_instance.
+const float texture_coord_unit = 65535.0f;
+
+inline void get_sin_cos(float angle, float& sine, float& cosine);
+inline void expand_instance(const Sprite_instance& instance, const Sprite_instances& common, Textured_sprite& where);
+
+#ifdef COMMON_SSE2
+inline void get_sin_cos(__m128 angles, __m128& sines, __m128& cosines);
+inline void expand_4_instances(const Sprite_instance* instances, const Sprite_instances& common,
+                               Textured_sprite* where);
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void expand_instances(const Sprite_instances& instances, Textured_sprite* where)
+{
+   uint i = 0;
+#ifdef COMMON_SSE2
+   for (; i + 4 <= instances.number; i += 4)
+   {
+      expand_4_instances(instances.instances + i, instances, where + i);
+   }
+#endif
+   for (; i < instances.number; ++i)
+   {
+      expand_instance(instances.instances[i], instances, where[i]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void get_sin_cos(float angle, float& sine, float& cosine)
+{
+   // nearest quadrant; ties are rounded away from zero, as SSE2 code does
+   const int quadrant = static_cast<int>(angle*two_over_pi + (angle < 0 ? -0.5f : 0.5f));
+   const float q = static_cast<float>(quadrant);
+   float r = angle - q*pi_over_2_a;
+   r = r - q*pi_over_2_b;
+   r = r - q*pi_over_2_c;
+
+   const float r2 = r*r;
+   const float sine_r   = ((sine_0*r2 + sine_1)*r2 + sine_2)*r2*r + r;
+   const float cosine_r = ((cosine_0*r2 + cosine_1)*r2 + cosine_2)*r2*r2 - 0.5f*r2 + 1.0f;
+
+   // angle is r + quadrant*pi/2
+   const bool is_swapped = (quadrant & 1) != 0;
+   sine   = is_swapped ? cosine_r : sine_r;
+   cosine = is_swapped ? sine_r : cosine_r;
+   sine   = (quadrant & 2) != 0 ? -sine : sine;
+   cosine = ((quadrant + 1) & 2) != 0 ? -cosine : cosine;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void expand_instance(const Sprite_instance& instance, const Sprite_instances& common, Textured_sprite& where)
+{
+   float sine;
+   float cosine;
+   get_sin_cos(instance.rotation, sine, cosine);
+
+   // corner (+-half_width, +-half_height) turned by angle; offsets of opposite corners differ only by sign
+   const float half_width_cos  = instance.half_width*cosine;
+   const float half_height_sin = instance.half_height*sine;
+   const float half_width_sin  = instance.half_width*sine;
+   const float half_height_cos = instance.half_height*cosine;
+   const float dx0 = half_width_cos - half_height_sin;
+   const float dx1 = half_width_cos + half_height_sin;
+   const float dy0 = half_width_sin + half_height_cos;
+   const float dy1 = half_width_sin - half_height_cos;
+
+   const float xs[4] = { instance.x - dx0, instance.x - dx1, instance.x + dx0, instance.x + dx1 };
+   const float ys[4] = { instance.y - dy0, instance.y - dy1, instance.y + dy0, instance.y + dy1 };
+
+   const float u0 = static_cast<float>(instance.u0) / texture_coord_unit;
+   const float v0 = static_cast<float>(instance.v0) / texture_coord_unit;
+   const float u1 = static_cast<float>(instance.u1) / texture_coord_unit;
+   const float v1 = static_cast<float>(instance.v1) / texture_coord_unit;
+   const float us[4] = { u0, u0, u1, u1 };
+   const float vs[4] = { v0, v1, v1, v0 };
+
+   for (uint i = 0; i < 4; ++i)
+   {
+      where.vertexes[i].position.x       = xs[i];
+      where.vertexes[i].position.y       = ys[i];
+      where.vertexes[i].position.z       = common.z;
+      where.vertexes[i].color            = instance.color;
+      where.vertexes[i].texture_coord.tu = us[i];
+      where.vertexes[i].texture_coord.tv = vs[i];
+   }
+   where.texture  = common.texture;
+   where.blending = common.blending;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef COMMON_SSE2
+
+inline void get_sin_cos(__m128 angles, __m128& sines, __m128& cosines)
+{
+   const __m128 sign = _mm_set1_ps(-0.0f);
+   const __m128i quadrants = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(angles, _mm_set1_ps(two_over_pi)),
+                                                         _mm_or_ps(_mm_and_ps(angles, sign), _mm_set1_ps(0.5f))));
+   const __m128 q = _mm_cvtepi32_ps(quadrants);
+   __m128 r = _mm_sub_ps(angles, _mm_mul_ps(q, _mm_set1_ps(pi_over_2_a)));
+   r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(pi_over_2_b)));
+   r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(pi_over_2_c)));
+
+   const __m128 r2 = _mm_mul_ps(r, r);
+   __m128 sine_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sine_0), r2), _mm_set1_ps(sine_1));
+   sine_r = _mm_add_ps(_mm_mul_ps(sine_r, r2), _mm_set1_ps(sine_2));
+   sine_r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sine_r, r2), r), r);
+   __m128 cosine_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cosine_0), r2), _mm_set1_ps(cosine_1));
+   cosine_r = _mm_add_ps(_mm_mul_ps(cosine_r, r2), _mm_set1_ps(cosine_2));
+   cosine_r = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cosine_r, r2), r2), _mm_mul_ps(_mm_set1_ps(0.5f), r2));
+   cosine_r = _mm_add_ps(cosine_r, _mm_set1_ps(1.0f));
+
+   // odd quadrants swap sine and cosine; signs are moved from bit 1 of quadrant (and of quadrant + 1) to bit 31
+   const __m128i one = _mm_set1_epi32(1);
+   const __m128 is_swapped = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrants, one), one));
+   const __m128 sine_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrants, _mm_set1_epi32(2)), 30));
+   const __m128 cosine_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrants, one),
+                                                                            _mm_set1_epi32(2)), 30));
+   sines   = _mm_or_ps(_mm_and_ps(is_swapped, cosine_r), _mm_andnot_ps(is_swapped, sine_r));
+   cosines = _mm_or_ps(_mm_and_ps(is_swapped, sine_r), _mm_andnot_ps(is_swapped, cosine_r));
+   sines   = _mm_xor_ps(sines, sine_sign);
+   cosines = _mm_xor_ps(cosines, cosine_sign);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Instances are transposed into registers of x, y, half widths etc. of all 4; corners of each are transposed back
+/// into x, y, z, color of vertex.
+inline void expand_4_instances(const Sprite_instance* instances, const Sprite_instances& common,
+                               Textured_sprite* where)
+{
+   const float* const in = reinterpret_cast<const float*>(instances);
+   __m128 xs           = _mm_loadu_ps(in);
+   __m128 ys           = _mm_loadu_ps(in + 8);
+   __m128 half_widths  = _mm_loadu_ps(in + 16);
+   __m128 half_heights = _mm_loadu_ps(in + 24);
+   _MM_TRANSPOSE4_PS(xs, ys, half_widths, half_heights);
+   __m128 rotations = _mm_loadu_ps(in + 4);
+   __m128 colors    = _mm_loadu_ps(in + 12);
+   __m128 uvs0      = _mm_loadu_ps(in + 20);
+   __m128 uvs1      = _mm_loadu_ps(in + 28);
+   _MM_TRANSPOSE4_PS(rotations, colors, uvs0, uvs1);
+
+   __m128 sines;
+   __m128 cosines;
+   get_sin_cos(rotations, sines, cosines);
+
+   const __m128 half_width_cos  = _mm_mul_ps(half_widths, cosines);
+   const __m128 half_height_sin = _mm_mul_ps(half_heights, sines);
+   const __m128 half_width_sin  = _mm_mul_ps(half_widths, sines);
+   const __m128 half_height_cos = _mm_mul_ps(half_heights, cosines);
+   const __m128 dx0 = _mm_sub_ps(half_width_cos, half_height_sin);
+   const __m128 dx1 = _mm_add_ps(half_width_cos, half_height_sin);
+   const __m128 dy0 = _mm_add_ps(half_width_sin, half_height_cos);
+   const __m128 dy1 = _mm_sub_ps(half_width_sin, half_height_cos);
+
+   // u0 and v0 are low and high halves of the third dword, u1 and v1 of the fourth one
+   const __m128i low = _mm_set1_epi32(0xFFFF);
+   const __m128  unit = _mm_set1_ps(texture_coord_unit);
+   const __m128  u0 = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_castps_si128(uvs0), low)), unit);
+   const __m128  v0 = _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(_mm_castps_si128(uvs0), 16)), unit);
+   const __m128  u1 = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_castps_si128(uvs1), low)), unit);
+   const __m128  v1 = _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(_mm_castps_si128(uvs1), 16)), unit);
+
+   const __m128 corner_xs[4] = { _mm_sub_ps(xs, dx0), _mm_sub_ps(xs, dx1), _mm_add_ps(xs, dx0), _mm_add_ps(xs, dx1) };
+   const __m128 corner_ys[4] = { _mm_sub_ps(ys, dy0), _mm_sub_ps(ys, dy1), _mm_add_ps(ys, dy0), _mm_add_ps(ys, dy1) };
+   const __m128 corner_us[4] = { u0, u0, u1, u1 };
+   const __m128 corner_vs[4] = { v0, v1, v1, v0 };
+   const __m128 zs = _mm_set1_ps(common.z);
+
+   for (uint corner = 0; corner < 4; ++corner)
+   {
+      __m128 vertex0 = corner_xs[corner];
+      __m128 vertex1 = corner_ys[corner];
+      __m128 vertex2 = zs;
+      __m128 vertex3 = colors;
+      _MM_TRANSPOSE4_PS(vertex0, vertex1, vertex2, vertex3);
+      _mm_storeu_ps(&where[0].vertexes[corner].position.x, vertex0);
+      _mm_storeu_ps(&where[1].vertexes[corner].position.x, vertex1);
+      _mm_storeu_ps(&where[2].vertexes[corner].position.x, vertex2);
+      _mm_storeu_ps(&where[3].vertexes[corner].position.x, vertex3);
+
+      const __m128 coords01 = _mm_unpacklo_ps(corner_us[corner], corner_vs[corner]);
+      const __m128 coords23 = _mm_unpackhi_ps(corner_us[corner], corner_vs[corner]);
+      _mm_storel_pi(reinterpret_cast<__m64*>(&where[0].vertexes[corner].texture_coord), coords01);
+      _mm_storeh_pi(reinterpret_cast<__m64*>(&where[1].vertexes[corner].texture_coord), coords01);
+      _mm_storel_pi(reinterpret_cast<__m64*>(&where[2].vertexes[corner].texture_coord), coords23);
+      _mm_storeh_pi(reinterpret_cast<__m64*>(&where[3].vertexes[corner].texture_coord), coords23);
+   }
+
+   for (uint i = 0; i < 4; ++i)
+   {
+      where[i].texture  = common.texture;
+      where[i].blending = common.blending;
+   }
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
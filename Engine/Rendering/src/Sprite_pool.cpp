@@ -0,0 +1,629 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Sprite_pool implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite_pool.h"
+
+#include "Common/Simd.h"
+
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Vertex_format colored_format         = Vertex_format(position | diffuse_color);
+const Vertex_format textured_format        = Vertex_format(position | diffuse_color | texture_coord0);
+const Vertex_format multitextured_2_format = Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1);
+
+typedef Device_vertex<colored_format>          Colored_device_vertex;
+typedef Device_vertex<textured_format>         Textured_device_vertex;
+typedef Device_vertex<multitextured_2_format>  Multitextured_2_device_vertex;
+
+/// Position of each sprite corner in triangle strip; corners 2 and 3 are swapped (see convert_sprites()).
+const uint strip_positions[4] = { 0, 1, 3, 2 };
+
+inline uint pack_color(const Diffuse_color& c);
+inline Diffuse_color unpack_color(uint c);
+inline uchar tint_channel(uint value, uint factor);
+template <class T>
+inline void move_last(std::vector<T>& v, uint index, uint count);
+template <Vertex_format format>
+inline bool same_state(const Sprite_pool<format>& pool, uint lhs, uint rhs);
+template <Vertex_format format>
+inline void convert_quad(const Sprite_pool<format>& pool, uint index, const float* const tus[], const float* const tvs[],
+                         Device_vertex<format>* where);
+inline void store_texture_coords(uint vertex, const float* const tus[], const float* const tvs[],
+                                 Colored_device_vertex& where);
+inline void store_texture_coords(uint vertex, const float* const tus[], const float* const tvs[],
+                                 Textured_device_vertex& where);
+inline void store_texture_coords(uint vertex, const float* const tus[], const float* const tvs[],
+                                 Multitextured_2_device_vertex& where);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+uint Sprite_pool<format>::add(const Sprite_type& s)
+{
+   const uint index = get_size();
+
+   m_xs.resize(m_xs.size() + 4);
+   m_ys.resize(m_ys.size() + 4);
+   m_zs.resize(m_zs.size() + 4);
+   m_colors.resize(m_colors.size() + 4);
+   for (uint stage = 0; stage < stages_number; ++stage)
+   {
+      m_tus[stage].resize(m_tus[stage].size() + 4);
+      m_tvs[stage].resize(m_tvs[stage].size() + 4);
+      m_textures[stage].push_back(Texture_ID());
+      m_blendings[stage].push_back(blending_mode_disable);
+   }
+
+   set(index, s);
+   return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_pool<format>::set(uint index, const Sprite_type& s)
+{
+   assert(index < get_size() && "Invalid sprite index");
+
+   for (uint i = 0; i < 4; ++i)
+   {
+      m_xs[4*index + i]     = s.vertexes[i].position.x;
+      m_ys[4*index + i]     = s.vertexes[i].position.y;
+      m_zs[4*index + i]     = s.vertexes[i].position.z;
+      m_colors[4*index + i] = pack_color(s.vertexes[i].color);
+   }
+   set_stages(index, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+Sprite<format> Sprite_pool<format>::get(uint index) const
+{
+   assert(index < get_size() && "Invalid sprite index");
+
+   Sprite_type s;
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].position.x = m_xs[4*index + i];
+      s.vertexes[i].position.y = m_ys[4*index + i];
+      s.vertexes[i].position.z = m_zs[4*index + i];
+      s.vertexes[i].color      = unpack_color(m_colors[4*index + i]);
+   }
+   get_stages(index, s);
+   return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_pool<format>::remove(uint index)
+{
+   assert(index < get_size() && "Invalid sprite index");
+
+   move_last(m_xs, index, 4);
+   move_last(m_ys, index, 4);
+   move_last(m_zs, index, 4);
+   move_last(m_colors, index, 4);
+   for (uint stage = 0; stage < stages_number; ++stage)
+   {
+      move_last(m_tus[stage], index, 4);
+      move_last(m_tvs[stage], index, 4);
+      move_last(m_textures[stage], index, 1);
+      move_last(m_blendings[stage], index, 1);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_pool<format>::clear()
+{
+   m_xs.clear();
+   m_ys.clear();
+   m_zs.clear();
+   m_colors.clear();
+   for (uint stage = 0; stage < stages_number; ++stage)
+   {
+      m_tus[stage].clear();
+      m_tvs[stage].clear();
+      m_textures[stage].clear();
+      m_blendings[stage].clear();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_pool<format>::reserve(uint sprites_number)
+{
+   m_xs.reserve(4*sprites_number);
+   m_ys.reserve(4*sprites_number);
+   m_zs.reserve(4*sprites_number);
+   m_colors.reserve(4*sprites_number);
+   for (uint stage = 0; stage < stages_number; ++stage)
+   {
+      m_tus[stage].reserve(4*sprites_number);
+      m_tvs[stage].reserve(4*sprites_number);
+      m_textures[stage].reserve(sprites_number);
+      m_blendings[stage].reserve(sprites_number);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Per-vertex arrays have 4 elements per sprite, so SSE2 loops below process whole registers without tails.
+
+template <Vertex_format format>
+void Sprite_pool<format>::translate(float dx, float dy)
+{
+   const uint n = 4*get_size();
+#ifdef COMMON_SSE2
+   const __m128 vdx = _mm_set1_ps(dx);
+   const __m128 vdy = _mm_set1_ps(dy);
+   for (uint i = 0; i < n; i += 4)
+   {
+      _mm_storeu_ps(&m_xs[i], _mm_add_ps(_mm_loadu_ps(&m_xs[i]), vdx));
+      _mm_storeu_ps(&m_ys[i], _mm_add_ps(_mm_loadu_ps(&m_ys[i]), vdy));
+   }
+#else
+   for (uint i = 0; i < n; ++i)
+   {
+      m_xs[i] += dx;
+      m_ys[i] += dy;
+   }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_pool<format>::translate(const float* dxs, const float* dys)
+{
+   const uint n = get_size();
+#ifdef COMMON_SSE2
+   for (uint i = 0; i < n; ++i)
+   {
+      _mm_storeu_ps(&m_xs[4*i], _mm_add_ps(_mm_loadu_ps(&m_xs[4*i]), _mm_set1_ps(dxs[i])));
+      _mm_storeu_ps(&m_ys[4*i], _mm_add_ps(_mm_loadu_ps(&m_ys[4*i]), _mm_set1_ps(dys[i])));
+   }
+#else
+   for (uint i = 0; i < n; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         m_xs[4*i + j] += dxs[i];
+         m_ys[4*i + j] += dys[i];
+      }
+   }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_pool<format>::scale(float center_x, float center_y, float sx, float sy)
+{
+   const uint n = 4*get_size();
+#ifdef COMMON_SSE2
+   const __m128 cx  = _mm_set1_ps(center_x);
+   const __m128 cy  = _mm_set1_ps(center_y);
+   const __m128 vsx = _mm_set1_ps(sx);
+   const __m128 vsy = _mm_set1_ps(sy);
+   for (uint i = 0; i < n; i += 4)
+   {
+      _mm_storeu_ps(&m_xs[i], _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_xs[i]), cx), vsx), cx));
+      _mm_storeu_ps(&m_ys[i], _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_ys[i]), cy), vsy), cy));
+   }
+#else
+   for (uint i = 0; i < n; ++i)
+   {
+      m_xs[i] = (m_xs[i] - center_x)*sx + center_x;
+      m_ys[i] = (m_ys[i] - center_y)*sy + center_y;
+   }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void Sprite_pool<format>::tint(const Diffuse_color& color)
+{
+   const uint n = 4*get_size();
+#ifdef COMMON_SSE2
+   // 0xAARRGGBB is stored as b, g, r, a bytes; two colors per register after widening to 16 bits
+   const __m128i zero    = _mm_setzero_si128();
+   const __m128i half    = _mm_set1_epi16(128);
+   const __m128i factors = _mm_set_epi16(color.a, color.r, color.g, color.b, color.a, color.r, color.g, color.b);
+   for (uint i = 0; i < n; i += 4)
+   {
+      __m128i* const where = reinterpret_cast<__m128i*>(&m_colors[i]);
+      const __m128i colors = _mm_loadu_si128(where);
+
+      // t = c*f + 128; c*f/255 rounded is (t + t/256)/256
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(colors, zero), factors), half);
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(colors, zero), factors), half);
+      lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+      hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+      _mm_storeu_si128(where, _mm_packus_epi16(lo, hi));
+   }
+#else
+   for (uint i = 0; i < n; ++i)
+   {
+      const uint c = m_colors[i];
+      m_colors[i] = (uint(tint_channel(c >> 24, color.a)) << 24) | (uint(tint_channel(c >> 16, color.r)) << 16)
+                  | (uint(tint_channel(c >> 8, color.g)) << 8)   | uint(tint_channel(c, color.b));
+   }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+const float* Sprite_pool<format>::get_tus(uint stage) const
+{
+   assert(stage < stages_number && "Invalid texture stage");
+   return m_tus[stage].empty() ? 0 : &m_tus[stage][0];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+const float* Sprite_pool<format>::get_tvs(uint stage) const
+{
+   assert(stage < stages_number && "Invalid texture stage");
+   return m_tvs[stage].empty() ? 0 : &m_tvs[stage][0];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+const Texture_ID& Sprite_pool<format>::get_texture(uint index, uint stage) const
+{
+   assert(stage < stages_number && "Invalid texture stage");
+   return m_textures[stage][index];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+Blending_mode Sprite_pool<format>::get_blending(uint index, uint stage) const
+{
+   assert(stage < stages_number && "Invalid texture stage");
+   return m_blendings[stage][index];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <>
+void Sprite_pool<colored_format>::set_stages(uint, const Colored_sprite&)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <>
+void Sprite_pool<colored_format>::get_stages(uint, Colored_sprite&) const
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <>
+void Sprite_pool<textured_format>::set_stages(uint index, const Textured_sprite& s)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      m_tus[0][4*index + i] = s.vertexes[i].texture_coord.tu;
+      m_tvs[0][4*index + i] = s.vertexes[i].texture_coord.tv;
+   }
+   m_textures[0][index]  = s.texture;
+   m_blendings[0][index] = s.blending;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <>
+void Sprite_pool<textured_format>::get_stages(uint index, Textured_sprite& s) const
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].texture_coord.tu = m_tus[0][4*index + i];
+      s.vertexes[i].texture_coord.tv = m_tvs[0][4*index + i];
+   }
+   s.texture  = m_textures[0][index];
+   s.blending = m_blendings[0][index];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <>
+void Sprite_pool<multitextured_2_format>::set_stages(uint index, const Multitextured_2_sprite& s)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      m_tus[0][4*index + i] = s.vertexes[i].texture_coord0.tu;
+      m_tvs[0][4*index + i] = s.vertexes[i].texture_coord0.tv;
+      m_tus[1][4*index + i] = s.vertexes[i].texture_coord1.tu;
+      m_tvs[1][4*index + i] = s.vertexes[i].texture_coord1.tv;
+   }
+   m_textures[0][index]  = s.texture0;
+   m_blendings[0][index] = s.blending0;
+   m_textures[1][index]  = s.texture1;
+   m_blendings[1][index] = s.blending1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <>
+void Sprite_pool<multitextured_2_format>::get_stages(uint index, Multitextured_2_sprite& s) const
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].texture_coord0.tu = m_tus[0][4*index + i];
+      s.vertexes[i].texture_coord0.tv = m_tvs[0][4*index + i];
+      s.vertexes[i].texture_coord1.tu = m_tus[1][4*index + i];
+      s.vertexes[i].texture_coord1.tv = m_tvs[1][4*index + i];
+   }
+   s.texture0  = m_textures[0][index];
+   s.blending0 = m_blendings[0][index];
+   s.texture1  = m_textures[1][index];
+   s.blending1 = m_blendings[1][index];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void convert_sprites(const Sprite_pool<format>& pool, uint first, uint n, Device_vertex<format>* where)
+{
+   assert(first + n <= pool.get_size() && "Sprites out of pool");
+
+   const float* tus[batch_stages_number] = { 0, 0 };
+   const float* tvs[batch_stages_number] = { 0, 0 };
+   for (uint stage = 0; stage < Sprite_pool<format>::stages_number; ++stage)
+   {
+      tus[stage] = pool.get_tus(stage);
+      tvs[stage] = pool.get_tvs(stage);
+   }
+
+   for (uint i = 0; i < n; ++i)
+   {
+      convert_quad(pool, first + i, tus, tvs, where + 4*i);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void compile_batches(const Sprite_pool<format>& pool, Batch_list& batches)
+{
+   const uint n = pool.get_size();
+   for (uint i = 0; i < n; )
+   {
+      // extend run while state remains the same
+      uint end = i + 1;
+      while (end < n && same_state(pool, i, end))
+      {
+         ++end;
+      }
+
+      Render_batch batch = make_batch(format, i);
+      batch.count = end - i;
+      for (uint stage = 0; stage < Sprite_pool<format>::stages_number; ++stage)
+      {
+         batch.textures[stage]  = pool.get_texture(i, stage);
+         batch.blendings[stage] = pool.get_blending(i, stage);
+      }
+      batches.push_back(batch);
+
+      i = end;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Stream device that takes vertexes from pool and passes the rest to another device.
+template <Vertex_format format>
+class Pool_stream_device : public Stream_device
+{
+public:
+
+   Pool_stream_device(const Sprite_pool<format>& pool, Stream_device& target) : m_pool(pool), m_target(target) { }
+
+   virtual void set_vertex_format(Vertex_format f)              { m_target.set_vertex_format(f); }
+   virtual void set_texture(uint nstage, const Texture_ID& id)  { m_target.set_texture(nstage, id); }
+   virtual void set_blending(uint nstage, Blending_mode mode)   { m_target.set_blending(nstage, mode); }
+   virtual void draw_quads(uint first_quad, uint nquads)        { m_target.draw_quads(first_quad, nquads); }
+   virtual uint get_quad_bytes(Vertex_format f) const           { return m_target.get_quad_bytes(f); }
+   virtual void set_vertex_offset(uint offset)                  { m_target.set_vertex_offset(offset); }
+
+   virtual void write_quads(Vertex_format, uint first, uint nquads, void* where)
+   {
+      convert_sprites(m_pool, first, nquads, static_cast<Device_vertex<format>*>(where));
+   }
+
+private:
+
+   const Sprite_pool<format>& m_pool;
+   Stream_device&             m_target;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void stream_pool(const Sprite_pool<format>& pool, Vertex_ring& ring, Stream_device& device, Batch_list& batches)
+{
+   batches.clear();
+   compile_batches(pool, batches);
+
+   Pool_stream_device<format> pool_device(pool, device);
+   stream_batches(batches, ring, pool_device);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Color as 0xAARRGGBB.
+inline uint pack_color(const Diffuse_color& c)
+{
+   return (uint(c.a) << 24) | (uint(c.r) << 16) | (uint(c.g) << 8) | uint(c.b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline Diffuse_color unpack_color(uint c)
+{
+   Diffuse_color result;
+   result.a = uchar(c >> 24);
+   result.r = uchar(c >> 16);
+   result.g = uchar(c >> 8);
+   result.b = uchar(c);
+   return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return value*factor/255 rounded to nearest, for the lowest byte of value.
+inline uchar tint_channel(uint value, uint factor)
+{
+   const uint t = (value & 0xFF)*factor + 128;
+   return uchar((t + (t >> 8)) >> 8);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Replaces group of count elements at given index with the last group and drops the last group.
+template <class T>
+inline void move_last(std::vector<T>& v, uint index, uint count)
+{
+   const size_t last = v.size() - count;
+   for (uint i = 0; i < count; ++i)
+   {
+      v[count*index + i] = v[last + i];
+   }
+   v.resize(last);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+inline bool same_state(const Sprite_pool<format>& pool, uint lhs, uint rhs)
+{
+   for (uint stage = 0; stage < Sprite_pool<format>::stages_number; ++stage)
+   {
+      if (!(pool.get_texture(lhs, stage) == pool.get_texture(rhs, stage))
+          || pool.get_blending(lhs, stage) != pool.get_blending(rhs, stage))
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Writes 4 vertexes of sprite in strip order.
+template <Vertex_format format>
+inline void convert_quad(const Sprite_pool<format>& pool, uint index, const float* const tus[], const float* const tvs[],
+                         Device_vertex<format>* where)
+{
+   const uint first = 4*index;
+
+#ifdef COMMON_SSE2
+   // x, y, z and w of 4 corners are transposed into 4 corners of x, y, z, w
+   __m128 p0 = _mm_loadu_ps(pool.get_xs() + first);
+   __m128 p1 = _mm_loadu_ps(pool.get_ys() + first);
+   __m128 p2 = _mm_loadu_ps(pool.get_zs() + first);
+   __m128 p3 = _mm_set1_ps(1);
+   _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+   _mm_storeu_ps(&where[strip_positions[0]].x, p0);
+   _mm_storeu_ps(&where[strip_positions[1]].x, p1);
+   _mm_storeu_ps(&where[strip_positions[2]].x, p2);
+   _mm_storeu_ps(&where[strip_positions[3]].x, p3);
+#else
+   for (uint i = 0; i < 4; ++i)
+   {
+      Device_vertex<format>& v = where[strip_positions[i]];
+      v.x = pool.get_xs()[first + i];
+      v.y = pool.get_ys()[first + i];
+      v.z = pool.get_zs()[first + i];
+      v.w = 1;
+   }
+#endif
+
+   for (uint i = 0; i < 4; ++i)
+   {
+      Device_vertex<format>& v = where[strip_positions[i]];
+      v.color = pool.get_colors()[first + i];
+      store_texture_coords(first + i, tus, tvs, v);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void store_texture_coords(uint, const float* const[], const float* const[], Colored_device_vertex&)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void store_texture_coords(uint vertex, const float* const tus[], const float* const tvs[],
+                                 Textured_device_vertex& where)
+{
+   where.tu = tus[0][vertex];
+   where.tv = tvs[0][vertex];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void store_texture_coords(uint vertex, const float* const tus[], const float* const tvs[],
+                                 Multitextured_2_device_vertex& where)
+{
+   where.tu0 = tus[0][vertex];
+   where.tv0 = tvs[0][vertex];
+   where.tu1 = tus[1][vertex];
+   where.tv1 = tvs[1][vertex];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template class Sprite_pool<colored_format>;
+template class Sprite_pool<textured_format>;
+template class Sprite_pool<multitextured_2_format>;
+
+template void convert_sprites(const Sprite_pool<colored_format>&, uint, uint, Colored_device_vertex*);
+template void convert_sprites(const Sprite_pool<textured_format>&, uint, uint, Textured_device_vertex*);
+template void convert_sprites(const Sprite_pool<multitextured_2_format>&, uint, uint, Multitextured_2_device_vertex*);
+
+template void compile_batches(const Sprite_pool<colored_format>&, Batch_list&);
+template void compile_batches(const Sprite_pool<textured_format>&, Batch_list&);
+template void compile_batches(const Sprite_pool<multitextured_2_format>&, Batch_list&);
+
+template void stream_pool(const Sprite_pool<colored_format>&, Vertex_ring&, Stream_device&, Batch_list&);
+template void stream_pool(const Sprite_pool<textured_format>&, Vertex_ring&, Stream_device&, Batch_list&);
+template void stream_pool(const Sprite_pool<multitextured_2_format>&, Vertex_ring&, Stream_device&, Batch_list&);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
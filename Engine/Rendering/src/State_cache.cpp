@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// State cache implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/State_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+bool is_changed(bool& is_known, T& current, T value);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+State_cache::State_cache(State_device& device)
+   : m_device(device)
+{
+   invalidate();
+   reset_statistics();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void State_cache::set_texture(uint nstage, const void* texture)
+{
+   if (nstage < state_cache_stages && !is_changed(m_is_texture_known[nstage], m_textures[nstage], texture))
+   {
+      ++m_statistics.filtered;
+      return;
+   }
+
+   ++m_statistics.issued;
+   m_device.set_texture(nstage, texture);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void State_cache::set_texture_stage_state(uint nstage, uint type, uint value)
+{
+   if (nstage < state_cache_stages && type < state_cache_stage_states
+       && !is_changed(m_is_stage_state_known[nstage][type], m_stage_states[nstage][type], value))
+   {
+      ++m_statistics.filtered;
+      return;
+   }
+
+   ++m_statistics.issued;
+   m_device.set_texture_stage_state(nstage, type, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void State_cache::set_vertex_format(uint format)
+{
+   if (!is_changed(m_is_format_known, m_format, format))
+   {
+      ++m_statistics.filtered;
+      return;
+   }
+
+   ++m_statistics.issued;
+   m_device.set_vertex_format(format);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void State_cache::set_stream_source(const void* buffer, uint offset, uint vertex_bytes)
+{
+   if (m_is_stream_known && m_stream_buffer == buffer && m_stream_offset == offset
+       && m_stream_vertex_bytes == vertex_bytes)
+   {
+      ++m_statistics.filtered;
+      return;
+   }
+
+   ++m_statistics.issued;
+   m_is_stream_known     = true;
+   m_stream_buffer       = buffer;
+   m_stream_offset       = offset;
+   m_stream_vertex_bytes = vertex_bytes;
+   m_device.set_stream_source(buffer, offset, vertex_bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void State_cache::invalidate()
+{
+   for (uint nstage = 0; nstage < state_cache_stages; ++nstage)
+   {
+      m_is_texture_known[nstage] = false;
+      for (uint type = 0; type < state_cache_stage_states; ++type)
+      {
+         m_is_stage_state_known[nstage][type] = false;
+      }
+   }
+   m_is_format_known = false;
+   m_is_stream_known = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void State_cache::reset_statistics()
+{
+   m_statistics.issued   = 0;
+   m_statistics.filtered = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Remembers value as current one.
+/// \return Whether value differs from current one or current one is unknown.
+template <class T>
+bool is_changed(bool& is_known, T& current, T value)
+{
+   if (is_known && current == value)
+   {
+      return false;
+   }
+
+   is_known = true;
+   current = value;
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
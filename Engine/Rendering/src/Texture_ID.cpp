@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Texture names interning.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Texture_ID.h"
+
+#include <map>
+#include <deque>
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Interned names: handle is index in names table.
+struct Texture_names
+{
+   // deque doesn't move names on growth, so references given out remain valid
+   std::deque<std::string>     names;
+   std::map<std::string, uint> handles;
+
+   Texture_names()
+   {
+      // empty name has handle 0, so default Texture_ID is empty one
+      names.push_back(std::string());
+      handles[std::string()] = 0;
+   }
+};
+
+/// Table is created on first use: Texture_IDs could be constructed during static initialization.
+Texture_names& get_texture_names()
+{
+   static Texture_names table;
+   return table;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint Texture_registry::intern(const std::string& file_name)
+{
+   Texture_names& table = get_texture_names();
+
+   std::map<std::string, uint>::const_iterator it = table.handles.find(file_name);
+   if (it != table.handles.end())
+   {
+      return it->second;
+   }
+
+   const uint handle = static_cast<uint>(table.names.size());
+   table.names.push_back(file_name);
+   table.handles.insert(std::make_pair(file_name, handle));
+   return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::string& Texture_registry::get_file_name(uint handle)
+{
+   Texture_names& table = get_texture_names();
+   assert(handle < table.names.size() && "Unknown texture handle");
+   return table.names[handle];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint Texture_registry::get_size()
+{
+   return static_cast<uint>(get_texture_names().names.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,442 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Texture_atlas implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Texture_atlas.h"
+#include "Engine/Rendering/Bmp.h"
+
+#include "Engine/Rendering/Logging.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// First line of atlas description.
+const char* const atlas_signature = "atlas";
+const uint        atlas_version   = 1;
+
+/// Texels around each texture copied from its edges.
+const uint atlas_border = 1;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void copy_with_border(const Image& source, Image& page, uint x, uint y);
+bool is_in_unit_square(const Texture_coord& coord);
+void remap_coord(Texture_coord& coord, const Atlas_region& region);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Skyline_packer::Skyline_packer(uint width, uint height)
+   : m_width(width)
+   , m_height(height)
+{
+   const Segment ground = { 0, 0, width };
+   m_skyline.push_back(ground);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Skyline_packer::insert(uint width, uint height, uint& x, uint& y)
+{
+   assert(width > 0 && height > 0 && "Empty rectangle");
+
+   // the lowest top; the leftmost one among equal
+   size_t best = m_skyline.size();
+   uint best_y = 0;
+   for (size_t i = 0; i < m_skyline.size(); ++i)
+   {
+      uint top;
+      if (fit(i, width, height, top) && (best == m_skyline.size() || top < best_y))
+      {
+         best   = i;
+         best_y = top;
+      }
+   }
+   if (best == m_skyline.size())
+   {
+      return false;
+   }
+
+   x = m_skyline[best].x;
+   y = best_y;
+
+   // new segment covers segments under rectangle
+   const Segment roof = { x, y + height, width };
+   m_skyline.insert(m_skyline.begin() + best, roof);
+   for (size_t i = best + 1; i < m_skyline.size() && m_skyline[i].x < x + width; )
+   {
+      const uint covered = x + width - m_skyline[i].x;
+      if (covered < m_skyline[i].width)
+      {
+         m_skyline[i].x     += covered;
+         m_skyline[i].width -= covered;
+         break;
+      }
+      m_skyline.erase(m_skyline.begin() + i);
+   }
+
+   // neighbours of the same height become one segment
+   for (size_t i = 1; i < m_skyline.size(); )
+   {
+      if (m_skyline[i - 1].y == m_skyline[i].y)
+      {
+         m_skyline[i - 1].width += m_skyline[i].width;
+         m_skyline.erase(m_skyline.begin() + i);
+      }
+      else
+      {
+         ++i;
+      }
+   }
+
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Skyline_packer::fit(size_t nsegment, uint width, uint height, uint& y) const
+{
+   if (m_skyline[nsegment].x + width > m_width)
+   {
+      return false;
+   }
+
+   // rectangle lies on the highest of segments under it
+   y = 0;
+   uint remaining = width;
+   for (size_t i = nsegment; remaining > 0; ++i)
+   {
+      y = std::max(y, m_skyline[i].y);
+      if (y + height > m_height)
+      {
+         return false;
+      }
+      remaining -= std::min(remaining, m_skyline[i].width);
+   }
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_atlas::add(const Texture_ID& id, const Image& image)
+{
+   assert(id != Texture_ID() && "Empty texture can't be in atlas");
+
+   const Source source = { id, image };
+   m_sources.push_back(source);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_atlas::pack(uint page_size, const std::string& name)
+{
+   // tall textures go first, so rows of skyline stay even
+   std::vector<const Source*> order;
+   for (size_t i = 0; i < m_sources.size(); ++i)
+   {
+      order.push_back(&m_sources[i]);
+   }
+   std::stable_sort(order.begin(), order.end(), is_taller);
+
+   std::vector<Skyline_packer> packers;
+   const size_t first_page = m_pages.size();
+   for (size_t i = 0; i < order.size(); ++i)
+   {
+      const Source& source = *order[i];
+      const uint width  = source.image.width + 2*atlas_border;
+      const uint height = source.image.height + 2*atlas_border;
+      if (source.image.pixels.empty() || width > page_size || height > page_size)
+      {
+         LOG_RENDERER(Logging::minor) << "Texture \"" << source.id.get_file_name() << "\" of "
+                                      << source.image.width << "x" << source.image.height
+                                      << " doesn't fit into atlas page of " << page_size << "; skipped";
+         continue;
+      }
+
+      uint x = 0;
+      uint y = 0;
+      size_t npage = 0;
+      while (npage < packers.size() && !packers[npage].insert(width, height, x, y))
+      {
+         ++npage;
+      }
+      if (npage == packers.size())
+      {
+         packers.push_back(Skyline_packer(page_size, page_size));
+         packers.back().insert(width, height, x, y);
+
+         std::ostringstream page_name;
+         page_name << name << "_" << m_pages.size() << ".bmp";
+         m_pages.push_back(Image(page_size, page_size));
+         m_page_ids.push_back(Texture_ID(page_name.str()));
+      }
+
+      copy_with_border(source.image, m_pages[first_page + npage], x, y);
+
+      const Placement placement = { source.id, static_cast<uint>(first_page + npage), x + atlas_border,
+                                    y + atlas_border, source.image.width, source.image.height };
+      m_placements.push_back(placement);
+      place(placement, page_size, page_size);
+   }
+
+   LOG_RENDERER(Logging::major) << "Packed " << m_sources.size() << " textures into " << packers.size()
+                                << " atlas pages of " << page_size << "x" << page_size;
+   m_sources.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_atlas::save(const std::string& description_file) const
+{
+   assert(m_pages.size() == m_page_ids.size() && "Pages of loaded atlas can't be saved");
+
+   std::ofstream file(description_file.c_str());
+   file << atlas_signature << " " << atlas_version << "\n" << m_pages.size() << "\n";
+   for (size_t i = 0; i < m_pages.size(); ++i)
+   {
+      save_bmp(m_pages[i], m_page_ids[i].get_file_name());
+      file << m_page_ids[i].get_file_name() << " " << m_pages[i].width << " " << m_pages[i].height << "\n";
+   }
+
+   file << m_placements.size() << "\n";
+   for (size_t i = 0; i < m_placements.size(); ++i)
+   {
+      const Placement& p = m_placements[i];
+      file << p.id.get_file_name() << " " << p.page << " " << p.x << " " << p.y << " " << p.width << " "
+           << p.height << "\n";
+   }
+
+   if (!file)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't write \"" << description_file << "\"; throw !!!";
+      throw Atlas_exception("Can't write atlas description " + description_file);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_atlas::load(const std::string& description_file)
+{
+   std::ifstream file(description_file.c_str());
+   if (!file)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Can't open \"" << description_file << "\"; throw !!!";
+      throw Atlas_exception("Can't open atlas description " + description_file);
+   }
+
+   std::string signature;
+   uint version = 0;
+   if (!(file >> signature >> version) || signature != atlas_signature || version != atlas_version)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! \"" << description_file << "\" isn't atlas description of version "
+                                      << atlas_version << "; throw !!!";
+      throw Atlas_exception("Not an atlas description " + description_file);
+   }
+
+   m_sources.clear();
+   m_pages.clear();
+   m_page_ids.clear();
+   m_placements.clear();
+   m_regions.clear();
+
+   std::vector<uint> widths;
+   std::vector<uint> heights;
+   size_t pages_number = 0;
+   file >> pages_number;
+   for (size_t i = 0; i < pages_number && file; ++i)
+   {
+      std::string page;
+      uint width  = 0;
+      uint height = 0;
+      file >> page >> width >> height;
+      m_page_ids.push_back(Texture_ID(page));
+      widths.push_back(width);
+      heights.push_back(height);
+   }
+
+   size_t placements_number = 0;
+   file >> placements_number;
+   for (size_t i = 0; i < placements_number && file; ++i)
+   {
+      std::string texture;
+      Placement p;
+      file >> texture >> p.page >> p.x >> p.y >> p.width >> p.height;
+      if (file && (p.page >= m_page_ids.size() || p.x + p.width > widths[p.page] || p.y + p.height > heights[p.page]))
+      {
+         file.setstate(std::ios::failbit);
+      }
+      if (file)
+      {
+         p.id = Texture_ID(texture);
+         m_placements.push_back(p);
+         place(p, widths[p.page], heights[p.page]);
+      }
+   }
+
+   if (!file)
+   {
+      LOG_RENDERER(Logging::critical) << "!!! Atlas description \"" << description_file << "\" is broken; throw !!!";
+      throw Atlas_exception("Broken atlas description " + description_file);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Texture_atlas::find(const Texture_ID& id, Atlas_region& region) const
+{
+   if (id.get_handle() >= m_regions.size() || m_regions[id.get_handle()].page == Texture_ID())
+   {
+      return false;
+   }
+   region = m_regions[id.get_handle()];
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Texture_atlas::remap(Textured_sprite& s) const
+{
+   Atlas_region region;
+   if (!find(s.texture, region))
+   {
+      return false;
+   }
+   for (uint i = 0; i < 4; ++i)
+   {
+      if (!is_in_unit_square(s.vertexes[i].texture_coord))
+      {
+         return false;
+      }
+   }
+
+   s.texture = region.page;
+   for (uint i = 0; i < 4; ++i)
+   {
+      remap_coord(s.vertexes[i].texture_coord, region);
+   }
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Texture_atlas::remap(Multitextured_2_sprite& s) const
+{
+   Atlas_region region0 = Atlas_region();
+   Atlas_region region1 = Atlas_region();
+   bool remap0 = find(s.texture0, region0);
+   bool remap1 = find(s.texture1, region1);
+   for (uint i = 0; i < 4; ++i)
+   {
+      remap0 = remap0 && is_in_unit_square(s.vertexes[i].texture_coord0);
+      remap1 = remap1 && is_in_unit_square(s.vertexes[i].texture_coord1);
+   }
+
+   if (remap0)
+   {
+      s.texture0 = region0.page;
+      for (uint i = 0; i < 4; ++i)
+      {
+         remap_coord(s.vertexes[i].texture_coord0, region0);
+      }
+   }
+   if (remap1)
+   {
+      s.texture1 = region1.page;
+      for (uint i = 0; i < 4; ++i)
+      {
+         remap_coord(s.vertexes[i].texture_coord1, region1);
+      }
+   }
+   return remap0 || remap1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint Texture_atlas::get_size() const
+{
+   return static_cast<uint>(m_placements.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_atlas::place(const Placement& placement, uint page_width, uint page_height)
+{
+   if (placement.id.get_handle() >= m_regions.size())
+   {
+      const Atlas_region none = { Texture_ID(), 0, 0, 0, 0 };
+      m_regions.resize(Texture_registry::get_size(), none);
+   }
+
+   Atlas_region& region = m_regions[placement.id.get_handle()];
+   region.page = m_page_ids[placement.page];
+   region.u0   = float(placement.x) / page_width;
+   region.v0   = float(placement.y) / page_height;
+   region.u1   = float(placement.x + placement.width) / page_width;
+   region.v1   = float(placement.y + placement.height) / page_height;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Texture_atlas::is_taller(const Source* lhs, const Source* rhs)
+{
+   return lhs->image.height > rhs->image.height;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Copies image to page at given position of its border; border repeats edge texels.
+void copy_with_border(const Image& source, Image& page, uint x, uint y)
+{
+   const uint width  = source.width + 2*atlas_border;
+   const uint height = source.height + 2*atlas_border;
+   for (uint row = 0; row < height; ++row)
+   {
+      const uint source_row = std::min(source.height - 1, row < atlas_border ? 0 : row - atlas_border);
+      const uint* from = &source.pixels[source_row*source.width];
+      uint* to = &page.pixels[(y + row)*page.width + x];
+
+      std::fill(to, to + atlas_border, from[0]);
+      std::copy(from, from + source.width, to + atlas_border);
+      std::fill(to + atlas_border + source.width, to + width, from[source.width - 1]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool is_in_unit_square(const Texture_coord& coord)
+{
+   return coord.tu >= 0 && coord.tu <= 1 && coord.tv >= 0 && coord.tv <= 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void remap_coord(Texture_coord& coord, const Atlas_region& region)
+{
+   coord.tu = region.u0 + coord.tu*(region.u1 - region.u0);
+   coord.tv = region.v0 + coord.tv*(region.v1 - region.v0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
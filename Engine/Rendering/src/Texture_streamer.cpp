@@ -0,0 +1,250 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Texture_streamer implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Texture_streamer.h"
+
+#include "Engine/Rendering/Bmp.h"
+#include "Engine/Rendering/Dds.h"
+
+#include "boost/bind.hpp"
+
+#include <cassert>
+#include <exception>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Texture_streamer::Texture_streamer(uint threads, Dds_mode dds_mode)
+   : m_dds_mode(dds_mode)
+   , m_pending_number(0)
+   , m_busy(0)
+   , m_stopping(false)
+{
+   start(threads);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Texture_streamer::Texture_streamer(uint threads, Decoder decoder)
+   : m_decoder(decoder)
+   , m_dds_mode(dds_decompressed)
+   , m_pending_number(0)
+   , m_busy(0)
+   , m_stopping(false)
+{
+   start(threads);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Texture_streamer::~Texture_streamer()
+{
+   {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_stopping = true;
+      m_requests.clear();
+      m_prefetches.clear();
+   }
+   m_job_queued.notify_all();
+   m_threads.join_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::request(const Texture_ID& id)
+{
+   if (!is_pending(id))
+   {
+      queue(id, pending_requested, m_requests);
+      return;
+   }
+
+   // renderer requests pending image on each draw, so image is searched for once
+   uchar& state = m_pending[id.get_handle()];
+   if (state == pending_requested)
+   {
+      return;
+   }
+   state = pending_requested;
+
+   // prefetched image is needed right now: move it ahead
+   boost::mutex::scoped_lock lock(m_mutex);
+   for (Jobs::iterator i = m_prefetches.begin(); i != m_prefetches.end(); ++i)
+   {
+      if (i->id == id)
+      {
+         m_requests.push_back(*i);
+         m_prefetches.erase(i);
+         return;
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::prefetch(const Texture_ID& id)
+{
+   if (!is_pending(id))
+   {
+      queue(id, pending_prefetched, m_prefetches);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::collect(std::vector<Streamed_image>& images)
+{
+   const size_t first = images.size();
+   {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (m_loaded.empty())
+      {
+         return;
+      }
+      images.insert(images.end(), m_loaded.begin(), m_loaded.end());
+      m_loaded.clear();
+   }
+
+   for (size_t i = first; i < images.size(); ++i)
+   {
+      m_pending[images[i].id.get_handle()] = not_pending;
+   }
+   m_pending_number -= images.size() - first;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::wait()
+{
+   boost::mutex::scoped_lock lock(m_mutex);
+   while (!m_requests.empty() || !m_prefetches.empty() || m_busy > 0)
+   {
+      m_job_done.wait(lock);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Texture_streamer::is_pending(const Texture_ID& id) const
+{
+   return id.get_handle() < m_pending.size() && m_pending[id.get_handle()] != not_pending;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::start(uint threads)
+{
+   assert(threads > 0);
+
+   for (uint i = 0; i < threads; ++i)
+   {
+      m_threads.create_thread(boost::bind(&Texture_streamer::work, this));
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::queue(const Texture_ID& id, Pending_state state, Jobs& jobs)
+{
+   assert(id != Texture_ID());
+
+   if (id.get_handle() >= m_pending.size())
+   {
+      m_pending.resize(Texture_registry::get_size(), not_pending);
+   }
+   m_pending[id.get_handle()] = static_cast<uchar>(state);
+   ++m_pending_number;
+
+   Job job;
+   job.id        = id;
+   job.file_name = id.get_file_name();
+   {
+      boost::mutex::scoped_lock lock(m_mutex);
+      jobs.push_back(job);
+   }
+   m_job_queued.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::work()
+{
+   boost::mutex::scoped_lock lock(m_mutex);
+   for (;;)
+   {
+      while (!m_stopping && m_requests.empty() && m_prefetches.empty())
+      {
+         m_job_queued.wait(lock);
+      }
+      if (m_stopping)
+      {
+         return;
+      }
+
+      Jobs& jobs = m_requests.empty() ? m_prefetches : m_requests;
+      const Job job = jobs.front();
+      jobs.pop_front();
+      ++m_busy;
+
+      Streamed_image loaded;
+      loaded.id = job.id;
+      lock.unlock();
+      try
+      {
+         load(job, loaded);
+      }
+      catch (const std::exception& ex)
+      {
+         loaded.error = ex.what();
+      }
+      lock.lock();
+
+      m_loaded.push_back(loaded);
+      --m_busy;
+      m_job_done.notify_all();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Texture_streamer::load(const Job& job, Streamed_image& loaded) const
+{
+   if (m_decoder)
+   {
+      loaded.image.reset(new Image(m_decoder(job.file_name)));
+   }
+   else if (!is_dds_file(job.file_name))
+   {
+      loaded.image.reset(new Image(load_bmp(job.file_name)));
+   }
+   else if (m_dds_mode == dds_compressed)
+   {
+      loaded.compressed.reset(new Compressed_image(load_dds(job.file_name)));
+   }
+   else
+   {
+      loaded.image.reset(new Image(decompress_image(load_dds(job.file_name))));
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
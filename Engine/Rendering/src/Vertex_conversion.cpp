@@ -0,0 +1,266 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Vertex conversion implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Vertex_conversion.h"
+
+#include "Common/Simd.h"
+
+#include "boost/static_assert.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef Vertex<Vertex_format(position | diffuse_color)>                                    Colored_vertex;
+typedef Vertex<Vertex_format(position | diffuse_color | texture_coord0)>                   Textured_vertex;
+typedef Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>  Multitextured_2_vertex;
+
+typedef Device_vertex<Vertex_format(position | diffuse_color)>                                   Colored_device_vertex;
+typedef Device_vertex<Vertex_format(position | diffuse_color | texture_coord0)>                  Textured_device_vertex;
+typedef Device_vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> Multitextured_2_device_vertex;
+
+// SSE2 code reads vertex as x, y, z, color followed by texture coordinates
+BOOST_STATIC_ASSERT(sizeof(Colored_vertex) == 16);
+BOOST_STATIC_ASSERT(sizeof(Textured_vertex) == 24);
+BOOST_STATIC_ASSERT(sizeof(Multitextured_2_vertex) == 32);
+BOOST_STATIC_ASSERT(sizeof(Colored_device_vertex) == 20);
+BOOST_STATIC_ASSERT(sizeof(Textured_device_vertex) == 28);
+BOOST_STATIC_ASSERT(sizeof(Multitextured_2_device_vertex) == 36);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Order of sprite corners in triangle strip.
+const uint strip_order[4] = { 0, 1, 3, 2 };
+
+inline uint pack_color(const Diffuse_color& c);
+inline void convert_quad(const Colored_sprite& s, Colored_device_vertex* where);
+inline void convert_quad(const Textured_sprite& s, Textured_device_vertex* where);
+inline void convert_quad(const Multitextured_2_sprite& s, Multitextured_2_device_vertex* where);
+
+#ifdef COMMON_SSE2
+inline __m128i pack_colors(__m128i colors);
+inline __m128i load_position_and_colors(const void* vertexes, uint stride, __m128i positions[4]);
+inline void store_vertex(const Textured_vertex& v, const __m128i& position, const __m128i& color,
+                         Textured_device_vertex& where);
+inline void store_vertex(const Multitextured_2_vertex& v, const __m128i& position, const __m128i& color,
+                         Multitextured_2_device_vertex& where);
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <Vertex_format format>
+void convert_sprites(const Sprite<format>* sprites, uint n, Device_vertex<format>* where)
+{
+   for (uint i = 0; i < n; ++i)
+   {
+      convert_quad(sprites[i], where + 4*i);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Color as 0xAARRGGBB.
+inline uint pack_color(const Diffuse_color& c)
+{
+   return (uint(c.a) << 24) | (uint(c.r) << 16) | (uint(c.g) << 8) | uint(c.b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef COMMON_SSE2
+
+/// Converts 4 colors laid out as a, r, g, b bytes into 0xAARRGGBB (i.e. reverses bytes of each lane).
+inline __m128i pack_colors(__m128i colors)
+{
+   colors = _mm_shufflehi_epi16(_mm_shufflelo_epi16(colors, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+   return _mm_or_si128(_mm_slli_epi16(colors, 8), _mm_srli_epi16(colors, 8));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Loads sprite corners in strip order (see strip_order).
+/// \param positions Receives x, y, z, 1 of each corner.
+/// \return Packed colors of corners.
+inline __m128i load_position_and_colors(const void* vertexes, uint stride, __m128i positions[4])
+{
+   const char* const bytes = static_cast<const char*>(vertexes);
+   const __m128i xyz = _mm_set_epi32(0, -1, -1, -1);
+   const __m128i w   = _mm_set_epi32(0x3F800000, 0, 0, 0);  // 1.0f
+
+   // unrolled by hand, otherwise compiler keeps registers in memory
+   const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+   const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + stride));
+   const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 3*stride));
+   const __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 2*stride));
+   positions[0] = _mm_or_si128(_mm_and_si128(v0, xyz), w);
+   positions[1] = _mm_or_si128(_mm_and_si128(v1, xyz), w);
+   positions[2] = _mm_or_si128(_mm_and_si128(v2, xyz), w);
+   positions[3] = _mm_or_si128(_mm_and_si128(v3, xyz), w);
+
+   // colors are in the last lane
+   return pack_colors(_mm_unpackhi_epi64(_mm_unpackhi_epi32(v0, v1), _mm_unpackhi_epi32(v2, v3)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// 4 vertexes are written as 5 whole registers.
+inline void convert_quad(const Colored_sprite& s, Colored_device_vertex* where)
+{
+   __m128i p[4];
+   const __m128i colors = load_position_and_colors(s.vertexes, sizeof(Colored_vertex), p);
+   const __m128i lane0 = _mm_set_epi32(0, 0, 0, -1);
+   const __m128i lane1 = _mm_set_epi32(0, 0, -1, 0);
+   const __m128i lane2 = _mm_set_epi32(0, -1, 0, 0);
+   const __m128i lane3 = _mm_set_epi32(-1, 0, 0, 0);
+
+   // x0 y0 z0 w0 | c0 x1 y1 z1 | w1 c1 x2 y2 | z2 w2 c2 x3 | y3 z3 w3 c3
+   __m128i* const out = reinterpret_cast<__m128i*>(where);
+   _mm_storeu_si128(out + 0, p[0]);
+   _mm_storeu_si128(out + 1, _mm_or_si128(_mm_slli_si128(p[1], 4), _mm_and_si128(colors, lane0)));
+   _mm_storeu_si128(out + 2, _mm_or_si128(_mm_or_si128(_mm_srli_si128(p[1], 12), _mm_slli_si128(p[2], 8)),
+                                          _mm_and_si128(colors, lane1)));
+   _mm_storeu_si128(out + 3, _mm_or_si128(_mm_or_si128(_mm_srli_si128(p[2], 8), _mm_slli_si128(p[3], 12)),
+                                          _mm_and_si128(colors, lane2)));
+   _mm_storeu_si128(out + 4, _mm_or_si128(_mm_srli_si128(p[3], 4), _mm_and_si128(colors, lane3)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void convert_quad(const Textured_sprite& s, Textured_device_vertex* where)
+{
+   __m128i p[4];
+   const __m128i colors = load_position_and_colors(s.vertexes, sizeof(Textured_vertex), p);
+   const __m128i lane1  = _mm_set_epi32(0, 0, -1, 0);
+
+   store_vertex(s.vertexes[0], p[0], _mm_and_si128(_mm_slli_si128(colors, 4), lane1), where[0]);
+   store_vertex(s.vertexes[1], p[1], _mm_and_si128(colors, lane1), where[1]);
+   store_vertex(s.vertexes[3], p[2], _mm_and_si128(_mm_srli_si128(colors, 4), lane1), where[2]);
+   store_vertex(s.vertexes[2], p[3], _mm_and_si128(_mm_srli_si128(colors, 8), lane1), where[3]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \param color Packed color in the second lane, other lanes are zero.
+inline void store_vertex(const Textured_vertex& v, const __m128i& position, const __m128i& color,
+                         Textured_device_vertex& where)
+{
+   const __m128i uv = _mm_set_epi32(-1, -1, 0, 0);
+   const __m128i w  = _mm_set_epi32(0, 0, 0, 0x3F800000);  // 1.0f
+
+   // z, color, tu, tv of source -> w, color, tu, tv; w is written twice, but stores stay within vertex
+   const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&v.position.z));
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(&where.x), position);
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(&where.w), _mm_or_si128(_mm_or_si128(_mm_and_si128(tail, uv), w), color));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void convert_quad(const Multitextured_2_sprite& s, Multitextured_2_device_vertex* where)
+{
+   __m128i p[4];
+   const __m128i colors = load_position_and_colors(s.vertexes, sizeof(Multitextured_2_vertex), p);
+   const __m128i lane0  = _mm_set_epi32(0, 0, 0, -1);
+
+   store_vertex(s.vertexes[0], p[0], _mm_and_si128(colors, lane0), where[0]);
+   store_vertex(s.vertexes[1], p[1], _mm_and_si128(_mm_srli_si128(colors, 4), lane0), where[1]);
+   store_vertex(s.vertexes[3], p[2], _mm_and_si128(_mm_srli_si128(colors, 8), lane0), where[2]);
+   store_vertex(s.vertexes[2], p[3], _mm_srli_si128(colors, 12), where[3]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \param color Packed color in the first lane, other lanes are zero.
+inline void store_vertex(const Multitextured_2_vertex& v, const __m128i& position, const __m128i& color,
+                         Multitextured_2_device_vertex& where)
+{
+   const __m128i texture_coords = _mm_set_epi32(-1, -1, -1, 0);
+
+   // color, tu0, tv0, tu1 of source; tu0, tv0, tu1 are written twice, but stores stay within vertex
+   const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&v.color));
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(&where.x), position);
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(&where.color), _mm_or_si128(_mm_and_si128(tail, texture_coords), color));
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(&where.tu0),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(&v.texture_coord0)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#else
+
+inline void convert_quad(const Colored_sprite& s, Colored_device_vertex* where)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      const Colored_vertex& v = s.vertexes[strip_order[i]];
+      where[i].x = v.position.x;
+      where[i].y = v.position.y;
+      where[i].z = v.position.z;
+      where[i].w = 1;
+      where[i].color = pack_color(v.color);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void convert_quad(const Textured_sprite& s, Textured_device_vertex* where)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      const Textured_vertex& v = s.vertexes[strip_order[i]];
+      where[i].x = v.position.x;
+      where[i].y = v.position.y;
+      where[i].z = v.position.z;
+      where[i].w = 1;
+      where[i].color = pack_color(v.color);
+      where[i].tu = v.texture_coord.tu;
+      where[i].tv = v.texture_coord.tv;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void convert_quad(const Multitextured_2_sprite& s, Multitextured_2_device_vertex* where)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      const Multitextured_2_vertex& v = s.vertexes[strip_order[i]];
+      where[i].x = v.position.x;
+      where[i].y = v.position.y;
+      where[i].z = v.position.z;
+      where[i].w = 1;
+      where[i].color = pack_color(v.color);
+      where[i].tu0 = v.texture_coord0.tu;
+      where[i].tv0 = v.texture_coord0.tv;
+      where[i].tu1 = v.texture_coord1.tu;
+      where[i].tv1 = v.texture_coord1.tv;
+   }
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template void convert_sprites(const Colored_sprite*, uint, Colored_device_vertex*);
+template void convert_sprites(const Textured_sprite*, uint, Textured_device_vertex*);
+template void convert_sprites(const Multitextured_2_sprite*, uint, Multitextured_2_device_vertex*);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Vertex ring implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Vertex_ring.h"
+
+#include "Engine/Rendering/Logging.h"
+
+#include <algorithm>            // for std::min
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Position in batch list: batch and number of its quads already streamed.
+struct Stream_cursor
+{
+   size_t batch;
+   uint   done;
+};
+
+bool next_piece(const Batch_list& batches, Stream_device& device, Stream_cursor& cursor, uint& space,
+                uint& nquads, uint& quad_bytes);
+uint plan_flush(const Batch_list& batches, Stream_device& device, Stream_cursor cursor, uint space,
+                Stream_cursor& end);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vertex_ring::Vertex_ring(Dynamic_vertex_buffer& buffer, uint capacity)
+   : m_buffer(buffer)
+   , m_capacity(capacity)
+   , m_head(capacity)
+   , m_frame_bytes(0)
+   , m_overflow_frames(0)
+   , m_overflow_peak(0)
+{
+   assert(capacity > 0 && "Empty vertex ring");
+
+   m_statistics.locks    = 0;
+   m_statistics.discards = 0;
+   m_statistics.growths  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Vertex_ring::end_frame()
+{
+   if (m_frame_bytes > m_capacity)
+   {
+      ++m_overflow_frames;
+      m_overflow_peak = std::max(m_overflow_peak, m_frame_bytes);
+   }
+   else
+   {
+      m_overflow_frames = 0;
+      m_overflow_peak   = 0;
+   }
+   m_frame_bytes = 0;
+
+   if (m_overflow_frames < vertex_ring_overflow_frames)
+   {
+      return;
+   }
+
+   uint capacity = m_capacity;
+   while (capacity < m_overflow_peak)
+   {
+      capacity *= 2;
+   }
+
+   LOG_RENDERER(Logging::major) << "Vertex buffer grows from " << m_capacity << " to " << capacity << " bytes";
+
+   m_buffer.resize(capacity);
+   m_capacity        = capacity;
+   m_head            = capacity;
+   m_overflow_frames = 0;
+   m_overflow_peak   = 0;
+   ++m_statistics.growths;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vertex_ring::Lock::Lock(Vertex_ring& ring, uint bytes)
+   : m_ring(0)
+   , m_raw(0)
+   , m_offset(0)
+{
+   assert(bytes <= ring.m_capacity && "Region doesn't fit into vertex ring");
+
+   // wrap if the rest of buffer is too small
+   const bool discard = bytes > ring.get_free_bytes();
+   if (discard)
+   {
+      ring.m_head = 0;
+      ++ring.m_statistics.discards;
+   }
+
+   m_raw    = ring.m_buffer.lock(ring.m_head, bytes, discard);
+   m_ring   = &ring;
+   m_offset = ring.m_head;
+
+   ring.m_head        += bytes;
+   ring.m_frame_bytes += bytes;
+   ++ring.m_statistics.locks;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vertex_ring::Lock::~Lock()
+{
+   reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Vertex_ring::Lock::reset()
+{
+   if (m_ring)
+   {
+      m_ring->m_buffer.unlock();
+      m_ring = 0;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void stream_batches(const Batch_list& batches, Vertex_ring& ring, Stream_device& device)
+{
+   Stream_cursor cursor = { 0, 0 };
+   while (cursor.batch < batches.size())
+   {
+      // continue after previous vertexes if the rest of scene fits there; use the whole ring otherwise
+      Stream_cursor end;
+      uint bytes = plan_flush(batches, device, cursor, ring.get_free_bytes(), end);
+      if (end.batch < batches.size())
+      {
+         bytes = plan_flush(batches, device, cursor, ring.get_capacity(), end);
+      }
+      assert(bytes > 0 && "Quad doesn't fit into vertex ring");
+
+      Vertex_ring::Lock lock(ring, bytes);
+
+      // write vertexes of flush
+      char* where = static_cast<char*>(lock.get_raw_memory());
+      uint space = bytes;
+      uint nquads;
+      uint quad_bytes;
+      for (Stream_cursor piece = cursor; piece.batch < batches.size(); where += nquads*quad_bytes)
+      {
+         const Render_batch& batch = batches[piece.batch];
+         const uint first = batch.first + piece.done;
+         if (!next_piece(batches, device, piece, space, nquads, quad_bytes))
+         {
+            break;
+         }
+         device.write_quads(batch.format, first, nquads, where);
+      }
+      lock.reset();
+
+      // draw them
+      uint offset = lock.get_offset();
+      space = bytes;
+      for (Stream_cursor piece = cursor; piece.batch < batches.size(); offset += nquads*quad_bytes)
+      {
+         const Render_batch& batch = batches[piece.batch];
+         const bool batch_starts = piece.done == 0;
+         const bool format_changes = piece.batch == 0 || batches[piece.batch - 1].format != batch.format;
+         if (!next_piece(batches, device, piece, space, nquads, quad_bytes))
+         {
+            break;
+         }
+
+         if (batch_starts)
+         {
+            if (format_changes)
+            {
+               device.set_vertex_format(batch.format);
+            }
+            for (uint nstage = 0; nstage < batch_stages_number; ++nstage)
+            {
+               device.set_texture(nstage, batch.textures[nstage]);
+               device.set_blending(nstage, batch.blendings[nstage]);
+            }
+         }
+         device.set_vertex_offset(offset);
+         device.draw_quads(0, nquads);
+      }
+
+      cursor = end;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Takes the next piece of scene that is drawn by single draw: it doesn't cross batch boundary, doesn't exceed
+/// max_quads_per_draw and fits into space.
+/// \param cursor Position of piece; moved after it.
+/// \param space Bytes available; decreased by piece size.
+/// \return false if scene is over or no quad fits into space.
+bool next_piece(const Batch_list& batches, Stream_device& device, Stream_cursor& cursor, uint& space,
+                uint& nquads, uint& quad_bytes)
+{
+   if (cursor.batch == batches.size())
+   {
+      return false;
+   }
+
+   const Render_batch& batch = batches[cursor.batch];
+   quad_bytes = device.get_quad_bytes(batch.format);
+   nquads = std::min(std::min(batch.count - cursor.done, max_quads_per_draw), space / quad_bytes);
+   if (nquads == 0)
+   {
+      return false;
+   }
+
+   space -= nquads*quad_bytes;
+   cursor.done += nquads;
+   if (cursor.done == batch.count)
+   {
+      ++cursor.batch;
+      cursor.done = 0;
+   }
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Finds how much of scene fits into space.
+/// \param end Receives position after the last piece that fits.
+/// \return Size of pieces that fit.
+uint plan_flush(const Batch_list& batches, Stream_device& device, Stream_cursor cursor, uint space,
+                Stream_cursor& end)
+{
+   const uint initial_space = space;
+   uint nquads;
+   uint quad_bytes;
+   while (next_piece(batches, device, cursor, space, nquads, quad_bytes))
+   {
+   }
+
+   end = cursor;
+   return initial_space - space;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
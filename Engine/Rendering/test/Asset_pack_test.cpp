@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for asset pack.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Asset_pack.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>               // for std::remove
+#include <cstring>              // for std::memcmp
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Asset_pack_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Image with every pixel different.
+Image make_image(uint width, uint height, uint seed)
+{
+   Image image(width, height);
+   for (size_t i = 0; i < image.pixels.size(); ++i)
+   {
+      image.pixels[i] = 0xFF000000 | (seed*0x010203 + static_cast<uint>(i)*0x0F0B07);
+   }
+   return image;
+}
+
+bool is_page_aligned(const void* p)
+{
+   return reinterpret_cast<size_t>(p) % 4096 == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textures come back as they were added, pointing into pages of pack.
+void test_round_trip()
+{
+   const Image plain = make_image(5, 3, 1);
+   const Compressed_image bc1 = compress_image(make_image(8, 8, 2), block_format_bc1);
+   const Compressed_image bc3 = compress_image(make_image(6, 5, 3), block_format_bc3);
+   {
+      Asset_pack_writer writer;
+      writer.add("plain.bmp", plain);
+      writer.add("bc1.dds", bc1);
+      writer.add("bc3.dds", bc3);
+      BOOST_CHECK_EQUAL(writer.get_size(), 3u);
+      writer.save("round_trip.pack");
+   }
+
+   {
+      const Asset_pack pack("round_trip.pack");
+      BOOST_CHECK_EQUAL(pack.get_size(), 3u);
+
+      Packed_texture texture;
+      BOOST_CHECK(!pack.find("missing.bmp", texture));
+      BOOST_CHECK(!pack.find("", texture));
+
+      BOOST_REQUIRE(pack.find("plain.bmp", texture));
+      BOOST_CHECK_EQUAL(texture.format, packed_format_a8r8g8b8);
+      BOOST_CHECK_EQUAL(texture.width, 5u);
+      BOOST_CHECK_EQUAL(texture.height, 3u);
+      BOOST_REQUIRE_EQUAL(texture.size, plain.pixels.size()*sizeof(uint));
+      BOOST_CHECK(is_page_aligned(texture.data));
+      BOOST_CHECK(std::memcmp(texture.data, &plain.pixels[0], texture.size) == 0);
+      BOOST_CHECK(unpack_image(texture).pixels == plain.pixels);
+
+      BOOST_REQUIRE(pack.find("bc1.dds", texture));
+      BOOST_CHECK_EQUAL(texture.format, packed_format_bc1);
+      BOOST_REQUIRE_EQUAL(texture.size, bc1.blocks.size());
+      BOOST_CHECK(is_page_aligned(texture.data));
+      BOOST_CHECK(std::memcmp(texture.data, &bc1.blocks[0], texture.size) == 0);
+      BOOST_CHECK(unpack_image(texture).pixels == decompress_image(bc1).pixels);
+
+      BOOST_REQUIRE(pack.find("bc3.dds", texture));
+      BOOST_CHECK_EQUAL(texture.format, packed_format_bc3);
+      BOOST_CHECK_EQUAL(texture.width, 6u);
+      BOOST_CHECK_EQUAL(texture.height, 5u);
+      BOOST_CHECK(unpack_image(texture).pixels == decompress_image(bc3).pixels);
+   }
+
+   std::remove("round_trip.pack");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Every one of many textures is found by its name.
+void test_many()
+{
+   const uint number = 300;
+   {
+      Asset_pack_writer writer;
+      for (uint i = 0; i < number; ++i)
+      {
+         ostringstream name;
+         name << "textures/texture_" << i << ".bmp";
+         writer.add(name.str(), make_image(1 + i % 7, 1 + i % 5, i));
+      }
+      writer.save("many.pack");
+   }
+
+   {
+      const Asset_pack pack("many.pack");
+      BOOST_CHECK_EQUAL(pack.get_size(), number);
+      for (uint i = 0; i < number; ++i)
+      {
+         ostringstream name;
+         name << "textures/texture_" << i << ".bmp";
+         Packed_texture texture;
+         BOOST_REQUIRE(pack.find(name.str(), texture));
+         BOOST_CHECK(unpack_image(texture).pixels == make_image(1 + i % 7, 1 + i % 5, i).pixels);
+      }
+   }
+
+   std::remove("many.pack");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_errors()
+{
+   BOOST_CHECK_THROW(Asset_pack("no_such.pack"), Asset_pack_exception);
+
+   {
+      ofstream file("not_pack.pack", ios::binary);
+      file << "definitely not a pack";
+   }
+   BOOST_CHECK_THROW(Asset_pack("not_pack.pack"), Asset_pack_exception);
+   std::remove("not_pack.pack");
+
+   Asset_pack_writer writer;
+   writer.add("same.bmp", make_image(2, 2, 0));
+   writer.add("same.bmp", make_image(2, 2, 1));
+   BOOST_CHECK_THROW(writer.save("same.pack"), Asset_pack_exception);
+
+   Asset_pack_writer empty_image;
+   empty_image.add("empty.bmp", Image());
+   BOOST_CHECK_THROW(empty_image.save("empty.pack"), Asset_pack_exception);
+
+   // pack cut in the middle of data refers beyond its end
+   Asset_pack_writer truncated;
+   truncated.add("big.bmp", make_image(64, 64, 0));
+   truncated.save("truncated.pack");
+   vector<char> contents;
+   {
+      ifstream file("truncated.pack", ios::binary);
+      contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+   }
+   BOOST_REQUIRE(contents.size() > 4096 + 100);
+   {
+      ofstream file("truncated.pack", ios::binary);
+      file.write(&contents[0], 4096 + 100);
+   }
+   BOOST_CHECK_THROW(Asset_pack("truncated.pack"), Asset_pack_exception);
+   std::remove("truncated.pack");
+   std::remove("same.pack");
+   std::remove("empty.pack");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Asset_pack_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Asset_pack_test;
+
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Asset_pack tests");
+
+   test->add(BOOST_TEST_CASE(test_round_trip));
+   test->add(BOOST_TEST_CASE(test_many));
+   test->add(BOOST_TEST_CASE(test_errors));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
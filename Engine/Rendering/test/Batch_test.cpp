@@ -0,0 +1,213 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for sprites batching.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Batch.h"
+#include "Recording_device.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Batch_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Textured_sprite make_textured_sprite(const string& file_name, Blending_mode blending)
+{
+   Textured_sprite s = Textured_sprite();
+   s.texture = Texture_ID(file_name);
+   s.blending = blending;
+   return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Lot of sprites sharing texture and blending are drawn by single call.
+void test_single_run()
+{
+   vector<Textured_sprite> sprites(5000, make_textured_sprite("banana.bmp", blending_mode_modulate));
+
+   Batch_list batches;
+   compile_batches(sprites, batches);
+
+   Recording_device device;
+   draw_batches(batches, device);
+
+   BOOST_REQUIRE(device.get_draws().size() == 1);
+   BOOST_CHECK(device.get_draws()[0].first_quad == 0);
+   BOOST_CHECK(device.get_draws()[0].nquads == 5000);
+   BOOST_CHECK(device.get_draws()[0].texture0 == Texture_ID("banana.bmp"));
+   BOOST_CHECK(device.get_draws()[0].blending0 == blending_mode_modulate);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Each run of equal state is a batch; runs are not reordered.
+void test_runs()
+{
+   vector<Textured_sprite> sprites;
+   sprites.push_back(make_textured_sprite("banana.bmp", blending_mode_add));
+   sprites.push_back(make_textured_sprite("banana.bmp", blending_mode_add));
+   sprites.push_back(make_textured_sprite("stain.bmp", blending_mode_add));
+   sprites.push_back(make_textured_sprite("stain.bmp", blending_mode_modulate));
+   sprites.push_back(make_textured_sprite("banana.bmp", blending_mode_add));
+
+   Batch_list batches;
+   compile_batches(sprites, batches);
+
+   Recording_device device;
+   draw_batches(batches, device);
+
+   const vector<Recording_device::Draw>& draws = device.get_draws();
+   BOOST_REQUIRE(draws.size() == 4);
+
+   BOOST_CHECK(draws[0].first_quad == 0 && draws[0].nquads == 2);
+   BOOST_CHECK(draws[0].texture0 == Texture_ID("banana.bmp"));
+   BOOST_CHECK(draws[1].first_quad == 2 && draws[1].nquads == 1);
+   BOOST_CHECK(draws[1].texture0 == Texture_ID("stain.bmp") && draws[1].blending0 == blending_mode_add);
+   BOOST_CHECK(draws[2].first_quad == 3 && draws[2].nquads == 1);
+   BOOST_CHECK(draws[2].blending0 == blending_mode_modulate);
+   BOOST_CHECK(draws[3].first_quad == 4 && draws[3].nquads == 1);
+   BOOST_CHECK(draws[3].texture0 == Texture_ID("banana.bmp"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Colored sprites go into single untextured batch; formats are drawn in order batches are compiled.
+void test_formats()
+{
+   vector<Colored_sprite> colored(3);
+   vector<Textured_sprite> textured(2, make_textured_sprite("banana.bmp", blending_mode_add));
+   vector<Multitextured_2_sprite> multitextured(2);
+   multitextured[1].texture1 = Texture_ID("stain.bmp");
+
+   Batch_list batches;
+   compile_batches(colored, batches);
+   compile_batches(textured, batches);
+   compile_batches(multitextured, batches);
+
+   Recording_device device;
+   draw_batches(batches, device);
+
+   const vector<Recording_device::Draw>& draws = device.get_draws();
+   BOOST_REQUIRE(draws.size() == 4);
+   BOOST_CHECK(draws[0].format == Vertex_format(position | diffuse_color));
+   BOOST_CHECK(draws[0].nquads == 3);
+   BOOST_CHECK(draws[0].texture0 == Texture_ID());
+   BOOST_CHECK(draws[1].format == Vertex_format(position | diffuse_color | texture_coord0));
+   BOOST_CHECK(draws[1].nquads == 2);
+   BOOST_CHECK(draws[2].format == Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1));
+   BOOST_CHECK(draws[2].first_quad == 0 && draws[2].nquads == 1);
+   BOOST_CHECK(draws[3].first_quad == 1 && draws[3].nquads == 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Only given sprites are drawn; runs break at skipped ones.
+void test_slots()
+{
+   vector<Textured_sprite> sprites(4, make_textured_sprite("banana.bmp", blending_mode_add));
+   sprites.push_back(make_textured_sprite("stain.bmp", blending_mode_add));
+   sprites.push_back(make_textured_sprite("banana.bmp", blending_mode_add));
+
+   vector<uint> slots;
+   slots.push_back(0);
+   slots.push_back(1);
+   slots.push_back(3);
+   slots.push_back(4);
+   slots.push_back(5);
+
+   Batch_list batches;
+   compile_batches(sprites, slots, batches);
+
+   BOOST_REQUIRE(batches.size() == 4);
+   BOOST_CHECK(batches[0].first == 0 && batches[0].count == 2);
+   BOOST_CHECK(batches[1].first == 3 && batches[1].count == 1);
+   BOOST_CHECK(batches[2].first == 4 && batches[2].count == 1);
+   BOOST_CHECK(batches[2].textures[0] == Texture_ID("stain.bmp"));
+   BOOST_CHECK(batches[3].first == 5 && batches[3].count == 1);
+
+   // colored sprites have no state, so only skipped sprites break runs
+   vector<Colored_sprite> colored(sprites.size(), Colored_sprite());
+   batches.clear();
+   compile_batches(colored, slots, batches);
+   BOOST_REQUIRE(batches.size() == 2);
+   BOOST_CHECK(batches[0].first == 0 && batches[0].count == 2);
+   BOOST_CHECK(batches[1].first == 3 && batches[1].count == 3);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Batch that doesn't fit 16-bit indexes is split.
+void test_split()
+{
+   vector<Colored_sprite> sprites(max_quads_per_draw + 10);
+
+   Batch_list batches;
+   compile_batches(sprites, batches);
+
+   Recording_device device;
+   draw_batches(batches, device);
+
+   BOOST_REQUIRE(device.get_draws().size() == 2);
+   BOOST_CHECK(device.get_draws()[0].first_quad == 0);
+   BOOST_CHECK(device.get_draws()[0].nquads == max_quads_per_draw);
+   BOOST_CHECK(device.get_draws()[1].first_quad == max_quads_per_draw);
+   BOOST_CHECK(device.get_draws()[1].nquads == 10);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_quad_indexes()
+{
+   ushort indexes[12];
+   fill_quad_indexes(indexes, 2);
+
+   const ushort etalon[12] = { 0, 1, 2, 2, 1, 3, 4, 5, 6, 6, 5, 7 };
+   BOOST_CHECK(equal(indexes, indexes + 12, etalon));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Batch_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Batch_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Batch tests");
+
+   test->add(BOOST_TEST_CASE(test_single_run));
+   test->add(BOOST_TEST_CASE(test_runs));
+   test->add(BOOST_TEST_CASE(test_formats));
+   test->add(BOOST_TEST_CASE(test_slots));
+   test->add(BOOST_TEST_CASE(test_split));
+   test->add(BOOST_TEST_CASE(test_quad_indexes));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Measures size, compression time, error and decompression throughput of BC1 and BC3.
+// Usage: Block_compression_benchmark [BMP file], Main/res/banana.bmp by default.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Block_compression.h"
+#include "Engine/Rendering/Bmp.h"
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Timing/Stopwatch.h"
+
+#include <cstdlib>              // for std::abs
+#include <iostream>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Block_compression_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint decompressions = 200;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Average difference of color channels.
+double get_mean_error(const Image& lhs, const Image& rhs)
+{
+   double error = 0;
+   for (size_t i = 0; i < lhs.pixels.size(); ++i)
+   {
+      for (uint shift = 0; shift < 24; shift += 8)
+      {
+         error += std::abs(int((lhs.pixels[i] >> shift) & 0xFF) - int((rhs.pixels[i] >> shift) & 0xFF));
+      }
+   }
+   return error / (3*lhs.pixels.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void measure(const char* name, const Image& image, Block_format format)
+{
+   Timing::Stopwatch stopwatch;
+   const Compressed_image compressed = compress_image(image, format);
+   const double compression = stopwatch.get_elapsed();
+
+   Image restored;
+   stopwatch.restart();
+   for (uint i = 0; i < decompressions; ++i)
+   {
+      restored = decompress_image(compressed);
+   }
+   const double seconds = stopwatch.get_elapsed();
+
+   // throughput is counted in decompressed bytes
+   const double megabytes = 4.0*image.pixels.size()*decompressions / (1024*1024);
+   cout << name << ": " << compressed.blocks.size() / 1024 << " KB (" << 4*image.pixels.size() / compressed.blocks.size()
+        << "x smaller), compressed in " << compression * 1000 << " ms, mean error " << get_mean_error(image, restored)
+        << ", decompressed at " << megabytes / seconds << " MB/s" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run(const char* file_name)
+{
+   const Image image = load_bmp(file_name);
+   cout << file_name << ": " << image.width << "x" << image.height << ", " << 4*image.pixels.size() / 1024 << " KB"
+        << endl;
+
+   measure("BC1", image, block_format_bc1);
+   measure("BC3", image, block_format_bc3);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Block_compression_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   try
+   {
+      Engine::Rendering::Block_compression_benchmark::run(argc > 1 ? argv[1] : "Main/res/banana.bmp");
+      return 0;
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
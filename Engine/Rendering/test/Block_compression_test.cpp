@@ -0,0 +1,217 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for block compression and DDS files.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Block_compression.h"
+#include "Engine/Rendering/Dds.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>               // for std::remove
+#include <cstdlib>              // for std::abs
+#include <fstream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Block_compression_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const file_name = "Block_compression_test.dds";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return The largest difference between channels of pixels.
+uint get_max_error(const Image& lhs, const Image& rhs, bool with_alpha)
+{
+   uint error = 0;
+   for (size_t i = 0; i < lhs.pixels.size(); ++i)
+   {
+      for (uint shift = 0; shift < (with_alpha ? 32u : 24u); shift += 8)
+      {
+         const int delta = int((lhs.pixels[i] >> shift) & 0xFF) - int((rhs.pixels[i] >> shift) & 0xFF);
+         error = std::max(error, uint(std::abs(delta)));
+      }
+   }
+   return error;
+}
+
+/// Image whose 4x4 blocks are filled with single colors taken in turn.
+Image make_blocks(uint width, uint height, const uint* colors, uint ncolors)
+{
+   Image image(width, height);
+   for (uint y = 0; y < height; ++y)
+   {
+      for (uint x = 0; x < width; ++x)
+      {
+         image.pixels[y*width + x] = colors[((y / 4)*((width + 3) / 4) + x / 4) % ncolors];
+      }
+   }
+   return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Blocks of single color that RGB565 represents exactly are restored exactly, including clipped edge blocks.
+void test_solid()
+{
+   const uint colors[] = { 0xFFFF0000, 0xFF00FF00, 0xFF0000FF, 0xFFFFFFFF, 0xFF000000, 0xFF08FF10 };
+   const Image image = make_blocks(13, 6, colors, 6);
+
+   const Compressed_image bc1 = compress_image(image, block_format_bc1);
+   BOOST_CHECK_EQUAL(bc1.blocks.size(), 4u*2*8);
+   BOOST_CHECK(decompress_image(bc1).pixels == image.pixels);
+
+   const Compressed_image bc3 = compress_image(image, block_format_bc3);
+   BOOST_CHECK_EQUAL(bc3.blocks.size(), 4u*2*16);
+   const Image restored = decompress_image(bc3);
+   BOOST_CHECK(restored.width == 13 && restored.height == 6);
+   BOOST_CHECK(restored.pixels == image.pixels);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Blocks made by hand decode as Direct3D decodes them.
+void test_decode()
+{
+   // red and blue endpoints; each row takes indices 0, 1, 2, 3
+   const uchar four_colors[] = { 0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 };
+   Compressed_image image;
+   image.width  = 4;
+   image.height = 4;
+   image.format = block_format_bc1;
+   image.blocks.assign(four_colors, four_colors + 8);
+
+   const uint expected[] = { 0xFFFF0000, 0xFF0000FF, 0xFFAA0055, 0xFF5500AA };
+   Image decoded = decompress_image(image);
+   for (uint i = 0; i < 16; ++i)
+   {
+      BOOST_CHECK_EQUAL(decoded.pixels[i], expected[i % 4]);
+   }
+
+   // the same endpoints swapped mean 3 colors and transparent black
+   const uchar three_colors[] = { 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4 };
+   image.blocks.assign(three_colors, three_colors + 8);
+   const uint expected_three[] = { 0xFF0000FF, 0xFFFF0000, 0xFF7F007F, 0x00000000 };
+   decoded = decompress_image(image);
+   for (uint i = 0; i < 16; ++i)
+   {
+      BOOST_CHECK_EQUAL(decoded.pixels[i], expected_three[i % 4]);
+   }
+
+   // BC3 color block is always in 4-color mode; alphas 255 and 0 with the first row of texels taking index 2
+   const uchar bc3[] = { 0xFF, 0x00, 0x92, 0x04, 0x00, 0x00, 0x00, 0x00,
+                         0x1F, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00 };
+   image.format = block_format_bc3;
+   image.blocks.assign(bc3, bc3 + 16);
+   decoded = decompress_image(image);
+   BOOST_CHECK_EQUAL(decoded.pixels[0], 0xDA0000FFu);     // alpha is (6*255 + 0) / 7
+   BOOST_CHECK_EQUAL(decoded.pixels[3], 0xDA0000FFu);
+   BOOST_CHECK_EQUAL(decoded.pixels[4], 0xFF0000FFu);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Smooth image loses little; BC1 drops alpha, BC3 keeps it.
+void test_gradient()
+{
+   Image image(64, 32);
+   for (uint y = 0; y < image.height; ++y)
+   {
+      for (uint x = 0; x < image.width; ++x)
+      {
+         image.pixels[y*image.width + x] = make_argb(uchar(8*y), uchar(4*x), uchar(2*x + 3*y), uchar(255 - 3*x));
+      }
+   }
+   BOOST_CHECK(has_alpha(image));
+
+   const Image bc1 = decompress_image(compress_image(image, block_format_bc1));
+   BOOST_CHECK(get_max_error(bc1, image, false) <= 12);
+   BOOST_CHECK(!has_alpha(bc1));
+
+   const Image bc3 = decompress_image(compress_image(image, block_format_bc3));
+   BOOST_CHECK(get_max_error(bc3, image, true) <= 12);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_dds()
+{
+   BOOST_CHECK(is_dds_file("texture.dds") && is_dds_file("TEXTURE.DDS"));
+   BOOST_CHECK(!is_dds_file("texture.bmp") && !is_dds_file("dds") && !is_dds_file("texture_dds"));
+
+   const uint colors[] = { 0x80FF0000, 0xFF00FF00 };
+   const Compressed_image image = compress_image(make_blocks(8, 12, colors, 2), block_format_bc3);
+   save_dds(image, file_name);
+   const Compressed_image loaded = load_dds(file_name);
+   BOOST_CHECK(loaded.width == 8 && loaded.height == 12 && loaded.format == block_format_bc3);
+   BOOST_CHECK(loaded.blocks == image.blocks);
+
+   // truncated and broken files
+   vector<char> bytes;
+   {
+      ifstream file(file_name, ios::binary);
+      bytes.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+   }
+   {
+      ofstream file(file_name, ios::binary);
+      file.write(&bytes[0], bytes.size() - 1);
+   }
+   BOOST_CHECK_THROW(load_dds(file_name), Image_exception);
+
+   bytes[84 + 3] = '3';                // DXT3
+   {
+      ofstream file(file_name, ios::binary);
+      file.write(&bytes[0], bytes.size());
+   }
+   BOOST_CHECK_THROW(load_dds(file_name), Image_exception);
+   remove(file_name);
+
+   BOOST_CHECK_THROW(load_dds("no_such_file.dds"), Image_exception);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Block_compression_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Block_compression_test;
+
+   // loader logs errors
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Block compression tests");
+
+   test->add(BOOST_TEST_CASE(test_solid));
+   test->add(BOOST_TEST_CASE(test_decode));
+   test->add(BOOST_TEST_CASE(test_gradient));
+   test->add(BOOST_TEST_CASE(test_dds));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
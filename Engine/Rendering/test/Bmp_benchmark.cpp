@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compares throughput of load_bmp() with naive reader that uses streams and converts pixel by pixel.
+// Usage: Bmp_benchmark [BMP file], Main/res/banana.bmp by default.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Bmp.h"
+#include "Naive_bmp.h"
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Timing/Stopwatch.h"
+
+#include <iostream>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Bmp_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint loads = 200;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Prints megabytes of decoded pixels per second.
+void report(const char* name, const Image& image, double seconds)
+{
+   const double megabytes = 4.0*image.pixels.size()*loads / (1024*1024);
+   cout << name << ": " << seconds * 1000 / loads << " ms per image, " << megabytes / seconds << " MB/s" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int run(const char* file_name)
+{
+   Image image;
+   if (!naive_load_bmp(file_name, image))
+   {
+      cerr << "Can't read " << file_name << endl;
+      return 1;
+   }
+   cout << file_name << ": " << image.width << "x" << image.height << endl;
+
+   Timing::Stopwatch stopwatch;
+   for (uint i = 0; i < loads; ++i)
+   {
+      naive_load_bmp(file_name, image);
+   }
+   report("naive", image, stopwatch.get_elapsed());
+
+   stopwatch.restart();
+   for (uint i = 0; i < loads; ++i)
+   {
+      image = load_bmp(file_name);
+   }
+   report("load_bmp", image, stopwatch.get_elapsed());
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Bmp_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   try
+   {
+      return Engine::Rendering::Bmp_benchmark::run(argc > 1 ? argv[1] : "Main/res/banana.bmp");
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
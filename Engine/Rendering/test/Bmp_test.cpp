@@ -0,0 +1,355 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for BMP reading and writing.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Bmp.h"
+#include "Naive_bmp.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cassert>
+#include <cstdio>               // for std::remove
+#include <cstdlib>              // for std::rand
+#include <fstream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Bmp_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* const file_name = "Bmp_test.bmp";
+
+/// BMP file given in command line, if any.
+const char* input_file = 0;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void append_le(vector<uchar>& bytes, uint value, uint nbytes)
+{
+   assert(nbytes <= sizeof(value) && "Value is wider than uint");
+   for (uint i = 0; i < nbytes; ++i)
+   {
+      bytes.push_back(static_cast<uchar>(value >> (8*i)));
+   }
+}
+
+/// Builds BMP file of given pixel data, which is stored as is.
+vector<uchar> make_bmp(int width, int height, uint bpp, uint compression, const vector<uint>& palette,
+                       const vector<uchar>& pixels)
+{
+   const uint offset = 54 + 4*palette.size();
+   vector<uchar> bytes;
+   bytes.push_back('B');
+   bytes.push_back('M');
+   append_le(bytes, offset + pixels.size(), 4);
+   append_le(bytes, 0, 4);
+   append_le(bytes, offset, 4);
+   append_le(bytes, 40, 4);
+   append_le(bytes, width, 4);
+   append_le(bytes, height, 4);
+   append_le(bytes, 1, 2);
+   append_le(bytes, bpp, 2);
+   append_le(bytes, compression, 4);
+   append_le(bytes, pixels.size(), 4);
+   append_le(bytes, 0, 4);
+   append_le(bytes, 0, 4);
+   append_le(bytes, palette.size(), 4);
+   append_le(bytes, 0, 4);
+   for (size_t i = 0; i < palette.size(); ++i)
+   {
+      append_le(bytes, palette[i], 4);
+   }
+   bytes.insert(bytes.end(), pixels.begin(), pixels.end());
+   return bytes;
+}
+
+Image decode(const vector<uchar>& bytes)
+{
+   return decode_bmp(&bytes[0], bytes.size(), "test");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Saved image is loaded back unchanged.
+void test_save_load()
+{
+   Image image(3, 2);
+   for (uint i = 0; i < image.pixels.size(); ++i)
+   {
+      image.pixels[i] = make_argb(uchar(10*i), uchar(i), uchar(2*i), uchar(255 - i));
+   }
+
+   save_bmp(image, file_name);
+   const Image loaded = load_bmp(file_name);
+   remove(file_name);
+
+   BOOST_CHECK(loaded.width == 3 && loaded.height == 2);
+   BOOST_CHECK(loaded.pixels == image.pixels);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// 24-bit bottom-up image with padded rows (as most of editors save).
+void test_load_24()
+{
+   const unsigned char bmp[] =
+   {
+      'B', 'M', 70, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0,             // file header
+      40, 0, 0, 0, 2, 0, 0, 0, 2, 0, 0, 0, 1, 0, 24, 0,           // info header: 2x2, 24 bit
+      0, 0, 0, 0, 16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 255,  0, 255, 0,  0, 0,                               // bottom row: red, green, padding
+      255, 0, 0,  255, 255, 255,  0, 0                            // top row: blue, white, padding
+   };
+   {
+      ofstream file(file_name, ios::binary);
+      file.write(reinterpret_cast<const char*>(bmp), sizeof(bmp));
+   }
+
+   const Image image = load_bmp(file_name);
+   remove(file_name);
+
+   BOOST_REQUIRE(image.width == 2 && image.height == 2);
+   BOOST_CHECK(image.pixels[0] == 0xFF0000FF);
+   BOOST_CHECK(image.pixels[1] == 0xFFFFFFFF);
+   BOOST_CHECK(image.pixels[2] == 0xFFFF0000);
+   BOOST_CHECK(image.pixels[3] == 0xFF00FF00);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Palettized image; palette has fewer than 256 colors.
+void test_load_8()
+{
+   vector<uint> palette;
+   palette.push_back(0x00FF0000);
+   palette.push_back(0x0000FF00);
+   palette.push_back(0x000000FF);
+
+   // 3 pixels padded to 4 bytes
+   const uchar data[] = { 0, 1, 2, 0,  2, 2, 1, 0 };
+   const Image image = decode(make_bmp(3, 2, 8, 0, palette, vector<uchar>(data, data + sizeof(data))));
+
+   BOOST_REQUIRE(image.width == 3 && image.height == 2);
+   const uint expected[] = { 0xFF0000FF, 0xFF0000FF, 0xFF00FF00,  0xFFFF0000, 0xFF00FF00, 0xFF0000FF };
+   BOOST_CHECK(image.pixels == vector<uint>(expected, expected + 6));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_load_rle8()
+{
+   vector<uint> palette;
+   palette.push_back(0x00000000);
+   palette.push_back(0x00FFFFFF);
+   palette.push_back(0x00FF0000);
+
+   const uchar data[] =
+   {
+      3, 1,  0, 0,                // bottom row: 3 white, end of line
+      0, 3, 2, 1, 2, 0,           // middle row: red, white, red as absolute run, padded
+      1, 1,  0, 0,                // white, end of line
+      0, 2, 2, 0,                 // move to the third pixel of top row
+      5, 2,                       // red, clipped by right edge
+      0, 1                        // end of bitmap
+   };
+   const Image image = decode(make_bmp(4, 3, 8, 1, palette, vector<uchar>(data, data + sizeof(data))));
+
+   BOOST_REQUIRE(image.width == 4 && image.height == 3);
+   const uint expected[] =
+   {
+      0xFF000000, 0xFF000000, 0xFFFF0000, 0xFFFF0000,
+      0xFFFF0000, 0xFFFFFFFF, 0xFFFF0000, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFF000000
+   };
+   BOOST_CHECK(image.pixels == vector<uint>(expected, expected + 12));
+
+   // missing end of bitmap
+   BOOST_CHECK_THROW(decode(make_bmp(4, 3, 8, 1, palette, vector<uchar>(data, data + sizeof(data) - 2))),
+                     Image_exception);
+   // absolute run going past the end
+   const uchar broken[] = { 0, 5, 1, 1 };
+   BOOST_CHECK_THROW(decode(make_bmp(4, 3, 8, 1, palette, vector<uchar>(broken, broken + sizeof(broken)))),
+                     Image_exception);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Encoded runs of row follow each other.
+void test_load_rle8_runs()
+{
+   vector<uint> palette;
+   palette.push_back(0x00000000);
+   palette.push_back(0x00FFFFFF);
+   palette.push_back(0x00FF0000);
+
+   const uchar data[] =
+   {
+      1, 2,  2, 1,  3, 2,  0, 0,  // red, 2 white, 3 red clipped by right edge, end of line
+      0, 1                        // end of bitmap
+   };
+   const Image image = decode(make_bmp(5, 1, 8, 1, palette, vector<uchar>(data, data + sizeof(data))));
+
+   BOOST_REQUIRE(image.width == 5 && image.height == 1);
+   const uint expected[] = { 0xFFFF0000, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFF0000, 0xFFFF0000 };
+   BOOST_CHECK(image.pixels == vector<uint>(expected, expected + 5));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// 32-bit image with explicit masks of the usual layout keeps its alpha.
+void test_load_32()
+{
+   vector<uchar> data;
+   append_le(data, 0x00FF0000, 4);     // masks of red, green and blue
+   append_le(data, 0x0000FF00, 4);
+   append_le(data, 0x000000FF, 4);
+   append_le(data, 0x80102030, 4);
+   append_le(data, 0x00405060, 4);
+   vector<uchar> bytes = make_bmp(2, -1, 32, 3, vector<uint>(), data);
+   // pixels start after masks
+   bytes[10] += 12;
+
+   const Image image = decode(bytes);
+   BOOST_REQUIRE(image.width == 2 && image.height == 1);
+   BOOST_CHECK(image.pixels[0] == 0x80102030);
+   BOOST_CHECK(image.pixels[1] == 0x00405060);
+
+   // other masks aren't supported
+   bytes[54] = 0xFF;
+   BOOST_CHECK_THROW(decode(bytes), Image_exception);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Vector conversion of 24-bit rows gives what naive reader does, for widths that aren't multiple of 4
+/// and with the last row reaching the end of file.
+void test_load_24_widths()
+{
+   for (uint width = 1; width <= 37; ++width)
+   {
+      const uint row_bytes = (3*width + 3) & ~3u;
+      vector<uchar> data(row_bytes*5);
+      for (size_t i = 0; i < data.size(); ++i)
+      {
+         data[i] = static_cast<uchar>(rand());
+      }
+      const vector<uchar> bytes = make_bmp(width, 5, 24, 0, vector<uint>(), data);
+      {
+         ofstream file(file_name, ios::binary);
+         file.write(reinterpret_cast<const char*>(&bytes[0]), bytes.size());
+      }
+
+      Image expected;
+      BOOST_REQUIRE(naive_load_bmp(file_name, expected));
+      const Image image = load_bmp(file_name);
+      BOOST_CHECK(image.pixels == expected.pixels);
+
+      // without padding of the last row
+      const Image unpadded = decode_bmp(&bytes[0], bytes.size() - (row_bytes - 3*width), "test");
+      BOOST_CHECK(unpadded.pixels == expected.pixels);
+   }
+   remove(file_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Real image, given in command line, is decoded as naive reader does.
+void test_load_file()
+{
+   if (input_file == 0)
+   {
+      return;
+   }
+
+   Image expected;
+   BOOST_REQUIRE(naive_load_bmp(input_file, expected));
+   const Image image = load_bmp(input_file);
+   BOOST_CHECK(image.width == expected.width && image.height == expected.height);
+   BOOST_CHECK(image.pixels == expected.pixels);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_errors()
+{
+   BOOST_CHECK_THROW(load_bmp("no_such_file.bmp"), Image_exception);
+
+   {
+      ofstream file(file_name, ios::binary);
+      file << "This isn't BMP file at all, it's just text long enough to have complete header.";
+   }
+   BOOST_CHECK_THROW(load_bmp(file_name), Image_exception);
+   remove(file_name);
+
+   // empty file can't be mapped, but it is just as wrong
+   {
+      ofstream file(file_name, ios::binary);
+   }
+   BOOST_CHECK_THROW(load_bmp(file_name), Image_exception);
+   remove(file_name);
+
+   // truncated pixels
+   const vector<uchar> bytes = make_bmp(4, 4, 24, 0, vector<uint>(), vector<uchar>(48));
+   BOOST_CHECK_THROW(decode_bmp(&bytes[0], bytes.size() - 1, "test"), Image_exception);
+   // huge image
+   BOOST_CHECK_THROW(decode(make_bmp(1 << 20, 1 << 20, 24, 0, vector<uint>(), vector<uchar>(48))), Image_exception);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Bmp_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Takes BMP file to check decoder on, e.g. Main/res/banana.bmp.
+boost::unit_test::test_suite* init_unit_test_suite(int argc, char** const argv)
+{
+   using namespace Engine::Rendering::Bmp_test;
+
+   if (argc > 1)
+   {
+      input_file = argv[1];
+   }
+
+   // loader logs errors
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("BMP tests");
+
+   test->add(BOOST_TEST_CASE(test_save_load));
+   test->add(BOOST_TEST_CASE(test_load_24));
+   test->add(BOOST_TEST_CASE(test_load_8));
+   test->add(BOOST_TEST_CASE(test_load_rle8));
+   test->add(BOOST_TEST_CASE(test_load_rle8_runs));
+   test->add(BOOST_TEST_CASE(test_load_32));
+   test->add(BOOST_TEST_CASE(test_load_24_widths));
+   test->add(BOOST_TEST_CASE(test_load_file));
+   test->add(BOOST_TEST_CASE(test_errors));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
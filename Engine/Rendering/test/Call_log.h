@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Fake renderer that records calls made to it, so users of renderer could be checked without real one.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEST_ENGINE_RENDERING_CALL_LOG_H_INCLUDED
+#define TEST_ENGINE_RENDERING_CALL_LOG_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Renderer.h"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Renderer that remembers calls made.
+class Call_log : public Renderer
+{
+public:
+
+   /// \param first_handle Handle given to the first retained sprite; the next ones are given sequentially.
+   explicit Call_log(uint first_handle = 0) : next_handle(first_handle), stats() { }
+
+   virtual void add_to_scene(const Colored_sprite& s)         { calls += 'c'; colored.push_back(s); }
+   virtual void add_to_scene(const Textured_sprite& s)        { calls += 't'; textured.push_back(s); }
+   virtual void add_to_scene(const Multitextured_2_sprite& s) { calls += 'm'; multitextured.push_back(s); }
+   virtual void add_to_scene(const Scene_buffer& buffer)
+   {
+      calls += 'b';
+      append(colored, buffer.get_colored_sprites());
+      append(textured, buffer.get_textured_sprites());
+      append(multitextured, buffer.get_multitextured_sprites());
+   }
+   virtual void add_to_scene(const Sprite_instances& instances)
+   {
+      calls += 'i';
+      const size_t size = textured.size();
+      textured.resize(size + instances.number);
+      if (instances.number > 0)
+      {
+         expand_instances(instances, &textured[size]);
+      }
+   }
+   virtual void render_scene()                                { calls += 'R'; }
+   virtual void clear_scene()                                 { calls += 'C'; }
+   virtual bool is_focused() const                            { return true; }
+   virtual void try_restore()                                 { calls += '!'; }
+   virtual const Render_stats& get_render_stats() const       { return stats; }
+
+   // retained sprites are logged along with added ones
+   virtual Colored_sprite_handle create_sprite(const Colored_sprite& s)
+   {
+      calls += 'n';
+      colored.push_back(s);
+      Colored_sprite_handle handle = { next_handle++ };
+      return handle;
+   }
+   virtual Textured_sprite_handle create_sprite(const Textured_sprite& s)
+   {
+      calls += 'n';
+      textured.push_back(s);
+      Textured_sprite_handle handle = { next_handle++ };
+      return handle;
+   }
+   virtual Multitextured_2_sprite_handle create_sprite(const Multitextured_2_sprite& s)
+   {
+      calls += 'n';
+      multitextured.push_back(s);
+      Multitextured_2_sprite_handle handle = { next_handle++ };
+      return handle;
+   }
+   virtual void update_sprite(Colored_sprite_handle handle, const Colored_sprite& s)
+   {
+      calls += 'u';
+      updated.push_back(handle.id);
+      colored.push_back(s);
+   }
+   virtual void update_sprite(Textured_sprite_handle handle, const Textured_sprite& s)
+   {
+      calls += 'u';
+      updated.push_back(handle.id);
+      textured.push_back(s);
+   }
+   virtual void update_sprite(Multitextured_2_sprite_handle handle, const Multitextured_2_sprite& s)
+   {
+      calls += 'u';
+      updated.push_back(handle.id);
+      multitextured.push_back(s);
+   }
+   virtual void destroy_sprite(Colored_sprite_handle handle)         { calls += 'd'; destroyed.push_back(handle.id); }
+   virtual void destroy_sprite(Textured_sprite_handle handle)        { calls += 'd'; destroyed.push_back(handle.id); }
+   virtual void destroy_sprite(Multitextured_2_sprite_handle handle) { calls += 'd'; destroyed.push_back(handle.id); }
+
+   /// One letter per call.
+   std::string                         calls;
+   std::vector<Colored_sprite>         colored;
+   std::vector<Textured_sprite>        textured;
+   std::vector<Multitextured_2_sprite> multitextured;
+   /// Handles passed to update_sprite() and destroy_sprite().
+   std::vector<uint>                   updated;
+   std::vector<uint>                   destroyed;
+   uint                                next_handle;
+   /// Returned by get_render_stats(); zero unless test sets it.
+   Render_stats                        stats;
+
+private:
+
+   template <class Sprite_type>
+   static void append(std::vector<Sprite_type>& to, const std::vector<Sprite_type>& sprites)
+   {
+      to.insert(to.end(), sprites.begin(), sprites.end());
+   }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // TEST_ENGINE_RENDERING_CALL_LOG_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,9 +10,25 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Block_compression.h"
+#include "Engine/Rendering/Culling.h"
+#include "Engine/Rendering/Dds.h"
+#include "Engine/Rendering/Render_queue.h"
+#include "Engine/Rendering/Render_stats.h"
 #include "Engine/Rendering/Renderer.h"
 #include "Engine/Rendering/Sprite.h"
+#include "Engine/Rendering/Sprite_instance.h"
+#include "Engine/Rendering/Sprite_pool.h"
+#include "Engine/Rendering/Sprite_store.h"
+#include "Engine/Rendering/State_cache.h"
 #include "Engine/Rendering/Vertex.h"
 #include "Engine/Rendering/Primitives.h"
+#include "Engine/Rendering/Scene_buffer.h"
+#include "Engine/Rendering/Texture_atlas.h"
+#include "Engine/Rendering/Texture_streamer.h"
+#include "Engine/Rendering/Image.h"
+#include "Engine/Rendering/Vertex_conversion.h"
+#include "Engine/Rendering/Vertex_ring.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for culling.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Culling.h"
+#include "Engine/Rendering/Sprite_store.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <cstdlib>              // for std::rand
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Culling_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Bounds viewport = { 0, 0, 640, 480 };
+
+/// Axis-aligned sprite marked by its color.
+Colored_sprite make_sprite(float left, float top, float right, float bottom, uchar mark)
+{
+   Colored_sprite s = Colored_sprite();
+   s.vertexes[0].position.x = left;
+   s.vertexes[0].position.y = top;
+   s.vertexes[1].position.x = right;
+   s.vertexes[1].position.y = top;
+   s.vertexes[2].position.x = left;
+   s.vertexes[2].position.y = bottom;
+   s.vertexes[3].position.x = right;
+   s.vertexes[3].position.y = bottom;
+   for (uint i = 0; i < 4; ++i)
+   {
+      // color bytes may form NaN when read as float; culling should not care
+      s.vertexes[i].color.a = 0xFF;
+      s.vertexes[i].color.r = 0xFF;
+      s.vertexes[i].color.g = 0xFF;
+      s.vertexes[i].color.b = mark;
+   }
+   return s;
+}
+
+Bounds make_bounds(float left, float top, float right, float bottom)
+{
+   const Bounds b = { left, top, right, bottom };
+   return b;
+}
+
+/// Random rectangle, some of them outside of world or larger than any cell.
+Bounds make_random_bounds(const Bounds& world)
+{
+   const float world_width = world.right - world.left;
+   const float x = world.left - world_width/4 + rand() % int(world_width*1.5f);
+   const float y = world.top - world_width/4 + rand() % int(world_width*1.5f);
+   const float size = rand() % 8 == 0 ? float(rand() % int(world_width)) : float(rand() % 64);
+   return make_bounds(x, y, x + size, y + size/2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprites touching viewport stay, in the same order.
+void test_cull_sprites()
+{
+   vector<Colored_sprite> sprites;
+   sprites.push_back(make_sprite(-20, -20, -1, -1, 0));        // culled
+   sprites.push_back(make_sprite(-20, -20, 0, 0, 1));          // touches corner
+   sprites.push_back(make_sprite(100, 100, 120, 120, 2));
+   sprites.push_back(make_sprite(641, 100, 700, 120, 3));      // culled
+   sprites.push_back(make_sprite(-100, 200, 1000, 220, 4));    // spans viewport
+   sprites.push_back(make_sprite(100, 481, 120, 500, 5));      // culled
+   sprites.push_back(make_sprite(630, 470, 650, 490, 6));
+
+   BOOST_CHECK_EQUAL(cull_sprites(sprites, viewport), 3u);
+   BOOST_REQUIRE_EQUAL(sprites.size(), 4u);
+   BOOST_CHECK_EQUAL(uint(sprites[0].vertexes[0].color.b), 1u);
+   BOOST_CHECK_EQUAL(uint(sprites[1].vertexes[0].color.b), 2u);
+   BOOST_CHECK_EQUAL(uint(sprites[2].vertexes[0].color.b), 4u);
+   BOOST_CHECK_EQUAL(uint(sprites[3].vertexes[0].color.b), 6u);
+
+   // rotated sprite is tested by all corners
+   Textured_sprite rotated = Textured_sprite();
+   rotated.vertexes[0].position.x = 700;
+   rotated.vertexes[0].position.y = -50;
+   rotated.vertexes[1].position.x = 600;
+   rotated.vertexes[1].position.y = -10;
+   rotated.vertexes[2].position.x = 660;
+   rotated.vertexes[2].position.y = 50;
+   rotated.vertexes[3].position.x = 750;
+   rotated.vertexes[3].position.y = 10;
+   vector<Textured_sprite> textured(1, rotated);
+   BOOST_CHECK_EQUAL(cull_sprites(textured, viewport), 0u);
+   BOOST_CHECK_EQUAL(textured.size(), 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Quadtree finds the same items as testing each of them.
+void test_quadtree()
+{
+   const Bounds world = make_bounds(0, 0, 1024, 1024);
+   Loose_quadtree tree(world, 4);
+
+   vector<Bounds> items;
+   vector<bool> present;
+   for (uint i = 0; i < 500; ++i)
+   {
+      items.push_back(make_random_bounds(world));
+      present.push_back(true);
+      tree.insert(i, items.back());
+   }
+   // move and remove some
+   for (uint i = 0; i < 500; i += 3)
+   {
+      items[i] = make_random_bounds(world);
+      tree.move(i, items[i]);
+   }
+   for (uint i = 0; i < 500; i += 7)
+   {
+      present[i] = false;
+      tree.remove(i);
+   }
+   BOOST_CHECK_EQUAL(tree.get_size(), 500u - 72);
+
+   for (uint query = 0; query < 50; ++query)
+   {
+      const Bounds area = make_random_bounds(world);
+
+      vector<uint> found;
+      tree.query(area, found);
+      sort(found.begin(), found.end());
+
+      vector<uint> expected;
+      for (uint i = 0; i < items.size(); ++i)
+      {
+         if (present[i] && intersect(items[i], area))
+         {
+            expected.push_back(i);
+         }
+      }
+      BOOST_REQUIRE_EQUAL(found.size(), expected.size());
+      BOOST_CHECK(found == expected);
+   }
+
+   // removed id is reused
+   tree.insert(0, make_bounds(10, 10, 20, 20));
+   vector<uint> found;
+   tree.query(make_bounds(15, 15, 16, 16), found);
+   BOOST_CHECK(find(found.begin(), found.end(), 0u) != found.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Retained sprites are found by slots, which change as sprites are destroyed.
+void test_visible_slots()
+{
+   Sprite_store<Vertex_format(position | diffuse_color)> store;
+   const Colored_sprite_handle offscreen = store.create(make_sprite(-100, -100, -50, -50, 0));
+   store.create(make_sprite(10, 10, 20, 20, 1));
+   store.create(make_sprite(5000, 10, 5010, 20, 2));
+   store.create(make_sprite(30, 30, 40, 40, 3));
+
+   vector<uint> slots;
+   store.get_visible_slots(viewport, slots);
+   BOOST_REQUIRE_EQUAL(slots.size(), 2u);
+   BOOST_CHECK_EQUAL(slots[0], 1u);
+   BOOST_CHECK_EQUAL(slots[1], 3u);
+
+   // the last sprite moves to the first slot
+   store.destroy(offscreen);
+   Batch_list batches;
+   vector<Queue_entry> translucent;
+   BOOST_CHECK_EQUAL(compile_visible_batches(store, viewport, slots, batches, translucent), 1u);
+   BOOST_CHECK(translucent.empty());
+   BOOST_REQUIRE_EQUAL(slots.size(), 2u);
+   BOOST_CHECK_EQUAL(slots[0], 0u);
+   BOOST_CHECK_EQUAL(slots[1], 1u);
+   BOOST_REQUIRE_EQUAL(batches.size(), 1u);
+   BOOST_CHECK_EQUAL(batches[0].count, 2u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Culling_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Culling_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Culling tests");
+
+   test->add(BOOST_TEST_CASE(test_cull_sprites));
+   test->add(BOOST_TEST_CASE(test_quadtree));
+   test->add(BOOST_TEST_CASE(test_visible_slots));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
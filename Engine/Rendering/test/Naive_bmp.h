@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Straightforward reader of uncompressed 24- and 32-bit BMP files: stream reads and conversion pixel by pixel.
+// Reference for checking and measuring native decoder of load_bmp().
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEST_ENGINE_RENDERING_NAIVE_BMP_H_INCLUDED
+#define TEST_ENGINE_RENDERING_NAIVE_BMP_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Image.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline uint naive_read_le(const uchar* p, uint nbytes)
+{
+   uint value = 0;
+   for (uint i = 0; i < nbytes; ++i)
+   {
+      value |= uint(p[i]) << (8*i);
+   }
+   return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return false if file can't be read or its format isn't supported.
+inline bool naive_load_bmp(const std::string& file_name, Image& image)
+{
+   std::ifstream file(file_name.c_str(), std::ios::binary);
+   uchar header[54];
+   if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 'B' || header[1] != 'M')
+   {
+      return false;
+   }
+
+   const uint offset      = naive_read_le(header + 10, 4);
+   const int  width       = static_cast<int>(naive_read_le(header + 18, 4));
+   const int  height      = static_cast<int>(naive_read_le(header + 22, 4));
+   const uint bpp         = naive_read_le(header + 28, 2);
+   const uint compression = naive_read_le(header + 30, 4);
+   if (width <= 0 || height == 0 || (bpp != 24 && bpp != 32) || compression != 0)
+   {
+      return false;
+   }
+
+   const bool bottom_up = height > 0;
+   const uint rows      = bottom_up ? height : -height;
+   const uint bytes_per_pixel = bpp / 8;
+   const uint row_bytes = (width*bytes_per_pixel + 3) & ~3u;
+
+   image = Image(width, rows);
+   std::vector<uchar> row(row_bytes);
+
+   file.seekg(offset);
+   for (uint y = 0; y < rows; ++y)
+   {
+      if (!file.read(reinterpret_cast<char*>(&row[0]), row_bytes))
+      {
+         return false;
+      }
+
+      uint* dst = &image.pixels[(bottom_up ? rows - 1 - y : y)*width];
+      const uchar* src = &row[0];
+      for (int x = 0; x < width; ++x, src += bytes_per_pixel)
+      {
+         const uchar alpha = bytes_per_pixel == 4 ? src[3] : 0xFF;
+         dst[x] = make_argb(alpha, src[2], src[1], src[0]);
+      }
+   }
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // TEST_ENGINE_RENDERING_NAIVE_BMP_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Measures how building of scene scales with number of threads filling Parallel_scene.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Scene_buffer.h"
+#include "Engine/Rendering/Software/Software_renderer.h"
+
+#include "Engine/Timing/Stopwatch.h"
+
+#include "boost/bind.hpp"
+#include "boost/thread/barrier.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Parallel_scene_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint sprites_number = 100000;
+const uint frames         = 100;
+const uint max_threads    = 16;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Game logic stand-in: sprite moves along its own orbit.
+Textured_sprite make_sprite(uint i, uint frame, const Texture_ID& texture)
+{
+   const float angle  = frame*0.01f*(1 + i % 7) + i*0.001f;
+   const float radius = 50.0f + i % 200;
+   const float x = 320 + radius*std::cos(angle);
+   const float y = 240 + radius*std::sin(angle);
+
+   Textured_sprite s;
+   for (uint j = 0; j < 4; ++j)
+   {
+      s.vertexes[j].position.x = x + (j & 1)*8;
+      s.vertexes[j].position.y = y + (j >> 1)*8;
+      s.vertexes[j].position.z = 0.5f;
+      s.vertexes[j].color.a = 255;
+      s.vertexes[j].color.r = uchar(i);
+      s.vertexes[j].color.g = uchar(frame);
+      s.vertexes[j].color.b = uchar(angle*64);
+      s.vertexes[j].texture_coord.tu = float(j & 1);
+      s.vertexes[j].texture_coord.tv = float(j >> 1);
+   }
+   s.texture  = texture;
+   s.blending = blending_mode_modulate;
+   return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Threads build each frame together; main thread submits it once all of them are done.
+class Frame_builder
+{
+public:
+
+   Frame_builder(uint threads_number, const Texture_ID& texture)
+      : m_scene(threads_number), m_start(threads_number + 1), m_done(threads_number + 1), m_texture(texture) { }
+
+   void run(Renderer& renderer)
+   {
+      boost::thread_group threads;
+      for (uint i = 0; i < m_scene.get_threads_number(); ++i)
+      {
+         threads.create_thread(boost::bind(&Frame_builder::build, this, i));
+      }
+
+      for (uint frame = 0; frame < frames; ++frame)
+      {
+         m_start.wait();
+         m_done.wait();
+         m_scene.submit(renderer);
+         renderer.clear_scene();
+      }
+
+      threads.join_all();
+   }
+
+private:
+
+   /// Fills buffer of given thread with its share of sprites every frame.
+   void build(uint thread)
+   {
+      const uint threads_number = m_scene.get_threads_number();
+      const uint first = sprites_number*thread / threads_number;
+      const uint end   = sprites_number*(thread + 1) / threads_number;
+      Scene_buffer& buffer = m_scene.get_buffer(thread);
+
+      for (uint frame = 0; frame < frames; ++frame)
+      {
+         m_start.wait();
+         for (uint i = first; i < end; ++i)
+         {
+            buffer.add_to_scene(make_sprite(i, frame, m_texture));
+         }
+         m_done.wait();
+      }
+   }
+
+private:
+
+   Parallel_scene m_scene;
+   boost::barrier m_start;
+   boost::barrier m_done;
+   Texture_ID     m_texture;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const char* name, uint threads_number, double seconds, double single_thread_seconds)
+{
+   cout << name << threads_number << " threads: " << seconds * 1000 / frames << " ms per frame, speedup "
+        << single_thread_seconds / seconds << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   // texture is interned once, copying Texture_ID is safe from any thread
+   const Texture_ID texture("parallel_banana.bmp");
+   Software_renderer renderer(640, 480);
+
+   cout << sprites_number << " sprites per frame, " << frames << " frames" << endl;
+
+   // baseline: sprites are added to renderer directly by the main thread
+   Timing::Stopwatch stopwatch;
+   for (uint frame = 0; frame < frames; ++frame)
+   {
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         renderer.add_to_scene(make_sprite(i, frame, texture));
+      }
+      renderer.clear_scene();
+   }
+   const double direct_seconds = stopwatch.get_elapsed();
+   cout << "Direct: " << direct_seconds * 1000 / frames << " ms per frame" << endl;
+
+   for (uint threads_number = 1; threads_number <= max_threads; threads_number *= 2)
+   {
+      Frame_builder builder(threads_number, texture);
+      stopwatch.restart();
+      builder.run(renderer);
+      report("Parallel_scene, ", threads_number, stopwatch.get_elapsed(), direct_seconds);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Parallel_scene_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Rendering::Parallel_scene_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Fake batch device that records calls made to it, so drawing could be checked without real device.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEST_ENGINE_RENDERING_RECORDING_DEVICE_H_INCLUDED
+#define TEST_ENGINE_RENDERING_RECORDING_DEVICE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Batch.h"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Device that just remembers what was requested to draw.
+class Recording_device : public Engine::Rendering::Batch_device
+{
+public:
+
+   /// Single draw_quads() call along with state it was made with.
+   struct Draw
+   {
+      Engine::Rendering::Vertex_format format;
+      uint                             first_quad;
+      uint                             nquads;
+      Engine::Rendering::Texture_ID    texture0;
+      Engine::Rendering::Blending_mode blending0;
+   };
+
+public:
+
+   Recording_device() : m_format(Engine::Rendering::position), m_state_changes(0) { }
+
+   void set_vertex_format(Engine::Rendering::Vertex_format format)
+   {
+      m_format = format;
+      ++m_state_changes;
+   }
+
+   void set_texture(uint nstage, const Engine::Rendering::Texture_ID& texture)
+   {
+      m_textures[nstage] = texture;
+      ++m_state_changes;
+   }
+
+   void set_blending(uint nstage, Engine::Rendering::Blending_mode blending)
+   {
+      m_blendings[nstage] = blending;
+      ++m_state_changes;
+   }
+
+   void draw_quads(uint first_quad, uint nquads)
+   {
+      Draw draw = { m_format, first_quad, nquads, m_textures[0], m_blendings[0] };
+      m_draws.push_back(draw);
+   }
+
+   const std::vector<Draw>& get_draws() const { return m_draws; }
+   uint get_state_changes() const             { return m_state_changes; }
+
+private:
+
+   Engine::Rendering::Vertex_format m_format;
+   Engine::Rendering::Texture_ID    m_textures[Engine::Rendering::batch_stages_number];
+   Engine::Rendering::Blending_mode m_blendings[Engine::Rendering::batch_stages_number];
+   std::vector<Draw>                m_draws;
+   uint                             m_state_changes;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // TEST_ENGINE_RENDERING_RECORDING_DEVICE_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
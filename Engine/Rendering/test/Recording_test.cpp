@@ -0,0 +1,344 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for scene recording and replaying.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Call_log.h"
+
+#include "Engine/Rendering/Recording_renderer.h"
+#include "Engine/Rendering/Scene_player.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>              // for std::memcmp
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Recording_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprites have no padding, so they could be compared bytewise.
+template <class Sprite_type>
+bool equal_sprites(const vector<Sprite_type>& lhs, const vector<Sprite_type>& rhs)
+{
+   return lhs.size() == rhs.size() && (lhs.empty() || memcmp(&lhs[0], &rhs[0], lhs.size()*sizeof(lhs[0])) == 0);
+}
+
+/// Fills sprite with distinct values.
+template <class Sprite_type>
+void fill_sprite(Sprite_type& s, uint seed)
+{
+   float* coords = reinterpret_cast<float*>(&s.vertexes[0]);
+   const uint nbytes = sizeof(s.vertexes);
+   for (uint i = 0; i < nbytes / sizeof(float); ++i)
+   {
+      coords[i] = seed + i*0.25f;
+   }
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].color.a = uchar(seed + i);
+      s.vertexes[i].color.r = uchar(seed + 2*i);
+      s.vertexes[i].color.g = uchar(seed + 3*i);
+      s.vertexes[i].color.b = uchar(seed + 4*i);
+   }
+}
+
+/// Records two frames and returns stream.
+string record(Call_log& target)
+{
+   ostringstream out;
+   Recording_renderer recorder(target, out);
+
+   Colored_sprite c;
+   fill_sprite(c, 1);
+   Textured_sprite t;
+   fill_sprite(t, 2);
+   t.texture  = Texture_ID("recorded_banana.bmp");
+   t.blending = blending_mode_modulate;
+   Multitextured_2_sprite m;
+   fill_sprite(m, 3);
+   m.texture0  = Texture_ID("recorded_banana.bmp");
+   m.blending0 = blending_mode_add;
+   m.texture1  = Texture_ID();
+   m.blending1 = blending_mode_disable;
+
+   recorder.add_to_scene(c);
+   recorder.add_to_scene(t);
+   recorder.add_to_scene(m);
+   recorder.render_scene();
+   recorder.clear_scene();
+
+   t.blending = blending_mode_select_arg1;
+   recorder.add_to_scene(t);
+   recorder.try_restore();
+   recorder.render_scene();
+   recorder.clear_scene();
+
+   return out.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Recorder passes calls through; replaying produces the same calls.
+void test_round_trip()
+{
+   Call_log original;
+   const string stream = record(original);
+   BOOST_CHECK(original.calls == "ctmRCt!RC");
+
+   Call_log replayed;
+   Scene_player player(stream.data(), stream.size());
+   BOOST_CHECK(player.play_frame(replayed));
+   BOOST_CHECK(replayed.calls == "ctmR");
+   BOOST_CHECK(player.play_frame(replayed));
+   BOOST_CHECK(!player.play_frame(replayed));
+   BOOST_CHECK(replayed.calls == "ctmRCtRC");
+
+   BOOST_CHECK(equal_sprites(replayed.colored, original.colored));
+   BOOST_CHECK(equal_sprites(replayed.textured, original.textured));
+   BOOST_CHECK(equal_sprites(replayed.multitextured, original.multitextured));
+
+   // played again after rewind
+   player.rewind(replayed);
+   BOOST_CHECK(player.play_frame(replayed));
+   BOOST_CHECK(replayed.calls == "ctmRCtRCctmR");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Calls on retained sprites are replayed with handles given by renderer played to.
+void test_retained()
+{
+   Call_log original;
+   ostringstream out;
+   {
+      Recording_renderer recorder(original, out);
+
+      Textured_sprite t;
+      fill_sprite(t, 5);
+      t.texture  = Texture_ID("retained_stain.bmp");
+      t.blending = blending_mode_add;
+      Multitextured_2_sprite m;
+      fill_sprite(m, 6);
+      m.texture0  = Texture_ID("retained_banana.bmp");
+      m.blending0 = blending_mode_add;
+      m.texture1  = Texture_ID("retained_stain.bmp");
+      m.blending1 = blending_mode_modulate;
+
+      const Textured_sprite_handle textured = recorder.create_sprite(t);
+      const Multitextured_2_sprite_handle multitextured = recorder.create_sprite(m);
+      recorder.render_scene();
+
+      t.blending = blending_mode_modulate;
+      recorder.update_sprite(textured, t);
+      recorder.destroy_sprite(multitextured);
+      recorder.render_scene();
+   }
+   BOOST_CHECK(original.calls == "nnRudR");
+
+   const string stream = out.str();
+   Call_log replayed(100);
+   Scene_player player(stream.data(), stream.size());
+   BOOST_CHECK(player.play_frame(replayed));
+   BOOST_CHECK(player.play_frame(replayed));
+   BOOST_CHECK(replayed.calls == "nnRudR");
+
+   BOOST_CHECK(equal_sprites(replayed.textured, original.textured));
+   BOOST_CHECK(equal_sprites(replayed.multitextured, original.multitextured));
+   BOOST_REQUIRE(replayed.updated.size() == 1 && replayed.destroyed.size() == 1);
+   BOOST_CHECK_EQUAL(replayed.updated[0], 100u);
+   BOOST_CHECK_EQUAL(replayed.destroyed[0], 101u);
+
+   // sprites still retained are destroyed on rewind
+   player.rewind(replayed);
+   BOOST_REQUIRE(replayed.destroyed.size() == 2);
+   BOOST_CHECK_EQUAL(replayed.destroyed[1], 100u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprites of scene buffer are recorded as added one by one.
+void test_scene_buffer()
+{
+   Call_log original;
+   ostringstream out;
+   {
+      Recording_renderer recorder(original, out);
+
+      Scene_buffer buffer;
+      Textured_sprite t;
+      fill_sprite(t, 7);
+      t.texture  = Texture_ID("buffered_banana.bmp");
+      t.blending = blending_mode_modulate;
+      buffer.add_to_scene(t);
+      Colored_sprite c;
+      fill_sprite(c, 8);
+      buffer.add_to_scene(c);
+      fill_sprite(t, 9);
+      buffer.add_to_scene(t);
+
+      recorder.add_to_scene(buffer);
+      recorder.render_scene();
+
+      // empty buffer writes nothing
+      recorder.add_to_scene(Scene_buffer());
+   }
+   BOOST_CHECK(original.calls == "bRb");
+
+   const string stream = out.str();
+   Call_log replayed;
+   Scene_player player(stream.data(), stream.size());
+   BOOST_CHECK(player.play_frame(replayed));
+   BOOST_CHECK(!player.play_frame(replayed));
+   BOOST_CHECK(replayed.calls == "cttR");
+   BOOST_CHECK(equal_sprites(replayed.colored, original.colored));
+   BOOST_CHECK(equal_sprites(replayed.textured, original.textured));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Instances are replayed as textured sprites they are expanded into.
+void test_instances()
+{
+   Sprite_instance instances[5];
+   for (uint i = 0; i < 5; ++i)
+   {
+      const Sprite_instance instance = { 10.0f*i, 5.0f, 4.0f, 2.0f, 0.3f*i, { 0xFF, uchar(i), 0, 0 },
+                                         0, 0, 65535, 65535 };
+      instances[i] = instance;
+   }
+   const Sprite_instances submitted = { instances, 5, Texture_ID("instanced_banana.bmp"), blending_mode_modulate,
+                                        0.5f };
+
+   Call_log original;
+   ostringstream out;
+   {
+      Recording_renderer recorder(original, out);
+      recorder.add_to_scene(submitted);
+      recorder.render_scene();
+   }
+   BOOST_CHECK(original.calls == "iR");
+
+   const string stream = out.str();
+   Call_log replayed;
+   Scene_player player(stream.data(), stream.size());
+   BOOST_CHECK(player.play_frame(replayed));
+   BOOST_CHECK(replayed.calls == "tttttR");
+   BOOST_CHECK(equal_sprites(replayed.textured, original.textured));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Texture names are written once; stream is compact.
+void test_compact()
+{
+   // texture that isn't recorded doesn't take stream handle
+   Texture_ID("unrecorded_stain.bmp");
+
+   Call_log target;
+   const string stream = record(target);
+
+   uint first_handle = 0;
+   const size_t texture_start = 8 + 1 + 4*(3*sizeof(float) + 4);
+   BOOST_REQUIRE(stream.size() > texture_start + sizeof(first_handle));
+   BOOST_CHECK(stream[texture_start] == scene_record_texture);
+   stream.copy(reinterpret_cast<char*>(&first_handle), sizeof(first_handle), texture_start + 1);
+   BOOST_CHECK_EQUAL(first_handle, 1u);
+
+   const string name = "recorded_banana.bmp";
+   BOOST_CHECK(stream.find(name) != string::npos);
+   BOOST_CHECK(stream.find(name, stream.find(name) + 1) == string::npos);
+
+   BOOST_CHECK(stream.size() < sizeof(Colored_sprite) + 2*sizeof(Textured_sprite) + sizeof(Multitextured_2_sprite)
+                               + name.size() + 64);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_malformed()
+{
+   Call_log target;
+   const string stream = record(target);
+
+   const string wrong_signature = "XXXX" + stream.substr(4);
+   BOOST_CHECK_THROW(Scene_player(wrong_signature.data(), wrong_signature.size()), Scene_format_exception);
+
+   // truncated in the middle of the first sprite
+   Scene_player player(stream.data(), 20);
+   BOOST_CHECK_THROW(player.play_frame(target), Scene_format_exception);
+
+   // texture used without definition: header, colored sprite record, textured sprite record w/o texture record
+   const size_t colored_end = 8 + 1 + 4*(3*sizeof(float) + 4);
+   const size_t texture_end = colored_end + 1 + 4 + 2 + string("recorded_banana.bmp").size();
+   const string undefined = stream.substr(0, colored_end) + stream.substr(texture_end);
+   Scene_player undefined_player(undefined.data(), undefined.size());
+   BOOST_CHECK_THROW(undefined_player.play_frame(target), Scene_format_exception);
+
+   // texture handle far beyond ones defined would make player allocate table for it
+   const uint far_handle = 0x7FFFFFFF;
+   const string far_texture = stream.substr(0, 8) + char(scene_record_texture)
+                              + string(reinterpret_cast<const char*>(&far_handle), sizeof(far_handle)) + string(2, '\0');
+   Scene_player far_texture_player(far_texture.data(), far_texture.size());
+   BOOST_CHECK_THROW(far_texture_player.play_frame(target), Scene_format_exception);
+
+   // unknown record
+   const string unknown = stream.substr(0, 8) + '\x7F';
+   Scene_player unknown_player(unknown.data(), unknown.size());
+   BOOST_CHECK_THROW(unknown_player.play_frame(target), Scene_format_exception);
+
+   // retained sprite destroyed without creation
+   const string not_created = stream.substr(0, 8) + char(scene_record_destroy) + string(4, '\0')
+                              + char(scene_record_colored);
+   Scene_player not_created_player(not_created.data(), not_created.size());
+   BOOST_CHECK_THROW(not_created_player.play_frame(target), Scene_format_exception);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Recording_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Recording_test;
+
+   // player logs errors
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Recording tests");
+
+   test->add(BOOST_TEST_CASE(test_round_trip));
+   test->add(BOOST_TEST_CASE(test_retained));
+   test->add(BOOST_TEST_CASE(test_scene_buffer));
+   test->add(BOOST_TEST_CASE(test_instances));
+   test->add(BOOST_TEST_CASE(test_compact));
+   test->add(BOOST_TEST_CASE(test_malformed));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
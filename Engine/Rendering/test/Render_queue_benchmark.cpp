@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compares radix sort of render queue with comparison sort, and measures whole sorting of scene.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Render_queue.h"
+
+#include "Engine/Timing/Stopwatch.h"
+
+#include <algorithm>
+#include <cstdlib>              // for std::rand
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Render_queue_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint sprites_number = 100000;
+const uint textures       = 64;
+const uint frames         = 50;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const char* name, double seconds)
+{
+   cout << name << ": " << seconds * 1000 / frames << " ms per frame, "
+        << static_cast<ulong>(double(frames)*sprites_number / seconds) << " sprites/s" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool is_less_key(const Queue_entry& lhs, const Queue_entry& rhs)
+{
+   return lhs.key < rhs.key;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Scene of sprites with random depths and textures, every eighth of them translucent.
+void make_scene(vector<Textured_sprite>& sprites)
+{
+   vector<Texture_ID> ids;
+   for (uint i = 0; i < textures; ++i)
+   {
+      ostringstream name;
+      name << "queue_" << i << ".bmp";
+      ids.push_back(Texture_ID(name.str()));
+   }
+
+   sprites.resize(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      Textured_sprite& s = sprites[i];
+      const float z = float(rand() % 10000) / 10000;
+      for (uint j = 0; j < 4; ++j)
+      {
+         s.vertexes[j].position.x = float(j & 1);
+         s.vertexes[j].position.y = float(j >> 1);
+         s.vertexes[j].position.z = z;
+         s.vertexes[j].color.a    = i % 8 == 0 ? 128 : 255;
+      }
+      s.texture  = ids[rand() % textures];
+      s.blending = blending_mode_modulate;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   vector<Textured_sprite> scene;
+   make_scene(scene);
+
+   vector<Queue_entry> keys;
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      const Queue_entry entry = { make_sort_key(scene[i]), Vertex_format(position | diffuse_color | texture_coord0),
+                                  i };
+      keys.push_back(entry);
+   }
+
+   cout << sprites_number << " sprites, " << textures << " textures" << endl;
+
+   vector<Queue_entry> entries;
+   vector<Queue_entry> buffer;
+   Timing::Stopwatch stopwatch;
+   for (uint frame = 0; frame < frames; ++frame)
+   {
+      entries = keys;
+      stable_sort(entries.begin(), entries.end(), is_less_key);
+   }
+   report("std::stable_sort", stopwatch.get_elapsed());
+
+   stopwatch.restart();
+   for (uint frame = 0; frame < frames; ++frame)
+   {
+      entries = keys;
+      radix_sort(entries, buffer);
+   }
+   report("radix_sort", stopwatch.get_elapsed());
+
+   // keys, sort, reordering of sprites and batches
+   Render_queue queue;
+   vector<Colored_sprite> colored;
+   vector<Textured_sprite> textured;
+   vector<Multitextured_2_sprite> multitextured;
+   Batch_list batches;
+   stopwatch.restart();
+   for (uint frame = 0; frame < frames; ++frame)
+   {
+      textured = scene;
+      batches.clear();
+      queue.sort(colored, textured, multitextured, batches);
+   }
+   report("Render_queue::sort", stopwatch.get_elapsed());
+   cout << batches.size() << " batches" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Render_queue_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Rendering::Render_queue_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for render queue.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Render_queue.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <cstdlib>              // for std::rand
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Render_queue_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprite of given depth and alpha, marked by its x coordinate.
+template <class Sprite_type>
+Sprite_type make_sprite(float mark, float z, uchar alpha)
+{
+   Sprite_type s = Sprite_type();
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].position.x = mark;
+      s.vertexes[i].position.z = z;
+      s.vertexes[i].color.a    = alpha;
+   }
+   return s;
+}
+
+Textured_sprite make_textured(float mark, float z, uchar alpha, const char* texture)
+{
+   Textured_sprite s = make_sprite<Textured_sprite>(mark, z, alpha);
+   s.texture  = Texture_ID(texture);
+   s.blending = blending_mode_modulate;
+   return s;
+}
+
+bool is_less_key(const Queue_entry& lhs, const Queue_entry& rhs)
+{
+   return lhs.key < rhs.key;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Radix sort gives the same order as stable comparison sort.
+void test_radix_sort()
+{
+   vector<Queue_entry> entries;
+   vector<Queue_entry> buffer;
+   radix_sort(entries, buffer);
+   BOOST_CHECK(entries.empty());
+
+   for (uint i = 0; i < 5000; ++i)
+   {
+      // few distinct keys with bits spread over all bytes
+      const uint value = rand() % 64;
+      const Queue_entry entry = { Sort_key(value & 7) << 61 | Sort_key(value >> 3) << 20 | (value & 1),
+                                  Vertex_format(position | diffuse_color), i };
+      entries.push_back(entry);
+   }
+
+   vector<Queue_entry> expected = entries;
+   stable_sort(expected.begin(), expected.end(), is_less_key);
+
+   radix_sort(entries, buffer);
+   BOOST_REQUIRE_EQUAL(entries.size(), expected.size());
+   for (size_t i = 0; i < entries.size(); ++i)
+   {
+      BOOST_REQUIRE(entries[i].key == expected[i].key);
+      BOOST_REQUIRE_EQUAL(entries[i].index, expected[i].index);
+   }
+
+   // keys that differ only in one byte need single pass
+   for (size_t i = 0; i < entries.size(); ++i)
+   {
+      entries[i].key = Sort_key(entries.size() - i) & 0xFF;
+   }
+   radix_sort(entries, buffer);
+   for (size_t i = 1; i < entries.size(); ++i)
+   {
+      BOOST_REQUIRE(entries[i - 1].key <= entries[i].key);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_keys()
+{
+   // opaque sprites go before translucent ones
+   BOOST_CHECK(make_sort_key(make_sprite<Colored_sprite>(0, 0.9f, 255))
+               < make_sort_key(make_sprite<Colored_sprite>(0, 0.1f, 254)));
+
+   // opaque sprites are grouped by state first, then go front to back
+   const Textured_sprite a_far  = make_textured(0, 0.9f, 255, "queue_a.bmp");
+   const Textured_sprite b_near = make_textured(0, 0.1f, 255, "queue_b.bmp");
+   const Textured_sprite a_near = make_textured(0, 0.1f, 255, "queue_a.bmp");
+   BOOST_CHECK(make_sort_key(a_far) < make_sort_key(b_near));
+   BOOST_CHECK(make_sort_key(a_near) < make_sort_key(a_far));
+   BOOST_CHECK(make_sort_key(make_sprite<Colored_sprite>(0, 0.9f, 255)) < make_sort_key(a_near));
+
+   // translucent sprites go back to front regardless of state
+   const Textured_sprite b_far_translucent  = make_textured(0, 0.9f, 128, "queue_b.bmp");
+   const Textured_sprite a_near_translucent = make_textured(0, 0.1f, 128, "queue_a.bmp");
+   BOOST_CHECK(make_sort_key(b_far_translucent) < make_sort_key(a_near_translucent));
+
+   // depth is clamped
+   BOOST_CHECK(make_sort_key(make_sprite<Colored_sprite>(0, -5, 255))
+               == make_sort_key(make_sprite<Colored_sprite>(0, 0, 255)));
+   BOOST_CHECK(make_sort_key(make_sprite<Colored_sprite>(0, 5, 255))
+               == make_sort_key(make_sprite<Colored_sprite>(0, 1, 255)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprites are reordered and batches follow the order of keys across formats.
+void test_sort()
+{
+   vector<Colored_sprite> colored;
+   colored.push_back(make_sprite<Colored_sprite>(0, 0.2f, 128));    // translucent, the nearest
+   colored.push_back(make_sprite<Colored_sprite>(1, 0.5f, 255));
+
+   vector<Textured_sprite> textured;
+   textured.push_back(make_textured(10, 0.5f, 255, "queue_b.bmp"));
+   textured.push_back(make_textured(11, 0.5f, 255, "queue_a.bmp"));
+   textured.push_back(make_textured(12, 0.9f, 128, "queue_a.bmp")); // translucent, the farthest
+   textured.push_back(make_textured(13, 0.3f, 255, "queue_b.bmp"));
+
+   vector<Multitextured_2_sprite> multitextured;
+
+   Render_queue queue;
+   Batch_list batches;
+   const uint opaque_batches = queue.sort(colored, textured, multitextured, batches);
+
+   BOOST_REQUIRE_EQUAL(colored.size(), 2u);
+   BOOST_CHECK_EQUAL(colored[0].vertexes[0].position.x, 1);
+   BOOST_CHECK_EQUAL(colored[1].vertexes[0].position.x, 0);
+   BOOST_REQUIRE_EQUAL(textured.size(), 4u);
+   BOOST_CHECK_EQUAL(textured[0].vertexes[0].position.x, 11);
+   BOOST_CHECK_EQUAL(textured[1].vertexes[0].position.x, 13);
+   BOOST_CHECK_EQUAL(textured[2].vertexes[0].position.x, 10);
+   BOOST_CHECK_EQUAL(textured[3].vertexes[0].position.x, 12);
+
+   // opaque: colored, texture a, texture b; translucent: far textured, near colored
+   BOOST_CHECK_EQUAL(opaque_batches, 3u);
+   BOOST_REQUIRE_EQUAL(batches.size(), 5u);
+   BOOST_CHECK(batches[0].format == Vertex_format(position | diffuse_color));
+   BOOST_CHECK(batches[0].first == 0 && batches[0].count == 1);
+   BOOST_CHECK(batches[1].format == Vertex_format(position | diffuse_color | texture_coord0));
+   BOOST_CHECK(batches[1].first == 0 && batches[1].count == 1);
+   BOOST_CHECK(batches[1].textures[0] == Texture_ID("queue_a.bmp"));
+   BOOST_CHECK(batches[2].first == 1 && batches[2].count == 2);
+   BOOST_CHECK(batches[2].textures[0] == Texture_ID("queue_b.bmp"));
+   BOOST_CHECK(batches[3].first == 3 && batches[3].count == 1);
+   BOOST_CHECK(batches[4].format == Vertex_format(position | diffuse_color));
+   BOOST_CHECK(batches[4].first == 1 && batches[4].count == 1);
+
+   // nothing to sort
+   colored.clear();
+   textured.clear();
+   batches.clear();
+   BOOST_CHECK_EQUAL(queue.sort(colored, textured, multitextured, batches), 0u);
+   BOOST_CHECK(batches.empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Render_queue_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Render_queue_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Render_queue tests");
+
+   test->add(BOOST_TEST_CASE(test_radix_sort));
+   test->add(BOOST_TEST_CASE(test_keys));
+   test->add(BOOST_TEST_CASE(test_sort));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Counts heap allocations made while scene is built.
+// Compares sprites identifying textures by file name (as they did before interning) with current ones.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite.h"
+
+#include <iostream>
+#include <cstdlib>              // for std::malloc and std::free
+#include <new>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// all allocations of program are counted
+
+ulong allocations_number = 0;
+
+void* operator new(std::size_t size) throw (std::bad_alloc)
+{
+   ++allocations_number;
+   void* p = std::malloc(size ? size : 1);
+   if (!p)
+   {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+void operator delete(void* p) throw ()
+{
+   std::free(p);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Scene_allocation_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textured sprite as it was with string-based texture identifier.
+struct Legacy_textured_sprite
+{
+   Vertex<Vertex_format(position | diffuse_color | texture_coord0)> vertexes[4];
+   string         texture_file_name;
+   Blending_mode  blending;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Builds scene the same way renderer does: copies each sprite into vector that is cleared every frame.
+/// \return Average number of allocations per frame.
+template <class Sprite_type>
+double count_allocations(const vector<Sprite_type>& sprites, int frames)
+{
+   vector<Sprite_type> scene;
+
+   // first frame reserves storage; it isn't counted
+   scene.assign(sprites.begin(), sprites.end());
+   scene.clear();
+
+   const ulong start = allocations_number;
+   for (int frame = 0; frame < frames; ++frame)
+   {
+      for (size_t i = 0; i < sprites.size(); ++i)
+      {
+         scene.push_back(sprites[i]);
+      }
+      scene.clear();
+   }
+   return static_cast<double>(allocations_number - start) / frames;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   const size_t sprites_number = 5000;
+   const int    frames         = 100;
+
+   // names are long enough not to fit into small string buffer, as real paths usually are
+   const char* names[] = { "textures/level_01/brick_red.bmp", "textures/level_01/brick_blue.bmp",
+                           "textures/common/particle_spark.bmp" };
+
+   vector<Legacy_textured_sprite> legacy_sprites(sprites_number);
+   vector<Textured_sprite> sprites(sprites_number);
+   for (size_t i = 0; i < sprites_number; ++i)
+   {
+      legacy_sprites[i].texture_file_name = names[i % 3];
+      sprites[i].texture = Texture_ID(names[i % 3]);
+   }
+
+   cout << "Sprites per frame: " << sprites_number << endl;
+   cout << "Allocations per frame, file name texture identifiers: "
+        << count_allocations(legacy_sprites, frames) << endl;
+   cout << "Allocations per frame, interned texture identifiers:  "
+        << count_allocations(sprites, frames) << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Scene_allocation_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Rendering::Scene_allocation_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for scene buffers.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Call_log.h"
+
+#include "Engine/Rendering/Scene_buffer.h"
+
+#include "boost/test/unit_test.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Scene_buffer_test
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprite marked by its x coordinate.
+Colored_sprite make_sprite(float x)
+{
+   Colored_sprite s = Colored_sprite();
+   s.vertexes[0].position.x = x;
+   return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_buffer()
+{
+   Scene_buffer buffer;
+   BOOST_CHECK(buffer.is_empty());
+
+   buffer.add_to_scene(make_sprite(1));
+   buffer.add_to_scene(Textured_sprite());
+   buffer.add_to_scene(make_sprite(2));
+   BOOST_CHECK(!buffer.is_empty());
+   BOOST_REQUIRE_EQUAL(buffer.get_colored_sprites().size(), 2u);
+   BOOST_CHECK_EQUAL(buffer.get_colored_sprites()[1].vertexes[0].position.x, 2);
+   BOOST_CHECK_EQUAL(buffer.get_textured_sprites().size(), 1u);
+   BOOST_CHECK(buffer.get_multitextured_sprites().empty());
+
+   buffer.clear();
+   BOOST_CHECK(buffer.is_empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Buffers go to renderer in order of threads regardless of order they were filled in.
+void test_submit_order()
+{
+   Parallel_scene scene(4);
+   BOOST_CHECK_EQUAL(scene.get_threads_number(), 4u);
+
+   scene.get_buffer(2).add_to_scene(make_sprite(20));
+   scene.get_buffer(0).add_to_scene(make_sprite(0));
+   scene.get_buffer(2).add_to_scene(make_sprite(21));
+   scene.get_buffer(1).add_to_scene(make_sprite(10));
+
+   Call_log renderer;
+   scene.submit(renderer);
+
+   // empty buffer of the last thread isn't submitted
+   BOOST_CHECK(renderer.calls == "bbb");
+   BOOST_REQUIRE_EQUAL(renderer.colored.size(), 4u);
+   BOOST_CHECK_EQUAL(renderer.colored[0].vertexes[0].position.x, 0);
+   BOOST_CHECK_EQUAL(renderer.colored[1].vertexes[0].position.x, 10);
+   BOOST_CHECK_EQUAL(renderer.colored[2].vertexes[0].position.x, 20);
+   BOOST_CHECK_EQUAL(renderer.colored[3].vertexes[0].position.x, 21);
+
+   // buffers are cleared for the next frame
+   for (uint i = 0; i < scene.get_threads_number(); ++i)
+   {
+      BOOST_CHECK(scene.get_buffer(i).is_empty());
+   }
+   scene.submit(renderer);
+   BOOST_CHECK(renderer.calls == "bbb");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Scene_buffer_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Scene_buffer_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Scene_buffer tests");
+
+   test->add(BOOST_TEST_CASE(test_buffer));
+   test->add(BOOST_TEST_CASE(test_submit_order));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,186 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Replays recorded scene and prints frames per second and frame latency percentiles.
+// Usage: Scene_replay_benchmark <scene file> [software|null] [repeat count]
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Scene_player.h"
+#include "Engine/Rendering/Software/Software_renderer.h"
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Timing/Stopwatch.h"
+
+#include "boost/scoped_ptr.hpp"
+
+#include <algorithm>
+#include <cstdlib>              // for std::atoi
+#include <cstring>              // for std::strcmp
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Scene_replay_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint frame_width  = 1280;
+const uint frame_height = 1024;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Renderer that draws nothing; measures cost of replaying itself.
+class Null_renderer : public Renderer
+{
+public:
+
+   Null_renderer() : m_stats() { }
+
+   virtual void add_to_scene(const Colored_sprite&)         {}
+   virtual void add_to_scene(const Textured_sprite&)        {}
+   virtual void add_to_scene(const Multitextured_2_sprite&) {}
+   virtual void add_to_scene(const Scene_buffer&)           {}
+   virtual void add_to_scene(const Sprite_instances&)       {}
+   virtual void render_scene()                              {}
+   virtual void clear_scene()                               {}
+   virtual bool is_focused() const                          { return true; }
+   virtual void try_restore()                               {}
+   virtual const Render_stats& get_render_stats() const     { return m_stats; }
+
+   virtual Colored_sprite_handle create_sprite(const Colored_sprite&)                       { return Colored_sprite_handle(); }
+   virtual Textured_sprite_handle create_sprite(const Textured_sprite&)                     { return Textured_sprite_handle(); }
+   virtual Multitextured_2_sprite_handle create_sprite(const Multitextured_2_sprite&)
+   {
+      return Multitextured_2_sprite_handle();
+   }
+   virtual void update_sprite(Colored_sprite_handle, const Colored_sprite&)                 {}
+   virtual void update_sprite(Textured_sprite_handle, const Textured_sprite&)               {}
+   virtual void update_sprite(Multitextured_2_sprite_handle, const Multitextured_2_sprite&) {}
+   virtual void destroy_sprite(Colored_sprite_handle)                                       {}
+   virtual void destroy_sprite(Textured_sprite_handle)                                      {}
+   virtual void destroy_sprite(Multitextured_2_sprite_handle)                               {}
+
+private:
+
+   Render_stats m_stats;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \param sorted_latencies Non-empty.
+double percentile(const vector<double>& sorted_latencies, uint percent)
+{
+   const size_t index = (sorted_latencies.size() - 1)*percent / 100;
+   return sorted_latencies[index];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int run(int argc, char** argv)
+{
+   if (argc < 2)
+   {
+      cerr << "Usage: " << argv[0] << " <scene file> [software|null] [repeat count]" << endl;
+      return 1;
+   }
+
+   ifstream file(argv[1], ios::binary);
+   if (!file)
+   {
+      cerr << "Can't open " << argv[1] << endl;
+      return 1;
+   }
+   const vector<char> scene((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+   boost::scoped_ptr<Renderer> renderer;
+   if (argc < 3 || strcmp(argv[2], "software") == 0)
+   {
+      renderer.reset(new Software_renderer(frame_width, frame_height));
+   }
+   else if (strcmp(argv[2], "null") == 0)
+   {
+      renderer.reset(new Null_renderer);
+   }
+   else
+   {
+      cerr << "Unknown renderer " << argv[2] << endl;
+      return 1;
+   }
+   const int repeats = argc < 4 ? 1 : atoi(argv[3]);
+
+   Scene_player player(scene.empty() ? 0 : &scene[0], scene.size());
+
+   vector<double> latencies;
+   Timing::Stopwatch total;
+   for (int i = 0; i < repeats; ++i)
+   {
+      for (;;)
+      {
+         Timing::Stopwatch frame;
+         if (!player.play_frame(*renderer))
+         {
+            break;
+         }
+         latencies.push_back(1000*frame.get_elapsed());
+      }
+      player.rewind(*renderer);
+   }
+   const double seconds = total.get_elapsed();
+
+   if (latencies.empty())
+   {
+      cerr << "No frames recorded in " << argv[1] << endl;
+      return 1;
+   }
+
+   sort(latencies.begin(), latencies.end());
+   cout << latencies.size() << " frames in " << seconds << " s, "
+        << latencies.size() / seconds << " frames/s" << endl;
+   cout << "Frame latency, ms: p50 " << percentile(latencies, 50)
+        << ", p90 " << percentile(latencies, 90)
+        << ", p99 " << percentile(latencies, 99)
+        << ", max " << latencies.back() << endl;
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Scene_replay_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::critical);
+
+   try
+   {
+      return Engine::Rendering::Scene_replay_benchmark::run(argc, argv);
+   }
+   catch (const std::exception& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 2;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
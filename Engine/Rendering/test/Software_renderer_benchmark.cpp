@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Measures how many sprites per second Software_renderer draws.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Software/Software_renderer.h"
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Timing/Stopwatch.h"
+
+#include <cstdlib>              // for std::rand
+#include <iostream>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Software_renderer_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint frame_width    = 1280;
+const uint frame_height   = 1024;
+const uint sprite_size    = 32;
+const uint sprites_number = 10000;
+const uint frames         = 20;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// All textures are the same 64x64 checkerboard.
+Image_ptr load(const Texture_ID&, uint& bytes)
+{
+   Image* image = new Image(64, 64);
+   for (uint i = 0; i < image->pixels.size(); ++i)
+   {
+      image->pixels[i] = ((i / 8) + (i / 64 / 8)) % 2 ? 0xFFFFFFFF : 0xFF404040;
+   }
+   bytes = image->pixels.size()*sizeof(uint);
+   return Image_ptr(image);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Places sprite at random position; corners go in the same order main application uses.
+template <class Sprite_type>
+void place_randomly(Sprite_type& s, bool gradient)
+{
+   const float left = static_cast<float>(rand() % (frame_width - sprite_size));
+   const float top  = static_cast<float>(rand() % (frame_height - sprite_size));
+   const float xs[4] = { left, left, left + sprite_size, left + sprite_size };
+   const float ys[4] = { top, top + sprite_size, top + sprite_size, top };
+
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].position.x = xs[i];
+      s.vertexes[i].position.y = ys[i];
+      s.vertexes[i].position.z = 0.5f;
+      s.vertexes[i].color.a = 255;
+      s.vertexes[i].color.r = gradient ? uchar(60*i) : 200;
+      s.vertexes[i].color.g = 100;
+      s.vertexes[i].color.b = 50;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Vertex_type>
+void set_texture_coords(Vertex_type* v, Texture_coord Vertex_type::* coord)
+{
+   const float us[4] = { 0, 0, 1, 1 };
+   const float vs[4] = { 0, 1, 1, 0 };
+   for (uint i = 0; i < 4; ++i)
+   {
+      (v[i].*coord).tu = us[i];
+      (v[i].*coord).tv = vs[i];
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Renders scene several times and prints sprites per second.
+void measure(Software_renderer& renderer, const char* name)
+{
+   renderer.render_scene();      // load textures
+
+   Timing::Stopwatch stopwatch;
+   for (uint i = 0; i < frames; ++i)
+   {
+      renderer.render_scene();
+   }
+   const double seconds = stopwatch.get_elapsed();
+
+   cout << name << ": " << static_cast<ulong>(sprites_number*frames / seconds) << " sprites/s, "
+        << 1000*seconds / frames << " ms per frame" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   cout << sprites_number << " sprites " << sprite_size << "x" << sprite_size
+        << " per frame " << frame_width << "x" << frame_height << endl;
+
+   {
+      Software_renderer renderer(frame_width, frame_height, load);
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         Colored_sprite s;
+         place_randomly(s, false);
+         renderer.add_to_scene(s);
+      }
+      measure(renderer, "Colored, flat");
+   }
+
+   {
+      Software_renderer renderer(frame_width, frame_height, load);
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         Colored_sprite s;
+         place_randomly(s, true);
+         renderer.add_to_scene(s);
+      }
+      measure(renderer, "Colored, gradient");
+   }
+
+   {
+      Software_renderer renderer(frame_width, frame_height, load);
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         Textured_sprite s;
+         place_randomly(s, false);
+         set_texture_coords(s.vertexes, &Vertex<Vertex_format(position | diffuse_color | texture_coord0)>::texture_coord);
+         s.texture  = Texture_ID(i % 2 ? "a.bmp" : "b.bmp");
+         s.blending = blending_mode_modulate;
+         renderer.add_to_scene(s);
+      }
+      measure(renderer, "Textured, modulate");
+   }
+
+   {
+      typedef Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> Multitextured_2_vertex;
+
+      Software_renderer renderer(frame_width, frame_height, load);
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         Multitextured_2_sprite s;
+         place_randomly(s, false);
+         set_texture_coords(s.vertexes, &Multitextured_2_vertex::texture_coord0);
+         set_texture_coords(s.vertexes, &Multitextured_2_vertex::texture_coord1);
+         s.texture0  = Texture_ID("a.bmp");
+         s.blending0 = blending_mode_modulate;
+         s.texture1  = Texture_ID("b.bmp");
+         s.blending1 = blending_mode_add;
+         renderer.add_to_scene(s);
+      }
+      measure(renderer, "Multitextured, modulate + add");
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Software_renderer_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   Engine::Rendering::Software_renderer_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,518 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for Software_renderer.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Software/Software_renderer.h"
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Bmp.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>               // for std::remove
+#include <map>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Software_renderer_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint clear_color = 0xFF0000FF;
+const uint red         = 0xFFFF0000;
+const uint green       = 0xFF00FF00;
+const uint gray        = 0x80808080;
+
+typedef Vertex<Vertex_format(position | diffuse_color | texture_coord0)>                  Textured_vertex;
+typedef Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> Multitextured_2_vertex;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textures are created in memory.
+map<string, Image_ptr> textures;
+
+Image_ptr load(const Texture_ID& id, uint& bytes)
+{
+   bytes = 16;
+   return textures[id.get_file_name()];
+}
+
+/// Creates 2x2 texture.
+void add_texture(const string& name, uint top_left, uint top_right, uint bottom_left, uint bottom_right)
+{
+   Image* image = new Image(2, 2);
+   image->pixels[0] = top_left;
+   image->pixels[1] = top_right;
+   image->pixels[2] = bottom_left;
+   image->pixels[3] = bottom_right;
+   textures[name] = Image_ptr(image);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sets rectangle corners in the same order main application uses: top-left, bottom-left, bottom-right, top-right.
+template <class Sprite_type>
+void set_rectangle(Sprite_type& s, float left, float top, float right, float bottom, float z, uint color)
+{
+   const float xs[4] = { left, left, right, right };
+   const float ys[4] = { top, bottom, bottom, top };
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].position.x = xs[i];
+      s.vertexes[i].position.y = ys[i];
+      s.vertexes[i].position.z = z;
+      s.vertexes[i].color.a = uchar(color >> 24);
+      s.vertexes[i].color.r = uchar(color >> 16);
+      s.vertexes[i].color.g = uchar(color >> 8);
+      s.vertexes[i].color.b = uchar(color);
+   }
+}
+
+/// Texture coordinates go from 0 to 1 across rectangle.
+template <class Vertex_type>
+void set_texture_coords(Vertex_type* v, Texture_coord Vertex_type::* coord)
+{
+   const float us[4] = { 0, 0, 1, 1 };
+   const float vs[4] = { 0, 1, 1, 0 };
+   for (uint i = 0; i < 4; ++i)
+   {
+      (v[i].*coord).tu = us[i];
+      (v[i].*coord).tv = vs[i];
+   }
+}
+
+Colored_sprite make_colored(float left, float top, float right, float bottom, float z, uint color)
+{
+   Colored_sprite s;
+   set_rectangle(s, left, top, right, bottom, z, color);
+   return s;
+}
+
+Textured_sprite make_textured(const string& texture, Blending_mode blending, uint color)
+{
+   Textured_sprite s;
+   set_rectangle(s, 0, 0, 4, 4, 0.5f, color);
+   set_texture_coords(s.vertexes, &Textured_vertex::texture_coord);
+   s.texture = Texture_ID(texture);
+   s.blending = blending;
+   return s;
+}
+
+/// \return Pixel of rendered frame.
+uint get_pixel(const Software_renderer& renderer, uint x, uint y)
+{
+   return renderer.get_frame().pixels[y*renderer.get_frame().width + x];
+}
+
+/// \return Whether all 2x2 blocks of 4x4 frame are filled with given colors.
+bool check_blocks(const Software_renderer& renderer, uint top_left, uint top_right, uint bottom_left, uint bottom_right)
+{
+   const uint etalon[4] = { top_left, top_right, bottom_left, bottom_right };
+   for (uint y = 0; y < 4; ++y)
+   {
+      for (uint x = 0; x < 4; ++x)
+      {
+         if (get_pixel(renderer, x, y) != etalon[2*(y/2) + x/2])
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Pixels whose centers are inside sprite are filled.
+void test_colored()
+{
+   Software_renderer renderer(8, 8, load);
+   renderer.add_to_scene(make_colored(2, 2, 6, 6, 0.5f, red));
+   renderer.render_scene();
+
+   for (uint y = 0; y < 8; ++y)
+   {
+      for (uint x = 0; x < 8; ++x)
+      {
+         const bool inside = x >= 2 && x < 6 && y >= 2 && y < 6;
+         BOOST_CHECK(get_pixel(renderer, x, y) == (inside ? red : clear_color));
+      }
+   }
+
+   // scene is kept until clear_scene()
+   renderer.clear_scene();
+   renderer.render_scene();
+   BOOST_CHECK(get_pixel(renderer, 3, 3) == clear_color);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprites partially outside of frame are clipped.
+void test_clipping()
+{
+   Software_renderer renderer(4, 4, load);
+   renderer.add_to_scene(make_colored(-10, -3, 2, 2, 0.5f, red));
+   renderer.add_to_scene(make_colored(2, 2, 100, 100, 0.5f, green));
+   renderer.render_scene();
+
+   BOOST_CHECK(check_blocks(renderer, red, clear_color, clear_color, green));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Nearer sprite hides farther one regardless of order; on equal depth the later one wins.
+void test_depth()
+{
+   Software_renderer renderer(4, 4, load);
+   renderer.add_to_scene(make_colored(0, 0, 4, 4, 0.3f, green));
+   renderer.add_to_scene(make_colored(0, 0, 4, 2, 0.6f, red));
+   renderer.add_to_scene(make_colored(0, 2, 4, 4, 0.3f, red));
+   renderer.render_scene();
+
+   BOOST_CHECK(check_blocks(renderer, green, green, red, red));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Colors are interpolated between vertexes.
+void test_gradient()
+{
+   Software_renderer renderer(8, 1, load);
+   Colored_sprite s = make_colored(0, 0, 8, 1, 0.5f, 0xFF000000);
+   s.vertexes[2].color.r = s.vertexes[3].color.r = 255;
+   renderer.add_to_scene(s);
+   renderer.render_scene();
+
+   uint previous = 0;
+   for (uint x = 0; x < 8; ++x)
+   {
+      const uint r = (get_pixel(renderer, x, 0) >> 16) & 0xFF;
+      BOOST_CHECK(r > previous || x == 0);
+      BOOST_CHECK(r == (2*x + 1)*255/16 || r == (2*x + 1)*255/16 + 1);
+      previous = r;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Each blending mode combines texture with diffuse color the way Direct3D texture stage does.
+void test_blending_modes()
+{
+   add_texture("quad.bmp", red, green, 0xFF808080, 0x00FFFFFF);
+
+   struct
+   {
+      Blending_mode mode;
+      uint          etalon[4];
+   } cases[] =
+   {
+      { blending_mode_select_arg1,  { red, green, 0xFF808080, 0x00FFFFFF } },
+      { blending_mode_select_arg2,  { gray, gray, gray, gray } },
+      { blending_mode_modulate,     { 0x80800000, 0x80008000, 0x80404040, 0x00808080 } },
+      { blending_mode_add,          { 0xFFFF8080, 0xFF80FF80, 0xFFFFFFFF, 0x80FFFFFF } },
+      { blending_mode_disable,      { gray, gray, gray, gray } },
+   };
+
+   for (uint i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i)
+   {
+      Software_renderer renderer(4, 4, load);
+      renderer.add_to_scene(make_textured("quad.bmp", cases[i].mode, gray));
+      renderer.render_scene();
+
+      BOOST_CHECK(check_blocks(renderer, cases[i].etalon[0], cases[i].etalon[1], cases[i].etalon[2], cases[i].etalon[3]));
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Second stage combines its texture with result of the first one.
+void test_multitextured()
+{
+   add_texture("red.bmp", red, red, red, red);
+   add_texture("mask.bmp", 0xFFFFFFFF, 0, 0xFF808080, 0xFFFFFFFF);
+
+   Multitextured_2_sprite s;
+   set_rectangle(s, 0, 0, 4, 4, 0.5f, gray);
+   set_texture_coords(s.vertexes, &Multitextured_2_vertex::texture_coord0);
+   set_texture_coords(s.vertexes, &Multitextured_2_vertex::texture_coord1);
+   s.texture0  = Texture_ID("red.bmp");
+   s.blending0 = blending_mode_select_arg1;
+   s.texture1  = Texture_ID("mask.bmp");
+   s.blending1 = blending_mode_modulate;
+
+   Software_renderer renderer(4, 4, load);
+   renderer.add_to_scene(s);
+   renderer.render_scene();
+
+   BOOST_CHECK(check_blocks(renderer, red, 0, 0xFF800000, red));
+   BOOST_CHECK(renderer.get_texture_statistics().misses == 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Texture coordinates outside of [0, 1] wrap.
+void test_wrap()
+{
+   add_texture("quad.bmp", red, green, 0xFF808080, 0x00FFFFFF);
+
+   Textured_sprite s = make_textured("quad.bmp", blending_mode_select_arg1, gray);
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].texture_coord.tu += 1.5f;
+      s.vertexes[i].texture_coord.tv -= 3.0f;
+   }
+
+   Software_renderer renderer(4, 4, load);
+   renderer.add_to_scene(s);
+   renderer.render_scene();
+
+   BOOST_CHECK(check_blocks(renderer, green, red, 0x00FFFFFF, 0xFF808080));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Instance is drawn as textured sprite; turning it turns texture.
+void test_instances()
+{
+   add_texture("quad.bmp", red, green, 0xFF808080, 0x00FFFFFF);
+
+   Sprite_instance instance;
+   instance.x = 2;
+   instance.y = 2;
+   instance.half_width = 2;
+   instance.half_height = 2;
+   instance.rotation = 0;
+   instance.color.a = instance.color.r = instance.color.g = instance.color.b = 0x80;
+   instance.u0 = instance.v0 = 0;
+   instance.u1 = instance.v1 = 65535;
+   Sprite_instances instances = { &instance, 1, Texture_ID("quad.bmp"), blending_mode_select_arg1, 0.5f };
+
+   Software_renderer renderer(4, 4, load);
+   renderer.add_to_scene(instances);
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, red, green, 0xFF808080, 0x00FFFFFF));
+
+   renderer.clear_scene();
+   instance.rotation = 3.14159265f;
+   renderer.add_to_scene(instances);
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, 0x00FFFFFF, 0xFF808080, green, red));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Retained sprites are drawn every frame until destroyed, before sprites added to scene.
+void test_retained()
+{
+   Software_renderer renderer(4, 4, load);
+   const Colored_sprite_handle left = renderer.create_sprite(make_colored(0, 0, 2, 4, 0.5f, red));
+   const Colored_sprite_handle right = renderer.create_sprite(make_colored(2, 0, 4, 4, 0.5f, red));
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, red, red, red, red));
+
+   // clear_scene() doesn't touch retained sprites; sprite added on equal depth covers them
+   renderer.add_to_scene(make_colored(0, 2, 4, 4, 0.5f, green));
+   renderer.render_scene();
+   renderer.clear_scene();
+   BOOST_CHECK(check_blocks(renderer, red, red, green, green));
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, red, red, red, red));
+
+   renderer.update_sprite(right, make_colored(2, 0, 4, 4, 0.5f, green));
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, red, green, red, green));
+
+   renderer.destroy_sprite(left);
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, clear_color, green, clear_color, green));
+
+   // handle of sprite moved into freed slot is still valid
+   renderer.create_sprite(make_colored(0, 0, 2, 2, 0.5f, red));
+   renderer.destroy_sprite(right);
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, red, clear_color, clear_color, clear_color));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Translucent retained sprites are drawn after opaque sprites added to scene, before translucent ones;
+/// sprite drawn later covers ones on equal depth.
+void test_retained_translucent()
+{
+   const uint faded_red   = 0x80FF0000;
+   const uint faded_green = 0x8000FF00;
+
+   Software_renderer renderer(4, 4, load);
+   renderer.create_sprite(make_colored(0, 0, 4, 4, 0.5f, faded_red));
+   renderer.create_sprite(make_colored(0, 2, 4, 4, 0.5f, red));
+   renderer.add_to_scene(make_colored(0, 0, 4, 2, 0.5f, green));
+   renderer.add_to_scene(make_colored(0, 0, 2, 4, 0.5f, faded_green));
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, faded_green, faded_red, faded_green, faded_red));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Streamed texture is replaced by white placeholder until it is loaded; missing one stays placeholder.
+void test_streaming()
+{
+   add_texture("quad.bmp", red, green, 0xFF808080, 0x00FFFFFF);
+   save_bmp(*textures["quad.bmp"], "streamed_quad.bmp");
+
+   Software_renderer renderer(4, 4);
+   renderer.enable_texture_streaming(2);
+
+   renderer.add_to_scene(make_textured("streamed_quad.bmp", blending_mode_select_arg1, gray));
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF));
+
+   // texture is taken at frame boundary
+   renderer.wait_for_textures();
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, red, green, 0xFF808080, 0x00FFFFFF));
+   BOOST_CHECK_EQUAL(renderer.get_texture_statistics().misses, 1u);
+
+   // prefetched texture is drawn by the first frame that uses it
+   save_bmp(*textures["quad.bmp"], "streamed_quad_copy.bmp");
+   renderer.clear_scene();
+   renderer.prefetch_texture(Texture_ID("streamed_quad_copy.bmp"));
+   renderer.prefetch_texture(Texture_ID("streamed_missing.bmp"));
+   renderer.wait_for_textures();
+   renderer.add_to_scene(make_textured("streamed_quad_copy.bmp", blending_mode_select_arg1, gray));
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, red, green, 0xFF808080, 0x00FFFFFF));
+
+   renderer.clear_scene();
+   renderer.add_to_scene(make_textured("streamed_missing.bmp", blending_mode_select_arg1, gray));
+   renderer.render_scene();
+   BOOST_CHECK(check_blocks(renderer, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF));
+
+   remove("streamed_quad.bmp");
+   remove("streamed_quad_copy.bmp");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textures in pack are drawn by the first frame without files or streaming; others are loaded as usual.
+void test_asset_pack()
+{
+   add_texture("quad.bmp", red, green, 0xFF808080, 0x00FFFFFF);
+   {
+      Asset_pack_writer writer;
+      writer.add("packed_quad.bmp", *textures["quad.bmp"]);
+      writer.save("test_renderer.pack");
+   }
+
+   {
+      const Asset_pack pack("test_renderer.pack");
+      Software_renderer renderer(4, 4, load);
+      renderer.enable_texture_streaming(1);
+      renderer.set_asset_pack(&pack);
+
+      renderer.add_to_scene(make_textured("packed_quad.bmp", blending_mode_select_arg1, gray));
+      renderer.render_scene();
+      BOOST_CHECK(check_blocks(renderer, red, green, 0xFF808080, 0x00FFFFFF));
+      BOOST_CHECK_EQUAL(renderer.get_texture_statistics().misses, 1u);
+
+      // the next frame takes it from cache
+      renderer.render_scene();
+      BOOST_CHECK_EQUAL(renderer.get_texture_statistics().hits, 1u);
+
+      renderer.clear_scene();
+      renderer.add_to_scene(make_textured("unpacked_missing.bmp", blending_mode_select_arg1, gray));
+      renderer.render_scene();
+      BOOST_CHECK(check_blocks(renderer, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF));
+      renderer.wait_for_textures();
+   }
+
+   remove("test_renderer.pack");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Stats count what the last frame drew; texture loads are counted only by the frame that caused them.
+void test_stats()
+{
+   add_texture("quad.bmp", red, green, 0xFF808080, 0x00FFFFFF);
+   Software_renderer renderer(4, 4, load);
+   renderer.create_sprite(make_colored(0, 0, 4, 4, 0.75f, red));
+   renderer.add_to_scene(make_textured("quad.bmp", blending_mode_select_arg1, gray));
+   renderer.add_to_scene(make_colored(8, 8, 12, 12, 0.5f, green));
+
+   renderer.render_scene();
+   const Render_stats& stats = renderer.get_render_stats();
+   BOOST_CHECK_EQUAL(stats.sprites_submitted, 3u);
+   BOOST_CHECK_EQUAL(stats.sprites_culled, 1u);
+   BOOST_CHECK_EQUAL(stats.sprites_drawn, 2u);
+   BOOST_CHECK_EQUAL(stats.draw_calls, 2u);
+   BOOST_CHECK(stats.state_changes > 0);
+   BOOST_CHECK_EQUAL(stats.texture_loads, 1u);
+   BOOST_CHECK_EQUAL(stats.vertex_bytes, 0u);
+   BOOST_CHECK_EQUAL(stats.upload_seconds, 0);
+   BOOST_CHECK_EQUAL(stats.present_seconds, 0);
+
+   renderer.render_scene();
+   BOOST_CHECK_EQUAL(stats.sprites_drawn, 2u);
+   BOOST_CHECK_EQUAL(stats.texture_loads, 0u);
+
+   // logging doesn't change stats
+   renderer.set_stats_log_period(1);
+   renderer.clear_scene();
+   renderer.render_scene();
+   BOOST_CHECK_EQUAL(stats.sprites_submitted, 1u);
+   BOOST_CHECK_EQUAL(stats.draw_calls, 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Software_renderer_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Software_renderer_test;
+
+   // renderer logs texture loads
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Software_renderer tests");
+
+   test->add(BOOST_TEST_CASE(test_colored));
+   test->add(BOOST_TEST_CASE(test_clipping));
+   test->add(BOOST_TEST_CASE(test_depth));
+   test->add(BOOST_TEST_CASE(test_gradient));
+   test->add(BOOST_TEST_CASE(test_blending_modes));
+   test->add(BOOST_TEST_CASE(test_multitextured));
+   test->add(BOOST_TEST_CASE(test_wrap));
+   test->add(BOOST_TEST_CASE(test_instances));
+   test->add(BOOST_TEST_CASE(test_retained));
+   test->add(BOOST_TEST_CASE(test_retained_translucent));
+   test->add(BOOST_TEST_CASE(test_streaming));
+   test->add(BOOST_TEST_CASE(test_asset_pack));
+   test->add(BOOST_TEST_CASE(test_stats));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for span operations of software rasterizer.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Software/Span.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Span_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Spans of all lengths up to this are checked: both SIMD part and the rest are exercised.
+const uint max_length = 11;
+
+/// \return Some pixels with all kinds of channel values.
+vector<uint> make_pixels(uint n, uint seed)
+{
+   vector<uint> pixels(n);
+   for (uint i = 0; i < n; ++i)
+   {
+      pixels[i] = (seed + i)*0x9E3779B9u;
+   }
+   return pixels;
+}
+
+uint get_channel(uint pixel, uint k)
+{
+   return (pixel >> (8*k)) & 0xFF;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_fill()
+{
+   for (uint n = 0; n <= max_length; ++n)
+   {
+      vector<uint> pixels(n + 1, 0);
+      fill_span(&pixels[0], 0x80112233, n);
+
+      BOOST_CHECK(count(pixels.begin(), pixels.begin() + n, 0x80112233u) == static_cast<int>(n));
+      BOOST_CHECK(pixels[n] == 0);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Modulation is exact per-channel rounding of a*b/255.
+void test_modulate()
+{
+   for (uint n = 0; n <= max_length; ++n)
+   {
+      vector<uint> pixels = make_pixels(n + 1, 1);
+      const vector<uint> args = make_pixels(n + 1, 100);
+      const vector<uint> source = pixels;
+
+      modulate_span(&pixels[0], &args[0], n);
+
+      for (uint i = 0; i < n; ++i)
+      {
+         for (uint k = 0; k < 4; ++k)
+         {
+            const uint product = get_channel(source[i], k)*get_channel(args[i], k);
+            BOOST_CHECK(get_channel(pixels[i], k) == (2*product + 255) / 510);
+         }
+      }
+      BOOST_CHECK(pixels[n] == source[n]);
+   }
+
+   // white is identity, black is zero
+   uint pixel = 0x12345678;
+   const uint white = 0xFFFFFFFF;
+   modulate_span(&pixel, &white, 1);
+   BOOST_CHECK(pixel == 0x12345678);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_add()
+{
+   for (uint n = 0; n <= max_length; ++n)
+   {
+      vector<uint> pixels = make_pixels(n, 7);
+      const vector<uint> args = make_pixels(n, 50);
+      const vector<uint> source = pixels;
+
+      if (n > 0)
+      {
+         add_span(&pixels[0], &args[0], n);
+      }
+
+      for (uint i = 0; i < n; ++i)
+      {
+         for (uint k = 0; k < 4; ++k)
+         {
+            const uint sum = get_channel(source[i], k) + get_channel(args[i], k);
+            BOOST_CHECK(get_channel(pixels[i], k) == min(sum, 255u));
+         }
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Channels are truncated and clamped.
+void test_interpolate()
+{
+   const float channels[4] = { 0.5f, 250.0f, -10.0f, 100.0f };
+   const float steps[4]    = { 1.0f, 1.0f, 2.0f, -0.25f };
+
+   vector<uint> pixels(max_length);
+   interpolate_span(&pixels[0], channels, steps, max_length);
+
+   for (uint i = 0; i < max_length; ++i)
+   {
+      BOOST_CHECK(get_channel(pixels[i], 0) == i);
+      BOOST_CHECK(get_channel(pixels[i], 1) == min(250 + i, 255u));
+      BOOST_CHECK(get_channel(pixels[i], 2) == (i < 5 ? 0 : 2*i - 10));
+      BOOST_CHECK(get_channel(pixels[i], 3) == static_cast<uint>(100.0f - 0.25f*i));
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Pixel is written if its depth is less or equal than stored one.
+void test_depth()
+{
+   for (uint n = 1; n <= max_length; ++n)
+   {
+      // depth buffer: 0.5 for even pixels, 0.1 for odd ones
+      vector<float> depths(n);
+      for (uint i = 0; i < n; ++i)
+      {
+         depths[i] = i % 2 ? 0.1f : 0.5f;
+      }
+      vector<uint> frame(n, 0);
+      const vector<uint> pixels = make_pixels(n, 3);
+
+      write_span(&frame[0], &depths[0], &pixels[0], 0.5f, 0.0f, n);
+
+      for (uint i = 0; i < n; ++i)
+      {
+         BOOST_CHECK(frame[i] == (i % 2 ? 0 : pixels[i]));
+         BOOST_CHECK(depths[i] == (i % 2 ? 0.1f : 0.5f));
+      }
+
+      // depth grows along span
+      fill(frame.begin(), frame.end(), 0);
+      fill(depths.begin(), depths.end(), 0.35f);
+      write_span(&frame[0], &depths[0], 0xFFFFFFFF, 0.0f, 0.1f, n);
+      for (uint i = 0; i < n; ++i)
+      {
+         BOOST_CHECK(frame[i] == (i <= 3 ? 0xFFFFFFFF : 0));
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Span_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Span_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Span tests");
+
+   test->add(BOOST_TEST_CASE(test_fill));
+   test->add(BOOST_TEST_CASE(test_modulate));
+   test->add(BOOST_TEST_CASE(test_add));
+   test->add(BOOST_TEST_CASE(test_interpolate));
+   test->add(BOOST_TEST_CASE(test_depth));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compares rotating sprites built by hand with sprite instances expanded by renderer.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite_instance.h"
+
+#include "Engine/Timing/Stopwatch.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Sprite_instance_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint sprites_number = 8192;
+const uint rounds         = 500;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void print(const char* name, double seconds, size_t bytes_per_sprite)
+{
+   cout << name << ": " << static_cast<ulong>(double(rounds)*sprites_number / seconds) << " sprites/s, "
+        << bytes_per_sprite << " bytes per sprite submitted" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Turns every sprite each round computing its corners the way application does without instances.
+void measure_sprites(const vector<Sprite_instance>& instances)
+{
+   vector<Textured_sprite> sprites(sprites_number);
+   const float corner_xs[4] = { -1, -1, 1, 1 };
+   const float corner_ys[4] = { -1, 1, 1, -1 };
+   const float us[4] = { 0, 0, 1, 1 };
+   const float vs[4] = { 0, 1, 1, 0 };
+
+   Timing::Stopwatch stopwatch;
+   for (uint round = 0; round < rounds; ++round)
+   {
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         const Sprite_instance& instance = instances[i];
+         const float angle = instance.rotation + 0.01f*round;
+         const float sine = std::sin(angle);
+         const float cosine = std::cos(angle);
+         for (uint j = 0; j < 4; ++j)
+         {
+            const float dx = corner_xs[j]*instance.half_width;
+            const float dy = corner_ys[j]*instance.half_height;
+            sprites[i].vertexes[j].position.x = instance.x + dx*cosine - dy*sine;
+            sprites[i].vertexes[j].position.y = instance.y + dx*sine + dy*cosine;
+            sprites[i].vertexes[j].position.z = 0.5f;
+            sprites[i].vertexes[j].color = instance.color;
+            sprites[i].vertexes[j].texture_coord.tu = us[j];
+            sprites[i].vertexes[j].texture_coord.tv = vs[j];
+         }
+         sprites[i].texture = Texture_ID();
+         sprites[i].blending = blending_mode_modulate;
+      }
+   }
+   print("Textured_sprite built by hand", stopwatch.get_elapsed(), sizeof(Textured_sprite));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Turns every instance each round and expands them, as renderer does on add_to_scene().
+void measure_instances(vector<Sprite_instance> instances)
+{
+   vector<Textured_sprite> sprites(sprites_number);
+   const Sprite_instances submitted = { &instances[0], sprites_number, Texture_ID(), blending_mode_modulate, 0.5f };
+
+   Timing::Stopwatch stopwatch;
+   for (uint round = 0; round < rounds; ++round)
+   {
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         instances[i].rotation += 0.01f;
+      }
+      expand_instances(submitted, &sprites[0]);
+   }
+   print("Sprite_instance expanded", stopwatch.get_elapsed(), sizeof(Sprite_instance));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   cout << sprites_number << " rotating sprites per round, " << rounds << " rounds" << endl;
+
+   vector<Sprite_instance> instances(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      Sprite_instance& instance = instances[i];
+      instance.x = float(i % 800);
+      instance.y = float(i % 600);
+      instance.half_width = 16;
+      instance.half_height = 16;
+      instance.rotation = 0.001f*i;
+      instance.color.a = instance.color.r = instance.color.g = instance.color.b = 0xFF;
+      instance.u0 = instance.v0 = 0;
+      instance.u1 = instance.v1 = 65535;
+   }
+
+   measure_sprites(instances);
+   measure_instances(instances);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Sprite_instance_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Rendering::Sprite_instance_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
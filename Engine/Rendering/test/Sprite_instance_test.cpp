@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for sprite instances.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite_instance.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cmath>
+#include <cstring>              // for std::memcmp
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Sprite_instance_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Sprite_instance make_instance(uint seed, float rotation)
+{
+   Sprite_instance instance;
+   instance.x           = 10.0f + seed;
+   instance.y           = 20.0f + 2*seed;
+   instance.half_width  = 3.0f + seed % 5;
+   instance.half_height = 1.0f + seed % 3;
+   instance.rotation    = rotation;
+   instance.color.a     = uchar(seed);
+   instance.color.r     = uchar(seed + 1);
+   instance.color.g     = uchar(seed + 2);
+   instance.color.b     = uchar(seed + 3);
+   instance.u0          = ushort(seed*100);
+   instance.v0          = ushort(seed*200);
+   instance.u1          = ushort(65535 - seed*300);
+   instance.v1          = ushort(65535 - seed*400);
+   return instance;
+}
+
+Sprite_instances make_instances(const vector<Sprite_instance>& instances)
+{
+   Sprite_instances result = { &instances[0], static_cast<uint>(instances.size()), Texture_ID("instance.bmp"),
+                               blending_mode_modulate, 0.25f };
+   return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Unturned instance becomes rectangle with corners in main application order; everything else is copied.
+void test_unturned()
+{
+   vector<Sprite_instance> instances;
+   for (uint i = 0; i < 7; ++i)
+   {
+      instances.push_back(make_instance(i, 0));
+   }
+   vector<Textured_sprite> sprites(instances.size());
+   expand_instances(make_instances(instances), &sprites[0]);
+
+   for (uint i = 0; i < instances.size(); ++i)
+   {
+      const Sprite_instance& instance = instances[i];
+      const Textured_sprite& s = sprites[i];
+      const float left   = instance.x - instance.half_width;
+      const float right  = instance.x + instance.half_width;
+      const float top    = instance.y - instance.half_height;
+      const float bottom = instance.y + instance.half_height;
+      const float xs[4] = { left, left, right, right };
+      const float ys[4] = { top, bottom, bottom, top };
+      const ushort us[4] = { instance.u0, instance.u0, instance.u1, instance.u1 };
+      const ushort vs[4] = { instance.v0, instance.v1, instance.v1, instance.v0 };
+      for (uint j = 0; j < 4; ++j)
+      {
+         BOOST_CHECK_EQUAL(s.vertexes[j].position.x, xs[j]);
+         BOOST_CHECK_EQUAL(s.vertexes[j].position.y, ys[j]);
+         BOOST_CHECK_EQUAL(s.vertexes[j].position.z, 0.25f);
+         BOOST_CHECK(std::memcmp(&s.vertexes[j].color, &instance.color, sizeof(Diffuse_color)) == 0);
+         BOOST_CHECK_EQUAL(s.vertexes[j].texture_coord.tu, us[j] / 65535.0f);
+         BOOST_CHECK_EQUAL(s.vertexes[j].texture_coord.tv, vs[j] / 65535.0f);
+      }
+      BOOST_CHECK(s.texture == Texture_ID("instance.bmp"));
+      BOOST_CHECK_EQUAL(s.blending, blending_mode_modulate);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Corners are turned around center as with standard sine and cosine.
+void test_rotation()
+{
+   vector<Sprite_instance> instances;
+   for (int i = -400; i <= 400; ++i)
+   {
+      instances.push_back(make_instance(i & 7, i*0.1234f));
+   }
+   // exact quadrants, where sine or cosine are zero
+   for (int i = -8; i <= 8; ++i)
+   {
+      instances.push_back(make_instance(3, i*1.57079632679f));
+   }
+   vector<Textured_sprite> sprites(instances.size());
+   expand_instances(make_instances(instances), &sprites[0]);
+
+   for (uint i = 0; i < instances.size(); ++i)
+   {
+      const Sprite_instance& instance = instances[i];
+      const double sine   = std::sin(double(instance.rotation));
+      const double cosine = std::cos(double(instance.rotation));
+      const double w = instance.half_width;
+      const double h = instance.half_height;
+      const double dxs[4] = { -w, -w, w, w };
+      const double dys[4] = { -h, h, h, -h };
+      for (uint j = 0; j < 4; ++j)
+      {
+         const double x = instance.x + dxs[j]*cosine - dys[j]*sine;
+         const double y = instance.y + dxs[j]*sine + dys[j]*cosine;
+         BOOST_CHECK_SMALL(sprites[i].vertexes[j].position.x - x, 1e-4);
+         BOOST_CHECK_SMALL(sprites[i].vertexes[j].position.y - y, 1e-4);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Instances expanded in groups (SSE2 path) give the same sprites as ones expanded alone (plain path).
+void test_groups()
+{
+   vector<Sprite_instance> instances;
+   for (int i = -50; i < 50; ++i)
+   {
+      instances.push_back(make_instance(i & 15, i*0.777f));
+   }
+   vector<Textured_sprite> sprites(instances.size());
+   expand_instances(make_instances(instances), &sprites[0]);
+
+   for (uint i = 0; i < instances.size(); ++i)
+   {
+      const vector<Sprite_instance> single(1, instances[i]);
+      Textured_sprite s;
+      expand_instances(make_instances(single), &s);
+      BOOST_CHECK(std::memcmp(s.vertexes, sprites[i].vertexes, sizeof(s.vertexes)) == 0);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Sprite_instance_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Sprite_instance_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Sprite_instance tests");
+
+   test->add(BOOST_TEST_CASE(test_unturned));
+   test->add(BOOST_TEST_CASE(test_rotation));
+   test->add(BOOST_TEST_CASE(test_groups));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
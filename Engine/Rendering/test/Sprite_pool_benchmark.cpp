@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compares per-frame update of moving sprites stored as array of sprites and as Sprite_pool.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite_pool.h"
+
+#include "Engine/Timing/Stopwatch.h"
+
+#include <iostream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Sprite_pool_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Vertex_format format = Vertex_format(position | diffuse_color | texture_coord0);
+
+const uint sprites_number = 50000;
+const uint frames         = 500;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void report(const char* name, double seconds)
+{
+   cout << name << ": " << seconds * 1000 / frames << " ms per frame, "
+        << static_cast<ulong>(double(frames)*sprites_number / seconds) << " sprites/s" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Every frame each sprite moves by its own velocity, then all sprites are converted to device vertexes.
+void measure_array(const vector<Textured_sprite>& initial, const vector<float>& dxs, const vector<float>& dys)
+{
+   vector<Textured_sprite> sprites(initial);
+   vector<Device_vertex<format> > vertexes(4*sprites_number);
+
+   Timing::Stopwatch stopwatch;
+   for (uint frame = 0; frame < frames; ++frame)
+   {
+      for (uint i = 0; i < sprites_number; ++i)
+      {
+         for (uint j = 0; j < 4; ++j)
+         {
+            sprites[i].vertexes[j].position.x += dxs[i];
+            sprites[i].vertexes[j].position.y += dys[i];
+         }
+      }
+      convert_sprites(&sprites[0], sprites_number, &vertexes[0]);
+   }
+   report("Array of sprites", stopwatch.get_elapsed());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void measure_pool(const vector<Textured_sprite>& initial, const vector<float>& dxs, const vector<float>& dys)
+{
+   Sprite_pool<format> pool;
+   pool.reserve(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      pool.add(initial[i]);
+   }
+   vector<Device_vertex<format> > vertexes(4*sprites_number);
+
+   Timing::Stopwatch stopwatch;
+   for (uint frame = 0; frame < frames; ++frame)
+   {
+      pool.translate(&dxs[0], &dys[0]);
+      convert_sprites(pool, 0, sprites_number, &vertexes[0]);
+   }
+   report("Sprite_pool", stopwatch.get_elapsed());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   vector<Textured_sprite> sprites(sprites_number);
+   vector<float> dxs(sprites_number);
+   vector<float> dys(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         sprites[i].vertexes[j].position.x = float(i % 1024 + (j & 1)*16);
+         sprites[i].vertexes[j].position.y = float(i / 1024 + (j >> 1)*16);
+         sprites[i].vertexes[j].color.a = 255;
+      }
+      dxs[i] = (i % 7) * 0.125f;
+      dys[i] = (i % 5) * -0.25f;
+   }
+
+   cout << sprites_number << " textured sprites, " << frames << " frames" << endl;
+   measure_array(sprites, dxs, dys);
+   measure_pool(sprites, dxs, dys);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Sprite_pool_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Rendering::Sprite_pool_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,344 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for structure-of-arrays sprite storage.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite_pool.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>              // for std::memcmp
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Sprite_pool_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// odd number of sprites, so that nothing relies on pairs
+const uint sprites_number = 7;
+
+typedef Sprite_pool<Vertex_format(position | diffuse_color)>                                   Colored_pool;
+typedef Sprite_pool<Vertex_format(position | diffuse_color | texture_coord0)>                  Textured_pool;
+typedef Sprite_pool<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> Multitextured_2_pool;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Gives all attributes of all vertexes distinct values.
+template <class Sprite_type>
+void fill_common(Sprite_type& s, uint seed)
+{
+   for (uint i = 0; i < 4; ++i)
+   {
+      const uint value = 4*seed + i;
+      s.vertexes[i].position.x = value + 0.5f;
+      s.vertexes[i].position.y = value + 0.25f;
+      s.vertexes[i].position.z = 1.0f / (value + 2);
+      s.vertexes[i].color.a = uchar(value);
+      s.vertexes[i].color.r = uchar(value + 64);
+      s.vertexes[i].color.g = uchar(value + 128);
+      s.vertexes[i].color.b = uchar(value + 192);
+   }
+}
+
+Textured_sprite make_textured(uint seed)
+{
+   Textured_sprite s;
+   fill_common(s, seed);
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].texture_coord.tu = seed + i*0.125f;
+      s.vertexes[i].texture_coord.tv = seed - i*0.125f;
+   }
+   // pairs of sprites share state
+   s.texture  = Texture_ID(seed / 2 % 2 ? "pool_banana.bmp" : "pool_stain.bmp");
+   s.blending = blending_mode_modulate;
+   return s;
+}
+
+Multitextured_2_sprite make_multitextured(uint seed)
+{
+   Multitextured_2_sprite s;
+   fill_common(s, seed);
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].texture_coord0.tu = seed + i*0.125f;
+      s.vertexes[i].texture_coord0.tv = seed - i*0.125f;
+      s.vertexes[i].texture_coord1.tu = seed + i*0.25f;
+      s.vertexes[i].texture_coord1.tv = seed - i*0.25f;
+   }
+   s.texture0  = Texture_ID("pool_banana.bmp");
+   s.blending0 = blending_mode_modulate;
+   s.texture1  = Texture_ID("pool_stain.bmp");
+   s.blending1 = seed < 3 ? blending_mode_add : blending_mode_disable;
+   return s;
+}
+
+/// Vertex buffer in system memory.
+class Memory_buffer : public Dynamic_vertex_buffer
+{
+public:
+
+   explicit Memory_buffer(uint capacity) : memory(capacity) { }
+
+   void* lock(uint offset, uint, bool)                          { return &memory[offset]; }
+   void unlock()                                                { }
+   void resize(uint bytes)                                      { memory.assign(bytes, 0); }
+
+   vector<char> memory;
+};
+
+/// Remembers where vertexes of each draw are; expects no vertexes to be written by itself.
+template <Vertex_format format>
+class Pool_device : public Stream_device
+{
+public:
+
+   Pool_device() : offset(0), batches_number(0) { }
+
+   void set_vertex_format(Vertex_format)                        { }
+   void set_texture(uint, const Texture_ID&)                    { ++batches_number; }
+   void set_blending(uint, Blending_mode)                       { }
+   uint get_quad_bytes(Vertex_format) const                     { return 4*sizeof(Device_vertex<format>); }
+   void set_vertex_offset(uint vertex_offset)                   { offset = vertex_offset; }
+
+   void write_quads(Vertex_format, uint, uint, void*)
+   {
+      BOOST_ERROR("Pool vertexes are written by device");
+   }
+
+   void draw_quads(uint first_quad, uint nquads)
+   {
+      for (uint i = 0; i < nquads; ++i)
+      {
+         quad_offsets.push_back(offset + (first_quad + i)*get_quad_bytes(format));
+      }
+   }
+
+   uint         offset;
+   uint         batches_number;
+   /// Offsets of quads in order they are drawn.
+   vector<uint> quad_offsets;
+};
+
+/// Sprites have no padding, so they could be compared bytewise.
+template <class Sprite_type>
+bool equal_sprites(const Sprite_type& lhs, const Sprite_type& rhs)
+{
+   return memcmp(&lhs, &rhs, sizeof(lhs)) == 0;
+}
+
+/// Pool gives the same vertexes and batches as array of the same sprites.
+template <Vertex_format format>
+void check_as_array(const Sprite_pool<format>& pool, const vector<Sprite<format> >& sprites)
+{
+   typedef Device_vertex<format> Vertex_type;
+
+   BOOST_REQUIRE_EQUAL(pool.get_size(), sprites.size());
+   vector<Vertex_type> expected(4*sprites.size());
+   convert_sprites(&sprites[0], static_cast<uint>(sprites.size()), &expected[0]);
+
+   // converted with offset
+   vector<Vertex_type> converted(4*sprites.size() - 4);
+   convert_sprites(pool, 1, pool.get_size() - 1, &converted[0]);
+   BOOST_CHECK(memcmp(&converted[0], &expected[4], converted.size()*sizeof(converted[0])) == 0);
+
+   Batch_list expected_batches;
+   compile_batches(sprites, expected_batches);
+   Batch_list batches;
+   compile_batches(pool, batches);
+   BOOST_REQUIRE_EQUAL(batches.size(), expected_batches.size());
+   for (size_t i = 0; i < batches.size(); ++i)
+   {
+      BOOST_CHECK_EQUAL(batches[i].first, expected_batches[i].first);
+      BOOST_CHECK_EQUAL(batches[i].count, expected_batches[i].count);
+      for (uint stage = 0; stage < batch_stages_number; ++stage)
+      {
+         BOOST_CHECK(batches[i].textures[stage] == expected_batches[i].textures[stage]);
+         BOOST_CHECK_EQUAL(batches[i].blendings[stage], expected_batches[i].blendings[stage]);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_round_trip()
+{
+   Multitextured_2_pool pool;
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      BOOST_CHECK_EQUAL(pool.add(make_multitextured(i)), i);
+   }
+   BOOST_REQUIRE_EQUAL(pool.get_size(), sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      BOOST_CHECK(equal_sprites(pool.get(i), make_multitextured(i)));
+   }
+
+   pool.set(3, make_multitextured(10));
+   BOOST_CHECK(equal_sprites(pool.get(3), make_multitextured(10)));
+   BOOST_CHECK_EQUAL(pool.get_xs()[4*3], make_multitextured(10).vertexes[0].position.x);
+   BOOST_CHECK(pool.get_texture(3, 1) == Texture_ID("pool_stain.bmp"));
+
+   pool.clear();
+   BOOST_CHECK_EQUAL(pool.get_size(), 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Removed sprite is replaced by the last one.
+void test_remove()
+{
+   Textured_pool pool;
+   for (uint i = 0; i < 4; ++i)
+   {
+      pool.add(make_textured(i));
+   }
+
+   pool.remove(1);
+   BOOST_REQUIRE_EQUAL(pool.get_size(), 3u);
+   BOOST_CHECK(equal_sprites(pool.get(0), make_textured(0)));
+   BOOST_CHECK(equal_sprites(pool.get(1), make_textured(3)));
+   BOOST_CHECK(equal_sprites(pool.get(2), make_textured(2)));
+
+   pool.remove(2);
+   BOOST_REQUIRE_EQUAL(pool.get_size(), 2u);
+   BOOST_CHECK(equal_sprites(pool.get(1), make_textured(3)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_transforms()
+{
+   Colored_pool pool;
+   vector<Colored_sprite> sprites(sprites_number);
+   vector<float> dxs(sprites_number);
+   vector<float> dys(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      fill_common(sprites[i], i);
+      pool.add(sprites[i]);
+      dxs[i] = float(i);
+      dys[i] = -float(i);
+   }
+
+   pool.translate(1, 2);
+   pool.translate(&dxs[0], &dys[0]);
+   pool.scale(10, 20, 2, 0.5f);
+   Diffuse_color tint = { 255, 128, 0, 51 };
+   pool.tint(tint);
+
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      const Colored_sprite s = pool.get(i);
+      for (uint j = 0; j < 4; ++j)
+      {
+         const Vertex<Vertex_format(position | diffuse_color)>& v = sprites[i].vertexes[j];
+         BOOST_CHECK_EQUAL(s.vertexes[j].position.x, (v.position.x + 1 + i - 10)*2 + 10);
+         BOOST_CHECK_EQUAL(s.vertexes[j].position.y, (v.position.y + 2 - i - 20)*0.5f + 20);
+         BOOST_CHECK_EQUAL(s.vertexes[j].position.z, v.position.z);
+         BOOST_CHECK_EQUAL(uint(s.vertexes[j].color.a), uint(v.color.a));
+         BOOST_CHECK_EQUAL(uint(s.vertexes[j].color.r), (v.color.r*128 + 127) / 255);
+         BOOST_CHECK_EQUAL(uint(s.vertexes[j].color.g), 0u);
+         BOOST_CHECK_EQUAL(uint(s.vertexes[j].color.b), (v.color.b*51 + 127) / 255);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_conversion()
+{
+   Colored_pool colored;
+   Textured_pool textured;
+   Multitextured_2_pool multitextured;
+   vector<Colored_sprite> colored_sprites(sprites_number);
+   vector<Textured_sprite> textured_sprites;
+   vector<Multitextured_2_sprite> multitextured_sprites;
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      fill_common(colored_sprites[i], i);
+      colored.add(colored_sprites[i]);
+      textured_sprites.push_back(make_textured(i));
+      textured.add(textured_sprites.back());
+      multitextured_sprites.push_back(make_multitextured(i));
+      multitextured.add(multitextured_sprites.back());
+   }
+
+   check_as_array(colored, colored_sprites);
+   check_as_array(textured, textured_sprites);
+   check_as_array(multitextured, multitextured_sprites);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Pool is drawn through vertex ring with the same vertexes and batches as array of the same sprites.
+void test_streaming()
+{
+   typedef Device_vertex<Vertex_format(position | diffuse_color | texture_coord0)> Vertex_type;
+
+   Textured_pool pool;
+   vector<Textured_sprite> sprites;
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      sprites.push_back(make_textured(i));
+      pool.add(sprites.back());
+   }
+   vector<Vertex_type> expected(4*sprites_number);
+   convert_sprites(&sprites[0], sprites_number, &expected[0]);
+   Batch_list expected_batches;
+   compile_batches(sprites, expected_batches);
+
+   Memory_buffer buffer(4096);
+   Vertex_ring ring(buffer, 4096);
+   Pool_device<Vertex_format(position | diffuse_color | texture_coord0)> device;
+   Batch_list batches;
+   stream_pool(pool, ring, device, batches);
+
+   BOOST_CHECK_EQUAL(device.batches_number, batch_stages_number*expected_batches.size());
+   BOOST_REQUIRE_EQUAL(device.quad_offsets.size(), sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      BOOST_CHECK(memcmp(&buffer.memory[device.quad_offsets[i]], &expected[4*i], 4*sizeof(Vertex_type)) == 0);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Sprite_pool_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Sprite_pool_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Sprite_pool tests");
+
+   test->add(BOOST_TEST_CASE(test_round_trip));
+   test->add(BOOST_TEST_CASE(test_remove));
+   test->add(BOOST_TEST_CASE(test_transforms));
+   test->add(BOOST_TEST_CASE(test_conversion));
+   test->add(BOOST_TEST_CASE(test_streaming));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
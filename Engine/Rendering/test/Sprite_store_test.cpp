@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for retained sprites storage.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Sprite_store.h"
+
+#include "boost/test/unit_test.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Sprite_store_test
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef Sprite_store<Vertex_format(position | diffuse_color)> Store;
+
+/// Sprite marked by its x coordinate.
+Colored_sprite make_sprite(float x)
+{
+   Colored_sprite s = Colored_sprite();
+   s.vertexes[0].position.x = x;
+   return s;
+}
+
+float get_mark(const Store& store, uint slot)
+{
+   return store.get_sprites()[slot].vertexes[0].position.x;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Created and updated sprites are dirty until clear_dirty().
+void test_dirty_range()
+{
+   Store store;
+   BOOST_CHECK(!store.is_changed());
+
+   Colored_sprite_handle handles[5];
+   for (uint i = 0; i < 5; ++i)
+   {
+      handles[i] = store.create(make_sprite(float(i)));
+   }
+   BOOST_CHECK(store.is_changed());
+   BOOST_CHECK_EQUAL(store.get_dirty_first(), 0u);
+   BOOST_CHECK_EQUAL(store.get_dirty_end(), 5u);
+
+   store.clear_dirty();
+   BOOST_CHECK(!store.is_changed());
+   BOOST_CHECK_EQUAL(store.get_dirty_first(), store.get_dirty_end());
+
+   store.update(handles[3], make_sprite(30));
+   store.update(handles[1], make_sprite(10));
+   BOOST_CHECK_EQUAL(store.get_dirty_first(), 1u);
+   BOOST_CHECK_EQUAL(store.get_dirty_end(), 4u);
+   BOOST_CHECK_EQUAL(get_mark(store, 1), 10);
+   BOOST_CHECK_EQUAL(get_mark(store, 3), 30);
+
+   store.clear_dirty();
+   store.mark_all_dirty();
+   BOOST_CHECK_EQUAL(store.get_dirty_first(), 0u);
+   BOOST_CHECK_EQUAL(store.get_dirty_end(), 5u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Destroyed sprite is replaced by the last one; handles keep pointing to their sprites.
+void test_destroy()
+{
+   Store store;
+   Colored_sprite_handle handles[4];
+   for (uint i = 0; i < 4; ++i)
+   {
+      handles[i] = store.create(make_sprite(float(i)));
+   }
+   store.clear_dirty();
+
+   store.destroy(handles[1]);
+   BOOST_REQUIRE_EQUAL(store.get_sprites().size(), 3u);
+   BOOST_CHECK_EQUAL(get_mark(store, 1), 3);
+   BOOST_CHECK_EQUAL(store.get_dirty_first(), 1u);
+   BOOST_CHECK_EQUAL(store.get_dirty_end(), 2u);
+
+   // the last sprite is just dropped
+   store.clear_dirty();
+   store.destroy(handles[2]);
+   BOOST_REQUIRE_EQUAL(store.get_sprites().size(), 2u);
+   BOOST_CHECK(store.is_changed());
+   BOOST_CHECK_EQUAL(store.get_dirty_first(), store.get_dirty_end());
+
+   store.update(handles[3], make_sprite(33));
+   BOOST_CHECK_EQUAL(get_mark(store, 1), 33);
+
+   // freed handle is reused
+   const Colored_sprite_handle handle = store.create(make_sprite(44));
+   BOOST_CHECK(handle.id == handles[1].id || handle.id == handles[2].id);
+   BOOST_CHECK_EQUAL(get_mark(store, 2), 44);
+
+   store.destroy(handles[0]);
+   store.update(handle, make_sprite(55));
+   BOOST_CHECK_EQUAL(get_mark(store, 0), 55);
+   BOOST_CHECK_EQUAL(get_mark(store, 1), 33);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Sprite_store_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Sprite_store_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Sprite_store tests");
+
+   test->add(BOOST_TEST_CASE(test_dirty_range));
+   test->add(BOOST_TEST_CASE(test_destroy));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
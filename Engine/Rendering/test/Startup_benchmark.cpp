@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Measures time to first frame of Software_renderer that draws many textures, loaded from separate BMP files
+// and taken from asset pack.
+// Usage: Startup_benchmark [BMP file], Main/res/banana.bmp by default; it is copied under different names.
+// Files are just written, so both ways read them from OS cache; cold start favours pack even more.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Software/Software_renderer.h"
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Bmp.h"
+
+#include "Engine/Logging/Logging.h"
+#include "Engine/Timing/Stopwatch.h"
+
+#include <cstdio>               // for std::remove
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Startup_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint textures_number = 32;
+const uint runs            = 10;
+const char* const pack_file = "startup_benchmark.pack";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sprite covering the whole frame.
+Textured_sprite make_sprite(const string& texture)
+{
+   Textured_sprite s = Textured_sprite();
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].position.x = static_cast<float>((i >> 1) * 64);
+      s.vertexes[i].position.y = static_cast<float>((i & 1) * 64);
+      s.vertexes[i].color.a = s.vertexes[i].color.r = s.vertexes[i].color.g = s.vertexes[i].color.b = 0xFF;
+      s.vertexes[i].texture_coord.tu = static_cast<float>(i >> 1);
+      s.vertexes[i].texture_coord.tv = static_cast<float>(i & 1);
+   }
+   s.texture  = Texture_ID(texture);
+   s.blending = blending_mode_modulate;
+   return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Seconds from renderer creation to the end of first frame drawing every texture.
+double get_first_frame_time(const vector<string>& names, bool use_pack)
+{
+   // textures aren't cached between runs, since each renderer has its own cache
+   Timing::Stopwatch stopwatch;
+   Software_renderer renderer(64, 64);
+   boost::scoped_ptr<Asset_pack> pack(use_pack ? new Asset_pack(pack_file) : 0);
+   renderer.set_asset_pack(pack.get());
+   for (size_t i = 0; i < names.size(); ++i)
+   {
+      renderer.add_to_scene(make_sprite(names[i]));
+   }
+   renderer.render_scene();
+   return stopwatch.get_elapsed();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int run(const char* file_name)
+{
+   const Image image = load_bmp(file_name);
+   cout << textures_number << " textures " << image.width << "x" << image.height << endl;
+
+   vector<string> names;
+   Asset_pack_writer writer;
+   for (uint i = 0; i < textures_number; ++i)
+   {
+      ostringstream name;
+      name << "startup_benchmark_" << i << ".bmp";
+      names.push_back(name.str());
+      save_bmp(image, names.back());
+      writer.add(names.back(), image);
+   }
+   writer.save(pack_file);
+
+   const char* const ways[2] = { "files", "pack" };
+   for (uint way = 0; way < 2; ++way)
+   {
+      double total = 0;
+      for (uint i = 0; i < runs; ++i)
+      {
+         total += get_first_frame_time(names, way == 1);
+      }
+      cout << ways[way] << ": " << total * 1000 / runs << " ms to first frame" << endl;
+   }
+
+   for (size_t i = 0; i < names.size(); ++i)
+   {
+      std::remove(names[i].c_str());
+   }
+   std::remove(pack_file);
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Startup_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   try
+   {
+      return Engine::Rendering::Startup_benchmark::run(argc > 1 ? argv[1] : "Main/res/banana.bmp");
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for state cache.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/State_cache.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <sstream>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace State_cache_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Device that logs calls reaching it, one letter per call followed by arguments.
+class Mock_device : public State_device
+{
+public:
+
+   virtual void set_texture(uint nstage, const void* texture)
+   {
+      m_calls << "t" << nstage << (texture ? "+" : "-") << " ";
+   }
+
+   virtual void set_texture_stage_state(uint nstage, uint type, uint value)
+   {
+      m_calls << "s" << nstage << "." << type << "=" << value << " ";
+   }
+
+   virtual void set_vertex_format(uint format)
+   {
+      m_calls << "f" << format << " ";
+   }
+
+   virtual void set_stream_source(const void* buffer, uint offset, uint vertex_bytes)
+   {
+      m_calls << "v" << (buffer ? "+" : "-") << offset << "/" << vertex_bytes << " ";
+   }
+
+   /// \return Calls made since previous take_calls().
+   string take_calls()
+   {
+      const string calls = m_calls.str();
+      m_calls.str("");
+      return calls;
+   }
+
+private:
+
+   ostringstream m_calls;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Only calls that change state reach device; the first ones always do.
+void test_filtering()
+{
+   Mock_device device;
+   State_cache cache(device);
+   const int texture = 0;
+
+   cache.set_texture(0, &texture);
+   cache.set_texture(0, &texture);
+   cache.set_texture(1, 0);
+   cache.set_texture(1, 0);
+   cache.set_texture(0, 0);
+   BOOST_CHECK_EQUAL(device.take_calls(), "t0+ t1- t0- ");
+
+   cache.set_texture_stage_state(0, 1, 4);
+   cache.set_texture_stage_state(0, 4, 4);
+   cache.set_texture_stage_state(0, 1, 4);
+   cache.set_texture_stage_state(1, 1, 4);
+   cache.set_texture_stage_state(0, 1, 2);
+   BOOST_CHECK_EQUAL(device.take_calls(), "s0.1=4 s0.4=4 s1.1=4 s0.1=2 ");
+
+   cache.set_vertex_format(0x144);
+   cache.set_vertex_format(0x144);
+   cache.set_vertex_format(0x244);
+   BOOST_CHECK_EQUAL(device.take_calls(), "f324 f580 ");
+
+   // any of buffer, offset and stride makes a change
+   cache.set_stream_source(&texture, 0, 24);
+   cache.set_stream_source(&texture, 0, 24);
+   cache.set_stream_source(&texture, 96, 24);
+   cache.set_stream_source(&texture, 96, 20);
+   cache.set_stream_source(0, 96, 20);
+   cache.set_stream_source(0, 96, 20);
+   BOOST_CHECK_EQUAL(device.take_calls(), "v+0/24 v+96/24 v+96/20 v-96/20 ");
+
+   BOOST_CHECK_EQUAL(cache.get_statistics().issued, 13u);
+   BOOST_CHECK_EQUAL(cache.get_statistics().filtered, 6u);
+
+   cache.reset_statistics();
+   BOOST_CHECK_EQUAL(cache.get_statistics().issued, 0u);
+   BOOST_CHECK_EQUAL(cache.get_statistics().filtered, 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// After invalidate() state is set again.
+void test_invalidate()
+{
+   Mock_device device;
+   State_cache cache(device);
+
+   cache.set_texture(0, 0);
+   cache.set_texture_stage_state(0, 1, 4);
+   cache.set_vertex_format(1);
+   cache.set_stream_source(0, 0, 16);
+   device.take_calls();
+
+   cache.invalidate();
+   cache.set_texture(0, 0);
+   cache.set_texture_stage_state(0, 1, 4);
+   cache.set_vertex_format(1);
+   cache.set_stream_source(0, 0, 16);
+   BOOST_CHECK_EQUAL(device.take_calls(), "t0- s0.1=4 f1 v-0/16 ");
+   BOOST_CHECK_EQUAL(cache.get_statistics().issued, 8u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Stages and states the cache doesn't track are passed every time.
+void test_untracked()
+{
+   Mock_device device;
+   State_cache cache(device);
+
+   cache.set_texture(state_cache_stages, 0);
+   cache.set_texture(state_cache_stages, 0);
+   cache.set_texture_stage_state(0, state_cache_stage_states, 1);
+   cache.set_texture_stage_state(0, state_cache_stage_states, 1);
+   BOOST_CHECK_EQUAL(device.take_calls(), "t8- t8- s0.33=1 s0.33=1 ");
+   BOOST_CHECK_EQUAL(cache.get_statistics().issued, 4u);
+   BOOST_CHECK_EQUAL(cache.get_statistics().filtered, 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Batches as renderer draws them: every batch sets texture and blending of both stages, which rarely change.
+void test_batches()
+{
+   Mock_device device;
+   State_cache cache(device);
+   const int textures[2] = { 0, 0 };
+
+   const uint batches = 100;
+   for (uint i = 0; i < batches; ++i)
+   {
+      cache.set_texture(0, &textures[i / 50]);
+      cache.set_texture_stage_state(0, 1, 4);
+      cache.set_texture_stage_state(0, 4, 4);
+      cache.set_texture(1, 0);
+      cache.set_texture_stage_state(1, 1, 1);
+      cache.set_texture_stage_state(1, 4, 1);
+   }
+   BOOST_CHECK_EQUAL(cache.get_statistics().issued, 7u);
+   BOOST_CHECK_EQUAL(cache.get_statistics().filtered, 6*batches - 7);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace State_cache_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::State_cache_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("State_cache tests");
+
+   test->add(BOOST_TEST_CASE(test_filtering));
+   test->add(BOOST_TEST_CASE(test_invalidate));
+   test->add(BOOST_TEST_CASE(test_untracked));
+   test->add(BOOST_TEST_CASE(test_batches));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for Texture_ID and texture names interning.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Texture_ID.h"
+
+#include "boost/test/unit_test.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Texture_ID_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Default identifier is empty one.
+void test_empty()
+{
+   BOOST_CHECK(Texture_ID().get_handle() == 0);
+   BOOST_CHECK(Texture_ID().get_file_name().empty());
+   BOOST_CHECK(Texture_ID(string()) == Texture_ID());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Equal names give equal identifiers; handles are dense.
+void test_interning()
+{
+   const uint size = Texture_registry::get_size();
+
+   Texture_ID banana("banana.bmp");
+   Texture_ID stain("stain.bmp");
+
+   BOOST_CHECK(banana == Texture_ID("banana.bmp"));
+   BOOST_CHECK(banana != stain);
+   BOOST_CHECK(banana.get_file_name() == "banana.bmp");
+   BOOST_CHECK(stain.get_file_name() == "stain.bmp");
+
+   BOOST_CHECK(banana.get_handle() == size);
+   BOOST_CHECK(stain.get_handle() == size + 1);
+   BOOST_CHECK(Texture_registry::get_size() == size + 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// References to names remain valid while registry grows.
+void test_references()
+{
+   const string& name = Texture_ID("first.bmp").get_file_name();
+
+   for (int i = 0; i < 1000; ++i)
+   {
+      Texture_ID(string(i % 50 + 1, 'x'));
+   }
+
+   BOOST_CHECK(name == "first.bmp");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Texture_ID_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Texture_ID_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Texture_ID tests");
+
+   test->add(BOOST_TEST_CASE(test_empty));
+   test->add(BOOST_TEST_CASE(test_interning));
+   test->add(BOOST_TEST_CASE(test_references));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,252 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for texture atlas.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Texture_atlas.h"
+#include "Engine/Rendering/Bmp.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>               // for std::remove
+#include <cstdlib>              // for std::rand
+#include <fstream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Texture_atlas_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Rectangle
+{
+   uint x, y, width, height;
+};
+
+bool overlap(const Rectangle& lhs, const Rectangle& rhs)
+{
+   return lhs.x < rhs.x + rhs.width && rhs.x < lhs.x + lhs.width
+       && lhs.y < rhs.y + rhs.height && rhs.y < lhs.y + lhs.height;
+}
+
+/// Image filled with single color.
+Image make_image(uint width, uint height, uint color)
+{
+   Image image(width, height);
+   std::fill(image.pixels.begin(), image.pixels.end(), color);
+   return image;
+}
+
+Textured_sprite make_sprite(const Texture_ID& texture, float max_coord)
+{
+   Textured_sprite s = Textured_sprite();
+   for (uint i = 0; i < 4; ++i)
+   {
+      s.vertexes[i].texture_coord.tu = (i & 1) * max_coord;
+      s.vertexes[i].texture_coord.tv = (i >> 1) * max_coord;
+   }
+   s.texture  = texture;
+   s.blending = blending_mode_modulate;
+   return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Rectangles stay inside page and don't overlap.
+void test_skyline()
+{
+   Skyline_packer packer(256, 256);
+   vector<Rectangle> placed;
+   for (uint i = 0; i < 200; ++i)
+   {
+      Rectangle r = { 0, 0, uint(1 + rand() % 40), uint(1 + rand() % 40) };
+      if (!packer.insert(r.width, r.height, r.x, r.y))
+      {
+         continue;
+      }
+      BOOST_REQUIRE(r.x + r.width <= 256 && r.y + r.height <= 256);
+      for (size_t j = 0; j < placed.size(); ++j)
+      {
+         BOOST_REQUIRE(!overlap(r, placed[j]));
+      }
+      placed.push_back(r);
+   }
+   BOOST_CHECK(placed.size() > 40);
+
+   // rectangles of the same size fill page completely
+   Skyline_packer grid(64, 64);
+   uint x = 0;
+   uint y = 0;
+   for (uint i = 0; i < 16; ++i)
+   {
+      BOOST_REQUIRE(grid.insert(16, 16, x, y));
+   }
+   BOOST_CHECK(!grid.insert(1, 1, x, y));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textures are copied to pages with borders; regions point to them.
+void test_pack()
+{
+   const Texture_ID red("atlas_red.bmp");
+   const Texture_ID green("atlas_green.bmp");
+   const Texture_ID huge("atlas_huge.bmp");
+
+   Texture_atlas atlas;
+   atlas.add(red, make_image(30, 20, 0xFFFF0000));
+   atlas.add(green, make_image(10, 40, 0xFF00FF00));
+   atlas.add(huge, make_image(64, 8, 0xFF0000FF));
+   atlas.pack(64, "test_atlas");
+
+   // huge texture doesn't fit with its border
+   BOOST_CHECK_EQUAL(atlas.get_size(), 2u);
+   BOOST_REQUIRE_EQUAL(atlas.get_pages().size(), 1u);
+   Atlas_region region;
+   BOOST_CHECK(!atlas.find(huge, region));
+   BOOST_CHECK(!atlas.find(Texture_ID(), region));
+
+   BOOST_REQUIRE(atlas.find(red, region));
+   BOOST_CHECK(region.page == Texture_ID("test_atlas_0.bmp"));
+   BOOST_CHECK_CLOSE((region.u1 - region.u0) * 64, 30.0f, 0.001f);
+   BOOST_CHECK_CLOSE((region.v1 - region.v0) * 64, 20.0f, 0.001f);
+
+   // texels of region and its border are red
+   const Image& page = atlas.get_pages()[0];
+   const uint x0 = static_cast<uint>(region.u0 * 64 + 0.5f);
+   const uint y0 = static_cast<uint>(region.v0 * 64 + 0.5f);
+   BOOST_REQUIRE(x0 >= 1 && y0 >= 1);
+   for (uint y = y0 - 1; y <= y0 + 20; ++y)
+   {
+      for (uint x = x0 - 1; x <= x0 + 30; ++x)
+      {
+         BOOST_REQUIRE_EQUAL(page.pixels[y*page.width + x], 0xFFFF0000u);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_remap()
+{
+   const Texture_ID red("atlas_red.bmp");
+   const Texture_ID blue("atlas_blue.bmp");
+
+   Texture_atlas atlas;
+   atlas.add(red, make_image(16, 16, 0xFFFF0000));
+   atlas.add(blue, make_image(16, 16, 0xFF0000FF));
+   atlas.pack(64, "remap_atlas");
+
+   Atlas_region region;
+   BOOST_REQUIRE(atlas.find(red, region));
+
+   Textured_sprite s = make_sprite(red, 1);
+   BOOST_REQUIRE(atlas.remap(s));
+   BOOST_CHECK(s.texture == region.page);
+   BOOST_CHECK_CLOSE(s.vertexes[0].texture_coord.tu, region.u0, 0.001f);
+   BOOST_CHECK_CLOSE(s.vertexes[3].texture_coord.tu, region.u1, 0.001f);
+   BOOST_CHECK_CLOSE(s.vertexes[3].texture_coord.tv, region.v1, 0.001f);
+
+   // both textures end up on the same page, so sprites could share batch
+   Textured_sprite other = make_sprite(blue, 1);
+   BOOST_REQUIRE(atlas.remap(other));
+   BOOST_CHECK(other.texture == s.texture);
+
+   // tiled sprite relies on wrapping
+   Textured_sprite tiled = make_sprite(red, 2);
+   BOOST_CHECK(!atlas.remap(tiled));
+   BOOST_CHECK(tiled.texture == red);
+
+   // stages are remapped independently
+   Multitextured_2_sprite multi = Multitextured_2_sprite();
+   multi.texture0 = Texture_ID("atlas_unknown.bmp");
+   multi.texture1 = blue;
+   BOOST_CHECK(atlas.remap(multi));
+   BOOST_CHECK(multi.texture0 == Texture_ID("atlas_unknown.bmp"));
+   BOOST_CHECK(multi.texture1 == region.page);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Description written by save() gives the same regions.
+void test_save_load()
+{
+   const Texture_ID red("atlas_red.bmp");
+
+   Texture_atlas atlas;
+   atlas.add(red, make_image(16, 8, 0xFFFF0000));
+   atlas.pack(32, "saved_atlas");
+   atlas.save("saved_atlas.atlas");
+
+   const Image page = load_bmp("saved_atlas_0.bmp");
+   BOOST_CHECK(page.pixels == atlas.get_pages()[0].pixels);
+
+   Texture_atlas loaded;
+   loaded.load("saved_atlas.atlas");
+   BOOST_CHECK_EQUAL(loaded.get_size(), 1u);
+   BOOST_CHECK(loaded.get_pages().empty());
+
+   Atlas_region expected;
+   Atlas_region region;
+   BOOST_REQUIRE(atlas.find(red, expected));
+   BOOST_REQUIRE(loaded.find(red, region));
+   BOOST_CHECK(region.page == expected.page);
+   BOOST_CHECK_EQUAL(region.u0, expected.u0);
+   BOOST_CHECK_EQUAL(region.v1, expected.v1);
+
+   std::remove("saved_atlas.atlas");
+   std::remove("saved_atlas_0.bmp");
+
+   // broken descriptions
+   BOOST_CHECK_THROW(loaded.load("no_such_atlas.atlas"), Atlas_exception);
+   {
+      std::ofstream broken("broken_atlas.atlas");
+      broken << "atlas 1\n1\npage.bmp 32 32\n1\ntexture.bmp 0 30 0 8 8\n";
+   }
+   BOOST_CHECK_THROW(loaded.load("broken_atlas.atlas"), Atlas_exception);
+   std::remove("broken_atlas.atlas");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Texture_atlas_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Texture_atlas_test;
+
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Texture_atlas tests");
+
+   test->add(BOOST_TEST_CASE(test_skyline));
+   test->add(BOOST_TEST_CASE(test_pack));
+   test->add(BOOST_TEST_CASE(test_remap));
+   test->add(BOOST_TEST_CASE(test_save_load));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for Texture_cache.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Texture_cache.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Texture_cache_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// "Texture" is just its file name; each of them is 100 bytes.
+/// All loads are remembered so it could be checked what was loaded.
+vector<string> loads;
+
+string load(const Texture_ID& id, uint& bytes)
+{
+   loads.push_back(id.get_file_name());
+   bytes = 100;
+   return id.get_file_name();
+}
+
+Texture_ID make_id(const string& file_name)
+{
+   return Texture_ID(file_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Texture is loaded once and then taken from cache.
+void test_single_load()
+{
+   loads.clear();
+   Texture_cache<string> cache(load, 1000);
+
+   for (int i = 0; i < 10; ++i)
+   {
+      BOOST_CHECK(cache.get(make_id("banana.bmp")) == "banana.bmp");
+   }
+
+   BOOST_CHECK(loads.size() == 1);
+   BOOST_CHECK(cache.get_statistics().misses == 1);
+   BOOST_CHECK(cache.get_statistics().hits == 9);
+   BOOST_CHECK(cache.get_statistics().evictions == 0);
+   BOOST_CHECK(cache.get_statistics().bytes_used == 100);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Least recently used texture is evicted when budget is exceeded.
+void test_lru_eviction()
+{
+   loads.clear();
+   Texture_cache<string> cache(load, 200);
+
+   cache.get(make_id("a"));
+   cache.get(make_id("b"));
+   cache.get(make_id("a"));            // "b" is least recently used now
+   cache.get(make_id("c"));            // evicts "b"
+
+   BOOST_CHECK(cache.get_statistics().evictions == 1);
+   BOOST_CHECK(cache.get_statistics().bytes_used == 200);
+
+   cache.get(make_id("a"));            // still cached
+   cache.get(make_id("b"));            // loaded again; evicts "c"
+
+   const char* etalon[] = { "a", "b", "c", "b" };
+   BOOST_CHECK(loads.size() == 4 && equal(loads.begin(), loads.end(), etalon));
+   BOOST_CHECK(cache.get_statistics().evictions == 2);
+   BOOST_CHECK(cache.get_statistics().hits == 2);
+   BOOST_CHECK(cache.get_statistics().misses == 4);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Shrinking budget evicts textures; texture bigger than budget is kept while it's the most recent one.
+void test_budget()
+{
+   loads.clear();
+   Texture_cache<string> cache(load, 1000);
+
+   cache.get(make_id("a"));
+   cache.get(make_id("b"));
+   cache.get(make_id("c"));
+
+   cache.set_budget(50);
+   BOOST_CHECK(cache.get_statistics().evictions == 2);
+   BOOST_CHECK(cache.get_statistics().bytes_used == 100);
+
+   cache.get(make_id("c"));
+   BOOST_CHECK(loads.size() == 3);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// After clear() (e.g. device reset) textures are loaded again.
+void test_clear()
+{
+   loads.clear();
+   Texture_cache<string> cache(load, 1000);
+
+   cache.get(make_id("a"));
+   cache.clear();
+   BOOST_CHECK(cache.get_statistics().bytes_used == 0);
+
+   cache.get(make_id("a"));
+   BOOST_CHECK(loads.size() == 2);
+   BOOST_CHECK(cache.get_statistics().misses == 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Textures loaded elsewhere are found without loader; find() doesn't load.
+void test_insert()
+{
+   loads.clear();
+   Texture_cache<string> cache(load, 200);
+
+   string texture;
+   BOOST_CHECK(!cache.find(make_id("a"), texture));
+   BOOST_CHECK(!cache.contains(make_id("a")));
+   BOOST_CHECK(cache.get_statistics().misses == 0);
+
+   cache.insert(make_id("a"), "streamed a", 100);
+   BOOST_CHECK(cache.contains(make_id("a")));
+   BOOST_CHECK(cache.find(make_id("a"), texture) && texture == "streamed a");
+   BOOST_CHECK(cache.get(make_id("a")) == "streamed a");
+   BOOST_CHECK(loads.empty());
+   BOOST_CHECK(cache.get_statistics().misses == 1);
+   BOOST_CHECK(cache.get_statistics().hits == 2);
+
+   // replacing doesn't count size twice
+   cache.insert(make_id("a"), "streamed a again", 150);
+   BOOST_CHECK(cache.get_statistics().bytes_used == 150);
+
+   // inserted textures are evicted as loaded ones
+   cache.insert(make_id("b"), "streamed b", 100);
+   BOOST_CHECK(!cache.contains(make_id("a")));
+   BOOST_CHECK(cache.get_statistics().evictions == 1);
+   BOOST_CHECK(cache.get_statistics().bytes_used == 100);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Texture_cache_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Texture_cache_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Texture_cache tests");
+
+   test->add(BOOST_TEST_CASE(test_single_load));
+   test->add(BOOST_TEST_CASE(test_lru_eviction));
+   test->add(BOOST_TEST_CASE(test_budget));
+   test->add(BOOST_TEST_CASE(test_clear));
+   test->add(BOOST_TEST_CASE(test_insert));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
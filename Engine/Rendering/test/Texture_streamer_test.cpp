@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for background loading of textures.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Texture_streamer.h"
+
+#include "boost/test/unit_test.hpp"
+#include "boost/thread/condition.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Texture_streamer_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Image of decoder is 1 pixel wide and as high as its file name is long; "missing" files can't be decoded.
+/// Decoding waits while gate is closed, so test could queue several images before they are taken.
+boost::mutex     mutex;
+boost::condition gate_opened;
+bool             is_gate_open = true;
+uint             started = 0;
+vector<string>   decoded;
+
+Image decode(const string& file_name)
+{
+   boost::mutex::scoped_lock lock(mutex);
+   ++started;
+   while (!is_gate_open)
+   {
+      gate_opened.wait(lock);
+   }
+   decoded.push_back(file_name);
+
+   if (file_name.find("missing") != string::npos)
+   {
+      throw runtime_error("no file " + file_name);
+   }
+   return Image(1, static_cast<uint>(file_name.size()));
+}
+
+void set_gate(bool is_open)
+{
+   boost::mutex::scoped_lock lock(mutex);
+   is_gate_open = is_open;
+   gate_opened.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Images are loaded once and collected with their identifiers; failures are reported.
+void test_load()
+{
+   decoded.clear();
+   Texture_streamer streamer(2, decode);
+
+   const Texture_ID a("streamed_a.bmp");
+   const Texture_ID b("streamed_bb.bmp");
+   const Texture_ID missing("missing.bmp");
+   streamer.request(a);
+   streamer.request(a);
+   streamer.prefetch(b);
+   streamer.request(missing);
+   BOOST_CHECK_EQUAL(streamer.get_pending_number(), 3u);
+   BOOST_CHECK(streamer.is_pending(a) && streamer.is_pending(missing));
+
+   streamer.wait();
+   vector<Streamed_image> images;
+   streamer.collect(images);
+   BOOST_CHECK_EQUAL(streamer.get_pending_number(), 0u);
+   BOOST_CHECK(!streamer.is_pending(a));
+   BOOST_REQUIRE_EQUAL(images.size(), 3u);
+   BOOST_CHECK_EQUAL(decoded.size(), 3u);
+
+   for (size_t i = 0; i < images.size(); ++i)
+   {
+      const Streamed_image& image = images[i];
+      if (image.id == missing)
+      {
+         BOOST_CHECK(!image.image);
+         BOOST_CHECK(image.error == "no file missing.bmp");
+      }
+      else
+      {
+         BOOST_REQUIRE(image.image);
+         BOOST_CHECK_EQUAL(image.image->height, image.id.get_file_name().size());
+         BOOST_CHECK(image.error.empty());
+      }
+   }
+
+   // collected image could be loaded again
+   streamer.prefetch(a);
+   streamer.wait();
+   images.clear();
+   streamer.collect(images);
+   BOOST_CHECK(images.size() == 1 && images[0].id == a);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Requested images go before prefetched ones, including prefetched ones requested again.
+void test_priority()
+{
+   decoded.clear();
+   started = 0;
+   Texture_streamer streamer(1, decode);
+
+   set_gate(false);
+   streamer.prefetch(Texture_ID("first.bmp"));
+   // loading thread takes the first image, then others are queued behind it
+   for (;;)
+   {
+      boost::mutex::scoped_lock lock(mutex);
+      if (started > 0)
+      {
+         break;
+      }
+      lock.unlock();
+      boost::thread::yield();
+   }
+   streamer.prefetch(Texture_ID("prefetched_1.bmp"));
+   streamer.prefetch(Texture_ID("prefetched_2.bmp"));
+   streamer.request(Texture_ID("requested.bmp"));
+   streamer.request(Texture_ID("prefetched_2.bmp"));
+   // images being loaded or promoted already aren't queued again
+   streamer.request(Texture_ID("first.bmp"));
+   streamer.request(Texture_ID("prefetched_2.bmp"));
+   BOOST_CHECK_EQUAL(streamer.get_pending_number(), 4u);
+   set_gate(true);
+
+   streamer.wait();
+   BOOST_REQUIRE_EQUAL(decoded.size(), 4u);
+   BOOST_CHECK(decoded[1] == "requested.bmp");
+   BOOST_CHECK(decoded[2] == "prefetched_2.bmp");
+   BOOST_CHECK(decoded[3] == "prefetched_1.bmp");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Streamer could be destroyed with images queued.
+void test_stop()
+{
+   set_gate(false);
+   {
+      Texture_streamer streamer(2, decode);
+      for (uint i = 0; i < 10; ++i)
+      {
+         streamer.prefetch(Texture_ID("dropped_" + string(1, char('0' + i)) + ".bmp"));
+      }
+      set_gate(true);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Texture_streamer_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Texture_streamer_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Texture_streamer tests");
+
+   test->add(BOOST_TEST_CASE(test_load));
+   test->add(BOOST_TEST_CASE(test_priority));
+   test->add(BOOST_TEST_CASE(test_stop));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Measures throughput of sprite to device vertex conversion.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Vertex_conversion.h"
+
+#include "Engine/Timing/Stopwatch.h"
+
+#include <iostream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Vertex_conversion_benchmark
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// sprites of a single type fit into initial 1 MB vertex buffer of Direct3D_renderer
+const uint sprites_number = 8192;
+const uint rounds         = 2000;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Converts the same sprites many times and prints bytes read and written per second.
+template <Vertex_format format>
+void measure(const char* name)
+{
+   vector<Sprite<format> > sprites(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         sprites[i].vertexes[j].position.x = float(i);
+         sprites[i].vertexes[j].position.y = float(j);
+         sprites[i].vertexes[j].color.a = uchar(i + j);
+      }
+   }
+   vector<Device_vertex<format> > vertexes(4*sprites_number);
+
+   convert_sprites(&sprites[0], sprites_number, &vertexes[0]);      // warm up caches
+
+   Timing::Stopwatch stopwatch;
+   for (uint i = 0; i < rounds; ++i)
+   {
+      convert_sprites(&sprites[0], sprites_number, &vertexes[0]);
+   }
+   const double seconds = stopwatch.get_elapsed();
+
+   const double bytes = double(rounds)*sprites_number*(sizeof(sprites[0].vertexes) + 4*sizeof(vertexes[0]));
+   cout << name << ": " << bytes / seconds / (1 << 30) << " GB/s, "
+        << static_cast<ulong>(rounds*sprites_number / seconds) << " sprites/s" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void run()
+{
+   cout << sprites_number << " sprites per round, " << rounds << " rounds" << endl;
+
+   measure<Vertex_format(position | diffuse_color)>("Colored");
+   measure<Vertex_format(position | diffuse_color | texture_coord0)>("Textured");
+   measure<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>("Multitextured");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Vertex_conversion_benchmark
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+   Engine::Rendering::Vertex_conversion_benchmark::run();
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
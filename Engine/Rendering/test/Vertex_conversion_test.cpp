@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for vertex conversion.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Vertex_conversion.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Vertex_conversion_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// odd number of sprites, so that conversion doesn't rely on pairs
+const uint sprites_number = 7;
+
+/// Corners of quad in order of device vertexes.
+const uint strip_order[4] = { 0, 1, 3, 2 };
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Gives all attributes of all vertexes distinct values.
+template <class Vertex_type>
+void fill_common(Vertex_type& v, uint seed)
+{
+   v.position.x = seed + 0.5f;
+   v.position.y = seed + 0.25f;
+   v.position.z = 1.0f / (seed + 2);
+   v.color.a = uchar(seed);
+   v.color.r = uchar(seed + 64);
+   v.color.g = uchar(seed + 128);
+   v.color.b = uchar(seed + 192);
+}
+
+template <class Vertex_type>
+void check_common(const Device_vertex<Vertex_format(position | diffuse_color)>& d, const Vertex_type& v)
+{
+   BOOST_CHECK_EQUAL(d.x, v.position.x);
+   BOOST_CHECK_EQUAL(d.y, v.position.y);
+   BOOST_CHECK_EQUAL(d.z, v.position.z);
+   BOOST_CHECK_EQUAL(d.w, 1.0f);
+   BOOST_CHECK_EQUAL(d.color, (uint(v.color.a) << 24) | (uint(v.color.r) << 16) | (uint(v.color.g) << 8) | v.color.b);
+}
+
+/// Device vertexes begin with the same fields.
+template <class Device_vertex_type>
+const Device_vertex<Vertex_format(position | diffuse_color)>& common(const Device_vertex_type& d)
+{
+   return reinterpret_cast<const Device_vertex<Vertex_format(position | diffuse_color)>&>(d);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_colored()
+{
+   vector<Colored_sprite> sprites(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         fill_common(sprites[i].vertexes[j], 4*i + j);
+      }
+   }
+
+   // extra vertex checks nothing is written past the end
+   vector<Device_vertex<Vertex_format(position | diffuse_color)> > vertexes(4*sprites_number + 1);
+   vertexes.back().x = 42;
+   vertexes.back().color = 42;
+   convert_sprites(&sprites[0], sprites_number, &vertexes[0]);
+
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         check_common(vertexes[4*i + j], sprites[i].vertexes[strip_order[j]]);
+      }
+   }
+   BOOST_CHECK_EQUAL(vertexes.back().x, 42);
+   BOOST_CHECK_EQUAL(vertexes.back().color, 42u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_textured()
+{
+   vector<Textured_sprite> sprites(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         fill_common(sprites[i].vertexes[j], 4*i + j);
+         sprites[i].vertexes[j].texture_coord.tu = i + 0.125f*j;
+         sprites[i].vertexes[j].texture_coord.tv = i - 0.125f*j;
+      }
+   }
+
+   vector<Device_vertex<Vertex_format(position | diffuse_color | texture_coord0)> > vertexes(4*sprites_number + 1);
+   vertexes.back().x = 42;
+   convert_sprites(&sprites[0], sprites_number, &vertexes[0]);
+
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         const Device_vertex<Vertex_format(position | diffuse_color | texture_coord0)>& d = vertexes[4*i + j];
+         const Vertex<Vertex_format(position | diffuse_color | texture_coord0)>& v = sprites[i].vertexes[strip_order[j]];
+         check_common(common(d), v);
+         BOOST_CHECK_EQUAL(d.tu, v.texture_coord.tu);
+         BOOST_CHECK_EQUAL(d.tv, v.texture_coord.tv);
+      }
+   }
+   BOOST_CHECK_EQUAL(vertexes.back().x, 42);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void test_multitextured()
+{
+   vector<Multitextured_2_sprite> sprites(sprites_number);
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         fill_common(sprites[i].vertexes[j], 4*i + j);
+         sprites[i].vertexes[j].texture_coord0.tu = i + 0.125f*j;
+         sprites[i].vertexes[j].texture_coord0.tv = i - 0.125f*j;
+         sprites[i].vertexes[j].texture_coord1.tu = i + 0.5f*j;
+         sprites[i].vertexes[j].texture_coord1.tv = i - 0.5f*j;
+      }
+   }
+
+   typedef Device_vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)> Device_vertex_type;
+   vector<Device_vertex_type> vertexes(4*sprites_number + 1);
+   vertexes.back().x = 42;
+   convert_sprites(&sprites[0], sprites_number, &vertexes[0]);
+
+   for (uint i = 0; i < sprites_number; ++i)
+   {
+      for (uint j = 0; j < 4; ++j)
+      {
+         const Device_vertex_type& d = vertexes[4*i + j];
+         const Vertex<Vertex_format(position | diffuse_color | texture_coord0 | texture_coord1)>& v =
+            sprites[i].vertexes[strip_order[j]];
+         check_common(common(d), v);
+         BOOST_CHECK_EQUAL(d.tu0, v.texture_coord0.tu);
+         BOOST_CHECK_EQUAL(d.tv0, v.texture_coord0.tv);
+         BOOST_CHECK_EQUAL(d.tu1, v.texture_coord1.tu);
+         BOOST_CHECK_EQUAL(d.tv1, v.texture_coord1.tv);
+      }
+   }
+   BOOST_CHECK_EQUAL(vertexes.back().x, 42);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Vertex_conversion_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Vertex_conversion_test;
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Vertex conversion tests");
+
+   test->add(BOOST_TEST_CASE(test_colored));
+   test->add(BOOST_TEST_CASE(test_textured));
+   test->add(BOOST_TEST_CASE(test_multitextured));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
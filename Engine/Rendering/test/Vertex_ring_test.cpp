@@ -0,0 +1,382 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Unit-tests for vertex ring and streaming of batches.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Vertex_ring.h"
+#include "Recording_device.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>              // for std::memcpy
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Rendering
+{
+namespace Vertex_ring_test
+{
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Buffer in system memory that remembers how it was locked.
+class Mock_buffer : public Dynamic_vertex_buffer
+{
+public:
+
+   struct Lock_call
+   {
+      uint offset;
+      uint bytes;
+      bool discard;
+   };
+
+public:
+
+   explicit Mock_buffer(uint capacity) : m_memory(capacity), m_locked(false) { }
+
+   void* lock(uint offset, uint bytes, bool discard)
+   {
+      BOOST_REQUIRE(!m_locked);
+      BOOST_REQUIRE(offset + bytes <= m_memory.size());
+      Lock_call call = { offset, bytes, discard };
+      m_locks.push_back(call);
+      m_locked = true;
+      return &m_memory[offset];
+   }
+
+   void unlock()
+   {
+      BOOST_REQUIRE(m_locked);
+      m_locked = false;
+   }
+
+   void resize(uint bytes)
+   {
+      BOOST_REQUIRE(!m_locked);
+      m_memory.assign(bytes, 0);
+   }
+
+   const vector<Lock_call>& get_locks() const { return m_locks; }
+   const vector<char>& get_memory() const     { return m_memory; }
+   bool is_locked() const                     { return m_locked; }
+
+private:
+
+   vector<char>      m_memory;
+   vector<Lock_call> m_locks;
+   bool              m_locked;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Every quad takes 16 bytes; the first word of quad is set to index of its sprite.
+class Mock_stream_device : public Recording_device, public Stream_device
+{
+public:
+
+   static const uint quad_bytes = 16;
+
+public:
+
+   explicit Mock_stream_device(const Mock_buffer& buffer) : m_buffer(buffer) { }
+
+   uint get_quad_bytes(Vertex_format) const
+   {
+      return quad_bytes;
+   }
+
+   void write_quads(Vertex_format, uint first, uint nquads, void* where)
+   {
+      BOOST_REQUIRE(m_buffer.is_locked());
+      for (uint i = 0; i < nquads; ++i)
+      {
+         const uint marker = first + i;
+         memcpy(static_cast<char*>(where) + i*quad_bytes, &marker, sizeof(marker));
+      }
+   }
+
+   void set_vertex_offset(uint offset)
+   {
+      m_offset = offset;
+   }
+
+   void set_vertex_format(Vertex_format format)                 { Recording_device::set_vertex_format(format); }
+   void set_texture(uint nstage, const Texture_ID& texture)     { Recording_device::set_texture(nstage, texture); }
+   void set_blending(uint nstage, Blending_mode blending)       { Recording_device::set_blending(nstage, blending); }
+
+   /// Records draw along with index of sprite its first vertexes belong to.
+   void draw_quads(uint first_quad, uint nquads)
+   {
+      BOOST_REQUIRE(!m_buffer.is_locked());
+      Recording_device::draw_quads(first_quad, nquads);
+
+      uint marker;
+      memcpy(&marker, &m_buffer.get_memory()[m_offset + first_quad*quad_bytes], sizeof(marker));
+      m_first_sprites.push_back(marker);
+   }
+
+   const vector<uint>& get_first_sprites() const { return m_first_sprites; }
+
+private:
+
+   const Mock_buffer& m_buffer;
+   uint               m_offset;
+   vector<uint>       m_first_sprites;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Render_batch make_batch(Vertex_format format, uint first, uint count, const char* texture)
+{
+   Render_batch batch = Render_batch();
+   batch.format = format;
+   batch.first = first;
+   batch.count = count;
+   batch.textures[0] = Texture_ID(texture);
+   return batch;
+}
+
+/// Checks that streamed batches are drawn as draw_batches() draws them and with vertexes of the right sprites.
+void check_draws(const Batch_list& batches, const Mock_stream_device& device)
+{
+   Recording_device expected;
+   draw_batches(batches, expected);
+
+   const vector<Recording_device::Draw>& draws = device.get_draws();
+   const vector<uint>& first_sprites = device.get_first_sprites();
+
+   // draws could be split further by flushes, so compare them quad by quad
+   vector<Recording_device::Draw> quads;
+   vector<uint> sprites;
+   for (size_t i = 0; i < draws.size(); ++i)
+   {
+      BOOST_CHECK(draws[i].nquads <= max_quads_per_draw);
+      for (uint j = 0; j < draws[i].nquads; ++j)
+      {
+         quads.push_back(draws[i]);
+         sprites.push_back(first_sprites[i] + j);
+      }
+   }
+
+   size_t nquad = 0;
+   for (size_t i = 0; i < expected.get_draws().size(); ++i)
+   {
+      const Recording_device::Draw& draw = expected.get_draws()[i];
+      for (uint j = 0; j < draw.nquads; ++j, ++nquad)
+      {
+         BOOST_REQUIRE(nquad < quads.size());
+         BOOST_CHECK(quads[nquad].format == draw.format);
+         BOOST_CHECK(quads[nquad].texture0 == draw.texture0);
+         BOOST_CHECK_EQUAL(sprites[nquad], draw.first_quad + j);
+      }
+   }
+   BOOST_CHECK_EQUAL(nquad, quads.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Ring discards buffer on the first lock and on wrapping; otherwise it appends without overwrite.
+void test_allocation()
+{
+   Mock_buffer buffer(100);
+   Vertex_ring ring(buffer, 100);
+
+   Vertex_ring::Lock(ring, 40);
+   Vertex_ring::Lock(ring, 40);
+   Vertex_ring::Lock(ring, 30);
+   {
+      Vertex_ring::Lock lock(ring, 10);
+      BOOST_CHECK_EQUAL(lock.get_offset(), 30u);
+      lock.reset();
+      lock.reset();
+   }
+
+   const vector<Mock_buffer::Lock_call>& locks = buffer.get_locks();
+   BOOST_REQUIRE_EQUAL(locks.size(), 4u);
+   BOOST_CHECK(locks[0].offset == 0 && locks[0].bytes == 40 && locks[0].discard);
+   BOOST_CHECK(locks[1].offset == 40 && locks[1].bytes == 40 && !locks[1].discard);
+   BOOST_CHECK(locks[2].offset == 0 && locks[2].bytes == 30 && locks[2].discard);
+   BOOST_CHECK(locks[3].offset == 30 && locks[3].bytes == 10 && !locks[3].discard);
+   BOOST_CHECK(!buffer.is_locked());
+
+   BOOST_CHECK_EQUAL(ring.get_free_bytes(), 60u);
+   BOOST_CHECK_EQUAL(ring.get_statistics().locks, 4u);
+   BOOST_CHECK_EQUAL(ring.get_statistics().discards, 2u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Ring grows only after several overflowing frames in a row, to the power of 2 multiple that fits the largest one.
+void test_growth()
+{
+   Mock_buffer buffer(100);
+   Vertex_ring ring(buffer, 100);
+
+   for (uint i = 0; i < vertex_ring_overflow_frames - 1; ++i)
+   {
+      Vertex_ring::Lock(ring, 100);
+      Vertex_ring::Lock(ring, 100);
+      ring.end_frame();
+   }
+   // frame that fits breaks the series
+   Vertex_ring::Lock(ring, 100);
+   ring.end_frame();
+   BOOST_CHECK_EQUAL(ring.get_capacity(), 100u);
+
+   for (uint i = 0; i < vertex_ring_overflow_frames; ++i)
+   {
+      Vertex_ring::Lock(ring, 100);
+      Vertex_ring::Lock(ring, 100);
+      if (i == 1)
+      {
+         Vertex_ring::Lock(ring, 50);
+      }
+      ring.end_frame();
+   }
+   BOOST_CHECK_EQUAL(ring.get_capacity(), 400u);
+   BOOST_CHECK_EQUAL(buffer.get_memory().size(), 400u);
+   BOOST_CHECK_EQUAL(ring.get_statistics().growths, 1u);
+
+   // buffer contents are lost, so the next lock discards
+   Vertex_ring::Lock(ring, 10);
+   BOOST_CHECK(buffer.get_locks().back().discard);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Scene that fits into ring is written by single lock and drawn as by draw_batches().
+void test_single_flush()
+{
+   Batch_list batches;
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color), 0, 3, ""));
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color | texture_coord0), 0, 5, "banana.bmp"));
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color | texture_coord0), 5, 2, "stain.bmp"));
+
+   Mock_buffer buffer(1024);
+   Vertex_ring ring(buffer, 1024);
+   Mock_stream_device device(buffer);
+   stream_batches(batches, ring, device);
+   ring.end_frame();
+
+   BOOST_CHECK_EQUAL(buffer.get_locks().size(), 1u);
+   BOOST_CHECK_EQUAL(device.get_draws().size(), 3u);
+   check_draws(batches, device);
+
+   // the next frame continues after this one
+   stream_batches(batches, ring, device);
+   BOOST_REQUIRE_EQUAL(buffer.get_locks().size(), 2u);
+   BOOST_CHECK_EQUAL(buffer.get_locks()[1].offset, 10*Mock_stream_device::quad_bytes);
+   BOOST_CHECK(!buffer.get_locks()[1].discard);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Scene larger than ring is drawn by several flushes, splitting batches if necessary.
+void test_several_flushes()
+{
+   Batch_list batches;
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color | texture_coord0), 0, 5, "banana.bmp"));
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color | texture_coord0), 5, 7, "stain.bmp"));
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color), 0, 9, ""));
+
+   const uint capacity = 8*Mock_stream_device::quad_bytes;
+   Mock_buffer buffer(capacity);
+   Vertex_ring ring(buffer, capacity);
+   Mock_stream_device device(buffer);
+   stream_batches(batches, ring, device);
+
+   // 21 quads by 8 at most
+   BOOST_CHECK_EQUAL(buffer.get_locks().size(), 3u);
+   check_draws(batches, device);
+
+   ring.end_frame();
+   BOOST_CHECK_EQUAL(ring.get_capacity(), capacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Long batch is split into draws of max_quads_per_draw quads.
+void test_long_batch()
+{
+   Batch_list batches;
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color), 0, 2*max_quads_per_draw + 1, ""));
+
+   const uint capacity = 4*max_quads_per_draw*Mock_stream_device::quad_bytes;
+   Mock_buffer buffer(capacity);
+   Vertex_ring ring(buffer, capacity);
+   Mock_stream_device device(buffer);
+   stream_batches(batches, ring, device);
+
+   BOOST_CHECK_EQUAL(buffer.get_locks().size(), 1u);
+   BOOST_CHECK_EQUAL(device.get_draws().size(), 3u);
+   check_draws(batches, device);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Flush that ends exactly at the end of batch list, and empty list, don't touch batches past the end
+/// (checked builds, e.g. with _GLIBCXX_ASSERTIONS or MSVC checked iterators, catch that).
+void test_end_of_batches()
+{
+   Batch_list batches;
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color), 0, 3, ""));
+   batches.push_back(make_batch(Vertex_format(position | diffuse_color | texture_coord0), 0, 5, "banana.bmp"));
+
+   const uint capacity = 8*Mock_stream_device::quad_bytes;
+   Mock_buffer buffer(capacity);
+   Vertex_ring ring(buffer, capacity);
+   Mock_stream_device device(buffer);
+   stream_batches(batches, ring, device);
+
+   BOOST_CHECK_EQUAL(buffer.get_locks().size(), 1u);
+   BOOST_CHECK_EQUAL(buffer.get_locks()[0].bytes, capacity);
+   check_draws(batches, device);
+
+   stream_batches(Batch_list(), ring, device);
+   BOOST_CHECK_EQUAL(buffer.get_locks().size(), 1u);
+   BOOST_CHECK_EQUAL(device.get_draws().size(), 2u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Vertex_ring_test
+} // namespace Rendering
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::unit_test::test_suite* init_unit_test_suite(int, char** const)
+{
+   using namespace Engine::Rendering::Vertex_ring_test;
+
+   Engine::Logging::Logger::init(0, 0);
+   Engine::Logging::Logger::set_global_message_level(Engine::Logging::no_log);
+
+   boost::unit_test::test_suite* test = BOOST_TEST_SUITE("Vertex ring tests");
+
+   test->add(BOOST_TEST_CASE(test_allocation));
+   test->add(BOOST_TEST_CASE(test_growth));
+   test->add(BOOST_TEST_CASE(test_single_flush));
+   test->add(BOOST_TEST_CASE(test_several_flushes));
+   test->add(BOOST_TEST_CASE(test_long_batch));
+   test->add(BOOST_TEST_CASE(test_end_of_batches));
+
+   return test;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Packs BMP files into texture atlas offline.
+// Usage: Atlas_builder <page size> <atlas name> <BMP files...>
+// Writes pages "<atlas name>_<n>.bmp" and description "<atlas name>.atlas" into current directory.
+// Textures are identified by file names as given, so it should be run from directory application loads them from;
+// e.g. "Atlas_builder 1024 sprites banana.bmp stain.bmp" in Main/res gives atlas main_app picks up.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Bmp.h"
+#include "Engine/Rendering/Texture_atlas.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include <cstdlib>              // for std::atoi
+#include <iostream>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   using namespace Engine::Rendering;
+   namespace Logging = Engine::Logging;
+
+   if (argc < 4 || std::atoi(argv[1]) <= 0)
+   {
+      std::cerr << "Usage: Atlas_builder <page size> <atlas name> <BMP files...>" << std::endl;
+      return 1;
+   }
+
+   try
+   {
+      Logging::Logger::init(0, 0);
+      Logging::Logger::set_global_message_level(Logging::major);
+
+      Texture_atlas atlas;
+      for (int i = 3; i < argc; ++i)
+      {
+         atlas.add(Texture_ID(argv[i]), load_bmp(argv[i]));
+      }
+      atlas.pack(std::atoi(argv[1]), argv[2]);
+      atlas.save(std::string(argv[2]) + ".atlas");
+
+      std::cout << atlas.get_size() << " of " << argc - 3 << " textures packed into " << atlas.get_pages().size()
+                << " pages" << std::endl;
+      return 0;
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Packs BMP and DDS files into asset pack offline.
+// Usage: Pack_builder <pack file> <BMP or DDS files...>
+// BMP files are kept decoded as A8R8G8B8 pixels, DDS ones as blocks.
+// Textures are identified by file names as given, so it should be run from directory application loads them from;
+// e.g. "Pack_builder sprites.pack banana.bmp stain.bmp" in Main/res gives pack main_app picks up.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Bmp.h"
+#include "Engine/Rendering/Dds.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   using namespace Engine::Rendering;
+   namespace Logging = Engine::Logging;
+
+   if (argc < 3)
+   {
+      std::cerr << "Usage: Pack_builder <pack file> <BMP or DDS files...>" << std::endl;
+      return 1;
+   }
+
+   try
+   {
+      Logging::Logger::init(0, 0);
+      Logging::Logger::set_global_message_level(Logging::major);
+
+      Asset_pack_writer writer;
+      for (int i = 2; i < argc; ++i)
+      {
+         const std::string file_name = argv[i];
+         if (is_dds_file(file_name))
+         {
+            writer.add(file_name, load_dds(file_name));
+         }
+         else
+         {
+            writer.add(file_name, load_bmp(file_name));
+         }
+      }
+      writer.save(argv[1]);
+
+      std::cout << writer.get_size() << " textures packed into " << argv[1] << std::endl;
+      return 0;
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Compresses BMP files into DDS ones offline.
+// Usage: Texture_compressor <bc1|bc3|auto> <BMP files...>
+// Each "<name>.bmp" is written as "<name>.dds" next to it; "auto" takes BC3 for images with alpha and BC1 for others.
+// Renderers load ".dds" textures compressed, so sprites should refer to the new names.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Rendering/Block_compression.h"
+#include "Engine/Rendering/Bmp.h"
+#include "Engine/Rendering/Dds.h"
+
+#include "Engine/Logging/Logging.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+   using namespace Engine::Rendering;
+   namespace Logging = Engine::Logging;
+
+   const std::string mode = argc > 1 ? argv[1] : "";
+   if (argc < 3 || (mode != "bc1" && mode != "bc3" && mode != "auto"))
+   {
+      std::cerr << "Usage: Texture_compressor <bc1|bc3|auto> <BMP files...>" << std::endl;
+      return 1;
+   }
+
+   try
+   {
+      Logging::Logger::init(0, 0);
+      Logging::Logger::set_global_message_level(Logging::major);
+
+      for (int i = 2; i < argc; ++i)
+      {
+         const std::string file_name = argv[i];
+         const Image image = load_bmp(file_name);
+         const Block_format format = mode == "bc1" ? block_format_bc1
+                                   : mode == "bc3" || has_alpha(image) ? block_format_bc3 : block_format_bc1;
+         const Compressed_image compressed = compress_image(image, format);
+
+         const std::string::size_type dot = file_name.find_last_of('.');
+         const std::string dds_name = file_name.substr(0, dot == std::string::npos ? file_name.size() : dot) + ".dds";
+         save_dds(compressed, dds_name);
+
+         std::cout << dds_name << ": " << (format == block_format_bc1 ? "BC1" : "BC3") << ", "
+                   << image.pixels.size()*4 / 1024 << " KB -> " << compressed.blocks.size() / 1024 << " KB" << std::endl;
+      }
+      return 0;
+   }
+   catch (const std::runtime_error& ex)
+   {
+      std::cerr << ex.what() << std::endl;
+      return 1;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
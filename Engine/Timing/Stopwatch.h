@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Portable high resolution stopwatch.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_TIMING_STOPWATCH_H_INCLUDED
+#define ENGINE_TIMING_STOPWATCH_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Timing
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Measures time intervals with the best resolution platform provides.
+/// Intended for profiling and benchmarks; unlike Timer it doesn't need Windows.
+class Stopwatch
+{
+public:
+
+   /// Starts measuring.
+   Stopwatch();
+
+   // default copying is ok
+
+   /// Starts measuring again.
+   void restart();
+
+   /// \return Seconds passed since construction, last restart() or lap().
+   double get_elapsed() const;
+
+   /// Starts measuring again, so that consecutive phases are measured by single stopwatch.
+   /// \return Seconds passed since construction, last restart() or lap().
+   double lap();
+
+private:
+
+   double m_start;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Timing
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // ENGINE_TIMING_STOPWATCH_H_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2009 Alexander Poluektov
+// All rights reserved
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+// $DateTime$
+
+// Stopwatch implementation.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Engine/Timing/Stopwatch.h"
+
+#ifdef _WIN32
+#include "Third_party/Platform/Win32.h"
+#else
+#include <time.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Engine
+{
+namespace Timing
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \return Seconds from some unspecified moment.
+double get_seconds()
+{
+#ifdef _WIN32
+   LARGE_INTEGER count;
+   LARGE_INTEGER freq;
+   ::QueryPerformanceCounter(&count);
+   ::QueryPerformanceFrequency(&freq);
+   return static_cast<double>(count.QuadPart) / static_cast<double>(freq.QuadPart);
+#else
+   timespec now;
+   ::clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec + now.tv_nsec*1e-9;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Stopwatch::Stopwatch()
+   : m_start(get_seconds())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Stopwatch::restart()
+{
+   m_start = get_seconds();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double Stopwatch::get_elapsed() const
+{
+   return get_seconds() - m_start;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double Stopwatch::lap()
+{
+   const double now = get_seconds();
+   const double elapsed = now - m_start;
+   m_start = now;
+   return elapsed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Timing
+} // namespace Engine
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27,7 +27,12 @@ namespace Logging
 
 const uchar sender_window = 2;
 
-#define LOG_WINDOW(message_level) LOG(Logging::sender_window, message_level)
+#ifdef NDEBUG
+// window logs trivial message every frame
+LOG_COMPILED_LEVEL(sender_window, minor);
+#endif
+
+#define LOG_WINDOW(message_level) LOG_SENDER(Logging::sender_window, message_level)
 
 }
 }
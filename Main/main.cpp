@@ -11,10 +11,18 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "Engine/Logging/Logging.h"
+#include "Engine/Logging/Circular_log_file.h"
 #include "Engine/Window/Window.h"
 #include "Engine/Rendering/Direct3D/Direct3D_renderer.h"
+#include "Engine/Rendering/Asset_pack.h"
+#include "Engine/Rendering/Recording_renderer.h"
+#include "Engine/Rendering/Texture_atlas.h"
 #include "Engine/Input/Win32_input_handler.h"
+#include "Engine/Timing/Stopwatch.h"
 
+#include "boost/scoped_ptr.hpp"
+
+#include <fstream>
 #include <string>
 
 #include <direct.h>
@@ -28,7 +36,7 @@ namespace Logging
 
 const uchar sender_main = 1;
 
-#define LOG_MAIN(message_level) LOG(Engine::Logging::sender_main, message_level)
+#define LOG_MAIN(message_level) LOG_SENDER(Engine::Logging::sender_main, message_level)
 
 }
 }
@@ -43,7 +51,19 @@ namespace Logging = Engine::Logging;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Optional atlas of textures in application directory.
+const char* const atlas_file = "sprites.atlas";
+
+/// Optional pack of textures in application directory, built by Pack_builder.
+const char* const pack_file = "sprites.pack";
+
+/// Bytes of the last messages circular log file keeps.
+const uint log_ring_size = 4 << 20;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void set_curdir_to_appdir();
+LONG WINAPI flush_log_on_crash(EXCEPTION_POINTERS*);
 void init_colored_sprites(Colored_sprite* sprites);
 void init_textured_sprites(Textured_sprite* tex_sprites);
 void init_multitextured_sprites(Multitextured_2_sprite* tex2_sprites);
@@ -51,19 +71,78 @@ void handle_some_input(Input_handler&);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int main(int /*argc*/, char** /*argv*/)
+int main(int argc, char** argv)
 {
+   // outlives try block, as messages about exceptions are logged into it
+   boost::scoped_ptr<Circular_log_file> log_ring;
+
    try
    {
-      Logger::init(0, 0);
+      // time to first frame is measured from here
+      const Timing::Stopwatch startup;
+
+      // "--log-ring <file>" logs into file that keeps the last messages even if application crashes;
+      // file of previous run is kept as <file>.old; see Log_unroller. If file can't be created, std::clog is used
+      std::ostream* log_stream = 0;
+      std::string log_ring_error;
+      if (argc == 3 && std::string(argv[1]) == "--log-ring")
+      {
+         try
+         {
+            log_ring.reset(new Circular_log_file(argv[2], log_ring_size));
+            log_stream = &log_ring->get_stream();
+         }
+         catch (const Common::Mapped_file_exception& ex)
+         {
+            log_ring_error = ex.what();
+         }
+      }
+      Logger::init(log_stream, 0);
+      if (!log_ring_error.empty())
+      {
+         LOG_MAIN(Logging::critical) << "Can't create log ring " << argv[2] << ": " << log_ring_error;
+      }
       Logger::set_global_message_level(Logging::minor);
 
+      // messages logged every frame don't wait for console; queued ones are written before main() returns
+      // or when application crashes
+      const Async_logging_scope async_logging(4096, overflow_block);
+      ::SetUnhandledExceptionFilter(flush_log_on_crash);
+
+      // "--record <file>" writes scene of every frame into file; see Scene_replay_benchmark
+      // opened before current directory is changed, so relative path is relative to caller's directory
+      std::ofstream scene_file;
+      if (argc == 3 && std::string(argv[1]) == "--record")
+      {
+         scene_file.open(argv[2], std::ios::binary);
+         if (!scene_file)
+         {
+            LOG_MAIN(Logging::critical) << "!!! Can't open scene file " << argv[2] << "; throw !!!";
+            throw std::runtime_error("Can't open scene file");
+         }
+      }
+
       set_curdir_to_appdir();
 
+      // textures in pack are taken from it right away rather than opened and decoded one by one;
+      // pack should outlive renderer
+      boost::scoped_ptr<Asset_pack> pack;
+      if (std::ifstream(pack_file).good())
+      {
+         pack.reset(new Asset_pack(pack_file));
+      }
+
       Window window("app.name", 100, 100, 300, 300);
       Direct3D_renderer renderer(window.get_handle(), true);
       Win32_input_handler input_handler(window);
 
+      boost::scoped_ptr<Recording_renderer> recorder;
+      if (scene_file.is_open())
+      {
+         recorder.reset(new Recording_renderer(renderer, scene_file));
+      }
+      Renderer& scene = recorder ? static_cast<Renderer&>(*recorder) : renderer;
+
       Colored_sprite sprites[2];
       init_colored_sprites(sprites);
 
@@ -73,6 +152,39 @@ int main(int /*argc*/, char** /*argv*/)
       Multitextured_2_sprite tex2_sprites[1];
       init_multitextured_sprites(tex2_sprites);
 
+      // textures packed by Atlas_builder share pages, so sprites of different textures are drawn by one batch
+      if (std::ifstream(atlas_file).good())
+      {
+         Texture_atlas atlas;
+         atlas.load(atlas_file);
+         atlas.remap(tex_sprites[0]);
+         atlas.remap(tex_sprites[1]);
+         atlas.remap(tex2_sprites[0]);
+      }
+
+      // textures missing from pack are loaded in background while window shows up;
+      // sprites are drawn plain until they arrive
+      renderer.set_asset_pack(pack.get());
+      renderer.enable_texture_streaming(2);
+      renderer.prefetch_texture(tex_sprites[0].texture);
+      renderer.prefetch_texture(tex_sprites[1].texture);
+      renderer.prefetch_texture(tex2_sprites[0].texture0);
+      renderer.prefetch_texture(tex2_sprites[0].texture1);
+
+      // frame costs show up in log every few seconds
+      renderer.set_stats_log_period(300);
+
+      // sprites don't move, so they are retained rather than added to every frame
+      for (uint i = 0; i < 2; ++i)
+      {
+         scene.create_sprite(sprites[0]);
+         scene.create_sprite(sprites[1]);
+         scene.create_sprite(tex_sprites[0]);
+         scene.create_sprite(tex_sprites[1]);
+         scene.create_sprite(tex2_sprites[0]);
+      }
+
+      bool is_first_frame = true;
       while (!window.is_closing())
       {
          window.handle_messages();
@@ -85,19 +197,14 @@ int main(int /*argc*/, char** /*argv*/)
 
          handle_some_input(input_handler);
 
-         renderer.add_to_scene(sprites[0]);
-         renderer.add_to_scene(sprites[1]);
-         renderer.add_to_scene(tex_sprites[0]);
-         renderer.add_to_scene(tex_sprites[1]);
-         renderer.add_to_scene(tex2_sprites[0]);
-         renderer.add_to_scene(sprites[0]);
-         renderer.add_to_scene(sprites[1]);
-         renderer.add_to_scene(tex_sprites[0]);
-         renderer.add_to_scene(tex_sprites[1]);
-         renderer.add_to_scene(tex2_sprites[0]);
-
-         renderer.render_scene();
-         renderer.clear_scene();
+         scene.render_scene();
+
+         if (is_first_frame)
+         {
+            is_first_frame = false;
+            LOG_MAIN(Logging::major) << "First frame in " << startup.get_elapsed() * 1000 << " ms"
+                                     << (pack ? " with asset pack" : "");
+         }
       }
 
       LOG_MAIN(Logging::major) << "Exit from main succesfully";
@@ -121,6 +228,15 @@ int main(int /*argc*/, char** /*argv*/)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Writes queued log messages out before application is terminated by unhandled exception.
+LONG WINAPI flush_log_on_crash(EXCEPTION_POINTERS*)
+{
+   Logger::flush_on_crash();
+   return EXCEPTION_CONTINUE_SEARCH;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // TODO: separate module
 // TODO: win32 specific, point it to developer
 // TODO: test it
@@ -272,7 +388,7 @@ void init_textured_sprites(Textured_sprite* tex_sprites)
    tex_sprites[0].vertexes[3].texture_coord.tv = 0;
 
    tex_sprites[0].blending = blending_mode_add;
-   tex_sprites[0].texture.file_name = "banana.bmp";
+   tex_sprites[0].texture = Texture_ID("banana.bmp");
 
    tex_sprites[1].vertexes[0].position.x = 10 + 200;
    tex_sprites[1].vertexes[0].position.y = 10;
@@ -315,7 +431,7 @@ void init_textured_sprites(Textured_sprite* tex_sprites)
    tex_sprites[1].vertexes[3].texture_coord.tv = 0;
 
    tex_sprites[1].blending = blending_mode_modulate;
-   tex_sprites[1].texture.file_name = "banana.bmp";
+   tex_sprites[1].texture = Texture_ID("banana.bmp");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -371,9 +487,9 @@ void init_multitextured_sprites(Multitextured_2_sprite* tex2_sprites)
    tex2_sprites[0].vertexes[3].texture_coord1.tv = 0;
 
    tex2_sprites[0].blending0 = blending_mode_add;
-   tex2_sprites[0].texture0.file_name = "banana.bmp";
+   tex2_sprites[0].texture0 = Texture_ID("banana.bmp");
    tex2_sprites[0].blending1 = blending_mode_modulate;
-   tex2_sprites[0].texture1.file_name = "stain.bmp";
+   tex2_sprites[0].texture1 = Texture_ID("stain.bmp");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////